@@ -0,0 +1,231 @@
+/**
+ * @file bench.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 benchmarks - common functions
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "session_p.h"
+
+static const char *bench_name;
+static char **results;
+static uint32_t result_count;
+
+void
+bench_start(const char *name)
+{
+    bench_name = name;
+}
+
+void
+bench_result(const char *test, const char *params, double value, const char *unit)
+{
+    char *result, **r;
+
+    fprintf(stderr, "%-12s %-40s %14.2f %s\n", test, params ? params : "", value, unit);
+
+    if (asprintf(&result, "{\"test\": \"%s\", \"params\": {%s}, \"value\": %.3f, \"unit\": \"%s\"}", test,
+            params ? params : "", value, unit) == -1) {
+        return;
+    }
+    r = realloc(results, (result_count + 1) * sizeof *results);
+    if (!r) {
+        free(result);
+        return;
+    }
+    results = r;
+    results[result_count++] = result;
+}
+
+int
+bench_finish(const char *path)
+{
+    FILE *f = stdout;
+    uint32_t i;
+
+    if (path) {
+        f = fopen(path, "w");
+        if (!f) {
+            fprintf(stderr, "Opening \"%s\" failed.\n", path);
+            return 1;
+        }
+    }
+
+    fprintf(f, "{\n  \"benchmark\": \"%s\",\n  \"results\": [", bench_name);
+    for (i = 0; i < result_count; ++i) {
+        fprintf(f, "%s\n    %s", i ? "," : "", results[i]);
+        free(results[i]);
+    }
+    fprintf(f, "\n  ]\n}\n");
+    free(results);
+    results = NULL;
+    result_count = 0;
+
+    if (path) {
+        fclose(f);
+    }
+    return 0;
+}
+
+double
+bench_elapsed(const struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int
+bench_fd_limit(uint32_t count)
+{
+    struct rlimit rl;
+
+    if (getrlimit(RLIMIT_NOFILE, &rl)) {
+        return 1;
+    }
+    if (rl.rlim_cur >= count) {
+        return 0;
+    }
+    if (rl.rlim_max < count) {
+        return 1;
+    }
+
+    rl.rlim_cur = count;
+    return setrlimit(RLIMIT_NOFILE, &rl) ? 1 : 0;
+}
+
+int
+bench_ctx_new(struct ly_ctx **ctx)
+{
+    const char *nc_features[] = {"candidate", NULL};
+
+    if (ly_ctx_new(BENCH_DATA_DIR "/modules", 0, ctx)) {
+        return 1;
+    }
+
+    if (!ly_ctx_load_module(*ctx, "ietf-netconf", NULL, nc_features) ||
+            !ly_ctx_load_module(*ctx, "nc-notifications", NULL, NULL)) {
+        ly_ctx_destroy(*ctx);
+        *ctx = NULL;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Create a new running session using FD transport.
+ *
+ * @param[in] side Side of the session.
+ * @param[in] ctx Context of the session.
+ * @param[in] version NETCONF version of the session.
+ * @param[in] fd Socket of the session.
+ * @return New session, NULL on error.
+ */
+static struct nc_session *
+bench_session_new(NC_SIDE side, struct ly_ctx *ctx, NC_VERSION version, int fd)
+{
+    struct nc_session *sess;
+    struct timespec ts;
+
+    sess = calloc(1, sizeof *sess);
+    if (!sess) {
+        return NULL;
+    }
+
+    sess->side = side;
+    if (side == NC_SERVER) {
+        pthread_mutex_init(&sess->opts.server.ntf_status_lock, NULL);
+        pthread_mutex_init(&sess->opts.server.rpc_lock, NULL);
+        pthread_cond_init(&sess->opts.server.rpc_cond, NULL);
+
+        nc_timeouttime_get(&ts, 0);
+        sess->opts.server.last_rpc = ts.tv_sec;
+    } else {
+        sess->opts.client.msgid = 1;
+    }
+
+    sess->io_lock = malloc(sizeof *sess->io_lock);
+    if (!sess->io_lock) {
+        free(sess);
+        return NULL;
+    }
+    pthread_mutex_init(sess->io_lock, NULL);
+
+    sess->status = NC_STATUS_RUNNING;
+    sess->version = version;
+    sess->ti_type = NC_TI_FD;
+    sess->ti.fd.in = fd;
+    sess->ti.fd.out = fd;
+    sess->ctx = ctx;
+    sess->flags = NC_SESSION_SHAREDCTX;
+
+    return sess;
+}
+
+int
+bench_session_pair(struct ly_ctx *ctx, NC_VERSION version, struct nc_session **server, struct nc_session **client)
+{
+    static uint32_t id = 1;
+    int sock[2];
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sock)) {
+        return 1;
+    }
+
+    *server = bench_session_new(NC_SERVER, ctx, version, sock[0]);
+    *client = bench_session_new(NC_CLIENT, ctx, version, sock[1]);
+    if (!*server || !*client) {
+        if (*server) {
+            bench_session_free(*server);
+        } else {
+            close(sock[0]);
+        }
+        if (*client) {
+            bench_session_free(*client);
+        } else {
+            close(sock[1]);
+        }
+        return 1;
+    }
+    (*server)->id = id;
+    (*client)->id = id;
+    ++id;
+
+    return 0;
+}
+
+void
+bench_session_free(struct nc_session *session)
+{
+    if (!session) {
+        return;
+    }
+
+    /* do not communicate on the closed socket */
+    close(session->ti.fd.in);
+    session->ti.fd.in = -1;
+    session->ti.fd.out = -1;
+    nc_session_free(session, NULL);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file bench.h
+ * @author agent <agent@local>
+ * @brief libnetconf2 benchmarks - common functions
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#ifndef NC_BENCH_H_
+#define NC_BENCH_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+#include "session_p.h"
+
+/**
+ * @brief Start recording the results of a benchmark.
+ *
+ * @param[in] name Name of the benchmark.
+ */
+void bench_start(const char *name);
+
+/**
+ * @brief Record a result of a benchmark, it is also printed in a human-readable form to stderr.
+ *
+ * @param[in] test Name of the measurement.
+ * @param[in] params Parameters of the measurement as JSON object members, NULL if none.
+ * @param[in] value Measured value.
+ * @param[in] unit Unit of @p value.
+ */
+void bench_result(const char *test, const char *params, double value, const char *unit);
+
+/**
+ * @brief Print all the recorded results of the benchmark as a JSON object.
+ *
+ * @param[in] path Path of the file to write, NULL for stdout.
+ * @return 0 on success, 1 on error.
+ */
+int bench_finish(const char *path);
+
+/**
+ * @brief Get seconds elapsed since a monotonic timestamp.
+ *
+ * @param[in] start Start timestamp.
+ * @return Elapsed seconds.
+ */
+double bench_elapsed(const struct timespec *start);
+
+/**
+ * @brief Raise the limit of open file descriptors.
+ *
+ * @param[in] count Required number of file descriptors.
+ * @return 0 on success, 1 if the limit cannot be raised enough.
+ */
+int bench_fd_limit(uint32_t count);
+
+/**
+ * @brief Create a new context with the modules required for the sessions created by ::bench_session_pair().
+ *
+ * @param[out] ctx Created context.
+ * @return 0 on success, 1 on error.
+ */
+int bench_ctx_new(struct ly_ctx **ctx);
+
+/**
+ * @brief Create a connected pair of running sessions using FD transport over a socketpair.
+ *
+ * No NETCONF handshake is performed, the sessions are established right away.
+ *
+ * @param[in] ctx Context of the sessions.
+ * @param[in] version NETCONF version of the sessions.
+ * @param[out] server Server session.
+ * @param[out] client Client session.
+ * @return 0 on success, 1 on error.
+ */
+int bench_session_pair(struct ly_ctx *ctx, NC_VERSION version, struct nc_session **server, struct nc_session **client);
+
+/**
+ * @brief Free a session created by ::bench_session_pair().
+ *
+ * @param[in] session Session to free.
+ */
+void bench_session_free(struct nc_session *session);
+
+#endif /* NC_BENCH_H_ */
@@ -0,0 +1,164 @@
+/**
+ * @file bench_framing.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 benchmark - throughput of :base:1.0 and :base:1.1 message framing
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+#include "bench.h"
+#include "messages_p.h"
+#include "session_p.h"
+
+/* amount of data transferred for each message size */
+#define DATA_TOTAL (256ULL * 1024 * 1024)
+
+struct writer_arg {
+    struct nc_session *session;
+    struct nc_server_reply *reply;
+    uint32_t rounds;
+    int ret;
+};
+
+static void *
+writer_thread(void *arg)
+{
+    struct writer_arg *warg = arg;
+    uint32_t i;
+
+    for (i = 0; i < warg->rounds; ++i) {
+        if (nc_write_msg_io(warg->session, -1, NC_MSG_REPLY, NULL, warg->reply) != NC_MSG_REPLY) {
+            warg->ret = 1;
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+run(struct ly_ctx *ctx, NC_VERSION version, uint64_t size)
+{
+    struct nc_session *server, *client;
+    struct writer_arg warg = {0};
+    struct lyd_node *err = NULL;
+    struct ly_in *msg;
+    struct timespec start;
+    pthread_t tid;
+    uint64_t bytes = 0;
+    uint32_t i;
+    char *text = NULL, params[64];
+    double t;
+    int ret = 1;
+
+    if (bench_session_pair(ctx, version, &server, &client)) {
+        return 1;
+    }
+
+    /* rpc-reply with an error message of the requested size */
+    text = malloc(size + 1);
+    if (!text) {
+        goto cleanup;
+    }
+    memset(text, 'a', size);
+    text[size] = '\0';
+
+    err = nc_err(ctx, NC_ERR_OP_FAILED, NC_ERR_TYPE_APP);
+    if (!err || nc_err_set_msg(err, text, "en")) {
+        goto cleanup;
+    }
+    warg.reply = nc_server_reply_err(err);
+    if (!warg.reply) {
+        goto cleanup;
+    }
+    err = NULL;
+
+    warg.session = server;
+    warg.rounds = (size < DATA_TOTAL) ? DATA_TOTAL / size : 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (pthread_create(&tid, NULL, writer_thread, &warg)) {
+        goto cleanup;
+    }
+
+    for (i = 0; i < warg.rounds; ++i) {
+        if (nc_read_msg_io(client, -1, &msg, 0) != 1) {
+            break;
+        }
+        bytes += strlen(ly_in_memory(msg, NULL));
+        ly_in_free(msg, 1);
+    }
+    if (i < warg.rounds) {
+        /* unblock the writer */
+        shutdown(client->ti.fd.in, SHUT_RDWR);
+    }
+    pthread_join(tid, NULL);
+    t = bench_elapsed(&start);
+    if (warg.ret || (i < warg.rounds)) {
+        fprintf(stderr, "Transferring messages of size %" PRIu64 " failed.\n", size);
+        goto cleanup;
+    }
+
+    sprintf(params, "\"framing\": \"%s\", \"size\": %" PRIu64, (version == NC_VERSION_10) ? "1.0" : "1.1", size);
+    bench_result("throughput", params, bytes / t / 1e6, "MB/s");
+    bench_result("messages", params, warg.rounds / t, "msg/s");
+    ret = 0;
+
+cleanup:
+    lyd_free_tree(err);
+    nc_server_reply_free(warg.reply);
+    free(text);
+    bench_session_free(server);
+    bench_session_free(client);
+    return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+    const uint64_t sizes[] = {100, 10000, 1000000, 100000000};
+    struct ly_ctx *ctx;
+    uint32_t i;
+    int ret = 0;
+
+    if (bench_ctx_new(&ctx) || nc_server_init()) {
+        return 1;
+    }
+
+    bench_start("framing");
+    for (i = 0; !ret && (i < sizeof sizes / sizeof *sizes); ++i) {
+        ret = run(ctx, NC_VERSION_10, sizes[i]);
+        if (!ret) {
+            ret = run(ctx, NC_VERSION_11, sizes[i]);
+        }
+    }
+
+    /* results to the file given as the argument or stdout */
+    if (!ret) {
+        ret = bench_finish((argc > 1) ? argv[1] : NULL);
+    }
+
+    nc_server_destroy();
+    ly_ctx_destroy(ctx);
+    return ret;
+}
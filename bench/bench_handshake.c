@@ -0,0 +1,234 @@
+/**
+ * @file bench_handshake.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 benchmark - rate of accepting new sessions
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libyang/libyang.h>
+
+#include "bench.h"
+#include "server_config.h"
+#include "session_p.h"
+
+#define UNIX_SOCKET_PATH "/tmp/nc2_bench_unix_sock"
+#define SSH_PORT 10830
+#define TLS_PORT 10831
+
+#define ACCEPT_TIMEOUT 5000
+#define POLL_TIMEOUT 5000
+
+struct server_arg {
+    struct ly_ctx *ctx;
+    uint32_t count;
+    int ret;
+};
+
+static void *
+server_thread(void *arg)
+{
+    struct server_arg *sarg = arg;
+    struct nc_session *session;
+    struct nc_pollsession *ps;
+    uint32_t i;
+    int r;
+
+    ps = nc_ps_new();
+    if (!ps) {
+        sarg->ret = 1;
+        return NULL;
+    }
+
+    for (i = 0; i < sarg->count; ++i) {
+        if (nc_accept(ACCEPT_TIMEOUT, sarg->ctx, &session) != NC_MSG_HELLO) {
+            sarg->ret = 1;
+            break;
+        }
+
+        /* process the close-session of the client */
+        nc_ps_add_session(ps, session);
+        do {
+            r = nc_ps_poll(ps, POLL_TIMEOUT, NULL);
+        } while (!(r & (NC_PSPOLL_SESSION_TERM | NC_PSPOLL_ERROR | NC_PSPOLL_TIMEOUT)));
+        nc_ps_clear(ps, 1, NULL);
+    }
+
+    nc_ps_free(ps);
+    return NULL;
+}
+
+static struct nc_session *
+client_connect(const char *transport, struct ly_ctx *ctx)
+{
+    if (!strcmp(transport, "unix")) {
+        return nc_connect_unix(UNIX_SOCKET_PATH, ctx);
+    }
+#ifdef NC_ENABLED_SSH_TLS
+    if (!strcmp(transport, "ssh")) {
+        return nc_connect_ssh("127.0.0.1", SSH_PORT, ctx);
+    }
+    if (!strcmp(transport, "tls")) {
+        return nc_connect_tls("127.0.0.1", TLS_PORT, ctx);
+    }
+#endif /* NC_ENABLED_SSH_TLS */
+
+    return NULL;
+}
+
+static int
+run(struct ly_ctx *ctx, struct ly_ctx *client_ctx, const char *transport, uint32_t count)
+{
+    struct server_arg sarg = {0};
+    struct nc_session *session;
+    struct timespec start;
+    pthread_t tid;
+    uint32_t i;
+    char params[32];
+    double t;
+    int ret = 0;
+
+    /* one more session for warming up the client context */
+    sarg.ctx = ctx;
+    sarg.count = count + 1;
+    if (pthread_create(&tid, NULL, server_thread, &sarg)) {
+        return 1;
+    }
+
+    session = client_connect(transport, client_ctx);
+    if (!session) {
+        ret = 1;
+    }
+    nc_session_free(session, NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; !ret && (i < count); ++i) {
+        session = client_connect(transport, client_ctx);
+        if (!session) {
+            ret = 1;
+            break;
+        }
+        nc_session_free(session, NULL);
+    }
+    t = bench_elapsed(&start);
+
+    pthread_join(tid, NULL);
+    if (ret || sarg.ret) {
+        fprintf(stderr, "Connecting using %s failed.\n", transport);
+        return 1;
+    }
+
+    sprintf(params, "\"transport\": \"%s\"", transport);
+    bench_result("handshake", params, count / t, "session/s");
+    return 0;
+}
+
+static int
+server_config(struct ly_ctx *ctx)
+{
+    int ret = 0;
+
+#ifdef NC_ENABLED_SSH_TLS
+    struct lyd_node *tree = NULL;
+
+    /* SSH endpoint */
+    ret = ret || nc_server_config_add_address_port(ctx, "ssh", NC_TI_SSH, "127.0.0.1", SSH_PORT, &tree);
+    ret = ret || nc_server_config_add_ssh_hostkey(ctx, "ssh", "hostkey", BENCH_DATA_DIR "/server.key", NULL, &tree);
+    ret = ret || nc_server_config_add_ssh_user_pubkey(ctx, "ssh", "test_ed25519", "pubkey",
+            BENCH_DATA_DIR "/id_ed25519.pub", &tree);
+
+    /* TLS endpoint */
+    ret = ret || nc_server_config_add_address_port(ctx, "tls", NC_TI_TLS, "127.0.0.1", TLS_PORT, &tree);
+    ret = ret || nc_server_config_add_tls_server_cert(ctx, "tls", BENCH_DATA_DIR "/server.key", NULL,
+            BENCH_DATA_DIR "/server.crt", &tree);
+    ret = ret || nc_server_config_add_tls_client_cert(ctx, "tls", "client_cert", BENCH_DATA_DIR "/client.crt", &tree);
+    ret = ret || nc_server_config_add_tls_ca_cert(ctx, "tls", "client_ca", BENCH_DATA_DIR "/serverca.pem", &tree);
+    ret = ret || nc_server_config_add_tls_ctn(ctx, "tls", 1,
+            "04:85:6B:75:D1:1A:86:E0:D8:FE:5B:BD:72:F5:73:1D:07:EA:32:BF:09:11:21:6A:6E:23:78:8E:B6:D5:73:C3:2D",
+            NC_TLS_CTN_SPECIFIED, "client", &tree);
+
+    ret = ret || nc_server_config_setup_data(tree);
+    lyd_free_all(tree);
+    if (ret) {
+        return 1;
+    }
+
+    /* client authentication */
+    nc_client_ssh_set_knownhosts_mode(NC_SSH_KNOWNHOSTS_SKIP);
+    ret = ret || nc_client_ssh_set_username("test_ed25519");
+    ret = ret || nc_client_ssh_add_keypair(BENCH_DATA_DIR "/id_ed25519.pub", BENCH_DATA_DIR "/id_ed25519");
+    ret = ret || nc_client_tls_set_cert_key_paths(BENCH_DATA_DIR "/client.crt", BENCH_DATA_DIR "/client.key");
+    ret = ret || nc_client_tls_set_trusted_ca_paths(NULL, BENCH_DATA_DIR);
+#else
+    (void)ctx;
+#endif /* NC_ENABLED_SSH_TLS */
+
+    /* UNIX socket endpoint */
+    unlink(UNIX_SOCKET_PATH);
+    ret = ret || nc_server_add_endpt_unix_socket_listen("unix", UNIX_SOCKET_PATH, 0700, -1, -1);
+
+    return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+    struct ly_ctx *ctx = NULL, *client_ctx = NULL;
+    int ret = 1;
+
+    if (ly_ctx_new(BENCH_MODULES_DIR, 0, &ctx) || nc_server_init_ctx(&ctx) || nc_server_config_load_modules(&ctx)) {
+        goto cleanup;
+    }
+    if (ly_ctx_new(BENCH_MODULES_DIR, 0, &client_ctx)) {
+        goto cleanup;
+    }
+    if (nc_server_init() || nc_client_init()) {
+        goto cleanup;
+    }
+    if (server_config(ctx)) {
+        fprintf(stderr, "Configuring the server failed.\n");
+        goto cleanup;
+    }
+
+    bench_start("handshake");
+    ret = run(ctx, client_ctx, "unix", 1000);
+#ifdef NC_ENABLED_SSH_TLS
+    if (!ret) {
+        ret = run(ctx, client_ctx, "ssh", 100);
+    }
+    if (!ret) {
+        ret = run(ctx, client_ctx, "tls", 200);
+    }
+#endif /* NC_ENABLED_SSH_TLS */
+
+    /* results to the file given as the argument or stdout */
+    if (!ret) {
+        ret = bench_finish((argc > 1) ? argv[1] : NULL);
+    }
+
+cleanup:
+    nc_client_destroy();
+    nc_server_destroy();
+    ly_ctx_destroy(client_ctx);
+    ly_ctx_destroy(ctx);
+    unlink(UNIX_SOCKET_PATH);
+    return ret;
+}
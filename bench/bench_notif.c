@@ -0,0 +1,203 @@
+/**
+ * @file bench_notif.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 benchmark - notification fan-out to many sessions
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+#include "bench.h"
+#include "messages_p.h"
+#include "session_p.h"
+
+#define READER_THREADS 4
+
+/* approximate count of notifications delivered for each session count */
+#define NOTIF_TOTAL 200000
+
+struct reader_arg {
+    struct nc_session **sessions;
+    uint32_t session_count;
+    uint32_t rounds;
+    int ret;
+};
+
+static void *
+reader_thread(void *arg)
+{
+    struct reader_arg *rarg = arg;
+    struct lyd_node *envp, *op;
+    uint32_t r, i;
+
+    /* the notifications are sent round by round so they can be received in the same order */
+    for (r = 0; r < rarg->rounds; ++r) {
+        for (i = 0; i < rarg->session_count; ++i) {
+            if (nc_recv_notif(rarg->sessions[i], -1, &envp, &op) != NC_MSG_NOTIF) {
+                rarg->ret = 1;
+                return NULL;
+            }
+            lyd_free_tree(envp);
+            lyd_free_tree(op);
+        }
+    }
+
+    return NULL;
+}
+
+static int
+run(struct ly_ctx *ctx, uint32_t session_count, int multi)
+{
+    struct nc_session **servers, **clients;
+    struct reader_arg rargs[READER_THREADS] = {0};
+    pthread_t tids[READER_THREADS];
+    struct lyd_node *ntf = NULL;
+    struct nc_server_notif *notif = NULL;
+    struct timespec start, ts;
+    uint32_t i, r, rounds, reader_threads, created = 0;
+    char *eventtime, params[64];
+    double t;
+    int ret = 1;
+
+    /* both sides of every session and some spare ones */
+    if (bench_fd_limit(2 * session_count + 64)) {
+        fprintf(stderr, "Not enough file descriptors for %" PRIu32 " sessions, skipping.\n", session_count);
+        return 0;
+    }
+
+    servers = calloc(session_count, sizeof *servers);
+    clients = calloc(session_count, sizeof *clients);
+    if (!servers || !clients) {
+        goto cleanup;
+    }
+
+    for (created = 0; created < session_count; ++created) {
+        if (bench_session_pair(ctx, NC_VERSION_11, &servers[created], &clients[created])) {
+            goto cleanup;
+        }
+        nc_session_inc_notif_status(servers[created]);
+    }
+
+    /* notification */
+    if (lyd_new_path(NULL, ctx, "/nc-notifications:notificationComplete", NULL, 0, &ntf)) {
+        goto cleanup;
+    }
+    clock_gettime(CLOCK_REALTIME, &ts);
+    if (ly_time_ts2str(&ts, &eventtime)) {
+        goto cleanup;
+    }
+    notif = nc_server_notif_new(ntf, eventtime, NC_PARAMTYPE_FREE);
+    if (!notif) {
+        free(eventtime);
+        goto cleanup;
+    }
+    ntf = NULL;
+
+    rounds = (session_count < NOTIF_TOTAL / 10) ? NOTIF_TOTAL / session_count : 10;
+
+    /* split the sessions between the reader threads */
+    reader_threads = (session_count < READER_THREADS) ? session_count : READER_THREADS;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < reader_threads; ++i) {
+        rargs[i].sessions = clients + (i * session_count) / reader_threads;
+        rargs[i].session_count = ((i + 1) * session_count) / reader_threads - (i * session_count) / reader_threads;
+        rargs[i].rounds = rounds;
+        pthread_create(&tids[i], NULL, reader_thread, &rargs[i]);
+    }
+
+    ret = 0;
+    for (r = 0; !ret && (r < rounds); ++r) {
+        if (multi) {
+            if (nc_server_notif_send_multi(servers, session_count, notif, -1, NULL) != (int)session_count) {
+                ret = 1;
+            }
+        } else {
+            for (i = 0; i < session_count; ++i) {
+                if (nc_server_notif_send(servers[i], notif, -1) != NC_MSG_NOTIF) {
+                    ret = 1;
+                    break;
+                }
+            }
+        }
+    }
+    if (ret) {
+        /* unblock the readers */
+        for (i = 0; i < session_count; ++i) {
+            shutdown(servers[i]->ti.fd.in, SHUT_RDWR);
+        }
+    }
+
+    for (i = 0; i < reader_threads; ++i) {
+        pthread_join(tids[i], NULL);
+        ret |= rargs[i].ret;
+    }
+    t = bench_elapsed(&start);
+
+    if (ret) {
+        fprintf(stderr, "Sending notifications to %" PRIu32 " sessions failed.\n", session_count);
+        goto cleanup;
+    }
+
+    sprintf(params, "\"sessions\": %" PRIu32 ", \"multi\": %s", session_count, multi ? "true" : "false");
+    bench_result("fan-out", params, (double)rounds * session_count / t, "notif/s");
+
+cleanup:
+    lyd_free_tree(ntf);
+    nc_server_notif_free(notif);
+    for (i = 0; i < created; ++i) {
+        bench_session_free(servers[i]);
+        bench_session_free(clients[i]);
+    }
+    free(servers);
+    free(clients);
+    return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+    const uint32_t session_counts[] = {1, 16, 256, 4096};
+    struct ly_ctx *ctx;
+    uint32_t i;
+    int ret = 0;
+
+    if (bench_ctx_new(&ctx) || nc_server_init()) {
+        return 1;
+    }
+
+    bench_start("notif");
+    for (i = 0; !ret && (i < sizeof session_counts / sizeof *session_counts); ++i) {
+        ret = run(ctx, session_counts[i], 0);
+        if (!ret) {
+            ret = run(ctx, session_counts[i], 1);
+        }
+    }
+
+    /* results to the file given as the argument or stdout */
+    if (!ret) {
+        ret = bench_finish((argc > 1) ? argv[1] : NULL);
+    }
+
+    nc_server_destroy();
+    ly_ctx_destroy(ctx);
+    return ret;
+}
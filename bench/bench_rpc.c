@@ -0,0 +1,220 @@
+/**
+ * @file bench_rpc.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 benchmark - RPC round trips with many sessions
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libyang/libyang.h>
+
+#include "bench.h"
+#include "messages_p.h"
+#include "session_p.h"
+
+#define SERVER_THREADS 4
+#define CLIENT_THREADS 4
+#define DURATION_S 2.0
+
+struct client_arg {
+    struct nc_session **sessions;
+    uint32_t session_count;
+    uint64_t rpcs;
+    int ret;
+};
+
+static struct nc_pollsession *ps;
+static ATOMIC_T stop;
+
+static struct nc_server_reply *
+rpc_clb(struct lyd_node *rpc, struct nc_session *session)
+{
+    (void)rpc;
+    (void)session;
+
+    return nc_server_reply_ok();
+}
+
+static void *
+server_thread(void *arg)
+{
+    (void)arg;
+
+    while (!ATOMIC_LOAD_RELAXED(stop)) {
+        nc_ps_poll(ps, 100, NULL);
+    }
+
+    return NULL;
+}
+
+static void *
+client_thread(void *arg)
+{
+    struct client_arg *carg = arg;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op;
+    struct timespec start;
+    uint64_t msgids[carg->session_count];
+    uint32_t i;
+
+    rpc = nc_rpc_get(NULL, NC_WD_UNKNOWN, NC_PARAMTYPE_CONST);
+    if (!rpc) {
+        carg->ret = 1;
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        /* one outstanding RPC on every session */
+        for (i = 0; i < carg->session_count; ++i) {
+            if (nc_send_rpc(carg->sessions[i], rpc, -1, &msgids[i]) != NC_MSG_RPC) {
+                carg->ret = 1;
+                goto cleanup;
+            }
+        }
+        for (i = 0; i < carg->session_count; ++i) {
+            if (nc_recv_reply(carg->sessions[i], rpc, msgids[i], -1, &envp, &op) != NC_MSG_REPLY) {
+                carg->ret = 1;
+                goto cleanup;
+            }
+            lyd_free_tree(envp);
+        }
+        carg->rpcs += carg->session_count;
+    } while (bench_elapsed(&start) < DURATION_S);
+
+cleanup:
+    nc_rpc_free(rpc);
+    return NULL;
+}
+
+static int
+run(struct ly_ctx *ctx, uint32_t session_count)
+{
+    struct nc_session **servers, **clients;
+    struct client_arg cargs[CLIENT_THREADS] = {0};
+    pthread_t server_tids[SERVER_THREADS], client_tids[CLIENT_THREADS];
+    struct timespec start;
+    uint32_t i, client_threads, created = 0;
+    uint64_t rpcs = 0;
+    char params[32];
+    double t;
+    int ret = 1;
+
+    /* both sides of every session and some spare ones */
+    if (bench_fd_limit(2 * session_count + 64)) {
+        fprintf(stderr, "Not enough file descriptors for %" PRIu32 " sessions, skipping.\n", session_count);
+        return 0;
+    }
+
+    servers = calloc(session_count, sizeof *servers);
+    clients = calloc(session_count, sizeof *clients);
+    ps = nc_ps_new_epoll();
+    if (!ps) {
+        ps = nc_ps_new();
+    }
+    if (!servers || !clients || !ps) {
+        goto cleanup;
+    }
+
+    for (created = 0; created < session_count; ++created) {
+        if (bench_session_pair(ctx, NC_VERSION_11, &servers[created], &clients[created])) {
+            goto cleanup;
+        }
+        if (nc_ps_add_session(ps, servers[created])) {
+            bench_session_free(servers[created]);
+            bench_session_free(clients[created]);
+            goto cleanup;
+        }
+    }
+
+    ATOMIC_STORE_RELAXED(stop, 0);
+    for (i = 0; i < SERVER_THREADS; ++i) {
+        pthread_create(&server_tids[i], NULL, server_thread, NULL);
+    }
+
+    /* split the sessions between the client threads */
+    client_threads = (session_count < CLIENT_THREADS) ? session_count : CLIENT_THREADS;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < client_threads; ++i) {
+        cargs[i].sessions = clients + (i * session_count) / client_threads;
+        cargs[i].session_count = ((i + 1) * session_count) / client_threads - (i * session_count) / client_threads;
+        pthread_create(&client_tids[i], NULL, client_thread, &cargs[i]);
+    }
+
+    ret = 0;
+    for (i = 0; i < client_threads; ++i) {
+        pthread_join(client_tids[i], NULL);
+        rpcs += cargs[i].rpcs;
+        ret |= cargs[i].ret;
+    }
+    t = bench_elapsed(&start);
+
+    ATOMIC_STORE_RELAXED(stop, 1);
+    for (i = 0; i < SERVER_THREADS; ++i) {
+        pthread_join(server_tids[i], NULL);
+    }
+
+    if (ret) {
+        fprintf(stderr, "RPC exchange with %" PRIu32 " sessions failed.\n", session_count);
+        goto cleanup;
+    }
+
+    sprintf(params, "\"sessions\": %" PRIu32, session_count);
+    bench_result("round-trips", params, rpcs / t, "rpc/s");
+
+cleanup:
+    for (i = 0; i < created; ++i) {
+        nc_ps_del_session(ps, servers[i]);
+        bench_session_free(servers[i]);
+        bench_session_free(clients[i]);
+    }
+    nc_ps_free(ps);
+    free(servers);
+    free(clients);
+    return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+    const uint32_t session_counts[] = {1, 16, 256, 4096};
+    struct ly_ctx *ctx;
+    uint32_t i;
+    int ret = 0;
+
+    if (bench_ctx_new(&ctx) || nc_server_init()) {
+        return 1;
+    }
+    nc_set_global_rpc_clb(rpc_clb);
+
+    bench_start("rpc");
+    for (i = 0; !ret && (i < sizeof session_counts / sizeof *session_counts); ++i) {
+        ret = run(ctx, session_counts[i]);
+    }
+
+    /* results to the file given as the argument or stdout */
+    if (!ret) {
+        ret = bench_finish((argc > 1) ? argv[1] : NULL);
+    }
+
+    nc_server_destroy();
+    ly_ctx_destroy(ctx);
+    return ret;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file bench_xml_escape.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 benchmark - escaping of XML content data
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "session_p.h"
+
+#define DATA_SIZE (4 * 1024 * 1024)
+#define OUT_BUFSIZE (32 * 512)
+#define ROUNDS 20
+
+/**
+ * @brief Escape data the way it was done before, byte by byte, into a buffer "flushed" when full.
+ */
+static uint64_t
+escape_bytewise(const char *buf, uint32_t count, char *out)
+{
+    uint64_t total = 0;
+    uint32_t l, len = 0;
+
+    for (l = 0; l < count; l++) {
+        if (len + 5 >= OUT_BUFSIZE) {
+            total += len;
+            len = 0;
+        }
+
+        switch (buf[l]) {
+        case '&':
+            memcpy(&out[len], "&amp;", 5);
+            len += 5;
+            break;
+        case '<':
+            memcpy(&out[len], "&lt;", 4);
+            len += 4;
+            break;
+        case '>':
+            memcpy(&out[len], "&gt;", 4);
+            len += 4;
+            break;
+        default:
+            memcpy(&out[len], &buf[l], 1);
+            len++;
+        }
+    }
+
+    return total + len;
+}
+
+/**
+ * @brief Escape data using the bulk escaper into a buffer "flushed" when full.
+ */
+static uint64_t
+escape_bulk(const char *buf, uint32_t count, char *out)
+{
+    uint64_t total = 0;
+    uint32_t l = 0, len = 0;
+
+    while (1) {
+        len += nc_xml_escape(buf, count, &l, out + len, OUT_BUFSIZE - len);
+        if (l == count) {
+            break;
+        }
+        total += len;
+        len = 0;
+    }
+
+    return total + len;
+}
+
+static void
+run(uint32_t density, const char *data, char *out)
+{
+    struct timespec start;
+    char params[32];
+    uint64_t len_byte = 0, len_bulk = 0;
+    double t_byte, t_bulk;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < ROUNDS; ++i) {
+        len_byte += escape_bytewise(data, DATA_SIZE, out);
+    }
+    t_byte = bench_elapsed(&start);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < ROUNDS; ++i) {
+        len_bulk += escape_bulk(data, DATA_SIZE, out);
+    }
+    t_bulk = bench_elapsed(&start);
+
+    if (len_byte != len_bulk) {
+        fprintf(stderr, "Escaped lengths differ (%" PRIu64 " != %" PRIu64 ").\n", len_byte, len_bulk);
+        exit(1);
+    }
+
+    /* density 0 means no special characters */
+    sprintf(params, "\"special-density\": %" PRIu32, density);
+    bench_result("bytewise", params, (double)DATA_SIZE * ROUNDS / t_byte / 1e6, "MB/s");
+    bench_result("bulk", params, (double)DATA_SIZE * ROUNDS / t_bulk / 1e6, "MB/s");
+}
+
+int
+main(int argc, char **argv)
+{
+    const char special[] = "&<>";
+    const uint32_t densities[] = {0, 10000, 1000, 100, 10};
+    char *data, *out;
+    uint32_t i, j;
+    int ret;
+
+    data = malloc(DATA_SIZE);
+    out = malloc(OUT_BUFSIZE);
+    if (!data || !out) {
+        return 1;
+    }
+
+    bench_start("xml_escape");
+    srand(42);
+    for (i = 0; i < sizeof densities / sizeof *densities; ++i) {
+        /* printable data with a special character once every density bytes on average */
+        for (j = 0; j < DATA_SIZE; ++j) {
+            if (densities[i] && !(rand() % densities[i])) {
+                data[j] = special[rand() % 3];
+            } else {
+                data[j] = 'a' + rand() % 26;
+            }
+        }
+        run(densities[i], data, out);
+    }
+
+    /* results to the file given as the argument or stdout */
+    ret = bench_finish((argc > 1) ? argv[1] : NULL);
+
+    free(data);
+    free(out);
+    return ret;
+}
@@ -14,7 +14,7 @@
  *     https://opensource.org/licenses/BSD-3-Clause
  */
 
-#define _GNU_SOURCE /* asprintf, signals */
+#define _GNU_SOURCE /* asprintf, memmem, signals */
 
 #include <assert.h>
 #include <errno.h>
@@ -24,10 +24,16 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <time.h>
 #include <unistd.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+#endif
+
 #include <libyang/libyang.h>
 
 #include "compat.h"
@@ -39,6 +45,8 @@
 #include "session_p.h"
 #include "session_wrapper.h"
 
+extern struct nc_server_opts server_opts;
+
 const char *nc_msgtype2str[] = {
     "error",
     "would block",
@@ -52,17 +60,96 @@ const char *nc_msgtype2str[] = {
 };
 
 #define BUFFERSIZE 512
+#define READ_BUFSIZE (32 * BUFFERSIZE)
+#define CHUNK_SIZE_MAXLEN 10 /* digits of the maximum chunk-size 4294967295 */
+
+/**
+ * @brief Wait until a NETCONF session transport is ready for reading or writing.
+ *
+ * @param[in] session Session to wait on.
+ * @param[in] write Whether to wait until writing is possible, reading otherwise.
+ * @param[in] timeout_ms Timeout in msec, -1 for infinite.
+ * @return 1 if the transport may be ready, the following read/write learns the details;
+ * @return 0 on timeout;
+ * @return -1 on error.
+ */
+static int
+nc_io_wait(struct nc_session *session, int write, int timeout_ms)
+{
+    struct pollfd fds = {0};
+    int r;
+
+    switch (session->ti_type) {
+    case NC_TI_FD:
+        fds.fd = write ? session->ti.fd.out : session->ti.fd.in;
+        fds.events = write ? POLLOUT : POLLIN;
+        break;
+    case NC_TI_UNIX:
+        fds.fd = session->ti.unixsock.sock;
+        fds.events = write ? POLLOUT : POLLIN;
+        break;
+#ifdef NC_ENABLED_SSH_TLS
+    case NC_TI_SSH:
+        if (!write) {
+            /* libssh processes the packets of all the channels, wait for data of this one */
+            r = ssh_channel_poll_timeout(session->ti.libssh.channel, timeout_ms, 0);
+            return r ? 1 : 0;
+        }
+
+        /* remote window exhausted, wait for its adjustment and for any buffered data to be flushed */
+        fds.fd = ssh_get_fd(session->ti.libssh.session);
+        fds.events = POLLIN;
+        if (ssh_get_status(session->ti.libssh.session) & SSH_WRITE_PENDING) {
+            fds.events |= POLLOUT;
+        }
+        break;
+    case NC_TI_TLS:
+        /* TLS may need to write when reading and vice versa */
+        fds.fd = nc_tls_get_fd_wrap(session);
+        fds.events = nc_tls_want_write_wrap(session) ? POLLOUT : POLLIN;
+        break;
+#endif /* NC_ENABLED_SSH_TLS */
+    default:
+        ERRINT;
+        return -1;
+    }
+
+    if (fds.fd < 0) {
+        ERRINT;
+        return -1;
+    }
 
+    r = nc_poll(&fds, 1, timeout_ms);
+    if (r < 0) {
+        return -1;
+    }
+    return r ? 1 : 0;
+}
+
+/**
+ * @brief Read from a NETCONF session.
+ *
+ * @param[in] session Session to read from.
+ * @param[in] buf Buffer to read into.
+ * @param[in] min Minimum count of bytes to read, waits until they are available, 0 to never wait.
+ * @param[in] count Maximum count of bytes to read into @p buf.
+ * @param[in] inact_timeout Inactive timeout in msec.
+ * @param[in] ts_act_timeout Absolute active timeout.
+ * @return Number of bytes read.
+ * @return -1 on error.
+ */
 static ssize_t
-nc_read(struct nc_session *session, char *buf, uint32_t count, uint32_t inact_timeout, struct timespec *ts_act_timeout)
+nc_read(struct nc_session *session, char *buf, uint32_t min, uint32_t count, uint32_t inact_timeout,
+        struct timespec *ts_act_timeout)
 {
     uint32_t readd = 0;
     ssize_t r = -1;
-    int fd, interrupted;
+    int fd, interrupted, wait_ms;
     struct timespec ts_inact_timeout;
 
     assert(session);
     assert(buf);
+    assert(min <= count);
 
     if ((session->status != NC_STATUS_RUNNING) && (session->status != NC_STATUS_STARTING)) {
         return -1;
@@ -141,8 +228,21 @@ nc_read(struct nc_session *session, char *buf, uint32_t count, uint32_t inact_ti
 
         if (r == 0) {
             /* nothing read */
+            if (!min) {
+                /* not waiting for any data */
+                break;
+            }
             if (!interrupted) {
-                usleep(NC_TIMEOUT_STEP);
+                /* wait for more data, but not longer than until any of the timeouts elapses */
+                wait_ms = nc_timeouttime_cur_diff(&ts_inact_timeout);
+                if (nc_timeouttime_cur_diff(ts_act_timeout) < wait_ms) {
+                    wait_ms = nc_timeouttime_cur_diff(ts_act_timeout);
+                }
+                if ((wait_ms > 0) && (nc_io_wait(session, 0, wait_ms) == -1)) {
+                    session->status = NC_STATUS_INVALID;
+                    session->term_reason = NC_SESSION_TERM_OTHER;
+                    return -1;
+                }
             }
             if ((nc_timeouttime_cur_diff(&ts_inact_timeout) < 1) || (nc_timeouttime_cur_diff(ts_act_timeout) < 1)) {
                 if (nc_timeouttime_cur_diff(&ts_inact_timeout) < 1) {
@@ -157,121 +257,338 @@ nc_read(struct nc_session *session, char *buf, uint32_t count, uint32_t inact_ti
         } else {
             /* something read */
             readd += r;
+            if (session->side == NC_SERVER) {
+                NC_STATS_ADD(session, in_bytes, r);
+            }
 
             /* reset inactive timeout */
             nc_timeouttime_get(&ts_inact_timeout, inact_timeout);
         }
 
-    } while (readd < count);
-    buf[count] = '\0';
+    } while (readd < min);
 
     return (ssize_t)readd;
 }
 
+/**
+ * @brief Read another block of data into the session receive buffer.
+ *
+ * Reads all the data available at once (up to the free space in the buffer), at least @p min bytes.
+ * Any unprocessed buffered data are kept.
+ *
+ * @param[in] session Session to read from.
+ * @param[in] min Minimum count of bytes to read, 0 to never wait.
+ * @param[in] inact_timeout Inactive timeout in msec.
+ * @param[in] ts_act_timeout Absolute active timeout.
+ * @return Number of bytes read.
+ * @return -1 on error.
+ */
 static ssize_t
-nc_read_chunk(struct nc_session *session, size_t len, uint32_t inact_timeout, struct timespec *ts_act_timeout, char **chunk)
+nc_read_buf_fill(struct nc_session *session, uint32_t min, uint32_t inact_timeout, struct timespec *ts_act_timeout)
 {
+    struct nc_rbuf *rbuf = &session->rbuf;
     ssize_t r;
 
+    if (!rbuf->data) {
+        rbuf->data = malloc(READ_BUFSIZE);
+        NC_CHECK_ERRMEM_RET(!rbuf->data, -1);
+        rbuf->start = 0;
+        rbuf->len = 0;
+    } else if (rbuf->start) {
+        /* move the unprocessed data to the beginning of the buffer */
+        memmove(rbuf->data, rbuf->data + rbuf->start, rbuf->len);
+        rbuf->start = 0;
+    }
+
+    /* the buffered data are always consumed before more are read */
+    assert(rbuf->len < READ_BUFSIZE);
+
+    r = nc_read(session, rbuf->data + rbuf->len, min, READ_BUFSIZE - rbuf->len, inact_timeout, ts_act_timeout);
+    if (r < 0) {
+        return -1;
+    }
+    rbuf->len += r;
+
+    return r;
+}
+
+/**
+ * @brief Consume data from the session receive buffer.
+ *
+ * @param[in] session Session with the buffer.
+ * @param[in] buf Buffer to copy the data into, NULL to discard them.
+ * @param[in] count Count of bytes to consume, must be buffered.
+ */
+static void
+nc_read_buf_consume(struct nc_session *session, char *buf, uint32_t count)
+{
+    struct nc_rbuf *rbuf = &session->rbuf;
+
+    assert(count <= rbuf->len);
+
+    if (buf) {
+        memcpy(buf, rbuf->data + rbuf->start, count);
+    }
+    rbuf->len -= count;
+    if (rbuf->len) {
+        rbuf->start += count;
+    } else {
+        rbuf->start = 0;
+    }
+}
+
+/**
+ * @brief Read a chunk of data of a known length.
+ *
+ * @param[in] session Session to read from.
+ * @param[in] buf Buffer to read the chunk into, must be large enough to hold it.
+ * @param[in] len Length of the chunk.
+ * @param[in] inact_timeout Inactive timeout in msec.
+ * @param[in] ts_act_timeout Absolute active timeout.
+ * @return 0 on success.
+ * @return -1 on error.
+ */
+static int
+nc_read_chunk(struct nc_session *session, char *buf, uint32_t len, uint32_t inact_timeout, struct timespec *ts_act_timeout)
+{
+    uint32_t buffered;
+
     assert(session);
-    assert(chunk);
+    assert(buf);
 
-    if (!len) {
-        return 0;
+    /* use the buffered data first */
+    buffered = (len < session->rbuf.len) ? len : session->rbuf.len;
+    nc_read_buf_consume(session, buf, buffered);
+
+    if (buffered < len) {
+        /* read the rest of the chunk directly */
+        if (nc_read(session, buf + buffered, len - buffered, len - buffered, inact_timeout, ts_act_timeout) < 1) {
+            return -1;
+        }
     }
 
-    *chunk = malloc((len + 1) * sizeof **chunk);
-    NC_CHECK_ERRMEM_RET(!*chunk, -1);
+    return 0;
+}
 
-    r = nc_read(session, *chunk, len, inact_timeout, ts_act_timeout);
-    if (r <= 0) {
-        free(*chunk);
-        return -1;
+/**
+ * @brief Read a chunk header of the chunked framing mechanism, the leading "\n#" must have already been read.
+ *
+ * @param[in] session Session to read from.
+ * @param[in] inact_timeout Inactive timeout in msec.
+ * @param[in] ts_act_timeout Absolute active timeout.
+ * @param[out] chunk_len Length of the following chunk.
+ * @return 1 if a chunk of @p chunk_len follows.
+ * @return 0 on end-of-chunks.
+ * @return -1 on error.
+ * @return -2 on malformed chunk header.
+ */
+static int
+nc_read_chunk_header(struct nc_session *session, uint32_t inact_timeout, struct timespec *ts_act_timeout,
+        uint32_t *chunk_len)
+{
+    struct nc_rbuf *rbuf = &session->rbuf;
+    char *hdr, *nl = NULL, *end;
+    unsigned long long size;
+
+    /* make sure the whole header is buffered */
+    while (!rbuf->len || !(nl = memchr(rbuf->data + rbuf->start, '\n',
+            (rbuf->len < CHUNK_SIZE_MAXLEN + 1) ? rbuf->len : CHUNK_SIZE_MAXLEN + 1))) {
+        if (rbuf->len > CHUNK_SIZE_MAXLEN) {
+            ERR(session, "Invalid frame chunk size detected, fatal error.");
+            return -2;
+        }
+
+        if (nc_read_buf_fill(session, 1, inact_timeout, ts_act_timeout) == -1) {
+            return -1;
+        }
     }
+    hdr = rbuf->data + rbuf->start;
 
-    /* terminating null byte */
-    (*chunk)[r] = 0;
+    if ((nl == hdr + 1) && (hdr[0] == '#')) {
+        /* end of chunks */
+        nc_read_buf_consume(session, NULL, 2);
+        return 0;
+    }
 
-    return r;
+    /* chunk-size = 1*DIGIT1 0*DIGIT (RFC 6242 sec. 4.2) */
+    if ((hdr[0] < '1') || (hdr[0] > '9')) {
+        ERR(session, "Invalid frame chunk size detected, fatal error.");
+        return -2;
+    }
+    errno = 0;
+    size = strtoull(hdr, &end, 10);
+    if (errno || (end != nl) || (size > UINT32_MAX)) {
+        ERR(session, "Invalid frame chunk size detected, fatal error.");
+        return -2;
+    }
+    nc_read_buf_consume(session, NULL, nl - hdr + 1);
+
+    *chunk_len = size;
+    return 1;
 }
 
 static ssize_t
 nc_read_until(struct nc_session *session, const char *endtag, size_t limit, uint32_t inact_timeout,
         struct timespec *ts_act_timeout, char **result)
 {
-    char *chunk = NULL;
-    size_t size, count = 0, r, len, i, matched = 0;
+    char *chunk = NULL, *match;
+    size_t size = 0, count = 0, len, n;
+    struct nc_rbuf *rbuf = &session->rbuf;
 
     assert(session);
     assert(endtag);
 
-    if (limit && (limit < BUFFERSIZE)) {
-        size = limit;
-    } else {
-        size = BUFFERSIZE;
-    }
-    chunk = malloc((size + 1) * sizeof *chunk);
-    NC_CHECK_ERRMEM_RET(!chunk, -1);
-
     len = strlen(endtag);
     while (1) {
-        if (limit && (count == limit)) {
+        /* look for the end tag in the buffered data */
+        match = rbuf->len ? memmem(rbuf->data + rbuf->start, rbuf->len, endtag, len) : NULL;
+        if (match) {
+            /* take everything up to and including the end tag */
+            n = (match - (rbuf->data + rbuf->start)) + len;
+        } else if (rbuf->len >= len) {
+            /* take everything but the last bytes that can be a beginning of the end tag */
+            n = rbuf->len - (len - 1);
+        } else {
+            n = 0;
+        }
+
+        if (limit && (count + n > limit)) {
             free(chunk);
             WRN(session, "Reading limit (%d) reached.", limit);
             ERR(session, "Invalid input data (missing \"%s\" sequence).", endtag);
             return -1;
         }
 
-        /* resize buffer if needed */
-        if ((count + (len - matched)) >= size) {
-            /* get more memory */
-            size = size + BUFFERSIZE;
-            chunk = nc_realloc(chunk, (size + 1) * sizeof *chunk);
-            NC_CHECK_ERRMEM_RET(!chunk, -1);
+        if (n) {
+            if (result && (count + n + 1 > size)) {
+                /* get more memory */
+                if (!size) {
+                    size = BUFFERSIZE;
+                }
+                while (count + n + 1 > size) {
+                    size *= 2;
+                }
+                chunk = nc_realloc(chunk, size * sizeof *chunk);
+                NC_CHECK_ERRMEM_RET(!chunk, -1);
+            }
+
+            nc_read_buf_consume(session, result ? chunk + count : NULL, n);
+            count += n;
+        }
+
+        /* whole endtag found */
+        if (match) {
+            break;
         }
 
-        /* get another character */
-        r = nc_read(session, &(chunk[count]), len - matched, inact_timeout, ts_act_timeout);
-        if (r != len - matched) {
+        /* read another block */
+        if (nc_read_buf_fill(session, 1, inact_timeout, ts_act_timeout) == -1) {
             free(chunk);
             return -1;
         }
+    }
 
-        count += len - matched;
+    if (result) {
+        /* terminating null byte */
+        chunk[count] = 0;
+        *result = chunk;
+    }
+    return count;
+}
 
-        for (i = len - matched; i > 0; i--) {
-            if (!strncmp(&endtag[matched], &(chunk[count - i]), i)) {
-                /*part of endtag found */
-                matched += i;
-                break;
-            } else {
-                matched = 0;
-            }
+/**
+ * @brief Read data up to an end tag, passing them to a callback instead of buffering them.
+ *
+ * @param[in] session Session to read from.
+ * @param[in] endtag End tag to read until, it is consumed but not passed to @p read_clb.
+ * @param[in] inact_timeout Inactive timeout in msec.
+ * @param[in] ts_act_timeout Absolute active timeout.
+ * @param[in] read_clb Callback for the read data.
+ * @param[in] user_data Arbitrary user data passed to @p read_clb.
+ * @return 0 on success.
+ * @return -1 on error.
+ */
+static int
+nc_read_until_clb(struct nc_session *session, const char *endtag, uint32_t inact_timeout, struct timespec *ts_act_timeout,
+        nc_read_clb read_clb, void *user_data)
+{
+    struct nc_rbuf *rbuf = &session->rbuf;
+    char *match;
+    size_t len, n;
+
+    len = strlen(endtag);
+    while (1) {
+        /* look for the end tag in the buffered data */
+        match = rbuf->len ? memmem(rbuf->data + rbuf->start, rbuf->len, endtag, len) : NULL;
+        if (match) {
+            /* pass everything up to the end tag */
+            n = match - (rbuf->data + rbuf->start);
+        } else if (rbuf->len >= len) {
+            /* pass everything but the last bytes that can be a beginning of the end tag */
+            n = rbuf->len - (len - 1);
+        } else {
+            n = 0;
         }
 
-        /* whole endtag found */
-        if (matched == len) {
-            break;
+        if (n) {
+            read_clb(rbuf->data + rbuf->start, n, user_data);
+            nc_read_buf_consume(session, NULL, n);
+        }
+
+        if (match) {
+            /* skip the end tag */
+            nc_read_buf_consume(session, NULL, len);
+            return 0;
+        }
+
+        /* read another block */
+        if (nc_read_buf_fill(session, 1, inact_timeout, ts_act_timeout) == -1) {
+            return -1;
         }
     }
+}
 
-    /* terminating null byte */
-    chunk[count] = 0;
+/**
+ * @brief Read a chunk of data of a known length, passing it to a callback as it is read.
+ *
+ * @param[in] session Session to read from.
+ * @param[in] len Length of the chunk.
+ * @param[in] inact_timeout Inactive timeout in msec.
+ * @param[in] ts_act_timeout Absolute active timeout.
+ * @param[in] read_clb Callback for the read data.
+ * @param[in] user_data Arbitrary user data passed to @p read_clb.
+ * @return 0 on success.
+ * @return -1 on error.
+ */
+static int
+nc_read_chunk_clb(struct nc_session *session, uint32_t len, uint32_t inact_timeout, struct timespec *ts_act_timeout,
+        nc_read_clb read_clb, void *user_data)
+{
+    struct nc_rbuf *rbuf = &session->rbuf;
+    uint32_t n;
 
-    if (result) {
-        *result = chunk;
-    } else {
-        free(chunk);
+    while (len) {
+        if (!rbuf->len && (nc_read_buf_fill(session, 1, inact_timeout, ts_act_timeout) == -1)) {
+            return -1;
+        }
+
+        /* pass the buffered part of the chunk */
+        n = (len < rbuf->len) ? len : rbuf->len;
+        read_clb(rbuf->data + rbuf->start, n, user_data);
+        nc_read_buf_consume(session, NULL, n);
+        len -= n;
     }
-    return count;
+
+    return 0;
 }
 
 int
 nc_read_msg_io(struct nc_session *session, int io_timeout, struct ly_in **msg, int passing_io_lock)
 {
     int ret = 1, r, io_locked = passing_io_lock;
-    char *data = NULL, *chunk;
-    uint64_t chunk_len, len = 0;
+    char *data = NULL;
+    uint32_t chunk_len, chunk_count = 0, alloc_count = 0;
+    size_t len = 0, size = 0;
     /* use timeout in milliseconds instead seconds */
     uint32_t inact_timeout = NC_READ_INACT_TIMEOUT * 1000;
     struct timespec ts_act_timeout;
@@ -306,7 +623,8 @@ nc_read_msg_io(struct nc_session *session, int io_timeout, struct ly_in **msg, i
         }
 
         /* cut off the end tag */
-        data[r - NC_VERSION_10_ENDTAG_LEN] = '\0';
+        len = r - NC_VERSION_10_ENDTAG_LEN;
+        data[len] = '\0';
         break;
     case NC_VERSION_11:
         while (1) {
@@ -315,15 +633,12 @@ nc_read_msg_io(struct nc_session *session, int io_timeout, struct ly_in **msg, i
                 ret = r;
                 goto cleanup;
             }
-            r = nc_read_until(session, "\n", 0, inact_timeout, &ts_act_timeout, &chunk);
-            if (r == -1) {
+            r = nc_read_chunk_header(session, inact_timeout, &ts_act_timeout, &chunk_len);
+            if (r < 0) {
                 ret = r;
                 goto cleanup;
-            }
-
-            if (!strcmp(chunk, "#\n")) {
+            } else if (!r) {
                 /* end of chunked framing message */
-                free(chunk);
                 if (!data) {
                     ERR(session, "Invalid frame chunk delimiters.");
                     ret = -2;
@@ -332,31 +647,30 @@ nc_read_msg_io(struct nc_session *session, int io_timeout, struct ly_in **msg, i
                 break;
             }
 
-            /* convert string to the size of the following chunk */
-            chunk_len = strtoul(chunk, (char **)NULL, 10);
-            free(chunk);
-            if (!chunk_len) {
-                ERR(session, "Invalid frame chunk size detected, fatal error.");
-                ret = -2;
-                goto cleanup;
+            /* make room for the chunk in the message buffer, remember to count terminating null byte */
+            if (len + chunk_len + 1 > size) {
+                size = (2 * size > len + chunk_len + 1) ? 2 * size : len + chunk_len + 1;
+                data = nc_realloc(data, size);
+                NC_CHECK_ERRMEM_GOTO(!data, ret = -1, cleanup);
+                ++alloc_count;
             }
 
-            /* now we have size of next chunk, so read the chunk */
-            r = nc_read_chunk(session, chunk_len, inact_timeout, &ts_act_timeout, &chunk);
-            if (r == -1) {
-                ret = r;
+            /* read the chunk directly into the message buffer */
+            if (nc_read_chunk(session, data + len, chunk_len, inact_timeout, &ts_act_timeout)) {
+                ret = -1;
                 goto cleanup;
             }
-
-            /* realloc message buffer, remember to count terminating null byte */
-            data = nc_realloc(data, len + chunk_len + 1);
-            NC_CHECK_ERRMEM_GOTO(!data, ret = -1, cleanup);
-            memcpy(data + len, chunk, chunk_len);
             len += chunk_len;
-            data[len] = '\0';
-            free(chunk);
+            ++chunk_count;
         }
+        data[len] = '\0';
 
+        DBG(session, "Received message of %zu bytes in %" PRIu32 " chunks (%" PRIu32 " buffer allocations).", len,
+                chunk_count, alloc_count);
+        if (session->side == NC_SERVER) {
+            NC_STATS_INC(session, in_chunked_msgs);
+            NC_STATS_ADD(session, in_chunked_msg_allocs, alloc_count);
+        }
         break;
     }
 
@@ -383,6 +697,58 @@ cleanup:
     return ret;
 }
 
+int
+nc_read_msg_ready_io(struct nc_session *session)
+{
+    struct nc_rbuf *rbuf = &session->rbuf;
+    struct timespec ts_act_timeout;
+    ssize_t r;
+    int ret;
+
+    assert(session->version == NC_VERSION_10);
+
+    if ((session->status != NC_STATUS_RUNNING) && (session->status != NC_STATUS_STARTING)) {
+        ERR(session, "Invalid session to read from.");
+        return -1;
+    }
+
+    /* SESSION IO LOCK */
+    ret = nc_session_io_lock(session, 0, __func__);
+    if (ret < 1) {
+        return ret;
+    }
+
+    /* never waited for */
+    nc_timeouttime_get(&ts_act_timeout, 0);
+
+    while (1) {
+        if (rbuf->len && memmem(rbuf->data + rbuf->start, rbuf->len, NC_VERSION_10_ENDTAG, NC_VERSION_10_ENDTAG_LEN)) {
+            /* whole message received */
+            ret = 1;
+            break;
+        } else if (rbuf->len == READ_BUFSIZE) {
+            /* too long to be buffered, the rest is waited for when reading it */
+            ret = 1;
+            break;
+        }
+
+        /* read all the available data, the transports buffer them too */
+        r = nc_read_buf_fill(session, 0, 0, &ts_act_timeout);
+        if (r < 0) {
+            ret = -1;
+            break;
+        } else if (!r) {
+            ret = 0;
+            break;
+        }
+    }
+
+    /* SESSION IO UNLOCK */
+    nc_session_io_unlock(session, __func__);
+
+    return ret;
+}
+
 /* return -1 means either poll error or that session was invalidated (socket error), EINTR is handled inside */
 static int
 nc_read_poll(struct nc_session *session, int io_timeout)
@@ -395,6 +761,11 @@ nc_read_poll(struct nc_session *session, int io_timeout)
         return -1;
     }
 
+    if (session->rbuf.len) {
+        /* some data of a previous read are still buffered */
+        return 1;
+    }
+
     switch (session->ti_type) {
 #ifdef NC_ENABLED_SSH_TLS
     case NC_TI_SSH:
@@ -505,8 +876,82 @@ nc_read_msg_poll_io(struct nc_session *session, int io_timeout, struct ly_in **m
         return ret;
     }
 
-    /* SESSION IO LOCK passed down */
-    return nc_read_msg_io(session, io_timeout, msg, 1);
+    /* SESSION IO LOCK passed down */
+    return nc_read_msg_io(session, io_timeout, msg, 1);
+}
+
+int
+nc_read_msg_poll_clb_io(struct nc_session *session, int io_timeout, nc_read_clb read_clb, void *user_data)
+{
+    int ret, r;
+    uint32_t chunk_len, chunk_count = 0;
+    /* use timeout in milliseconds instead seconds */
+    uint32_t inact_timeout = NC_READ_INACT_TIMEOUT * 1000;
+    struct timespec ts_act_timeout;
+
+    assert(session && read_clb);
+
+    if ((session->status != NC_STATUS_RUNNING) && (session->status != NC_STATUS_STARTING)) {
+        ERR(session, "Invalid session to read from.");
+        return -1;
+    }
+
+    /* SESSION IO LOCK */
+    ret = nc_session_io_lock(session, io_timeout, __func__);
+    if (ret < 1) {
+        return ret;
+    }
+
+    ret = nc_read_poll(session, io_timeout);
+    if (ret < 1) {
+        /* timed out or error */
+        goto cleanup;
+    }
+
+    nc_timeouttime_get(&ts_act_timeout, NC_READ_ACT_TIMEOUT * 1000);
+
+    /* read the message, pass its data on as they are read */
+    switch (session->version) {
+    case NC_VERSION_10:
+        if (nc_read_until_clb(session, NC_VERSION_10_ENDTAG, inact_timeout, &ts_act_timeout, read_clb, user_data)) {
+            ret = -1;
+            goto cleanup;
+        }
+        break;
+    case NC_VERSION_11:
+        while (1) {
+            r = nc_read_until(session, "\n#", 0, inact_timeout, &ts_act_timeout, NULL);
+            if (r == -1) {
+                ret = r;
+                goto cleanup;
+            }
+            r = nc_read_chunk_header(session, inact_timeout, &ts_act_timeout, &chunk_len);
+            if (r < 0) {
+                ret = r;
+                goto cleanup;
+            } else if (!r) {
+                /* end of chunked framing message */
+                if (!chunk_count) {
+                    ERR(session, "Invalid frame chunk delimiters.");
+                    ret = -2;
+                    goto cleanup;
+                }
+                break;
+            }
+
+            if (nc_read_chunk_clb(session, chunk_len, inact_timeout, &ts_act_timeout, read_clb, user_data)) {
+                ret = -1;
+                goto cleanup;
+            }
+            ++chunk_count;
+        }
+        break;
+    }
+
+cleanup:
+    /* SESSION IO UNLOCK */
+    nc_session_io_unlock(session, __func__);
+    return ret;
 }
 
 /* does not really log, only fatal errors */
@@ -552,53 +997,140 @@ nc_session_is_connected(const struct nc_session *session)
 }
 
 #define WRITE_BUFSIZE (2 * BUFFERSIZE)
+#define WRITE_STARTTAG_MAXLEN (3 + CHUNK_SIZE_MAXLEN) /* "\n#4294967295\n" */
+#define WRITE_ENDTAG_MAXLEN 6 /* "]]>]]>" */
 struct nc_wclb_arg {
     struct nc_session *session;
-    char buf[WRITE_BUFSIZE];
-    uint32_t len;
+    char buf[WRITE_STARTTAG_MAXLEN + WRITE_BUFSIZE + WRITE_ENDTAG_MAXLEN]; /**< start tag space, data, end tag space */
+    uint32_t len;   /**< length of the buffered data (after the start tag space) */
+    int flushed;    /**< whether any data were already written to the session */
 };
 
+/**
+ * @brief Learn that a session was dropped by the other side while writing.
+ *
+ * @param[in] session Session that was dropped.
+ */
+static void
+nc_write_dropped(struct nc_session *session)
+{
+    ERR(session, "Communication socket unexpectedly closed.");
+    session->status = NC_STATUS_INVALID;
+    session->term_reason = NC_SESSION_TERM_DROPPED;
+}
+
+#ifdef NC_ENABLED_SSH_TLS
+
+#define WRITE_COALESCE_MAXLEN 4096 /* small buffers are copied together up to this length for SSH/TLS */
+
+/**
+ * @brief Get the data of the next write to an SSH channel or a TLS session, which can write only a single buffer.
+ *
+ * Small leading buffers are copied into one so that they are sent in a single SSH channel or TLS record write.
+ * The result depends only on @p iov so a repeated write after no progress passes the same data.
+ *
+ * @param[in] iov Buffers to write, the first one is not empty.
+ * @param[in] iovcnt Count of buffers in @p iov.
+ * @param[in] buf Buffer of ::WRITE_COALESCE_MAXLEN bytes to copy the buffers into.
+ * @param[out] len Length of the returned data.
+ * @return Data to write, either @p buf or the first buffer of @p iov.
+ */
+static const void *
+nc_write_coalesce(const struct iovec *iov, int iovcnt, char *buf, size_t *len)
+{
+    int i;
+
+    if ((iovcnt < 2) || (iov[0].iov_len + iov[1].iov_len > WRITE_COALESCE_MAXLEN)) {
+        /* nothing to coalesce */
+        *len = iov[0].iov_len;
+        return iov[0].iov_base;
+    }
+
+    *len = 0;
+    for (i = 0; (i < iovcnt) && (*len + iov[i].iov_len <= WRITE_COALESCE_MAXLEN); ++i) {
+        memcpy(buf + *len, iov[i].iov_base, iov[i].iov_len);
+        *len += iov[i].iov_len;
+    }
+    return buf;
+}
+
+#endif /* NC_ENABLED_SSH_TLS */
+
 /**
  * @brief Write to a NETCONF session.
  *
+ * All the buffers are written at once, if the transport allows it. For SSH and TLS, small buffers
+ * are coalesced into a single write.
+ *
  * @param[in] session Session to write to.
- * @param[in] buf Buffer to write.
- * @param[in] count Count of bytes from @p buf to write.
+ * @param[in,out] iov Buffers to write, they are modified as they are written.
+ * @param[in] iovcnt Count of buffers in @p iov.
+ * @param[in] block Whether to wait until everything is written, otherwise only what can be written
+ * immediately is.
  * @return Number of bytes written.
  * @return -1 on error.
  */
 static int
-nc_write(struct nc_session *session, const void *buf, uint32_t count)
+nc_write(struct nc_session *session, struct iovec *iov, int iovcnt, int block)
 {
-    int c, fd, interrupted;
+    int fd, i, interrupted;
+    ssize_t c;
     uint32_t written = 0;
+    struct msghdr msg = {0};
+
+#ifdef NC_ENABLED_SSH_TLS
+    char cbuf[WRITE_COALESCE_MAXLEN];
+    const void *data;
+    size_t len;
+#endif
 
     if ((session->status != NC_STATUS_RUNNING) && (session->status != NC_STATUS_STARTING)) {
         return -1;
     }
 
-    /* prevent SIGPIPE this way */
-    if (!nc_session_is_connected(session)) {
-        ERR(session, "Communication socket unexpectedly closed.");
-        session->status = NC_STATUS_INVALID;
-        session->term_reason = NC_SESSION_TERM_DROPPED;
-        return -1;
+    for (i = 0; i < iovcnt; ++i) {
+        DBG(session, "Sending message:\n%.*s\n", (int)iov[i].iov_len, (char *)iov[i].iov_base);
     }
 
-    DBG(session, "Sending message:\n%.*s\n", (int)count, buf);
+    while (iovcnt) {
+        if (!iov->iov_len) {
+            /* buffer written */
+            ++iov;
+            --iovcnt;
+            continue;
+        }
 
-    do {
         interrupted = 0;
         switch (session->ti_type) {
         case NC_TI_FD:
         case NC_TI_UNIX:
             fd = session->ti_type == NC_TI_FD ? session->ti.fd.out : session->ti.unixsock.sock;
-            c = write(fd, (char *)(buf + written), count - written);
+            c = -1;
+            if (!(session->flags & NC_SESSION_FD_NOTSOCK)) {
+                /* prevent SIGPIPE this way */
+                msg.msg_iov = iov;
+                msg.msg_iovlen = iovcnt;
+                c = sendmsg(fd, &msg, MSG_NOSIGNAL);
+                if ((c < 0) && (errno == ENOTSOCK)) {
+                    session->flags |= NC_SESSION_FD_NOTSOCK;
+                }
+            }
+            if (session->flags & NC_SESSION_FD_NOTSOCK) {
+                /* prevent SIGPIPE by checking the connection first */
+                if (!nc_session_is_connected(session)) {
+                    nc_write_dropped(session);
+                    return -1;
+                }
+                c = writev(fd, iov, iovcnt);
+            }
             if ((c < 0) && (errno == EAGAIN)) {
                 c = 0;
             } else if ((c < 0) && (errno == EINTR)) {
                 c = 0;
                 interrupted = 1;
+            } else if ((c < 0) && ((errno == EPIPE) || (errno == ECONNRESET))) {
+                nc_write_dropped(session);
+                return -1;
             } else if (c < 0) {
                 ERR(session, "Socket error (%s).", strerror(errno));
                 return -1;
@@ -617,14 +1149,16 @@ nc_write(struct nc_session *session, const void *buf, uint32_t count)
                 session->term_reason = NC_SESSION_TERM_DROPPED;
                 return -1;
             }
-            c = ssh_channel_write(session->ti.libssh.channel, (char *)(buf + written), count - written);
+            data = nc_write_coalesce(iov, iovcnt, cbuf, &len);
+            c = ssh_channel_write(session->ti.libssh.channel, data, len);
             if ((c == SSH_ERROR) || (c == -1)) {
                 ERR(session, "SSH channel write failed.");
                 return -1;
             }
             break;
         case NC_TI_TLS:
-            c = nc_tls_write_wrap(session, (const unsigned char *)(buf + written), count - written);
+            data = nc_write_coalesce(iov, iovcnt, cbuf, &len);
+            c = nc_tls_write_wrap(session, data, len);
             if (c < 0) {
                 /* possible client dc, or some socket/TLS communication error */
                 return -1;
@@ -637,12 +1171,33 @@ nc_write(struct nc_session *session, const void *buf, uint32_t count)
         }
 
         if ((c == 0) && !interrupted) {
+            if (!block) {
+                /* cannot write more now */
+                break;
+            }
+
             /* we must wait */
-            usleep(NC_TIMEOUT_STEP);
+            if (nc_io_wait(session, 1, -1) == -1) {
+                return -1;
+            }
         }
 
         written += c;
-    } while (written < count);
+        if (c && (session->side == NC_SERVER)) {
+            NC_STATS_ADD(session, out_bytes, c);
+        }
+
+        /* skip what was written */
+        while (c && ((size_t)c >= iov->iov_len)) {
+            c -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (c) {
+            iov->iov_base = (char *)iov->iov_base + c;
+            iov->iov_len -= c;
+        }
+    }
 
     return written;
 }
@@ -659,75 +1214,161 @@ nc_write(struct nc_session *session, const void *buf, uint32_t count)
 static int
 nc_write_starttag_and_msg(struct nc_session *session, const void *buf, uint32_t count)
 {
-    int ret = 0, r;
-    char chunksize[24];
+    char starttag[WRITE_STARTTAG_MAXLEN + 1];
+    struct iovec iov[2];
+    int iovcnt = 0;
 
     if (session->version == NC_VERSION_11) {
-        r = sprintf(chunksize, "\n#%" PRIu32 "\n", count);
-
-        r = nc_write(session, chunksize, r);
-        if (r == -1) {
-            return -1;
-        }
-        ret += r;
+        iov[iovcnt].iov_base = starttag;
+        iov[iovcnt].iov_len = sprintf(starttag, "\n#%" PRIu32 "\n", count);
+        ++iovcnt;
     }
 
-    r = nc_write(session, buf, count);
-    if (r == -1) {
-        return -1;
-    }
-    ret += r;
+    iov[iovcnt].iov_base = (void *)buf;
+    iov[iovcnt].iov_len = count;
+    ++iovcnt;
 
-    return ret;
+    return nc_write(session, iov, iovcnt, 1);
 }
 
 /**
- * @brief Write the end tag part of a chunked-framing NETCONF message.
+ * @brief Flush all the data buffered for writing.
  *
- * @param[in] session Session to write to.
- * @return Number of bytes written.
+ * The start tag and, if @p endtag is set, the end tag are added around the buffered data in place
+ * so that the whole message part is written at once.
+ *
+ * @param[in] warg Write callback structure to flush.
+ * @param[in] endtag Whether to also write the end tag of the message.
+ * @return Number of written bytes.
  * @return -1 on error.
  */
 static int
-nc_write_endtag(struct nc_session *session)
+nc_write_clb_flush(struct nc_wclb_arg *warg, int endtag)
 {
-    int ret;
+    char *data = warg->buf + WRITE_STARTTAG_MAXLEN, starttag[WRITE_STARTTAG_MAXLEN + 1];
+    struct iovec iov;
+    int len;
+
+    iov.iov_base = data;
+    iov.iov_len = warg->len;
+
+    if (warg->len && (warg->session->version == NC_VERSION_11)) {
+        /* start tag right before the data */
+        len = sprintf(starttag, "\n#%" PRIu32 "\n", warg->len);
+        iov.iov_base = data - len;
+        iov.iov_len += len;
+        memcpy(iov.iov_base, starttag, len);
+    }
 
-    if (session->version == NC_VERSION_11) {
-        ret = nc_write(session, "\n##\n", 4);
-    } else {
-        ret = nc_write(session, "]]>]]>", 6);
+    if (endtag) {
+        /* end tag right after the data */
+        if (warg->session->version == NC_VERSION_11) {
+            memcpy(data + warg->len, "\n##\n", 4);
+            iov.iov_len += 4;
+        } else {
+            memcpy(data + warg->len, "]]>]]>", 6);
+            iov.iov_len += 6;
+        }
     }
 
-    return ret;
+    warg->len = 0;
+    if (!iov.iov_len) {
+        return 0;
+    }
+    warg->flushed = 1;
+    return nc_write(warg->session, &iov, 1, 1);
 }
 
 /**
- * @brief Flush all the data buffered for writing.
+ * @brief Learn the length of a data prefix that does not need to be escaped in XML content.
  *
- * @param[in] warg Write callback structure to flush.
- * @return Number of written bytes.
- * @return -1 on error.
+ * @param[in] buf Data to scan.
+ * @param[in] len Length of @p buf.
+ * @return Offset of the first '&', '<', or '>' in @p buf, @p len if there is none.
  */
-static int
-nc_write_clb_flush(struct nc_wclb_arg *warg)
+static uint32_t
+nc_xml_escape_span(const char *buf, uint32_t len)
 {
-    int ret = 0;
+    uint32_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i amp = _mm_set1_epi8('&'), lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>');
+    __m128i chunk, match;
+    int mask;
+
+    /* compare 16 bytes at once */
+    for ( ; i + 16 <= len; i += 16) {
+        chunk = _mm_loadu_si128((const __m128i *)(buf + i));
+        match = _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_or_si128(_mm_cmpeq_epi8(chunk, lt), _mm_cmpeq_epi8(chunk, gt)));
+        mask = _mm_movemask_epi8(match);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
 
-    /* flush current buffer */
-    if (warg->len) {
-        ret = nc_write_starttag_and_msg(warg->session, warg->buf, warg->len);
-        warg->len = 0;
+    for ( ; i < len; ++i) {
+        if ((buf[i] == '&') || (buf[i] == '<') || (buf[i] == '>')) {
+            break;
+        }
     }
 
-    return ret;
+    return i;
+}
+
+uint32_t
+nc_xml_escape(const char *src, uint32_t src_len, uint32_t *src_used, char *dst, uint32_t dst_size)
+{
+    uint32_t i = *src_used, o = 0, run, esc_len;
+    const char *esc;
+
+    while (i < src_len) {
+        /* copy the whole run of characters that need no escaping and fit */
+        run = src_len - i;
+        if (run > dst_size - o) {
+            run = dst_size - o;
+        }
+        run = nc_xml_escape_span(src + i, run);
+        memcpy(dst + o, src + i, run);
+        i += run;
+        o += run;
+        if ((i == src_len) || (o == dst_size)) {
+            break;
+        }
+
+        /* escape the character */
+        switch (src[i]) {
+        case '&':
+            esc = "&amp;";
+            esc_len = 5;
+            break;
+        case '<':
+            esc = "&lt;";
+            esc_len = 4;
+            break;
+        default:
+            /* '>', not needed, just for readability */
+            esc = "&gt;";
+            esc_len = 4;
+            break;
+        }
+        if (esc_len > dst_size - o) {
+            break;
+        }
+        memcpy(dst + o, esc, esc_len);
+        o += esc_len;
+        ++i;
+    }
+
+    *src_used = i;
+    return o;
 }
 
 /**
  * @brief Write callback buffering the data in a write structure.
  *
  * @param[in] arg Write structure used for buffering.
- * @param[in] buf Buffer to write.
+ * @param[in] buf Buffer to write, NULL to flush the buffer and finish the message.
  * @param[in] count Count of bytes to write from @p buf.
  * @param[in] xmlcontent Whether the data are actually printed as part of an XML in which case they need to be encoded.
  * @return Number of written bytes.
@@ -739,27 +1380,16 @@ nc_write_clb(void *arg, const void *buf, uint32_t count, int xmlcontent)
     ssize_t ret = 0, c;
     uint32_t l;
     struct nc_wclb_arg *warg = arg;
+    char *data = warg->buf + WRITE_STARTTAG_MAXLEN;
 
     if (!buf) {
-        c = nc_write_clb_flush(warg);
-        if (c == -1) {
-            return -1;
-        }
-        ret += c;
-
-        /* endtag */
-        c = nc_write_endtag(warg->session);
-        if (c == -1) {
-            return -1;
-        }
-        ret += c;
-
-        return ret;
+        /* flush with the endtag */
+        return nc_write_clb_flush(warg, 1);
     }
 
     if (warg->len && (warg->len + count > WRITE_BUFSIZE)) {
         /* dump current buffer */
-        c = nc_write_clb_flush(warg);
+        c = nc_write_clb_flush(warg, 0);
         if (c == -1) {
             return -1;
         }
@@ -768,6 +1398,7 @@ nc_write_clb(void *arg, const void *buf, uint32_t count, int xmlcontent)
 
     if (!xmlcontent && (count > WRITE_BUFSIZE)) {
         /* write directly */
+        warg->flushed = 1;
         c = nc_write_starttag_and_msg(warg->session, buf, count);
         if (c == -1) {
             return -1;
@@ -776,40 +1407,23 @@ nc_write_clb(void *arg, const void *buf, uint32_t count, int xmlcontent)
     } else {
         /* keep in buffer and write later */
         if (xmlcontent) {
-            for (l = 0; l < count; l++) {
-                if (warg->len + 5 >= WRITE_BUFSIZE) {
-                    /* buffer is full */
-                    c = nc_write_clb_flush(warg);
-                    if (c == -1) {
-                        return -1;
-                    }
+            l = 0;
+            while (1) {
+                c = nc_xml_escape(buf, count, &l, &data[warg->len], WRITE_BUFSIZE - warg->len);
+                warg->len += c;
+                ret += c;
+                if (l == count) {
+                    break;
                 }
 
-                switch (((char *)buf)[l]) {
-                case '&':
-                    ret += 5;
-                    memcpy(&warg->buf[warg->len], "&amp;", 5);
-                    warg->len += 5;
-                    break;
-                case '<':
-                    ret += 4;
-                    memcpy(&warg->buf[warg->len], "&lt;", 4);
-                    warg->len += 4;
-                    break;
-                case '>':
-                    /* not needed, just for readability */
-                    ret += 4;
-                    memcpy(&warg->buf[warg->len], "&gt;", 4);
-                    warg->len += 4;
-                    break;
-                default:
-                    ret++;
-                    memcpy(&warg->buf[warg->len], &((char *)buf)[l], 1);
-                    warg->len++;
+                /* buffer is full */
+                c = nc_write_clb_flush(warg, 0);
+                if (c == -1) {
+                    return -1;
                 }
             }
         } else {
-            memcpy(&warg->buf[warg->len], buf, count);
+            memcpy(&data[warg->len], buf, count);
             warg->len += count; /* is <= WRITE_BUFSIZE */
             ret += count;
         }
@@ -835,6 +1449,140 @@ nc_write_xmlclb(void *arg, const void *buf, size_t count)
     return count;
 }
 
+/**
+ * @brief Learn libyang printer flags for a with-defaults mode.
+ *
+ * @param[in] wd With-defaults mode.
+ * @return Printer flags.
+ */
+static uint32_t
+nc_wd2print_flags(NC_WD_MODE wd)
+{
+    switch (wd) {
+    case NC_WD_UNKNOWN:
+    case NC_WD_EXPLICIT:
+        return LYD_PRINT_WD_EXPLICIT;
+    case NC_WD_TRIM:
+        return LYD_PRINT_WD_TRIM;
+    case NC_WD_ALL:
+        return LYD_PRINT_WD_ALL;
+    case NC_WD_ALL_TAG:
+        return LYD_PRINT_WD_ALL_TAG;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Write a streamed DATA rpc-reply, every part is written right after it is produced.
+ *
+ * @param[in] arg Write callback structure.
+ * @param[in] rpc_envp Parsed envelopes of the RPC to reply to.
+ * @param[in] reply Streamed reply to write.
+ * @return 0 on success, an error reply is written instead if producing the reply fails before any of it is written.
+ * @return -1 on error, the session is terminated if the message was not finished.
+ */
+static int
+nc_write_reply_stream(struct nc_wclb_arg *arg, struct lyd_node_opaq *rpc_envp, struct nc_server_reply_stream *reply)
+{
+    struct nc_session *session = arg->session;
+    struct lyd_node *reply_envp, *subtree, *err;
+    const char *fragment;
+    char *envp_str;
+    size_t len;
+    int r, ret = 0;
+
+    /* print an empty rpc-reply with the attributes of the rpc */
+    if (lyd_new_opaq2(NULL, session->ctx, "rpc-reply", NULL, rpc_envp->name.prefix, rpc_envp->name.module_ns,
+            &reply_envp)) {
+        ERRINT;
+        return -1;
+    }
+    ((struct lyd_node_opaq *)reply_envp)->attr = rpc_envp->attr;
+    r = lyd_print_mem(&envp_str, reply_envp, LYD_XML, LYD_PRINT_SHRINK);
+    ((struct lyd_node_opaq *)reply_envp)->attr = NULL;
+    lyd_free_tree(reply_envp);
+    if (r) {
+        return -1;
+    }
+
+    len = strlen(envp_str);
+    if ((len < 2) || strcmp(envp_str + len - 2, "/>")) {
+        ERRINT;
+        free(envp_str);
+        return -1;
+    }
+
+    /* <rpc-reply> open */
+    if ((nc_write_clb((void *)arg, envp_str, len - 2, 0) == -1) || (nc_write_clb((void *)arg, ">", 1, 0) == -1)) {
+        ret = -1;
+    }
+
+    /* reply parts */
+    while (!ret) {
+        subtree = NULL;
+        fragment = NULL;
+        r = reply->stream_clb(session, &subtree, &fragment, reply->user_data);
+        if (r == 1) {
+            /* reply complete */
+            break;
+        } else if (r) {
+            ERR(session, "Failed to produce a streamed reply part.");
+            lyd_free_siblings(subtree);
+            ret = -1;
+            break;
+        }
+
+        if (subtree) {
+            if (lyd_print_clb(nc_write_xmlclb, (void *)arg, subtree, LYD_XML,
+                    LYD_PRINT_SHRINK | LYD_PRINT_WITHSIBLINGS | nc_wd2print_flags(reply->wd))) {
+                ret = -1;
+            }
+            lyd_free_siblings(subtree);
+        }
+        if (!ret && fragment && (nc_write_clb((void *)arg, fragment, strlen(fragment), 0) == -1)) {
+            ret = -1;
+        }
+    }
+
+    if (ret && !arg->flushed && (session->status == NC_STATUS_RUNNING)) {
+        /* nothing written yet, drop the buffered part and reply with an error instead */
+        arg->len = 0;
+        ret = 0;
+        err = nc_err(session->ctx, NC_ERR_OP_FAILED, NC_ERR_TYPE_APP);
+        if (!err) {
+            ret = -1;
+        } else if ((nc_write_clb((void *)arg, envp_str, len - 2, 0) == -1) || (nc_write_clb((void *)arg, ">", 1, 0) == -1) ||
+                lyd_print_clb(nc_write_xmlclb, (void *)arg, err, LYD_XML, LYD_PRINT_SHRINK)) {
+            ret = -1;
+        }
+        lyd_free_tree(err);
+    }
+    free(envp_str);
+
+    if (!ret) {
+        /* </rpc-reply> close */
+        if (rpc_envp->name.prefix) {
+            if ((nc_write_clb((void *)arg, "</", 2, 0) == -1) ||
+                    (nc_write_clb((void *)arg, rpc_envp->name.prefix, strlen(rpc_envp->name.prefix), 0) == -1) ||
+                    (nc_write_clb((void *)arg, ":rpc-reply>", 11, 0) == -1)) {
+                ret = -1;
+            }
+        } else if (nc_write_clb((void *)arg, "</rpc-reply>", 12, 0) == -1) {
+            ret = -1;
+        }
+    }
+
+    if (ret && (session->status == NC_STATUS_RUNNING)) {
+        /* part of the message was written, it cannot be finished */
+        ERR(session, "Streamed reply could not be finished, terminating the session.");
+        session->status = NC_STATUS_INVALID;
+        session->term_reason = NC_SESSION_TERM_OTHER;
+    }
+
+    return ret;
+}
+
 /* return NC_MSG_ERROR can change session status, acquires IO lock as needed */
 NC_MSG_TYPE
 nc_write_msg_io(struct nc_session *session, int io_timeout, int type, ...)
@@ -861,6 +1609,7 @@ nc_write_msg_io(struct nc_session *session, int io_timeout, int type, ...)
 
     arg.session = session;
     arg.len = 0;
+    arg.flushed = 0;
 
     /* SESSION IO LOCK */
     ret = nc_session_io_lock(session, io_timeout, __func__);
@@ -870,6 +1619,12 @@ nc_write_msg_io(struct nc_session *session, int io_timeout, int type, ...)
         return NC_MSG_WOULDBLOCK;
     }
 
+    if ((session->side == NC_SERVER) && session->opts.server.ntf_queue && nc_write_ntf_queue(session, 1)) {
+        /* a queued notification was partially written, it could not be finished */
+        nc_session_io_unlock(session, __func__);
+        return NC_MSG_ERROR;
+    }
+
     va_start(ap, type);
 
     switch (type) {
@@ -928,6 +1683,15 @@ nc_write_msg_io(struct nc_session *session, int io_timeout, int type, ...)
             break;
         }
 
+        if (reply->type == NC_RPL_STREAM) {
+            /* written while being produced */
+            if (nc_write_reply_stream(&arg, rpc_envp, (struct nc_server_reply_stream *)reply)) {
+                ret = NC_MSG_ERROR;
+                goto cleanup;
+            }
+            break;
+        }
+
         /* build a rpc-reply opaque node that can be simply printed */
         if (lyd_new_opaq2(NULL, session->ctx, "rpc-reply", NULL, rpc_envp->name.prefix, rpc_envp->name.module_ns,
                 &reply_envp)) {
@@ -947,21 +1711,7 @@ nc_write_msg_io(struct nc_session *session, int io_timeout, int type, ...)
             }
             break;
         case NC_RPL_DATA:
-            switch (((struct nc_server_reply_data *)reply)->wd) {
-            case NC_WD_UNKNOWN:
-            case NC_WD_EXPLICIT:
-                wd = LYD_PRINT_WD_EXPLICIT;
-                break;
-            case NC_WD_TRIM:
-                wd = LYD_PRINT_WD_TRIM;
-                break;
-            case NC_WD_ALL:
-                wd = LYD_PRINT_WD_ALL;
-                break;
-            case NC_WD_ALL_TAG:
-                wd = LYD_PRINT_WD_ALL_TAG;
-                break;
-            }
+            wd = nc_wd2print_flags(((struct nc_server_reply_data *)reply)->wd);
 
             node = ((struct nc_server_reply_data *)reply)->data;
             assert(node->schema->nodetype & (LYS_RPC | LYS_ACTION));
@@ -1076,6 +1826,144 @@ nc_write_msg_io(struct nc_session *session, int io_timeout, int type, ...)
 cleanup:
     va_end(ap);
     nc_session_io_unlock(session, __func__);
+    nc_ps_epoll_session_written(session);
+    return ret;
+}
+
+/**
+ * @brief Prepare buffers for writing (the rest of) a printed notification.
+ *
+ * @param[in] session Session to write to.
+ * @param[in] msg Printed notification.
+ * @param[in] offset Count of bytes of the framed notification already written.
+ * @param[out] iov Buffers to write, at least 2.
+ * @param[out] total Optional length of the whole framed notification.
+ * @return Count of buffers in @p iov.
+ */
+static int
+nc_write_notif_msg_iov(const struct nc_session *session, const struct nc_server_notif_msg *msg, uint32_t offset,
+        struct iovec *iov, uint32_t *total)
+{
+    static char endtag[] = "]]>]]>";
+
+    if (session->version == NC_VERSION_11) {
+        /* the message is already framed */
+        if (total) {
+            *total = msg->buf_len;
+        }
+        iov[0].iov_base = msg->buf + offset;
+        iov[0].iov_len = msg->buf_len - offset;
+        return 1;
+    }
+
+    /* only the message itself and the end tag */
+    if (total) {
+        *total = msg->msg_len + 6;
+    }
+    if (offset < msg->msg_len) {
+        iov[0].iov_base = msg->buf + msg->starttag_len + offset;
+        iov[0].iov_len = msg->msg_len - offset;
+        iov[1].iov_base = endtag;
+        iov[1].iov_len = 6;
+        return 2;
+    }
+    iov[0].iov_base = endtag + (offset - msg->msg_len);
+    iov[0].iov_len = 6 - (offset - msg->msg_len);
+    return 1;
+}
+
+int
+nc_write_ntf_queue(struct nc_session *session, int finish)
+{
+    struct nc_ntf_queue *queue = session->opts.server.ntf_queue;
+    struct nc_server_notif_msg *msg;
+    struct iovec iov[2];
+    uint32_t offset, total;
+    int iovcnt, r;
+
+    while (1) {
+        /* QUEUE LOCK */
+        pthread_mutex_lock(&queue->lock);
+
+        if (!queue->count || (finish && !queue->started)) {
+            /* nothing (more) to write */
+            pthread_mutex_unlock(&queue->lock);
+            return 0;
+        }
+
+        /* the first notification cannot be dropped anymore */
+        msg = queue->msgs[queue->first];
+        offset = queue->written;
+        queue->started = 1;
+
+        /* QUEUE UNLOCK */
+        pthread_mutex_unlock(&queue->lock);
+
+        iovcnt = nc_write_notif_msg_iov(session, msg, offset, iov, &total);
+        r = nc_write(session, iov, iovcnt, finish);
+        if (r == -1) {
+            return -1;
+        }
+
+        /* QUEUE LOCK */
+        pthread_mutex_lock(&queue->lock);
+
+        queue->written += r;
+        if (queue->written == total) {
+            /* whole notification written, dequeue it */
+            nc_server_notif_msg_free(msg);
+            queue->first = (queue->first + 1) % queue->size;
+            --queue->count;
+            queue->written = 0;
+            queue->started = 0;
+            pthread_cond_broadcast(&queue->cond);
+        }
+
+        /* QUEUE UNLOCK */
+        pthread_mutex_unlock(&queue->lock);
+
+        if (finish || (offset + r < total)) {
+            /* the started notification was finished or nothing more can be written now */
+            return 0;
+        }
+    }
+}
+
+/* return NC_MSG_ERROR can change session status, acquires IO lock as needed */
+NC_MSG_TYPE
+nc_write_notif_msg_io(struct nc_session *session, int io_timeout, const struct nc_server_notif_msg *msg)
+{
+    struct iovec iov[2];
+    int iovcnt, ret;
+
+    assert(session && msg);
+
+    if ((session->status != NC_STATUS_RUNNING) && (session->status != NC_STATUS_STARTING)) {
+        ERR(session, "Invalid session to write to.");
+        return NC_MSG_ERROR;
+    }
+
+    iovcnt = nc_write_notif_msg_iov(session, msg, 0, iov, NULL);
+
+    /* SESSION IO LOCK */
+    ret = nc_session_io_lock(session, io_timeout, __func__);
+    if (ret < 0) {
+        return NC_MSG_ERROR;
+    } else if (!ret) {
+        return NC_MSG_WOULDBLOCK;
+    }
+
+    if ((nc_write(session, iov, iovcnt, 1) == -1) ||
+            ((session->status != NC_STATUS_RUNNING) && (session->status != NC_STATUS_STARTING))) {
+        ret = NC_MSG_ERROR;
+    } else {
+        ret = NC_MSG_NOTIF;
+    }
+
+    /* SESSION IO UNLOCK */
+    nc_session_io_unlock(session, __func__);
+
+    nc_ps_epoll_session_written(session);
     return ret;
 }
 
@@ -20,6 +20,7 @@
 
 #include <libyang/libyang.h>
 
+#include "compat.h"
 #include "messages_client.h"
 #include "messages_server.h"
 #include "netconf.h"
@@ -44,6 +45,14 @@ struct nc_server_reply_error {
     struct lyd_node *err;
 };
 
+struct nc_server_reply_stream {
+    NC_RPL type;
+    nc_server_reply_stream_clb stream_clb;
+    void *user_data;
+    void (*free_clb)(void *user_data);
+    NC_WD_MODE wd;
+};
+
 struct nc_server_rpc {
     struct lyd_node *envp;   /**< NETCONF-specific RPC envelopes */
     struct lyd_node *rpc;    /**< RPC data tree */
@@ -55,6 +64,14 @@ struct nc_server_notif {
     int free;
 };
 
+struct nc_server_notif_msg {
+    ATOMIC_T refcount;      /**< number of references to the message */
+    char *buf;              /**< message framed using the chunked framing (start tag, message, end tag) */
+    uint32_t buf_len;       /**< length of the framed message */
+    uint32_t starttag_len;  /**< length of the start tag, the message itself follows */
+    uint32_t msg_len;       /**< length of the message itself */
+};
+
 struct nc_client_reply_error {
     NC_RPL type;
     struct nc_err *err;
@@ -265,6 +282,14 @@ struct nc_rpc_resyncsub {
 
 void nc_server_rpc_free(struct nc_server_rpc *rpc);
 
+/**
+ * @brief Add a reference to a printed Event Notification.
+ *
+ * @param[in] msg Printed Event Notification.
+ * @return @p msg.
+ */
+struct nc_server_notif_msg *nc_server_notif_msg_ref(struct nc_server_notif_msg *msg);
+
 void nc_client_err_clean(struct nc_err *err, struct ly_ctx *ctx);
 
 #endif /* NC_MESSAGES_P_H_ */
@@ -92,6 +92,25 @@ nc_server_reply_err(struct lyd_node *err)
     return (struct nc_server_reply *)ret;
 }
 
+API struct nc_server_reply *
+nc_server_reply_stream(nc_server_reply_stream_clb stream_clb, void *user_data, void (*free_clb)(void *user_data),
+        NC_WD_MODE wd)
+{
+    struct nc_server_reply_stream *ret;
+
+    NC_CHECK_ARG_RET(NULL, stream_clb, NULL);
+
+    ret = malloc(sizeof *ret);
+    NC_CHECK_ERRMEM_RET(!ret, NULL);
+
+    ret->type = NC_RPL_STREAM;
+    ret->stream_clb = stream_clb;
+    ret->user_data = user_data;
+    ret->free_clb = free_clb;
+    ret->wd = wd;
+    return (struct nc_server_reply *)ret;
+}
+
 API int
 nc_server_reply_add_err(struct nc_server_reply *reply, struct lyd_node *err)
 {
@@ -739,6 +758,7 @@ nc_server_reply_free(struct nc_server_reply *reply)
 {
     struct nc_server_reply_data *data_rpl;
     struct nc_server_reply_error *error_rpl;
+    struct nc_server_reply_stream *stream_rpl;
 
     if (!reply) {
         return;
@@ -758,6 +778,12 @@ nc_server_reply_free(struct nc_server_reply *reply)
         error_rpl = (struct nc_server_reply_error *)reply;
         lyd_free_siblings(error_rpl->err);
         break;
+    case NC_RPL_STREAM:
+        stream_rpl = (struct nc_server_reply_stream *)reply;
+        if (stream_rpl->free_clb) {
+            stream_rpl->free_clb(stream_rpl->user_data);
+        }
+        break;
     default:
         break;
     }
@@ -819,6 +845,65 @@ nc_server_notif_free(struct nc_server_notif *notif)
     free(notif);
 }
 
+API struct nc_server_notif_msg *
+nc_server_notif_msg_new(const struct nc_server_notif *notif)
+{
+    struct nc_server_notif_msg *msg;
+    char *data = NULL;
+    int len;
+
+    NC_CHECK_ARG_RET(NULL, notif, notif->ntf, notif->eventtime, NULL);
+
+    /* print the notification content */
+    if (lyd_print_mem(&data, notif->ntf, LYD_XML, LYD_PRINT_SHRINK)) {
+        return NULL;
+    }
+
+    msg = calloc(1, sizeof *msg);
+    NC_CHECK_ERRMEM_GOTO(!msg, , cleanup);
+    ATOMIC_STORE_RELAXED(msg->refcount, 1);
+
+    /* learn the message length to be able to print the start tag */
+    len = snprintf(NULL, 0, "<notification xmlns=\"%s\"><eventTime>%s</eventTime>%s</notification>", NC_NS_NOTIF,
+            notif->eventtime, data);
+    msg->msg_len = len;
+
+    /* print the whole framed message, NETCONF 1.0 framing uses only the message itself */
+    len = asprintf(&msg->buf, "\n#%" PRIu32 "\n<notification xmlns=\"%s\"><eventTime>%s</eventTime>%s</notification>\n##\n",
+            msg->msg_len, NC_NS_NOTIF, notif->eventtime, data);
+    NC_CHECK_ERRMEM_GOTO(len == -1, free(msg); msg = NULL, cleanup);
+    msg->buf_len = len;
+    msg->starttag_len = msg->buf_len - msg->msg_len - 4;
+
+cleanup:
+    free(data);
+    return msg;
+}
+
+struct nc_server_notif_msg *
+nc_server_notif_msg_ref(struct nc_server_notif_msg *msg)
+{
+    ATOMIC_INC_RELAXED(msg->refcount);
+    return msg;
+}
+
+API void
+nc_server_notif_msg_free(struct nc_server_notif_msg *msg)
+{
+    if (!msg) {
+        return;
+    }
+
+    /* the last reference must see all the accesses of the other holders before freeing */
+    if (ATOMIC_DEC_ACQ_REL(msg->refcount) > 1) {
+        /* still referenced */
+        return;
+    }
+
+    free(msg->buf);
+    free(msg);
+}
+
 API const char *
 nc_server_notif_get_time(const struct nc_server_notif *notif)
 {
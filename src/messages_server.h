@@ -114,6 +114,46 @@ struct nc_server_reply *nc_server_reply_data(struct lyd_node *data, NC_WD_MODE w
  */
 struct nc_server_reply *nc_server_reply_err(struct lyd_node *err);
 
+/**
+ * @brief Callback producing the next part of a streamed DATA rpc-reply.
+ *
+ * Every call should produce either a data subtree or a printed XML fragment. The parts are written
+ * right away in the order they are produced as the content of the \<rpc-reply\> element.
+ *
+ * @param[in] session NETCONF session the reply is being written to.
+ * @param[out] subtree Data subtree (with siblings) to print, it is freed once printed.
+ * @param[out] fragment Printed XML fragment to write as is, it must be valid until the next call of the callback.
+ * @param[in] user_data Arbitrary user data passed to nc_server_reply_stream().
+ * @return 0 if a part was produced, it is skipped if both @p subtree and @p fragment are NULL.
+ * @return 1 if the reply is complete.
+ * @return -1 on error.
+ */
+typedef int (*nc_server_reply_stream_clb)(struct nc_session *session, struct lyd_node **subtree, const char **fragment,
+        void *user_data);
+
+/**
+ * @brief Create a streamed DATA rpc-reply object.
+ *
+ * Instead of creating the whole reply data tree at once, its parts are generated by @p stream_clb only
+ * while the reply is being written and sent in :base:1.1 chunks whenever the write buffer fills up (or as a single
+ * :base:1.0 message written in several parts). Hence, only a single part needs to be kept in memory at any time,
+ * which is useful for huge replies such as the \<data\> of \<get\> and \<get-config\>. Their first
+ * produced part is then expected to be the `<data xmlns="urn:ietf:params:xml:ns:netconf:base:1.0">` fragment
+ * and the last one `</data>`.
+ *
+ * If @p stream_clb fails while all the produced parts are still buffered, they are dropped and an operation-failed
+ * \<rpc-error\> is replied instead. If some parts were already written, the message cannot be finished and the
+ * session is terminated.
+ *
+ * @param[in] stream_clb Callback producing the reply parts.
+ * @param[in] user_data Arbitrary user data passed to @p stream_clb.
+ * @param[in] free_clb Optional callback for freeing @p user_data, called when the reply is freed.
+ * @param[in] wd with-default mode used for printing the data subtrees.
+ * @return rpc-reply object, NULL on error.
+ */
+struct nc_server_reply *nc_server_reply_stream(nc_server_reply_stream_clb stream_clb, void *user_data,
+        void (*free_clb)(void *user_data), NC_WD_MODE wd);
+
 /**
  * @brief Add another error opaque data node tree to an ERROR rpc-reply object.
  *
@@ -327,6 +367,60 @@ NC_MSG_TYPE nc_server_notif_send(struct nc_session *session, struct nc_server_no
  */
 void nc_server_notif_free(struct nc_server_notif *notif);
 
+/**
+ * @brief Event Notification printed once to be sent to any number of sessions without printing it again.
+ */
+struct nc_server_notif_msg;
+
+/**
+ * @brief Print an Event Notification to be sent to many sessions.
+ *
+ * The notification is printed including both the NETCONF 1.0 and 1.1 framing so sending it to a session
+ * is reduced to a single write.
+ *
+ * @param[in] notif Server Event Notification object to print, it is not referenced by the result.
+ * @return Printed Event Notification to be freed using nc_server_notif_msg_free().
+ * @return NULL on error.
+ */
+struct nc_server_notif_msg *nc_server_notif_msg_new(const struct nc_server_notif *notif);
+
+/**
+ * @brief Send a printed NETCONF Event Notification via the session.
+ *
+ * @param[in] session NETCONF session where the Event Notification will be written.
+ * @param[in] msg Printed Event Notification, created by nc_server_notif_msg_new().
+ * @param[in] timeout Timeout for writing in milliseconds. Use negative value for infinite
+ *            waiting and 0 for return if data cannot be sent immediately.
+ * @return #NC_MSG_NOTIF on success,
+ *         #NC_MSG_WOULDBLOCK in case of a busy session, and
+ *         #NC_MSG_ERROR on error.
+ */
+NC_MSG_TYPE nc_server_notif_msg_send(struct nc_session *session, struct nc_server_notif_msg *msg, int timeout);
+
+/**
+ * @brief Send NETCONF Event Notification via several sessions, printing it only once.
+ *
+ * @param[in] sessions Array of NETCONF sessions where the Event Notification will be written.
+ * @param[in] session_count Count of @p sessions.
+ * @param[in] notif NETCONF Notification object to send via all the sessions.
+ * @param[in] timeout Timeout for writing to each session in milliseconds. Use negative value for infinite
+ *            waiting and 0 for return if data cannot be sent immediately.
+ * @param[out] results Optional array of @p session_count results of nc_server_notif_msg_send() for each session.
+ * @return Number of sessions the notification was sent to.
+ * @return -1 on error.
+ */
+int nc_server_notif_send_multi(struct nc_session **sessions, uint32_t session_count, const struct nc_server_notif *notif,
+        int timeout, NC_MSG_TYPE *results);
+
+/**
+ * @brief Free a printed Event Notification.
+ *
+ * It is actually freed once it is not referenced by any session anymore.
+ *
+ * @param[in] msg Printed Event Notification to free.
+ */
+void nc_server_notif_msg_free(struct nc_server_notif_msg *msg);
+
 /**
  * @brief Get the notification timestamp.
  *
@@ -112,7 +112,8 @@ typedef enum NC_REPLY {
     NC_RPL_OK,    /**< OK rpc-reply */
     NC_RPL_DATA,  /**< DATA rpc-reply */
     NC_RPL_ERROR, /**< ERROR rpc-reply */
-    NC_RPL_NOTIF  /**< notification (client-only) */
+    NC_RPL_NOTIF, /**< notification (client-only) */
+    NC_RPL_STREAM /**< streamed DATA rpc-reply (server-only) */
 } NC_RPL;
 
 /**
@@ -616,6 +616,7 @@ nc_server_config_del_auth_client(struct nc_server_ssh_opts *opts, struct nc_auth
     } else if (auth_client->store == NC_STORE_TRUSTSTORE) {
         free(auth_client->ts_ref);
     }
+    nc_server_ssh_pubkey_index_free(auth_client->pubkey_idx);
 
     free(auth_client->password);
 
@@ -635,9 +636,7 @@ nc_server_config_del_ssh_opts(struct nc_bind *bind, struct nc_server_ssh_opts *o
 
     if (bind) {
         free(bind->address);
-        if (bind->sock > -1) {
-            close(bind->sock);
-        }
+        nc_server_bind_close(bind);
     }
 
     /* store in variable because it gets decremented in the function call */
@@ -656,6 +655,9 @@ nc_server_config_del_ssh_opts(struct nc_bind *bind, struct nc_server_ssh_opts *o
     free(opts->encryption_algs);
     free(opts->mac_algs);
 
+    ssh_bind_free(opts->sbind);
+    pthread_mutex_destroy(&opts->sbind_lock);
+
     free(opts);
 }
 
@@ -814,9 +816,7 @@ nc_server_config_del_tls_opts(struct nc_bind *bind, struct nc_server_tls_opts *o
 {
     if (bind) {
         free(bind->address);
-        if (bind->sock > -1) {
-            close(bind->sock);
-        }
+        nc_server_bind_close(bind);
     }
 
     if (opts->store == NC_STORE_LOCAL) {
@@ -832,7 +832,12 @@ nc_server_config_del_tls_opts(struct nc_bind *bind, struct nc_server_tls_opts *o
     nc_server_config_del_certs(&opts->ee_certs);
 
     nc_server_config_del_ctns(opts);
+    nc_server_tls_ctn_index_free(opts->ctn_idx);
     free(opts->ciphers);
+
+    nc_server_tls_cfg_free(opts->tls_cfg);
+    pthread_mutex_destroy(&opts->tls_cfg_lock);
+
     free(opts);
 }
 
@@ -1193,6 +1198,7 @@ nc_server_config_create_ssh(struct nc_endpt *endpt)
     endpt->ti = NC_TI_SSH;
     endpt->opts.ssh = calloc(1, sizeof(struct nc_server_ssh_opts));
     NC_CHECK_ERRMEM_RET(!endpt->opts.ssh, 1);
+    pthread_mutex_init(&endpt->opts.ssh->sbind_lock, NULL);
 
     return 0;
 }
@@ -1203,6 +1209,7 @@ nc_server_config_ch_create_ssh(struct nc_ch_endpt *ch_endpt)
     ch_endpt->ti = NC_TI_SSH;
     ch_endpt->opts.ssh = calloc(1, sizeof(struct nc_server_ssh_opts));
     NC_CHECK_ERRMEM_RET(!ch_endpt->opts.ssh, 1);
+    pthread_mutex_init(&ch_endpt->opts.ssh->sbind_lock, NULL);
 
     return 0;
 }
@@ -1269,6 +1276,7 @@ nc_server_config_create_tls(struct nc_endpt *endpt)
     endpt->ti = NC_TI_TLS;
     endpt->opts.tls = calloc(1, sizeof *endpt->opts.tls);
     NC_CHECK_ERRMEM_RET(!endpt->opts.tls, 1);
+    pthread_mutex_init(&endpt->opts.tls->tls_cfg_lock, NULL);
 
     return 0;
 }
@@ -1279,6 +1287,7 @@ nc_server_config_ch_create_tls(struct nc_ch_endpt *ch_endpt)
     ch_endpt->ti = NC_TI_TLS;
     ch_endpt->opts.tls = calloc(1, sizeof(struct nc_server_tls_opts));
     NC_CHECK_ERRMEM_RET(!ch_endpt->opts.tls, 1);
+    pthread_mutex_init(&ch_endpt->opts.tls->tls_cfg_lock, NULL);
 
     return 0;
 }
@@ -3979,6 +3988,15 @@ nc_server_config_setup_diff(const struct lyd_node *data)
     }
 
 cleanup:
+#ifdef NC_ENABLED_SSH_TLS
+    /* prepare the lookup indexes of the new configuration */
+    nc_server_ssh_pubkey_indexes_update();
+    nc_server_tls_ctn_indexes_update();
+#endif /* NC_ENABLED_SSH_TLS */
+
+    /* invalidate all the data cached for the previous configuration */
+    ATOMIC_INC_RELAXED(server_opts.config_gen);
+
     /* UNLOCK */
     pthread_rwlock_unlock(&server_opts.config_lock);
     return ret;
@@ -4044,6 +4062,15 @@ nc_server_config_setup_data(const struct lyd_node *data)
     }
 
 cleanup:
+#ifdef NC_ENABLED_SSH_TLS
+    /* prepare the lookup indexes of the new configuration */
+    nc_server_ssh_pubkey_indexes_update();
+    nc_server_tls_ctn_indexes_update();
+#endif /* NC_ENABLED_SSH_TLS */
+
+    /* invalidate all the data cached for the previous configuration */
+    ATOMIC_INC_RELAXED(server_opts.config_gen);
+
     /* UNLOCK */
     pthread_rwlock_unlock(&server_opts.config_lock);
     return ret;
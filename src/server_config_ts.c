@@ -283,6 +283,7 @@ nc_server_config_ts_del_public_key_bag(struct nc_public_key_bag *pbag)
     for (i = 0; i < pubkey_count; i++) {
         nc_server_config_ts_del_public_key(pbag, &pbag->pubkeys[i]);
     }
+    nc_server_ssh_pubkey_index_free(pbag->pubkey_idx);
 
     ts->pub_bag_count--;
     if (!ts->pub_bag_count) {
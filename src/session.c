@@ -104,7 +104,7 @@ nc_realtime_get(struct timespec *ts)
 }
 
 int
-nc_poll(struct pollfd *pfd, uint16_t pfd_count, int timeout_ms)
+nc_poll(struct pollfd *pfd, uint32_t pfd_count, int timeout_ms)
 {
     int rc;
     struct timespec start_ts;
@@ -806,7 +806,13 @@ nc_session_free_transport(struct nc_session *session, int *multisession)
         memset(&session->ti.tls.ctx, 0, sizeof session->ti.tls.ctx);
         nc_tls_session_destroy_wrap(session->ti.tls.session);
         session->ti.tls.session = NULL;
-        nc_tls_config_destroy_wrap(session->ti.tls.config);
+        if (session->ti.tls.srv_cfg) {
+            /* shared config */
+            nc_server_tls_cfg_free(session->ti.tls.srv_cfg);
+            session->ti.tls.srv_cfg = NULL;
+        } else {
+            nc_tls_config_destroy_wrap(session->ti.tls.config);
+        }
         session->ti.tls.config = NULL;
 
         if (session->side == NC_SERVER) {
@@ -830,6 +836,7 @@ nc_session_free(struct nc_session *session, void (*data_free)(void *))
 {
     int r, i, rpc_locked = 0, msgs_locked = 0, timeout;
     int multisession = 0; /* flag for more NETCONF sessions on a single SSH session */
+    uint32_t u;
     struct nc_msg_cont *contiter;
     struct ly_in *msg;
     struct timespec ts;
@@ -839,6 +846,13 @@ nc_session_free(struct nc_session *session, void (*data_free)(void *))
         return;
     }
 
+    if ((session->side == NC_SERVER) && (session->flags & NC_SESSION_STATS) &&
+            ((session->term_reason == NC_SESSION_TERM_DROPPED) || (session->term_reason == NC_SESSION_TERM_TIMEOUT) ||
+            (session->term_reason == NC_SESSION_TERM_OTHER))) {
+        /* abnormally terminated session */
+        ATOMIC_INC_RELAXED(server_opts.stats.dropped_sessions);
+    }
+
     /* stop notification threads if any */
     if ((session->side == NC_CLIENT) && ATOMIC_LOAD_RELAXED(session->opts.client.ntf_thread_running)) {
         /* let the threads know they should quit */
@@ -889,6 +903,10 @@ nc_session_free(struct nc_session *session, void (*data_free)(void *))
             contiter = contiter->next;
             free(p);
         }
+        for (u = 0; u < session->opts.client.replies_size; ++u) {
+            ly_in_free(session->opts.client.replies[u].msg, 1);
+        }
+        free(session->opts.client.replies);
 
         if (msgs_locked) {
             /* MSGS UNLOCK */
@@ -970,6 +988,7 @@ nc_session_free(struct nc_session *session, void (*data_free)(void *))
     nc_session_free_transport(session, &multisession);
 
     /* final cleanup */
+    free(session->rbuf.data);
     free(session->username);
     free(session->host);
     free(session->path);
@@ -981,6 +1000,7 @@ nc_session_free(struct nc_session *session, void (*data_free)(void *))
         }
         pthread_mutex_destroy(&session->opts.server.rpc_lock);
         pthread_cond_destroy(&session->opts.server.rpc_cond);
+        nc_ntf_queue_free(session->opts.server.ntf_queue);
     }
 
     if (session->io_lock && !multisession) {
@@ -1518,7 +1538,7 @@ cleanup:
 }
 
 NC_MSG_TYPE
-nc_handshake_io(struct nc_session *session)
+nc_server_handshake_start_io(struct nc_session *session)
 {
     NC_MSG_TYPE type;
 
@@ -1527,15 +1547,46 @@ nc_handshake_io(struct nc_session *session)
         return type;
     }
 
-    if (session->side == NC_CLIENT) {
-        type = nc_client_recv_hello_io(session);
-    } else {
-        type = nc_server_recv_hello_io(session);
+    /* the session is started once its <hello> is sent */
+    session->flags |= NC_SESSION_STATS;
+    ATOMIC_INC_RELAXED(server_opts.stats.in_sessions);
+
+    return type;
+}
+
+NC_MSG_TYPE
+nc_server_handshake_finish_io(struct nc_session *session)
+{
+    NC_MSG_TYPE type;
+
+    type = nc_server_recv_hello_io(session);
+    if (type == NC_MSG_BAD_HELLO) {
+        ATOMIC_INC_RELAXED(server_opts.stats.in_bad_hellos);
     }
 
     return type;
 }
 
+NC_MSG_TYPE
+nc_handshake_io(struct nc_session *session)
+{
+    NC_MSG_TYPE type;
+
+    if (session->side == NC_SERVER) {
+        type = nc_server_handshake_start_io(session);
+        if (type != NC_MSG_HELLO) {
+            return type;
+        }
+        return nc_server_handshake_finish_io(session);
+    }
+
+    type = nc_send_hello_io(session);
+    if (type != NC_MSG_HELLO) {
+        return type;
+    }
+    return nc_client_recv_hello_io(session);
+}
+
 #ifdef NC_ENABLED_SSH_TLS
 
 /**
@@ -1699,4 +1750,286 @@ cleanup:
     return ret;
 }
 
+/**
+ * @brief Download a CRL for the CRL cache.
+ *
+ * @param[in] handle CURL handle.
+ * @param[in] downloaded Storage of the downloaded data used by @p handle.
+ * @param[in] uri URI to download the CRL from.
+ * @param[out] data Downloaded CRL, null-terminated.
+ * @param[out] size Size of @p data.
+ * @param[out] refresh Real time of the next download.
+ * @return 0 on success, 1 on failure.
+ */
+static int
+nc_server_crl_cache_download(CURL *handle, struct nc_curl_data *downloaded, const char *uri, unsigned char **data,
+        size_t *size, time_t *refresh)
+{
+    int ret = 0;
+    time_t next_update, now;
+
+    *data = NULL;
+    *size = 0;
+
+    VRB(NULL, "Downloading CRL from \"%s\".", uri);
+    if (nc_session_curl_fetch(handle, uri)) {
+        ret = 1;
+        goto cleanup;
+    }
+
+    /* keep the data null-terminated for PEM parsers, which read the terminating byte, too */
+    *data = nc_realloc(downloaded->data, downloaded->size + 1);
+    downloaded->data = NULL;
+    NC_CHECK_ERRMEM_GOTO(!*data, ret = 1, cleanup);
+    (*data)[downloaded->size] = '\0';
+    *size = downloaded->size;
+
+    /* learn when the CRL should be refreshed, which also checks it can be parsed */
+    if (nc_server_tls_crl_next_update_wrap(*data, *size, &next_update)) {
+        ret = 1;
+        goto cleanup;
+    }
+
+    now = time(NULL);
+    if (!next_update) {
+        *refresh = now + NC_CRL_REFRESH_INTERVAL;
+    } else if (next_update < now + NC_CRL_RETRY_INTERVAL) {
+        /* outdated CRL, the new one may not have been published yet */
+        *refresh = now + NC_CRL_RETRY_INTERVAL;
+    } else {
+        *refresh = next_update;
+    }
+
+cleanup:
+    if (ret) {
+        free(*data);
+        *data = NULL;
+        *size = 0;
+    }
+    free(downloaded->data);
+    downloaded->data = NULL;
+    downloaded->size = 0;
+    return ret;
+}
+
+/**
+ * @brief CRL cache thread downloading all the CRLs that are not cached yet or should be refreshed.
+ *
+ * @param[in] arg CRL cache.
+ * @return NULL.
+ */
+static void *
+nc_server_crl_cache_thread(void *arg)
+{
+    struct nc_crl_cache *cache = arg;
+    CURL *handle = NULL;
+    struct nc_curl_data downloaded = {0};
+    struct nc_crl_cache_entry *entry;
+    struct timespec ts_timeout;
+    unsigned char *data;
+    size_t size;
+    time_t now, next, refresh;
+    char *uri;
+    uint32_t i;
+    int r;
+
+    if (nc_session_curl_init(&handle, &downloaded)) {
+        ERR(NULL, "CRL cache thread failed to start, CRLs will not be downloaded.");
+        curl_easy_cleanup(handle);
+        return NULL;
+    }
+
+    /* CRL CACHE LOCK */
+    pthread_mutex_lock(&cache->lock);
+
+    while (!cache->terminate) {
+        now = time(NULL);
+        next = now + NC_CRL_REFRESH_INTERVAL;
+
+        for (i = 0; (i < cache->entry_count) && !cache->terminate; ++i) {
+            if (cache->entries[i].refresh > now) {
+                if (cache->entries[i].refresh < next) {
+                    next = cache->entries[i].refresh;
+                }
+                continue;
+            }
+
+            /* download without holding the lock, entries are never removed */
+            uri = strdup(cache->entries[i].uri);
+            if (!uri) {
+                ERRMEM;
+                break;
+            }
+
+            /* CRL CACHE UNLOCK */
+            pthread_mutex_unlock(&cache->lock);
+
+            r = nc_server_crl_cache_download(handle, &downloaded, uri, &data, &size, &refresh);
+            if (r) {
+                WRN(NULL, "Failed to fetch CRL from \"%s\".", uri);
+                refresh = time(NULL) + NC_CRL_RETRY_INTERVAL;
+            }
+            free(uri);
+
+            /* CRL CACHE LOCK */
+            pthread_mutex_lock(&cache->lock);
+
+            entry = &cache->entries[i];
+            if (!r) {
+                /* replace the cached CRL, keep the previous one on failure */
+                free(entry->data);
+                entry->data = data;
+                entry->size = size;
+                ATOMIC_INC_RELAXED(cache->gen);
+            }
+            entry->refresh = refresh;
+            if (refresh < next) {
+                next = refresh;
+            }
+
+            /* wake anyone waiting for the first download */
+            pthread_cond_broadcast(&cache->fetch_cond);
+        }
+
+        if (cache->terminate) {
+            break;
+        }
+
+        /* wait for the next refresh or a new CRL to download */
+        now = time(NULL);
+        nc_timeouttime_get(&ts_timeout, (next > now) ? (next - now) * 1000 : 0);
+        pthread_cond_clockwait(&cache->cond, &cache->lock, COMPAT_CLOCK_ID, &ts_timeout);
+    }
+
+    /* CRL CACHE UNLOCK */
+    pthread_mutex_unlock(&cache->lock);
+
+    curl_easy_cleanup(handle);
+    return NULL;
+}
+
+/**
+ * @brief Find a CRL cache entry. Needs CRL CACHE LOCK.
+ *
+ * @param[in] cache CRL cache.
+ * @param[in] uri CRL distribution point URI.
+ * @return Index of the entry, entry count if not found.
+ */
+static uint32_t
+nc_server_crl_cache_find(const struct nc_crl_cache *cache, const char *uri)
+{
+    uint32_t i;
+
+    for (i = 0; i < cache->entry_count; ++i) {
+        if (!strcmp(cache->entries[i].uri, uri)) {
+            break;
+        }
+    }
+
+    return i;
+}
+
+int
+nc_server_crl_cache_get(char **uris, int uri_count, void *crl_store)
+{
+    struct nc_crl_cache *cache = &server_opts.crl_cache;
+    struct nc_crl_cache_entry *entry;
+    struct timespec ts_timeout;
+    int ret = 0, i, new_uri = 0, r;
+    uint32_t j;
+    void *mem;
+
+    /* CRL CACHE LOCK */
+    pthread_mutex_lock(&cache->lock);
+
+    for (i = 0; i < uri_count; ++i) {
+        if (nc_server_crl_cache_find(cache, uris[i]) < cache->entry_count) {
+            continue;
+        }
+
+        /* new URI, the CRL will be downloaded in the background */
+        mem = realloc(cache->entries, (cache->entry_count + 1) * sizeof *cache->entries);
+        NC_CHECK_ERRMEM_GOTO(!mem, ret = 1, cleanup);
+        cache->entries = mem;
+
+        entry = &cache->entries[cache->entry_count];
+        memset(entry, 0, sizeof *entry);
+        entry->uri = strdup(uris[i]);
+        NC_CHECK_ERRMEM_GOTO(!entry->uri, ret = 1, cleanup);
+        ++cache->entry_count;
+        new_uri = 1;
+    }
+
+    if (new_uri) {
+        if (!cache->thread_running) {
+            /* start the refresh thread */
+            if ((r = pthread_create(&cache->tid, NULL, nc_server_crl_cache_thread, cache))) {
+                ERR(NULL, "Failed to create the CRL cache thread (%s).", strerror(r));
+                ret = 1;
+                goto cleanup;
+            }
+            cache->thread_running = 1;
+        } else {
+            /* wake the refresh thread */
+            pthread_cond_signal(&cache->cond);
+        }
+    }
+
+    /* add the cached CRLs, wait for the first download of the new ones but never accept without them */
+    nc_timeouttime_get(&ts_timeout, NC_CRL_FETCH_TIMEOUT);
+    for (i = 0; i < uri_count; ++i) {
+        j = nc_server_crl_cache_find(cache, uris[i]);
+        r = 0;
+        while (!cache->entries[j].refresh && !cache->terminate && (r != ETIMEDOUT)) {
+            /* entries may be reallocated while waiting, but never removed */
+            r = pthread_cond_clockwait(&cache->fetch_cond, &cache->lock, COMPAT_CLOCK_ID, &ts_timeout);
+        }
+
+        entry = &cache->entries[j];
+        if (!entry->data) {
+            ERR(NULL, "CRL from \"%s\" is not available.", entry->uri);
+            ret = 1;
+            goto cleanup;
+        }
+        if (nc_server_tls_add_crl_to_store_wrap(entry->data, entry->size, crl_store)) {
+            ret = 1;
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    /* CRL CACHE UNLOCK */
+    pthread_mutex_unlock(&cache->lock);
+    return ret;
+}
+
+void
+nc_server_crl_cache_destroy(void)
+{
+    struct nc_crl_cache *cache = &server_opts.crl_cache;
+    uint32_t i;
+
+    /* CRL CACHE LOCK */
+    pthread_mutex_lock(&cache->lock);
+    cache->terminate = 1;
+    pthread_cond_signal(&cache->cond);
+    pthread_cond_broadcast(&cache->fetch_cond);
+    /* CRL CACHE UNLOCK */
+    pthread_mutex_unlock(&cache->lock);
+
+    if (cache->thread_running) {
+        pthread_join(cache->tid, NULL);
+        cache->thread_running = 0;
+    }
+
+    for (i = 0; i < cache->entry_count; ++i) {
+        free(cache->entries[i].uri);
+        free(cache->entries[i].data);
+    }
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->entry_count = 0;
+    cache->terminate = 0;
+}
+
 #endif
@@ -1782,7 +1782,7 @@ nc_client_ch_add_bind_listen(const char *address, uint16_t port, const char *hos
 
     NC_CHECK_ARG_RET(NULL, address, port, -1);
 
-    sock = nc_sock_listen_inet(address, port);
+    sock = nc_sock_listen_inet(address, port, 0);
     if (sock == -1) {
         return -1;
     }
@@ -1808,6 +1808,9 @@ nc_client_ch_add_bind_listen(const char *address, uint16_t port, const char *hos
     client_opts.ch_binds[client_opts.ch_bind_count - 1].port = port;
     client_opts.ch_binds[client_opts.ch_bind_count - 1].sock = sock;
     client_opts.ch_binds[client_opts.ch_bind_count - 1].pollin = 0;
+    client_opts.ch_binds[client_opts.ch_bind_count - 1].reuseport = 0;
+    client_opts.ch_binds[client_opts.ch_bind_count - 1].reuse_socks = NULL;
+    client_opts.ch_binds[client_opts.ch_bind_count - 1].reuse_sock_count = 0;
 
     return 0;
 }
@@ -2020,17 +2023,17 @@ recv_reply_check_msgid(struct nc_session *session, const struct lyd_node *envp,
  * @brief Used to roughly estimate the type of the message, does not actually parse or verify it.
  *
  * @param[in] session NETCONF session used to send error messages.
- * @param[in] msg Message to check for type.
+ * @param[in] str Message to check for type.
+ * @param[in] complete Whether @p str is the whole message or only its beginning.
  * @return NC_MSG_REPLY If format roughly matches a rpc-reply;
  * @return NC_MSG_NOTIF If format roughly matches a notification;
+ * @return NC_MSG_NONE If @p str is not @p complete and more of the message is needed;
  * @return NC_MSG_ERROR If format is malformed or unrecognized.
  */
 static NC_MSG_TYPE
-get_msg_type(struct nc_session *session, struct ly_in *msg)
+get_msg_type(struct nc_session *session, const char *str, int complete)
 {
-    const char *str, *end;
-
-    str = ly_in_memory(msg, NULL);
+    const char *end;
 
     while (*str) {
         /* Skip whitespaces */
@@ -2038,6 +2041,11 @@ get_msg_type(struct nc_session *session, struct ly_in *msg)
             str++;
         }
 
+        if (!complete && (strnlen(str, 13) < 13)) {
+            /* the longest start tag prefix "<notification" may not be whole */
+            return NC_MSG_NONE;
+        }
+
         if (*str == '<') {
             str++;
             if (!strncmp(str, "!--", 3)) {
@@ -2057,6 +2065,10 @@ get_msg_type(struct nc_session *session, struct ly_in *msg)
                 return NC_MSG_ERROR;
             }
             if (!str) {
+                if (!complete) {
+                    return NC_MSG_NONE;
+                }
+
                 /* No matching ending tag found */
                 ERR(session, "No matching ending tag '%s' found in xml message.", end);
                 return NC_MSG_ERROR;
@@ -2069,17 +2081,303 @@ get_msg_type(struct nc_session *session, struct ly_in *msg)
         }
     }
 
+    if (!complete) {
+        return NC_MSG_NONE;
+    }
+
     /* Unexpected end of message */
     ERR(session, "Unexpected end of xml message.");
     return NC_MSG_ERROR;
 }
 
+/**
+ * @brief Learn the message-id of a received rpc-reply without parsing it.
+ *
+ * @param[in] msg Received rpc-reply message, its beginning with the whole start tag is enough.
+ * @param[out] msgid Message-id of the reply.
+ * @return 0 on success;
+ * @return -1 if the reply has no valid message-id.
+ */
+static int
+recv_reply_get_msgid(const char *msg, uint64_t *msgid)
+{
+    const char *str, *end, *ptr;
+    char *num_end;
+    char quot;
+
+    /* skip whitespaces, comments, and the XML declaration, the whole message is never searched */
+    str = msg;
+    while (1) {
+        while (isspace(*str)) {
+            str++;
+        }
+
+        if (!strncmp(str, "<!--", 4)) {
+            end = "-->";
+        } else if (!strncmp(str, "<?", 2)) {
+            end = "?>";
+        } else {
+            break;
+        }
+        str = strstr(str, end);
+        if (!str) {
+            return -1;
+        }
+        str += strlen(end);
+    }
+
+    /* the start tag, the element name may have any prefix */
+    if ((*str != '<') || !(end = strchr(str, '>'))) {
+        return -1;
+    }
+    for (ptr = ++str; (ptr < end) && !isspace(*ptr) && (*ptr != '/') && (*ptr != ':'); ++ptr) {}
+    if (*ptr == ':') {
+        str = ptr + 1;
+    }
+    if (strncmp(str, "rpc-reply", 9) || (!isspace(str[9]) && (str[9] != '/') && (str[9] != '>'))) {
+        return -1;
+    }
+
+    /* find the attribute in the start tag */
+    for (str += 9; str + 10 <= end; ++str) {
+        if (strncmp(str, "message-id", 10) || !isspace(str[-1])) {
+            /* not the attribute or only the suffix of another attribute name */
+            continue;
+        }
+
+        for (ptr = str + 10; isspace(*ptr); ++ptr) {}
+        if (*ptr != '=') {
+            continue;
+        }
+        for (++ptr; isspace(*ptr); ++ptr) {}
+        quot = *ptr;
+        if (((quot != '\'') && (quot != '\"')) || !isdigit(ptr[1])) {
+            return -1;
+        }
+
+        errno = 0;
+        *msgid = strtoull(ptr + 1, &num_end, 10);
+        if (errno || (*num_end != quot)) {
+            return -1;
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Insert a reply into a pipelining replies table with a free slot, linear probing is used.
+ *
+ * @param[in] replies Replies table.
+ * @param[in] size Size of @p replies.
+ * @param[in] msgid Message-id of the reply.
+ * @param[in] msg Reply to insert.
+ */
+static void
+recv_reply_table_insert(struct nc_msg_cont *replies, uint32_t size, uint64_t msgid, struct ly_in *msg)
+{
+    uint32_t idx;
+
+    for (idx = msgid % size; replies[idx].msg; idx = (idx + 1) % size) {}
+    replies[idx].msgid = msgid;
+    replies[idx].msg = msg;
+}
+
+/**
+ * @brief Keep a reply to another RPC in the pipelining replies table. Needs MSGS LOCK.
+ *
+ * The table is an open-addressing hash table with linear probing indexed by message-id modulo its size,
+ * it is doubled whenever it would become more than half full.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] msgid Message-id of the reply.
+ * @param[in] msg Reply to keep, spent only on success.
+ * @return 0 on success;
+ * @return -1 on error.
+ */
+static int
+recv_reply_park(struct nc_session *session, uint64_t msgid, struct ly_in *msg)
+{
+    struct nc_msg_cont *replies = session->opts.client.replies;
+    uint32_t size = session->opts.client.replies_size, u;
+
+    /* check for a duplicate */
+    if (size) {
+        for (u = msgid % size; replies[u].msg; u = (u + 1) % size) {
+            if (replies[u].msgid == msgid) {
+                ERR(session, "Received a duplicate reply with message-id %" PRIu64 ".", msgid);
+                return -1;
+            }
+        }
+    }
+
+    if ((session->opts.client.replies_count + 1) * 2 > size) {
+        /* (re)create the table twice the size */
+        if (size > UINT32_MAX / 4) {
+            ERR(session, "Too many RPC replies kept in the pipelining mode.");
+            return -1;
+        }
+        size = size ? size * 2 : 16;
+
+        replies = calloc(size, sizeof *replies);
+        NC_CHECK_ERRMEM_RET(!replies, -1);
+        for (u = 0; u < session->opts.client.replies_size; ++u) {
+            if (session->opts.client.replies[u].msg) {
+                recv_reply_table_insert(replies, size, session->opts.client.replies[u].msgid,
+                        session->opts.client.replies[u].msg);
+            }
+        }
+
+        free(session->opts.client.replies);
+        session->opts.client.replies = replies;
+        session->opts.client.replies_size = size;
+    }
+
+    recv_reply_table_insert(replies, size, msgid, msg);
+    ++session->opts.client.replies_count;
+    return 0;
+}
+
+/**
+ * @brief Take a kept reply out of the pipelining replies table. Needs MSGS LOCK.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] msgid Message-id of the reply.
+ * @return Kept reply, NULL if not received yet.
+ */
+static struct ly_in *
+recv_reply_unpark(struct nc_session *session, uint64_t msgid)
+{
+    struct nc_msg_cont *replies = session->opts.client.replies;
+    uint32_t size = session->opts.client.replies_size, idx, u, home;
+    struct ly_in *msg;
+
+    if (!size) {
+        return NULL;
+    }
+
+    for (idx = msgid % size; replies[idx].msg && (replies[idx].msgid != msgid); idx = (idx + 1) % size) {}
+    if (!replies[idx].msg) {
+        return NULL;
+    }
+
+    msg = replies[idx].msg;
+    replies[idx].msg = NULL;
+    --session->opts.client.replies_count;
+
+    /* move the following replies of the probe sequence back so that no lookup stops at the freed slot,
+     * a reply can be moved if its home slot is not (cyclically) between the freed slot and its slot */
+    for (u = (idx + 1) % size; replies[u].msg; u = (u + 1) % size) {
+        home = replies[u].msgid % size;
+        if ((u > idx) ? ((home <= idx) || (home > u)) : ((home <= idx) && (home > u))) {
+            replies[idx] = replies[u];
+            replies[u].msg = NULL;
+            idx = u;
+        }
+    }
+
+    return msg;
+}
+
+/**
+ * @brief Take an already received message out of the session buffers. Needs MSGS LOCK.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] expected Type of the message the caller desired.
+ * @param[in] msgid Message-id of the desired reply, used only in the pipelining mode.
+ * @param[out] msg Taken message.
+ * @return Type of the taken message;
+ * @return NC_MSG_NONE if no such message was received.
+ */
+static NC_MSG_TYPE
+recv_msg_take(struct nc_session *session, NC_MSG_TYPE expected, uint64_t msgid, struct ly_in **msg)
+{
+    struct nc_msg_cont *cont, *prev;
+    NC_MSG_TYPE type;
+
+    if ((expected == NC_MSG_REPLY) && (session->flags & NC_SESSION_CLIENT_PIPELINING)) {
+        /* the reply may have already been received */
+        *msg = recv_reply_unpark(session, msgid);
+        if (*msg) {
+            return NC_MSG_REPLY;
+        }
+    }
+
+    /* Find the expected message in the buffer */
+    prev = NULL;
+    for (cont = session->opts.client.msgs; cont && (cont->type != expected); cont = cont->next) {
+        prev = cont;
+    }
+    if (!cont) {
+        return NC_MSG_NONE;
+    }
+
+    /* Remove found message from buffer */
+    if (prev) {
+        prev->next = cont->next;
+    } else {
+        session->opts.client.msgs = cont->next;
+    }
+
+    /* Use the buffer message */
+    type = cont->type;
+    *msg = cont->msg;
+    free(cont);
+    return type;
+}
+
+/**
+ * @brief Keep a received message of an unexpected type in the session buffer. Needs MSGS LOCK.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] type Type of the message.
+ * @param[in] msg Message to keep, spent only on success.
+ * @return 0 on success;
+ * @return -1 on error.
+ */
+static int
+recv_msg_store(struct nc_session *session, NC_MSG_TYPE type, struct ly_in *msg)
+{
+    struct nc_msg_cont **cont_ptr;
+
+    cont_ptr = &session->opts.client.msgs;
+    while (*cont_ptr) {
+        cont_ptr = &((*cont_ptr)->next);
+    }
+    *cont_ptr = malloc(sizeof **cont_ptr);
+    NC_CHECK_ERRMEM_RET(!*cont_ptr, -1);
+    (*cont_ptr)->msg = msg;
+    (*cont_ptr)->type = type;
+    (*cont_ptr)->next = NULL;
+
+    return 0;
+}
+
+/**
+ * @brief Learn whether a received rpc-reply is a reply to another sent RPC that should be kept in the pipelining mode.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] msg Received rpc-reply message, its beginning with the whole start tag is enough.
+ * @param[in] expected Type of the message the caller desired.
+ * @param[in] msgid Message-id of the desired reply.
+ * @param[out] cur_msgid Message-id of the received reply, set if it should be kept.
+ * @return Whether the reply should be kept.
+ */
+static int
+recv_reply_is_other(struct nc_session *session, const char *msg, NC_MSG_TYPE expected, uint64_t msgid, uint64_t *cur_msgid)
+{
+    return (session->flags & NC_SESSION_CLIENT_PIPELINING) && !recv_reply_get_msgid(msg, cur_msgid) &&
+           (*cur_msgid <= session->opts.client.msgid) && ((expected != NC_MSG_REPLY) || (*cur_msgid != msgid));
+}
+
 /**
  * @brief Function to receive either replies or notifications.
  *
  * @param[in] session NETCONF session from which this function receives messages.
  * @param[in] timeout Timeout for reading in milliseconds. Use negative value for infinite.
  * @param[in] expected Type of the message the caller desired.
+ * @param[in] msgid Message-id of the desired reply, used only in the pipelining mode.
  * @param[out] message If receiving a message succeeded this is the message, NULL otherwise.
  * @return NC_MSG_REPLY If a rpc-reply was received;
  * @return NC_MSG_NOTIF If a notification was received;
@@ -2087,12 +2385,12 @@ get_msg_type(struct nc_session *session, struct ly_in *msg)
  * @return NC_MSG_WOULDBLOCK If the timeout was reached.
  */
 static NC_MSG_TYPE
-recv_msg(struct nc_session *session, int timeout, NC_MSG_TYPE expected, struct ly_in **message)
+recv_msg(struct nc_session *session, int timeout, NC_MSG_TYPE expected, uint64_t msgid, struct ly_in **message)
 {
-    struct nc_msg_cont **cont_ptr;
     struct ly_in *msg = NULL;
-    struct nc_msg_cont *cont, *prev;
     NC_MSG_TYPE ret = NC_MSG_ERROR;
+    struct timespec ts_timeout;
+    uint64_t cur_msgid;
     int r;
 
     *message = NULL;
@@ -2107,27 +2405,17 @@ recv_msg(struct nc_session *session, int timeout, NC_MSG_TYPE expected, struct l
         goto cleanup;
     }
 
-    /* Find the expected message in the buffer */
-    prev = NULL;
-    for (cont = session->opts.client.msgs; cont && (cont->type != expected); cont = cont->next) {
-        prev = cont;
+    /* the message may have already been received */
+    ret = recv_msg_take(session, expected, msgid, &msg);
+    if (ret != NC_MSG_NONE) {
+        goto cleanup_unlock;
     }
 
-    if (cont) {
-        /* Remove found message from buffer */
-        if (prev) {
-            prev->next = cont->next;
-        } else {
-            session->opts.client.msgs = cont->next;
-        }
-
-        /* Use the buffer message */
-        ret = cont->type;
-        msg = cont->msg;
-        free(cont);
-        goto cleanup_unlock;
+    if (timeout > 0) {
+        nc_timeouttime_get(&ts_timeout, timeout);
     }
 
+read_msg:
     /* Read a message from the wire */
     r = nc_read_msg_poll_io(session, timeout, &msg);
     if (!r) {
@@ -2139,23 +2427,39 @@ recv_msg(struct nc_session *session, int timeout, NC_MSG_TYPE expected, struct l
     }
 
     /* Basic check to determine message type */
-    ret = get_msg_type(session, msg);
+    ret = get_msg_type(session, ly_in_memory(msg, NULL), 1);
     if (ret == NC_MSG_ERROR) {
         goto cleanup_unlock;
     }
 
+    if ((ret == NC_MSG_REPLY) && recv_reply_is_other(session, ly_in_memory(msg, NULL), expected, msgid, &cur_msgid)) {
+        /* reply to another sent RPC, keep it until requested */
+        if (recv_reply_park(session, cur_msgid, msg)) {
+            ret = NC_MSG_ERROR;
+            goto cleanup_unlock;
+        }
+        msg = NULL;
+
+        if (expected == NC_MSG_REPLY) {
+            /* keep reading until the requested reply is received */
+            if (timeout > 0) {
+                timeout = nc_timeouttime_cur_diff(&ts_timeout);
+                if (timeout < 1) {
+                    timeout = 0;
+                }
+            }
+            goto read_msg;
+        }
+        goto cleanup_unlock;
+    }
+
     /* If received a message of different type store it in the buffer */
     if (ret != expected) {
-        cont_ptr = &session->opts.client.msgs;
-        while (*cont_ptr) {
-            cont_ptr = &((*cont_ptr)->next);
+        if (recv_msg_store(session, ret, msg)) {
+            ret = NC_MSG_ERROR;
+            goto cleanup_unlock;
         }
-        *cont_ptr = malloc(sizeof **cont_ptr);
-        NC_CHECK_ERRMEM_GOTO(!*cont_ptr, ret = NC_MSG_ERROR, cleanup_unlock);
-        (*cont_ptr)->msg = msg;
         msg = NULL;
-        (*cont_ptr)->type = ret;
-        (*cont_ptr)->next = NULL;
     }
 
 cleanup_unlock:
@@ -2184,7 +2488,7 @@ recv_reply(struct nc_session *session, int timeout, struct lyd_node *op, uint64_
     *envp = NULL;
 
     /* Receive messages until a rpc-reply is found or a timeout or error reached */
-    ret = recv_msg(session, timeout, NC_MSG_REPLY, &msg);
+    ret = recv_msg(session, timeout, NC_MSG_REPLY, msgid, &msg);
     if (ret != NC_MSG_REPLY) {
         goto cleanup;
     }
@@ -2405,6 +2709,280 @@ nc_recv_reply(struct nc_session *session, struct nc_rpc *rpc, uint64_t msgid, in
     return ret;
 }
 
+/**
+ * @brief Check the message-id of a received rpc-reply without parsing it.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] msg Received rpc-reply message, its beginning with the whole start tag is enough.
+ * @param[in] msgid Expected message-id.
+ * @return NC_MSG_REPLY if the message-id matches;
+ * @return NC_MSG_REPLY_ERR_MSGID if the message-id is missing or does not match.
+ */
+static NC_MSG_TYPE
+recv_reply_stream_check_msgid(struct nc_session *session, const char *msg, uint64_t msgid)
+{
+    uint64_t cur_msgid;
+
+    if (recv_reply_get_msgid(msg, &cur_msgid)) {
+        ERR(session, "Received a <rpc-reply> without a message-id.");
+        return NC_MSG_REPLY_ERR_MSGID;
+    }
+
+    if (cur_msgid != msgid) {
+        ERR(session, "Received a <rpc-reply> with an unexpected message-id %" PRIu64 " (expected %" PRIu64 ").",
+                cur_msgid, msgid);
+        return NC_MSG_REPLY_ERR_MSGID;
+    }
+
+    return NC_MSG_REPLY;
+}
+
+/**
+ * @brief Arguments of the callback reading a message for nc_recv_reply_stream().
+ */
+struct recv_reply_stream_arg {
+    struct nc_session *session;
+    uint64_t msgid;
+    nc_reply_stream_clb stream_clb;
+    void *user_data;
+
+    char *buf;              /**< buffered beginning of the message or the whole message if not streamed */
+    size_t len;
+    size_t size;
+
+    NC_MSG_TYPE type;       /**< type of the message, NC_MSG_NONE until learned */
+    NC_MSG_TYPE ret;        /**< result of the message-id check of a streamed reply */
+    int stream;             /**< whether the message data are passed to the callback */
+    int discard;            /**< whether the rest of the message data are only dropped */
+    int err;                /**< whether an internal error occurred */
+};
+
+/**
+ * @brief Decide what to do with a message being read based on its buffered beginning.
+ *
+ * @param[in] arg Reading arguments.
+ */
+static void
+recv_reply_stream_decide(struct recv_reply_stream_arg *arg)
+{
+    const char *start;
+    uint64_t cur_msgid;
+
+    arg->type = get_msg_type(arg->session, arg->buf, 0);
+    if (arg->type == NC_MSG_ERROR) {
+        /* malformed message */
+        arg->discard = 1;
+        return;
+    } else if (arg->type != NC_MSG_REPLY) {
+        /* more data are needed or a notification that is kept whole */
+        return;
+    }
+
+    start = strstr(arg->buf, "<rpc-reply");
+    if (!start || !strchr(start, '>')) {
+        /* the whole start tag is needed */
+        arg->type = NC_MSG_NONE;
+        return;
+    }
+
+    if (recv_reply_is_other(arg->session, arg->buf, NC_MSG_REPLY, arg->msgid, &cur_msgid)) {
+        /* reply to another sent RPC, it is kept whole */
+        return;
+    }
+
+    /* the requested reply, pass the buffered data and all the following ones to the callback */
+    arg->ret = recv_reply_stream_check_msgid(arg->session, arg->buf, arg->msgid);
+    arg->stream = 1;
+    if (arg->stream_clb(arg->buf, arg->len, arg->user_data)) {
+        arg->discard = 1;
+    }
+
+    free(arg->buf);
+    arg->buf = NULL;
+    arg->len = 0;
+    arg->size = 0;
+}
+
+/**
+ * @brief Callback for the data of a message being read by nc_recv_reply_stream().
+ */
+static void
+recv_reply_stream_read_clb(const char *data, size_t len, void *user_data)
+{
+    struct recv_reply_stream_arg *arg = user_data;
+
+    if (arg->discard) {
+        /* drop the data */
+        return;
+    }
+
+    if (arg->stream) {
+        if (arg->stream_clb(data, len, arg->user_data)) {
+            arg->discard = 1;
+        }
+        return;
+    }
+
+    /* buffer the data */
+    if (arg->len + len + 1 > arg->size) {
+        arg->size = 2 * (arg->len + len + 1);
+        arg->buf = nc_realloc(arg->buf, arg->size);
+        if (!arg->buf) {
+            ERRMEM;
+            arg->len = 0;
+            arg->size = 0;
+            arg->err = 1;
+            arg->discard = 1;
+            return;
+        }
+    }
+    memcpy(arg->buf + arg->len, data, len);
+    arg->len += len;
+    arg->buf[arg->len] = '\0';
+
+    if (arg->type == NC_MSG_NONE) {
+        recv_reply_stream_decide(arg);
+    }
+}
+
+/**
+ * @brief Pass a whole received rpc-reply to the stream callback.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] msg Received rpc-reply message.
+ * @param[in] msgid Expected message-id.
+ * @param[in] stream_clb Callback to pass the reply to.
+ * @param[in] user_data Arbitrary user data passed to @p stream_clb.
+ * @return Received message type as returned by nc_recv_reply_stream().
+ */
+static NC_MSG_TYPE
+recv_reply_stream_whole(struct nc_session *session, struct ly_in *msg, uint64_t msgid, nc_reply_stream_clb stream_clb,
+        void *user_data)
+{
+    const char *str;
+    NC_MSG_TYPE ret;
+
+    str = ly_in_memory(msg, NULL);
+    ret = recv_reply_stream_check_msgid(session, str, msgid);
+    if (stream_clb(str, strlen(str), user_data)) {
+        ret = NC_MSG_ERROR;
+    }
+
+    return ret;
+}
+
+API NC_MSG_TYPE
+nc_recv_reply_stream(struct nc_session *session, uint64_t msgid, int timeout, nc_reply_stream_clb stream_clb,
+        void *user_data)
+{
+    struct recv_reply_stream_arg arg = {0};
+    struct ly_in *msg = NULL;
+    struct timespec ts_timeout;
+    uint64_t cur_msgid;
+    NC_MSG_TYPE ret;
+    int r;
+
+    NC_CHECK_ARG_RET(session, session, stream_clb, NC_MSG_ERROR);
+
+    if ((session->status != NC_STATUS_RUNNING) || (session->side != NC_CLIENT)) {
+        ERR(session, "Invalid session to receive RPC replies.");
+        return NC_MSG_ERROR;
+    }
+
+    /* MSGS LOCK */
+    r = nc_session_client_msgs_lock(session, &timeout, __func__);
+    if (!r) {
+        return NC_MSG_WOULDBLOCK;
+    } else if (r == -1) {
+        return NC_MSG_ERROR;
+    }
+
+    /* the reply may have already been received */
+    if (recv_msg_take(session, NC_MSG_REPLY, msgid, &msg) == NC_MSG_REPLY) {
+        ret = recv_reply_stream_whole(session, msg, msgid, stream_clb, user_data);
+        goto cleanup_unlock;
+    }
+
+    if (timeout > 0) {
+        nc_timeouttime_get(&ts_timeout, timeout);
+    }
+
+read_msg:
+    memset(&arg, 0, sizeof arg);
+    arg.session = session;
+    arg.msgid = msgid;
+    arg.stream_clb = stream_clb;
+    arg.user_data = user_data;
+    arg.type = NC_MSG_NONE;
+
+    /* read a message from the wire, the requested reply is passed to the callback as it is read */
+    r = nc_read_msg_poll_clb_io(session, timeout, recv_reply_stream_read_clb, &arg);
+    if (!r) {
+        ret = NC_MSG_WOULDBLOCK;
+        goto cleanup_unlock;
+    } else if ((r < 0) || arg.err) {
+        ret = NC_MSG_ERROR;
+        goto cleanup_unlock;
+    } else if (arg.stream) {
+        ret = arg.discard ? NC_MSG_ERROR : arg.ret;
+        goto cleanup_unlock;
+    } else if (arg.type == NC_MSG_ERROR) {
+        ret = NC_MSG_ERROR;
+        goto cleanup_unlock;
+    }
+
+    /* the message was read whole */
+    if (!arg.buf) {
+        /* empty message, only log the error */
+        ret = get_msg_type(session, "", 1);
+        goto cleanup_unlock;
+    }
+    if (ly_in_new_memory(arg.buf, &msg)) {
+        ret = NC_MSG_ERROR;
+        goto cleanup_unlock;
+    }
+    arg.buf = NULL;
+
+    /* basic check to determine message type */
+    ret = get_msg_type(session, ly_in_memory(msg, NULL), 1);
+    if (ret == NC_MSG_REPLY) {
+        if (recv_reply_is_other(session, ly_in_memory(msg, NULL), NC_MSG_REPLY, msgid, &cur_msgid)) {
+            /* reply to another sent RPC, keep it until requested */
+            if (recv_reply_park(session, cur_msgid, msg)) {
+                ret = NC_MSG_ERROR;
+                goto cleanup_unlock;
+            }
+            msg = NULL;
+
+            /* keep reading until the requested reply is received */
+            if (timeout > 0) {
+                timeout = nc_timeouttime_cur_diff(&ts_timeout);
+                if (timeout < 1) {
+                    timeout = 0;
+                }
+            }
+            goto read_msg;
+        }
+
+        ret = recv_reply_stream_whole(session, msg, msgid, stream_clb, user_data);
+    } else if (ret == NC_MSG_NOTIF) {
+        /* store the notification in the buffer */
+        if (recv_msg_store(session, ret, msg)) {
+            ret = NC_MSG_ERROR;
+            goto cleanup_unlock;
+        }
+        msg = NULL;
+    }
+
+cleanup_unlock:
+    /* MSGS UNLOCK */
+    nc_session_client_msgs_unlock(session, __func__);
+
+    free(arg.buf);
+    ly_in_free(msg, 1);
+    return ret;
+}
+
 static NC_MSG_TYPE
 recv_notif(struct nc_session *session, int timeout, struct lyd_node **envp, struct lyd_node **op)
 {
@@ -2416,7 +2994,7 @@ recv_notif(struct nc_session *session, int timeout, struct lyd_node **envp, stru
     *envp = NULL;
 
     /* Receive messages until a notification is found or a timeout or error reached */
-    ret = recv_msg(session, timeout, NC_MSG_NOTIF, &msg);
+    ret = recv_msg(session, timeout, NC_MSG_NOTIF, 0, &msg);
     if (ret != NC_MSG_NOTIF) {
         goto cleanup;
     }
@@ -3193,3 +3771,41 @@ nc_client_session_set_not_strict(struct nc_session *session)
 
     session->flags |= NC_SESSION_CLIENT_NOT_STRICT;
 }
+
+API int
+nc_client_session_set_pipelining(struct nc_session *session, int enable)
+{
+    uint32_t u;
+    int timeout = -1;
+
+    NC_CHECK_ARG_RET(session, session, -1);
+    if (session->side != NC_CLIENT) {
+        ERRARG(NULL, "session");
+        return -1;
+    }
+
+    if (enable) {
+        session->flags |= NC_SESSION_CLIENT_PIPELINING;
+        return 0;
+    }
+
+    /* MSGS LOCK */
+    if (nc_session_client_msgs_lock(session, &timeout, __func__) != 1) {
+        return -1;
+    }
+
+    session->flags &= ~NC_SESSION_CLIENT_PIPELINING;
+
+    /* drop all the kept replies */
+    for (u = 0; u < session->opts.client.replies_size; ++u) {
+        ly_in_free(session->opts.client.replies[u].msg, 1);
+    }
+    free(session->opts.client.replies);
+    session->opts.client.replies = NULL;
+    session->opts.client.replies_size = 0;
+    session->opts.client.replies_count = 0;
+
+    /* MSGS UNLOCK */
+    nc_session_client_msgs_unlock(session, __func__);
+    return 0;
+}
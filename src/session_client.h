@@ -457,6 +457,18 @@ int nc_client_tls_set_crl_paths(const char *crl_file, const char *crl_dir);
  */
 void nc_client_tls_get_crl_paths(const char **crl_file, const char **crl_dir);
 
+/**
+ * @brief Set the number of TLS sessions kept for resumption, disabled by default.
+ *
+ * A session established by ::nc_connect_tls() is kept for its host and port and a following connection
+ * to the same host and port tries to resume it instead of performing the full TLS handshake.
+ * If the limit is reached, the oldest kept session is replaced. Changing the client certificate
+ * or the trusted CA certificates drops all the kept sessions.
+ *
+ * @param[in] cache_size Maximum number of kept sessions, 0 to disable resumption.
+ */
+void nc_client_tls_set_resumption(uint32_t cache_size);
+
 /**
  * @brief Connect to the NETCONF server using TLS transport (via libssl)
  *
@@ -535,6 +547,43 @@ int nc_session_ntf_thread_running(const struct nc_session *session);
 NC_MSG_TYPE nc_recv_reply(struct nc_session *session, struct nc_rpc *rpc, uint64_t msgid, int timeout,
         struct lyd_node **envp, struct lyd_node **op);
 
+/**
+ * @brief Callback for receiving a NETCONF RPC reply incrementally.
+ *
+ * @param[in] data Next part of the raw rpc-reply XML, not terminated.
+ * @param[in] len Length of @p data.
+ * @param[in] user_data Arbitrary user data passed to the callback.
+ * @return 0 to continue receiving the reply;
+ * @return non-zero to stop, the rest of the reply is then read and discarded.
+ */
+typedef int (*nc_reply_stream_clb)(const char *data, size_t len, void *user_data);
+
+/**
+ * @brief Receive NETCONF RPC reply incrementally, without keeping it whole in memory.
+ *
+ * Useful for replies with large data such as \<get\> or \<get-config\> of a huge datastore. The raw
+ * rpc-reply XML is passed to @p stream_clb part by part as it is read from the wire (chunk by chunk
+ * with the :base:1.1 framing) and it is neither parsed nor validated, only the message-id of its
+ * start tag is checked before passing any data.
+ *
+ * @note This function can be called in a single thread only. @p stream_clb must not use the session.
+ *
+ * @param[in] session NETCONF session from which the function gets data. It must be the
+ * client side session object.
+ * @param[in] msgid Expected message ID of the reply.
+ * @param[in] timeout Timeout for reading in milliseconds. Use negative value for infinite
+ * waiting and 0 for immediate return if data are not available on the wire.
+ * @param[in] stream_clb Callback called for every received part of the reply.
+ * @param[in] user_data Arbitrary user data passed to @p stream_clb.
+ * @return #NC_MSG_REPLY for success,
+ *         #NC_MSG_WOULDBLOCK if @p timeout has elapsed,
+ *         #NC_MSG_ERROR if reading has failed or @p stream_clb stopped receiving the reply,
+ *         #NC_MSG_NOTIF if a notification was read instead (call this function again to get the reply), and
+ *         #NC_MSG_REPLY_ERR_MSGID if a reply with missing or wrong message-id was received.
+ */
+NC_MSG_TYPE nc_recv_reply_stream(struct nc_session *session, uint64_t msgid, int timeout,
+        nc_reply_stream_clb stream_clb, void *user_data);
+
 /**
  * @brief Receive NETCONF Notification.
  *
@@ -615,6 +664,20 @@ NC_MSG_TYPE nc_send_rpc(struct nc_session *session, struct nc_rpc *rpc, int time
  */
 void nc_client_session_set_not_strict(struct nc_session *session);
 
+/**
+ * @brief Enable or disable RPC pipelining on a session.
+ *
+ * In the pipelining mode, several RPCs can be sent using ::nc_send_rpc() before receiving any of
+ * their replies. Replies to other RPCs than the one requested in ::nc_recv_reply() are kept in the session
+ * and returned once their message-id is requested, so the replies can be received in any order.
+ * Replies that are never requested are kept until the session is freed or pipelining is disabled.
+ *
+ * @param[in] session NETCONF client session.
+ * @param[in] enable Whether to enable (non-zero) or disable (0) the pipelining mode.
+ * @return 0 on success, -1 on error.
+ */
+int nc_client_session_set_pipelining(struct nc_session *session, int enable);
+
 /** @} Client Session */
 
 #ifdef __cplusplus
@@ -40,9 +40,116 @@ struct nc_client_context *nc_client_context_location(void);
 #define tls_opts nc_client_context_location()->tls_opts
 #define tls_ch_opts nc_client_context_location()->tls_ch_opts
 
+/**
+ * @brief Free all the TLS sessions kept for resumption.
+ *
+ * @param[in] opts TLS client options.
+ */
+static void
+nc_client_tls_sess_cache_clear(struct nc_client_tls_opts *opts)
+{
+    uint32_t i;
+
+    for (i = 0; i < opts->sess_cache_count; ++i) {
+        free(opts->sess_cache[i].host);
+        nc_client_tls_session_free_wrap(opts->sess_cache[i].tls_sess);
+    }
+    free(opts->sess_cache);
+    opts->sess_cache = NULL;
+    opts->sess_cache_count = 0;
+    opts->sess_cache_next = 0;
+}
+
+/**
+ * @brief Find a TLS session kept for resumption.
+ *
+ * @param[in] opts TLS client options.
+ * @param[in] host Host of the session.
+ * @param[in] port Port of the session.
+ * @return Kept session, NULL if there is none.
+ */
+static struct nc_client_tls_sess *
+nc_client_tls_sess_cache_find(struct nc_client_tls_opts *opts, const char *host, uint16_t port)
+{
+    uint32_t i;
+
+    for (i = 0; i < opts->sess_cache_count; ++i) {
+        if ((opts->sess_cache[i].port == port) && !strcmp(opts->sess_cache[i].host, host)) {
+            return &opts->sess_cache[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Keep an established TLS session for resumption, replacing the oldest one if the cache is full.
+ *
+ * @param[in] opts TLS client options.
+ * @param[in] host Host of the session.
+ * @param[in] port Port of the session.
+ * @param[in] tls_session Established TLS session.
+ */
+static void
+nc_client_tls_sess_cache_store(struct nc_client_tls_opts *opts, const char *host, uint16_t port, void *tls_session)
+{
+    struct nc_client_tls_sess *entry;
+    void *tls_sess, *ptr;
+    char *host_dup;
+
+    if (!opts->sess_cache_size) {
+        return;
+    }
+
+    tls_sess = nc_client_tls_session_save_wrap(tls_session);
+    if (!tls_sess) {
+        /* not resumable */
+        return;
+    }
+
+    entry = nc_client_tls_sess_cache_find(opts, host, port);
+    if (entry) {
+        /* replace the previous session */
+        nc_client_tls_session_free_wrap(entry->tls_sess);
+        entry->tls_sess = tls_sess;
+        return;
+    }
+
+    host_dup = strdup(host);
+    if (!host_dup) {
+        ERRMEM;
+        nc_client_tls_session_free_wrap(tls_sess);
+        return;
+    }
+
+    if (opts->sess_cache_count < opts->sess_cache_size) {
+        /* new entry */
+        ptr = realloc(opts->sess_cache, (opts->sess_cache_count + 1) * sizeof *opts->sess_cache);
+        if (!ptr) {
+            ERRMEM;
+            free(host_dup);
+            nc_client_tls_session_free_wrap(tls_sess);
+            return;
+        }
+        opts->sess_cache = ptr;
+        entry = &opts->sess_cache[opts->sess_cache_count++];
+    } else {
+        /* evict the oldest entry */
+        entry = &opts->sess_cache[opts->sess_cache_next];
+        opts->sess_cache_next = (opts->sess_cache_next + 1) % opts->sess_cache_size;
+        free(entry->host);
+        nc_client_tls_session_free_wrap(entry->tls_sess);
+    }
+
+    entry->host = host_dup;
+    entry->port = port;
+    entry->tls_sess = tls_sess;
+}
+
 void
 _nc_client_tls_destroy_opts(struct nc_client_tls_opts *opts)
 {
+    nc_client_tls_sess_cache_clear(opts);
     free(opts->cert_path);
     free(opts->key_path);
     free(opts->ca_file);
@@ -62,6 +169,9 @@ _nc_client_tls_set_cert_key_paths(const char *client_cert, const char *client_ke
 {
     NC_CHECK_ARG_RET(NULL, client_cert, -1);
 
+    /* kept sessions were authenticated with the previous identity */
+    nc_client_tls_sess_cache_clear(opts);
+
     free(opts->cert_path);
     free(opts->key_path);
 
@@ -126,6 +236,9 @@ _nc_client_tls_set_trusted_ca_paths(const char *ca_file, const char *ca_dir, str
         return -1;
     }
 
+    /* kept sessions were verified with the previous CA certificates */
+    nc_client_tls_sess_cache_clear(opts);
+
     free(opts->ca_file);
     free(opts->ca_dir);
 
@@ -256,8 +369,16 @@ nc_client_tls_connect_check(int connect_ret, void *tls_session, const char *peer
     return connect_ret;
 }
 
+API void
+nc_client_tls_set_resumption(uint32_t cache_size)
+{
+    nc_client_tls_sess_cache_clear(&tls_opts);
+    tls_opts.sess_cache_size = cache_size;
+}
+
 static void *
-nc_client_tls_session_new(int sock, const char *host, int timeout, struct nc_client_tls_opts *opts, void **out_tls_cfg, struct nc_tls_ctx *tls_ctx)
+nc_client_tls_session_new(int sock, const char *host, int timeout, struct nc_client_tls_opts *opts, void *resume_sess,
+        void **out_tls_cfg, struct nc_tls_ctx *tls_ctx)
 {
     int ret = 0, sock_tmp = sock;
     struct timespec ts_timeout;
@@ -315,7 +436,9 @@ nc_client_tls_session_new(int sock, const char *host, int timeout, struct nc_cli
     }
 
     /* set session fd */
-    nc_server_tls_set_fd_wrap(tls_session, sock, tls_ctx);
+    if (nc_server_tls_set_fd_wrap(tls_session, sock, tls_ctx)) {
+        goto fail;
+    }
 
     sock = -1;
 
@@ -324,6 +447,11 @@ nc_client_tls_session_new(int sock, const char *host, int timeout, struct nc_cli
         goto fail;
     }
 
+    /* try to resume a previous session with the host */
+    if (resume_sess && nc_client_tls_session_resume_wrap(tls_session, resume_sess)) {
+        goto fail;
+    }
+
     /* handshake */
     if (timeout > -1) {
         nc_timeouttime_get(&ts_timeout, timeout);
@@ -366,6 +494,7 @@ nc_connect_tls(const char *host, unsigned short port, struct ly_ctx *ctx)
     char *ip_host = NULL;
     void *tls_cfg = NULL;
     struct nc_tls_ctx tls_ctx = {0};
+    struct nc_client_tls_sess *kept_sess;
 
     if (!tls_opts.cert_path) {
         ERR(NULL, "Client certificate not set.");
@@ -396,9 +525,11 @@ nc_connect_tls(const char *host, unsigned short port, struct ly_ctx *ctx)
         goto fail;
     }
 
-    /* fill the session */
+    /* fill the session, resume a kept session if any */
     session->ti_type = NC_TI_TLS;
-    if (!(session->ti.tls.session = nc_client_tls_session_new(sock, host, NC_TRANSPORT_TIMEOUT, &tls_opts, &tls_cfg, &tls_ctx))) {
+    kept_sess = nc_client_tls_sess_cache_find(&tls_opts, host, port);
+    if (!(session->ti.tls.session = nc_client_tls_session_new(sock, host, NC_TRANSPORT_TIMEOUT, &tls_opts,
+            kept_sess ? kept_sess->tls_sess : NULL, &tls_cfg, &tls_ctx))) {
         goto fail;
     }
     session->ti.tls.config = tls_cfg;
@@ -417,6 +548,9 @@ nc_connect_tls(const char *host, unsigned short port, struct ly_ctx *ctx)
     }
     session->status = NC_STATUS_RUNNING;
 
+    /* keep the session for resumption, any TLS 1.3 tickets were received together with the hello */
+    nc_client_tls_sess_cache_store(&tls_opts, host, port, session->ti.tls.session);
+
     if (nc_ctx_check_and_fill(session) == -1) {
         goto fail;
     }
@@ -456,7 +590,7 @@ nc_accept_callhome_tls_sock(int sock, const char *host, uint16_t port, struct ly
 
     /* fill the session */
     session->ti_type = NC_TI_TLS;
-    if (!(session->ti.tls.session = nc_client_tls_session_new(sock, peername, timeout, &tls_ch_opts, &tls_cfg, &tls_ctx))) {
+    if (!(session->ti.tls.session = nc_client_tls_session_new(sock, peername, timeout, &tls_ch_opts, NULL, &tls_cfg, &tls_ctx))) {
         goto fail;
     }
     session->ti.tls.config = tls_cfg;
@@ -22,6 +22,7 @@
 #include <ctype.h>
 #include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -46,6 +47,8 @@
 #include <mbedtls/oid.h>
 #include <mbedtls/pem.h>
 #include <mbedtls/ssl.h>
+#include <mbedtls/ssl_cache.h>
+#include <mbedtls/ssl_ticket.h>
 #include <mbedtls/x509.h>
 #include <mbedtls/x509_crl.h>
 #include <mbedtls/x509_crt.h>
@@ -106,64 +109,79 @@ nc_server_tls_dn2str(const mbedtls_x509_name *dn)
     return str;
 }
 
+/**
+ * @brief Destroy the random number generator context.
+ *
+ * @param[in] rng Random bit generator context.
+ */
+static void
+nc_tls_rng_destroy(struct nc_tls_rng *rng)
+{
+    if (!rng) {
+        return;
+    }
+
+    mbedtls_ctr_drbg_free(&rng->ctr_drbg);
+    mbedtls_entropy_free(&rng->entropy);
+    pthread_mutex_destroy(&rng->lock);
+    free(rng);
+}
+
 /**
  * @brief Create a new random number generator context.
  *
- * @param[out] ctr_drbg Random bit generator context.
- * @param[out] entropy Entropy context.
+ * @param[out] rng Random bit generator context.
  * @return 0 on success, 1 on failure.
  */
 static int
-nc_tls_rng_new(mbedtls_ctr_drbg_context **ctr_drbg, mbedtls_entropy_context **entropy)
+nc_tls_rng_new(struct nc_tls_rng **rng)
 {
     int rc;
 
-    *ctr_drbg = NULL;
-    *entropy = NULL;
+    *rng = malloc(sizeof **rng);
+    NC_CHECK_ERRMEM_RET(!*rng, 1);
 
-    *entropy = malloc(sizeof **entropy);
-    NC_CHECK_ERRMEM_GOTO(!*entropy, , fail);
-    *ctr_drbg = malloc(sizeof **ctr_drbg);
-    NC_CHECK_ERRMEM_GOTO(!*ctr_drbg, , fail);
+    mbedtls_entropy_init(&(*rng)->entropy);
+    mbedtls_ctr_drbg_init(&(*rng)->ctr_drbg);
+    pthread_mutex_init(&(*rng)->lock, NULL);
 
-    mbedtls_entropy_init(*entropy);
-    mbedtls_ctr_drbg_init(*ctr_drbg);
-
-    rc = mbedtls_ctr_drbg_seed(*ctr_drbg, mbedtls_entropy_func, *entropy, NULL, 0);
+    rc = mbedtls_ctr_drbg_seed(&(*rng)->ctr_drbg, mbedtls_entropy_func, &(*rng)->entropy, NULL, 0);
     if (rc) {
         ERR(NULL, "Seeding ctr_drbg failed (%s).", nc_get_mbedtls_str_err(rc));
-        goto fail;
+        nc_tls_rng_destroy(*rng);
+        *rng = NULL;
+        return 1;
     }
 
     return 0;
-
-fail:
-    mbedtls_ctr_drbg_free(*ctr_drbg);
-    free(*ctr_drbg);
-    if (*entropy) {
-        mbedtls_entropy_free(*entropy);
-        free(*entropy);
-    }
-    *ctr_drbg = NULL;
-    *entropy = NULL;
-    return 1;
 }
 
 /**
- * @brief Destroy the random number generator context.
+ * @brief Generate random data, the RNG callback of all the MbedTLS functions.
+ *
+ * The generator of a server TLS configuration is shared by all its sessions, which may perform handshakes
+ * concurrently, so the access to it is always serialized.
  *
- * @param[in] ctr_drbg Random bit generator context.
- * @param[in] entropy Entropy context.
+ * @param[in] p_rng Random bit generator context.
+ * @param[out] output Buffer to fill.
+ * @param[in] output_len Length of @p output.
+ * @return 0 on success, MbedTLS error code on failure.
  */
-static void
-nc_tls_rng_destroy(mbedtls_ctr_drbg_context *ctr_drbg, mbedtls_entropy_context *entropy)
+static int
+nc_tls_rng_random(void *p_rng, unsigned char *output, size_t output_len)
 {
-    mbedtls_ctr_drbg_free(ctr_drbg);
-    free(ctr_drbg);
-    if (entropy) {
-        mbedtls_entropy_free(entropy);
-        free(entropy);
-    }
+    struct nc_tls_rng *rng = p_rng;
+    int rc;
+
+    /* RNG LOCK */
+    pthread_mutex_lock(&rng->lock);
+
+    rc = mbedtls_ctr_drbg_random(&rng->ctr_drbg, output, output_len);
+
+    /* RNG UNLOCK */
+    pthread_mutex_unlock(&rng->lock);
+
+    return rc;
 }
 
 /**
@@ -362,10 +380,9 @@ nc_tls_pem_to_privkey_wrap(const char *privkey_data)
 {
     int rc = 0;
     mbedtls_pk_context *pkey = NULL;
-    mbedtls_ctr_drbg_context *ctr_drbg = NULL;
-    mbedtls_entropy_context *entropy = NULL;
+    struct nc_tls_rng *rng = NULL;
 
-    rc = nc_tls_rng_new(&ctr_drbg, &entropy);
+    rc = nc_tls_rng_new(&rng);
     if (rc) {
         goto cleanup;
     }
@@ -376,7 +393,7 @@ nc_tls_pem_to_privkey_wrap(const char *privkey_data)
         goto cleanup;
     }
 
-    rc = mbedtls_pk_parse_key(pkey, (const unsigned char *)privkey_data, strlen(privkey_data) + 1, NULL, 0, mbedtls_ctr_drbg_random, ctr_drbg);
+    rc = mbedtls_pk_parse_key(pkey, (const unsigned char *)privkey_data, strlen(privkey_data) + 1, NULL, 0, nc_tls_rng_random, rng);
     if (rc) {
         ERR(NULL, "Parsing private key data failed (%s).", nc_get_mbedtls_str_err(rc));
         goto cleanup;
@@ -387,7 +404,7 @@ cleanup:
         nc_tls_privkey_destroy_wrap(pkey);
         pkey = NULL;
     }
-    nc_tls_rng_destroy(ctr_drbg, entropy);
+    nc_tls_rng_destroy(rng);
     return pkey;
 }
 
@@ -415,6 +432,41 @@ nc_server_tls_add_crl_to_store_wrap(const unsigned char *crl_data, size_t size,
     return 1;
 }
 
+int
+nc_server_tls_crl_next_update_wrap(const unsigned char *crl_data, size_t size, time_t *next_update)
+{
+    int rc;
+    mbedtls_x509_crl crl;
+    struct tm tm = {0};
+
+    *next_update = 0;
+    mbedtls_x509_crl_init(&crl);
+
+    /* try DER first, PEM next */
+    rc = mbedtls_x509_crl_parse_der(&crl, crl_data, size);
+    if (rc) {
+        rc = mbedtls_x509_crl_parse(&crl, crl_data, size + 1);
+    }
+    if (rc) {
+        ERR(NULL, "Reading downloaded CRL failed.");
+        mbedtls_x509_crl_free(&crl);
+        return 1;
+    }
+
+    if (crl.next_update.year) {
+        tm.tm_year = crl.next_update.year - 1900;
+        tm.tm_mon = crl.next_update.mon - 1;
+        tm.tm_mday = crl.next_update.day;
+        tm.tm_hour = crl.next_update.hour;
+        tm.tm_min = crl.next_update.min;
+        tm.tm_sec = crl.next_update.sec;
+        *next_update = timegm(&tm);
+    }
+
+    mbedtls_x509_crl_free(&crl);
+    return 0;
+}
+
 int
 nc_server_tls_set_tls_versions_wrap(void *tls_cfg, unsigned int tls_versions)
 {
@@ -581,10 +633,133 @@ nc_server_tls_verify_cb(void *cb_data, mbedtls_x509_crt *cert, int depth, uint32
 }
 
 void
-nc_server_tls_set_verify_wrap(void *tls_cfg, struct nc_tls_verify_cb_data *cb_data)
+nc_server_tls_set_verify_wrap(void *tls_cfg)
 {
     mbedtls_ssl_conf_authmode(tls_cfg, MBEDTLS_SSL_VERIFY_REQUIRED);
-    mbedtls_ssl_conf_verify(tls_cfg, nc_server_tls_verify_cb, cb_data);
+}
+
+void
+nc_server_tls_set_verify_data_wrap(void *tls_session, struct nc_tls_verify_cb_data *cb_data)
+{
+    /* the configuration is shared, set the cb with its data in the session */
+    mbedtls_ssl_set_verify(tls_session, nc_server_tls_verify_cb, cb_data);
+}
+
+int
+nc_server_tls_set_resumption_wrap(void *tls_cfg, struct nc_tls_ctx *tls_ctx, uint32_t cache_size, uint32_t lifetime)
+{
+#if defined (MBEDTLS_SSL_CACHE_C) && defined (MBEDTLS_SSL_TICKET_C)
+    int rc;
+    mbedtls_ssl_cache_context *cache;
+    mbedtls_ssl_ticket_context *ticket;
+
+    if (!cache_size) {
+        /* neither session cache nor ticket callbacks are set by default */
+        return 0;
+    }
+
+    /* bounded in-process session cache */
+    cache = malloc(sizeof *cache);
+    NC_CHECK_ERRMEM_RET(!cache, 1);
+    mbedtls_ssl_cache_init(cache);
+    tls_ctx->sess_cache = cache;
+
+    mbedtls_ssl_cache_set_max_entries(cache, cache_size);
+    mbedtls_ssl_cache_set_timeout(cache, lifetime);
+    mbedtls_ssl_conf_session_cache(tls_cfg, cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+
+    /* session tickets, the keys are rotated after every lifetime and the previous one is kept */
+    ticket = malloc(sizeof *ticket);
+    NC_CHECK_ERRMEM_RET(!ticket, 1);
+    mbedtls_ssl_ticket_init(ticket);
+    tls_ctx->ticket = ticket;
+
+    rc = mbedtls_ssl_ticket_setup(ticket, nc_tls_rng_random, tls_ctx->rng, MBEDTLS_CIPHER_AES_256_GCM, lifetime);
+    if (rc) {
+        ERR(NULL, "Setting up TLS session tickets failed (%s).", nc_get_mbedtls_str_err(rc));
+        return 1;
+    }
+    mbedtls_ssl_conf_session_tickets_cb(tls_cfg, mbedtls_ssl_ticket_write, mbedtls_ssl_ticket_parse, ticket);
+
+    return 0;
+#else
+    (void)tls_cfg;
+    (void)tls_ctx;
+    (void)lifetime;
+
+    if (cache_size) {
+        WRN(NULL, "TLS session resumption not supported by MbedTLS, sessions will not be resumed.");
+    }
+    return 0;
+#endif
+}
+
+int
+nc_server_tls_get_resumed_auth_wrap(void *tls_session, char **username, void **client_cert, void **cert_chain)
+{
+    const mbedtls_x509_crt *cert;
+
+    *username = NULL;
+    *client_cert = NULL;
+    *cert_chain = NULL;
+
+    /* sessions cannot hold any additional data, only the peer cert chain is kept */
+    cert = mbedtls_ssl_get_peer_cert(tls_session);
+    if (!cert) {
+        ERR(NULL, "Resumed TLS session does not include the client certificate.");
+        return 1;
+    }
+    *client_cert = nc_tls_cert_dup(cert);
+    NC_CHECK_ERRMEM_RET(!*client_cert, 1);
+    *cert_chain = (void *)cert;
+
+    return 0;
+}
+
+void *
+nc_client_tls_session_save_wrap(void *tls_session)
+{
+    int rc;
+    mbedtls_ssl_session *sess;
+
+    sess = malloc(sizeof *sess);
+    NC_CHECK_ERRMEM_RET(!sess, NULL);
+    mbedtls_ssl_session_init(sess);
+
+    rc = mbedtls_ssl_get_session(tls_session, sess);
+    if (rc) {
+        /* no ticket received or not resumable */
+        mbedtls_ssl_session_free(sess);
+        free(sess);
+        return NULL;
+    }
+
+    return sess;
+}
+
+int
+nc_client_tls_session_resume_wrap(void *tls_session, void *tls_sess)
+{
+    int rc;
+
+    rc = mbedtls_ssl_set_session(tls_session, tls_sess);
+    if (rc) {
+        ERR(NULL, "Setting TLS session to resume failed (%s).", nc_get_mbedtls_str_err(rc));
+        return 1;
+    }
+
+    return 0;
+}
+
+void
+nc_client_tls_session_free_wrap(void *tls_sess)
+{
+    if (!tls_sess) {
+        return;
+    }
+
+    mbedtls_ssl_session_free(tls_sess);
+    free(tls_sess);
 }
 
 void
@@ -898,15 +1073,16 @@ nc_server_tls_recv(void *ctx, unsigned char *buf, size_t len)
     return ret;
 }
 
-void
+int
 nc_server_tls_set_fd_wrap(void *tls_session, int UNUSED(sock), struct nc_tls_ctx *tls_ctx)
 {
     /* mbedtls sets a pointer to the sock, which is stored in tls_ctx */
     mbedtls_ssl_set_bio(tls_session, tls_ctx->sock, nc_server_tls_send, nc_server_tls_recv, NULL);
+    return 0;
 }
 
 int
-nc_server_tls_handshake_step_wrap(void *tls_session)
+nc_server_tls_handshake_step_wrap(void *tls_session, struct nc_tls_ctx *tls_ctx)
 {
     int rc = 0;
 
@@ -914,6 +1090,7 @@ nc_server_tls_handshake_step_wrap(void *tls_session)
     if (!rc) {
         return 1;
     } else if ((rc == MBEDTLS_ERR_SSL_WANT_READ) || (rc == MBEDTLS_ERR_SSL_WANT_WRITE)) {
+        tls_ctx->want_write = (rc == MBEDTLS_ERR_SSL_WANT_WRITE);
         return 0;
     } else {
         return rc;
@@ -948,12 +1125,22 @@ nc_client_tls_handshake_step_wrap(void *tls_session, int sock)
 void
 nc_tls_ctx_destroy_wrap(struct nc_tls_ctx *tls_ctx)
 {
-    nc_tls_rng_destroy(tls_ctx->ctr_drbg, tls_ctx->entropy);
+    nc_tls_rng_destroy(tls_ctx->rng);
     nc_tls_cert_destroy_wrap(tls_ctx->cert);
     nc_tls_privkey_destroy_wrap(tls_ctx->pkey);
     nc_tls_cert_store_destroy_wrap(tls_ctx->cert_store);
     nc_tls_crl_store_destroy_wrap(tls_ctx->crl_store);
     free(tls_ctx->sock);
+#if defined (MBEDTLS_SSL_CACHE_C) && defined (MBEDTLS_SSL_TICKET_C)
+    if (tls_ctx->sess_cache) {
+        mbedtls_ssl_cache_free(tls_ctx->sess_cache);
+        free(tls_ctx->sess_cache);
+    }
+    if (tls_ctx->ticket) {
+        mbedtls_ssl_ticket_free(tls_ctx->ticket);
+        free(tls_ctx->ticket);
+    }
+#endif
 }
 
 void *
@@ -961,21 +1148,20 @@ nc_tls_import_privkey_file_wrap(const char *privkey_path)
 {
     int rc;
     mbedtls_pk_context *pkey;
-    mbedtls_ctr_drbg_context *ctr_drbg;
-    mbedtls_entropy_context *entropy;
+    struct nc_tls_rng *rng;
 
-    if (nc_tls_rng_new(&ctr_drbg, &entropy)) {
+    if (nc_tls_rng_new(&rng)) {
         return NULL;
     }
 
     pkey = nc_tls_pkey_new_wrap();
     if (!pkey) {
-        nc_tls_rng_destroy(ctr_drbg, entropy);
+        nc_tls_rng_destroy(rng);
         return NULL;
     }
 
-    rc = mbedtls_pk_parse_keyfile(pkey, privkey_path, NULL, mbedtls_ctr_drbg_random, ctr_drbg);
-    nc_tls_rng_destroy(ctr_drbg, entropy);
+    rc = mbedtls_pk_parse_keyfile(pkey, privkey_path, NULL, nc_tls_rng_random, rng);
+    nc_tls_rng_destroy(rng);
     if (rc) {
         ERR(NULL, "Parsing private key from file \"%s\" failed (%s).", privkey_path, nc_get_mbedtls_str_err(rc));
         nc_tls_privkey_destroy_wrap(pkey);
@@ -1055,7 +1241,7 @@ int
 nc_tls_init_ctx_wrap(int sock, void *cert, void *pkey, void *cert_store, void *crl_store, struct nc_tls_ctx *tls_ctx)
 {
     /* setup rng */
-    if (nc_tls_rng_new(&tls_ctx->ctr_drbg, &tls_ctx->entropy)) {
+    if (nc_tls_rng_new(&tls_ctx->rng)) {
         return 1;
     }
 
@@ -1070,6 +1256,16 @@ nc_tls_init_ctx_wrap(int sock, void *cert, void *pkey, void *cert_store, void *c
     return 0;
 }
 
+int
+nc_server_tls_init_session_ctx_wrap(int sock, struct nc_tls_ctx *tls_ctx)
+{
+    /* mbedtls sets a pointer to the sock */
+    tls_ctx->sock = malloc(sizeof *tls_ctx->sock);
+    NC_CHECK_ERRMEM_RET(!tls_ctx->sock, 1);
+    *tls_ctx->sock = sock;
+    return 0;
+}
+
 int
 nc_tls_setup_config_from_ctx_wrap(struct nc_tls_ctx *tls_ctx, int side, void *tls_cfg)
 {
@@ -1086,8 +1282,8 @@ nc_tls_setup_config_from_ctx_wrap(struct nc_tls_ctx *tls_ctx, int side, void *tl
         return 1;
     }
 
-    /* set config's rng */
-    mbedtls_ssl_conf_rng(tls_cfg, mbedtls_ctr_drbg_random, tls_ctx->ctr_drbg);
+    /* set config's rng, shared by all the sessions created from the config so its access is serialized */
+    mbedtls_ssl_conf_rng(tls_cfg, nc_tls_rng_random, tls_ctx->rng);
     /* set config's cert and key */
     mbedtls_ssl_conf_own_cert(tls_cfg, tls_ctx->cert, tls_ctx->pkey);
     /* set config's CA and CRL cert store */
@@ -1213,6 +1409,7 @@ nc_tls_read_wrap(struct nc_session *session, unsigned char *buf, size_t size)
         switch (rc) {
         case MBEDTLS_ERR_SSL_WANT_READ:
         case MBEDTLS_ERR_SSL_WANT_WRITE:
+            session->ti.tls.ctx.want_write = (rc == MBEDTLS_ERR_SSL_WANT_WRITE);
             rc = 0;
             break;
         case MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY:
@@ -1244,12 +1441,19 @@ nc_tls_write_wrap(struct nc_session *session, const unsigned char *buf, size_t s
         switch (rc) {
         case MBEDTLS_ERR_SSL_WANT_READ:
         case MBEDTLS_ERR_SSL_WANT_WRITE:
+            session->ti.tls.ctx.want_write = (rc == MBEDTLS_ERR_SSL_WANT_WRITE);
             rc = 0;
             break;
         case MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY:
             ERR(session, "TLS connection was properly closed.");
             rc = -1;
             break;
+        case MBEDTLS_ERR_NET_CONN_RESET:
+            ERR(session, "Communication socket unexpectedly closed.");
+            session->status = NC_STATUS_INVALID;
+            session->term_reason = NC_SESSION_TERM_DROPPED;
+            rc = -1;
+            break;
         default:
             ERR(session, "TLS communication error occurred (%s).", nc_get_mbedtls_str_err(rc));
             rc = -1;
@@ -1272,6 +1476,12 @@ nc_tls_get_fd_wrap(const struct nc_session *session)
     return session->ti.tls.ctx.sock ? *session->ti.tls.ctx.sock : -1;
 }
 
+int
+nc_tls_want_write_wrap(const struct nc_session *session)
+{
+    return session->ti.tls.ctx.want_write;
+}
+
 void
 nc_tls_close_notify_wrap(void *tls_session)
 {
@@ -20,11 +20,15 @@
 #define _GNU_SOURCE
 
 #include <ctype.h>
+#include <errno.h>
 #include <poll.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <curl/curl.h>
@@ -37,8 +41,11 @@
 #include "session_wrapper.h"
 
 #include <openssl/bio.h>
+#include <openssl/core_names.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/rand.h>
 #include <openssl/ssl.h>
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
@@ -80,6 +87,9 @@ nc_tls_config_new_wrap(int side)
     }
     NC_CHECK_ERRMEM_RET(!tls_cfg, NULL)
 
+    /* a repeated write may pass the same data in a different (coalescing) buffer */
+    SSL_CTX_set_mode(tls_cfg, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
     return tls_cfg;
 }
 
@@ -243,6 +253,52 @@ cleanup:
     return ret;
 }
 
+int
+nc_server_tls_crl_next_update_wrap(const unsigned char *crl_data, size_t size, time_t *next_update)
+{
+    int ret = 0, day, sec;
+    X509_CRL *crl = NULL;
+    BIO *bio = NULL;
+    const ASN1_TIME *next;
+
+    *next_update = 0;
+
+    bio = BIO_new_mem_buf(crl_data, size);
+    if (!bio) {
+        ERR(NULL, "Creating new bio failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        ret = 1;
+        goto cleanup;
+    }
+
+    /* try DER first, PEM next */
+    crl = d2i_X509_CRL_bio(bio, NULL);
+    if (!crl) {
+        BIO_reset(bio);
+        crl = PEM_read_bio_X509_CRL(bio, NULL, NULL, NULL);
+    }
+    if (!crl) {
+        ERR(NULL, "Parsing downloaded CRL failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        ret = 1;
+        goto cleanup;
+    }
+
+    next = X509_CRL_get0_nextUpdate(crl);
+    if (next) {
+        /* get the difference from the current time */
+        if (!ASN1_TIME_diff(&day, &sec, NULL, next)) {
+            ERR(NULL, "Invalid CRL nextUpdate time.");
+            ret = 1;
+            goto cleanup;
+        }
+        *next_update = time(NULL) + (time_t)day * 86400 + sec;
+    }
+
+cleanup:
+    X509_CRL_free(crl);
+    BIO_free(bio);
+    return ret;
+}
+
 int
 nc_server_tls_set_tls_versions_wrap(void *tls_cfg, unsigned int tls_versions)
 {
@@ -294,21 +350,15 @@ nc_server_tls_verify_cb(int preverify_ok, X509_STORE_CTX *x509_ctx)
     int ret = 0, depth, err;
     struct nc_tls_verify_cb_data *data;
     SSL *ssl;
-    SSL_CTX *ctx;
     X509 *cert;
 
-    /* retrieve callback data stored inside the SSL_CTX struct */
+    /* retrieve callback data stored inside the SSL struct */
     ssl = X509_STORE_CTX_get_ex_data(x509_ctx, SSL_get_ex_data_X509_STORE_CTX_idx());
     if (!ssl) {
         ERRINT;
         return 0;
     }
-    ctx = SSL_get_SSL_CTX(ssl);
-    if (!ctx) {
-        ERRINT;
-        return 0;
-    }
-    data = SSL_CTX_get_ex_data(ctx, 0);
+    data = SSL_get_app_data(ssl);
     if (!data) {
         ERRINT;
         return 0;
@@ -368,6 +418,14 @@ nc_server_tls_verify_cb(int preverify_ok, X509_STORE_CTX *x509_ctx)
             /* copy the client cert */
             data->session->opts.server.client_cert = X509_dup(cert);
             NC_CHECK_ERRMEM_RET(!data->session->opts.server.client_cert, 0);
+
+            /* store the username in the TLS session, it is kept in the session cache and tickets
+             * so that a resumed session does not need to perform cert-to-name again */
+            if (!SSL_SESSION_set1_ticket_appdata(SSL_get0_session(ssl), data->session->username,
+                    strlen(data->session->username))) {
+                ERR(data->session, "Storing username in the TLS session failed (%s).", ERR_reason_error_string(ERR_get_error()));
+                return 0;
+            }
         }
         return 1;
     } else {
@@ -382,13 +440,253 @@ nc_server_tls_verify_cb(int preverify_ok, X509_STORE_CTX *x509_ctx)
 }
 
 void
-nc_server_tls_set_verify_wrap(void *tls_cfg, struct nc_tls_verify_cb_data *cb_data)
+nc_server_tls_set_verify_wrap(void *tls_cfg)
 {
-    /* set verify cb and its data */
-    SSL_CTX_set_ex_data(tls_cfg, 0, cb_data);
     SSL_CTX_set_verify(tls_cfg, SSL_VERIFY_PEER | SSL_VERIFY_FAIL_IF_NO_PEER_CERT, nc_server_tls_verify_cb);
 }
 
+void
+nc_server_tls_set_verify_data_wrap(void *tls_session, struct nc_tls_verify_cb_data *cb_data)
+{
+    /* the configuration is shared, store the data in the session */
+    SSL_set_app_data(tls_session, cb_data);
+}
+
+/**
+ * @brief Session ticket key.
+ */
+struct nc_tls_ticket_key {
+    unsigned char name[16];         /**< Key name sent in the tickets. */
+    unsigned char aes_key[32];      /**< Ticket encryption key. */
+    unsigned char hmac_key[32];     /**< Ticket HMAC key. */
+    time_t created;                 /**< Creation time of the key. */
+};
+
+/**
+ * @brief Rotating session ticket keys of a TLS server configuration.
+ */
+struct nc_tls_ticket_keys {
+    pthread_mutex_t lock;           /**< Lock for accessing the keys. */
+    uint32_t lifetime;              /**< Rotation interval of the keys in seconds. */
+    struct nc_tls_ticket_key cur;   /**< Key used for issuing new tickets. */
+    struct nc_tls_ticket_key prev;  /**< Previous key, only tickets issued with it are accepted and renewed. */
+    int has_prev;                   /**< Whether the previous key is still valid. */
+};
+
+/**
+ * @brief Rotate the session ticket keys if the current one expired, keys lock is expected to be held.
+ *
+ * @param[in] keys Ticket keys.
+ * @return 0 on success, 1 on error.
+ */
+static int
+nc_server_tls_ticket_keys_rotate(struct nc_tls_ticket_keys *keys)
+{
+    time_t now = time(NULL);
+
+    if (keys->cur.created && (now < keys->cur.created + keys->lifetime)) {
+        /* current key still valid */
+        return 0;
+    }
+
+    /* tickets issued with the previous key can be at most one lifetime old */
+    if (keys->cur.created && (now < keys->cur.created + 2 * keys->lifetime)) {
+        keys->prev = keys->cur;
+        keys->has_prev = 1;
+    } else {
+        keys->has_prev = 0;
+    }
+
+    if ((RAND_bytes(keys->cur.name, sizeof keys->cur.name) != 1) ||
+            (RAND_bytes(keys->cur.aes_key, sizeof keys->cur.aes_key) != 1) ||
+            (RAND_bytes(keys->cur.hmac_key, sizeof keys->cur.hmac_key) != 1)) {
+        ERR(NULL, "Generating TLS session ticket key failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        keys->cur.created = 0;
+        return 1;
+    }
+    keys->cur.created = now;
+
+    return 0;
+}
+
+/**
+ * @brief Session ticket key callback, encrypts new tickets and decrypts received ones.
+ *
+ * @param[in] ssl TLS session.
+ * @param[in,out] key_name Name of the key the ticket is encrypted with.
+ * @param[in,out] iv Ticket IV.
+ * @param[in] cipher_ctx Cipher context to initialize.
+ * @param[in] mac_ctx MAC context to initialize.
+ * @param[in] enc Whether to encrypt a new ticket or decrypt a received one.
+ * @return 1 on success, 2 on success with the ticket to be renewed, 0 if the ticket cannot be decrypted, -1 on error.
+ */
+static int
+nc_server_tls_ticket_key_cb(SSL *ssl, unsigned char *key_name, unsigned char *iv, EVP_CIPHER_CTX *cipher_ctx,
+        EVP_MAC_CTX *mac_ctx, int enc)
+{
+    int ret = 1;
+    struct nc_tls_ticket_keys *keys;
+    struct nc_tls_ticket_key *key;
+    OSSL_PARAM params[3];
+
+    keys = SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+    if (!keys) {
+        ERRINT;
+        return -1;
+    }
+
+    /* KEYS LOCK */
+    pthread_mutex_lock(&keys->lock);
+
+    if (nc_server_tls_ticket_keys_rotate(keys)) {
+        ret = -1;
+        goto cleanup;
+    }
+
+    if (enc) {
+        /* always issue tickets with the current key */
+        key = &keys->cur;
+        memcpy(key_name, key->name, sizeof key->name);
+        if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) != 1) {
+            ret = -1;
+            goto cleanup;
+        }
+    } else if (!memcmp(key_name, keys->cur.name, sizeof keys->cur.name)) {
+        key = &keys->cur;
+    } else if (keys->has_prev && !memcmp(key_name, keys->prev.name, sizeof keys->prev.name)) {
+        /* accept the ticket, but issue a new one with the current key */
+        key = &keys->prev;
+        ret = 2;
+    } else {
+        /* unknown or expired key, full handshake */
+        ret = 0;
+        goto cleanup;
+    }
+
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key->hmac_key, sizeof key->hmac_key);
+    params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0);
+    params[2] = OSSL_PARAM_construct_end();
+    if (!EVP_MAC_CTX_set_params(mac_ctx, params)) {
+        ret = -1;
+        goto cleanup;
+    }
+
+    if (enc) {
+        if (!EVP_EncryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL, key->aes_key, iv)) {
+            ret = -1;
+        }
+    } else {
+        if (!EVP_DecryptInit_ex(cipher_ctx, EVP_aes_256_cbc(), NULL, key->aes_key, iv)) {
+            ret = -1;
+        }
+    }
+
+cleanup:
+    /* KEYS UNLOCK */
+    pthread_mutex_unlock(&keys->lock);
+    return ret;
+}
+
+int
+nc_server_tls_set_resumption_wrap(void *tls_cfg, struct nc_tls_ctx *tls_ctx, uint32_t cache_size, uint32_t lifetime)
+{
+    struct nc_tls_ticket_keys *keys;
+    const unsigned char sid_ctx[] = "libnetconf2";
+
+    if (!cache_size) {
+        /* no session cache nor tickets, which would also be issued (and wasted) by default */
+        SSL_CTX_set_session_cache_mode(tls_cfg, SSL_SESS_CACHE_OFF);
+        SSL_CTX_set_options(tls_cfg, SSL_OP_NO_TICKET);
+        SSL_CTX_set_num_tickets(tls_cfg, 0);
+        return 0;
+    }
+
+    /* bounded in-process session cache, the context is required for resumption with client certificates */
+    SSL_CTX_set_session_cache_mode(tls_cfg, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(tls_cfg, cache_size);
+    SSL_CTX_set_timeout(tls_cfg, lifetime);
+    if (!SSL_CTX_set_session_id_context(tls_cfg, sid_ctx, sizeof sid_ctx - 1)) {
+        ERR(NULL, "Setting TLS session ID context failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        return 1;
+    }
+
+    /* session tickets with rotating keys */
+    keys = calloc(1, sizeof *keys);
+    NC_CHECK_ERRMEM_RET(!keys, 1);
+    pthread_mutex_init(&keys->lock, NULL);
+    keys->lifetime = lifetime;
+    tls_ctx->ticket_keys = keys;
+
+    SSL_CTX_set_app_data(tls_cfg, keys);
+    if (!SSL_CTX_set_tlsext_ticket_key_evp_cb(tls_cfg, nc_server_tls_ticket_key_cb)) {
+        ERR(NULL, "Setting TLS session ticket key callback failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+nc_server_tls_get_resumed_auth_wrap(void *tls_session, char **username, void **client_cert, void **cert_chain)
+{
+    void *data;
+    size_t len;
+    X509 *cert;
+
+    *username = NULL;
+    *client_cert = NULL;
+    *cert_chain = NULL;
+
+    /* username stored by the verify callback of the original session */
+    if (!SSL_SESSION_get0_ticket_appdata(SSL_get0_session(tls_session), &data, &len) || !len) {
+        ERR(NULL, "Resumed TLS session does not include the client username.");
+        return 1;
+    }
+    *username = strndup(data, len);
+    NC_CHECK_ERRMEM_RET(!*username, 1);
+
+    cert = SSL_get0_peer_certificate(tls_session);
+    if (!cert) {
+        ERR(NULL, "Resumed TLS session does not include the client certificate.");
+        return 1;
+    }
+    *client_cert = X509_dup(cert);
+    NC_CHECK_ERRMEM_RET(!*client_cert, 1);
+
+    return 0;
+}
+
+void *
+nc_client_tls_session_save_wrap(void *tls_session)
+{
+    SSL_SESSION *sess;
+
+    sess = SSL_get1_session(tls_session);
+    if (sess && !SSL_SESSION_is_resumable(sess)) {
+        SSL_SESSION_free(sess);
+        sess = NULL;
+    }
+
+    return sess;
+}
+
+int
+nc_client_tls_session_resume_wrap(void *tls_session, void *tls_sess)
+{
+    if (!SSL_set_session(tls_session, tls_sess)) {
+        ERR(NULL, "Setting TLS session to resume failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        return 1;
+    }
+
+    return 0;
+}
+
+void
+nc_client_tls_session_free_wrap(void *tls_sess)
+{
+    SSL_SESSION_free(tls_sess);
+}
+
 void
 nc_client_tls_set_verify_wrap(void *tls_cfg)
 {
@@ -588,14 +886,89 @@ nc_server_tls_sha512_wrap(void *cert, unsigned char *buf)
     return 0;
 }
 
-void
+/**
+ * @brief Socket BIO write callback, sends with MSG_NOSIGNAL so that writing to a closed socket
+ * does not generate SIGPIPE.
+ *
+ * @param[in] bio BIO to write to.
+ * @param[in] buf Data to write.
+ * @param[in] len Length of @p buf.
+ * @return Number of bytes written, <= 0 on error.
+ */
+static int
+nc_tls_sock_write(BIO *bio, const char *buf, int len)
+{
+    int fd, ret;
+
+    if (BIO_get_fd(bio, &fd) < 0) {
+        return -1;
+    }
+
+    errno = 0;
+    ret = send(fd, buf, len, MSG_NOSIGNAL);
+    BIO_clear_retry_flags(bio);
+    if ((ret <= 0) && BIO_sock_should_retry(ret)) {
+        BIO_set_retry_write(bio);
+    }
+
+    return ret;
+}
+
+static BIO_METHOD *nc_tls_sock_method;
+static pthread_once_t nc_tls_sock_method_once = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Create the socket BIO method used by all the TLS sessions, a socket BIO writing with MSG_NOSIGNAL.
+ */
+static void
+nc_tls_sock_method_create(void)
+{
+    const BIO_METHOD *sock_method = BIO_s_socket();
+    BIO_METHOD *method;
+
+    method = BIO_meth_new(BIO_TYPE_SOCKET, "libnetconf2 socket");
+    if (!method) {
+        return;
+    }
+
+    if (!BIO_meth_set_write(method, nc_tls_sock_write) ||
+            !BIO_meth_set_read(method, BIO_meth_get_read(sock_method)) ||
+            !BIO_meth_set_puts(method, BIO_meth_get_puts(sock_method)) ||
+            !BIO_meth_set_ctrl(method, BIO_meth_get_ctrl(sock_method)) ||
+            !BIO_meth_set_create(method, BIO_meth_get_create(sock_method)) ||
+            !BIO_meth_set_destroy(method, BIO_meth_get_destroy(sock_method))) {
+        BIO_meth_free(method);
+        return;
+    }
+
+    nc_tls_sock_method = method;
+}
+
+int
 nc_server_tls_set_fd_wrap(void *tls_session, int sock, struct nc_tls_ctx *UNUSED(tls_ctx))
 {
-    SSL_set_fd(tls_session, sock);
+    BIO *bio;
+
+    pthread_once(&nc_tls_sock_method_once, nc_tls_sock_method_create);
+    if (!nc_tls_sock_method) {
+        ERR(NULL, "Creating a TLS socket BIO method failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        return 1;
+    }
+
+    /* the same as SSL_set_fd() but the socket is written to with MSG_NOSIGNAL */
+    bio = BIO_new(nc_tls_sock_method);
+    if (!bio) {
+        ERR(NULL, "Creating a TLS socket BIO failed (%s).", ERR_reason_error_string(ERR_get_error()));
+        return 1;
+    }
+    BIO_set_fd(bio, sock, BIO_NOCLOSE);
+    SSL_set_bio(tls_session, bio, bio);
+
+    return 0;
 }
 
 int
-nc_server_tls_handshake_step_wrap(void *tls_session)
+nc_server_tls_handshake_step_wrap(void *tls_session, struct nc_tls_ctx *UNUSED(tls_ctx))
 {
     int ret = 0;
 
@@ -629,9 +1002,15 @@ nc_client_tls_handshake_step_wrap(void *tls_session, int UNUSED(sock))
 }
 
 void
-nc_tls_ctx_destroy_wrap(struct nc_tls_ctx *UNUSED(tls_ctx))
+nc_tls_ctx_destroy_wrap(struct nc_tls_ctx *tls_ctx)
 {
-    return;
+    struct nc_tls_ticket_keys *keys = tls_ctx->ticket_keys;
+
+    if (keys) {
+        pthread_mutex_destroy(&keys->lock);
+        OPENSSL_cleanse(keys, sizeof *keys);
+        free(keys);
+    }
 }
 
 int
@@ -724,6 +1103,13 @@ nc_tls_init_ctx_wrap(int UNUSED(sock), void *cert, void *pkey, void *cert_store,
     return 0;
 }
 
+int
+nc_server_tls_init_session_ctx_wrap(int UNUSED(sock), struct nc_tls_ctx *UNUSED(tls_ctx))
+{
+    /* nothing to do, the socket is set directly in the session */
+    return 0;
+}
+
 /**
  * @brief Move CRLs from one store to another.
  *
@@ -990,6 +1376,7 @@ nc_tls_write_wrap(struct nc_session *session, const unsigned char *buf, size_t s
     char *reasons;
     SSL *tls_session = session->ti.tls.session;
 
+    /* the socket BIO writes with MSG_NOSIGNAL, SIGPIPE is never generated */
     ERR_clear_error();
     rc = SSL_write(tls_session, buf, size);
     if (rc < 1) {
@@ -1005,6 +1392,10 @@ nc_tls_write_wrap(struct nc_session *session, const unsigned char *buf, size_t s
             break;
         case SSL_ERROR_SYSCALL:
             ERR(session, "TLS socket error (%s).", errno ? strerror(errno) : "unexpected EOF");
+            if ((errno == EPIPE) || (errno == ECONNRESET)) {
+                session->status = NC_STATUS_INVALID;
+                session->term_reason = NC_SESSION_TERM_DROPPED;
+            }
             rc = -1;
             break;
         case SSL_ERROR_SSL:
@@ -1035,6 +1426,12 @@ nc_tls_get_fd_wrap(const struct nc_session *session)
     return session->ti.tls.session ? SSL_get_fd(session->ti.tls.session) : -1;
 }
 
+int
+nc_tls_want_write_wrap(const struct nc_session *session)
+{
+    return SSL_want_write((SSL *)session->ti.tls.session);
+}
+
 void
 nc_tls_close_notify_wrap(void *tls_session)
 {
@@ -22,12 +22,15 @@
 #include <poll.h>
 #include <pthread.h>
 #include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
 
 #include <libyang/libyang.h>
 
 #include "compat.h"
 #include "config.h"
 #include "session_client.h"
+#include "session_server.h"
 #include "session_server_ch.h"
 #include "session_wrapper.h"
 
@@ -60,6 +63,18 @@ typedef enum {
 /* seconds */
 #define NC_SSH_TIMEOUT 10
 
+/* length of a SHA-256 public key fingerprint */
+#define NC_PUBKEY_FP_LEN 32
+
+/* maximum number of cached authorized keys files of system users */
+#define NC_SSH_AUTHKEYS_CACHE_SIZE 64
+
+/* number of supported cert-to-name fingerprint algorithms (MD5, SHA-1, SHA-224, SHA-256, SHA-384, SHA-512) */
+#define NC_TLS_FP_ALG_COUNT 6
+
+/* length of the longest cert-to-name fingerprint digest (SHA-512) */
+#define NC_TLS_DIGEST_MAX_LEN 64
+
 /* number of all supported authentication methods */
 #define NC_SSH_AUTH_COUNT 3
 
@@ -128,10 +143,23 @@ struct nc_public_key {
     char *data;             /**< Base-64 encoded public key. */
 };
 
+/**
+ * @brief Public keys parsed once and indexed by the SHA-256 fingerprint of their blob.
+ */
+struct nc_pubkey_index {
+    struct nc_pubkey_index_entry {
+        unsigned char fp[NC_PUBKEY_FP_LEN]; /**< SHA-256 fingerprint of the key blob. */
+        ssh_key key;                        /**< Parsed key, NULL if the slot is empty. */
+    } *entries;                             /**< Open addressing table with linear probing. */
+    uint32_t size;                          /**< Number of slots, always a power of 2. */
+    uint16_t spki_count;                    /**< Number of keys in the SubjectPublicKeyInfo format, unusable for SSH. */
+};
+
 struct nc_public_key_bag {
     char *name;
     struct nc_public_key *pubkeys;
     uint16_t pubkey_count;
+    struct nc_pubkey_index *pubkey_idx;     /**< Index of parsed pubkeys, rebuilt on every configuration change. */
 };
 
 struct nc_truststore {
@@ -161,6 +189,26 @@ struct nc_auth_state {
     int auth_success_count; /**< The number of auth. methods that ended successfully. */
 };
 
+/**
+ * @brief Phase of establishing a new SSH session.
+ */
+typedef enum {
+    NC_SSH_ACCEPT_KEX,      /**< key exchange */
+    NC_SSH_ACCEPT_AUTH,     /**< client authentication */
+    NC_SSH_ACCEPT_CHANNEL   /**< opening a channel with the "netconf" subsystem */
+} NC_SSH_ACCEPT_PHASE;
+
+/**
+ * @brief State of establishing a new SSH session, progressed whenever new data are received.
+ */
+struct nc_ssh_accept {
+    NC_SSH_ACCEPT_PHASE phase;          /**< Current phase. */
+    struct nc_auth_state auth_state;    /**< State of the authentication. */
+    int timeout;                        /**< Transport operations timeout in msec (not SSH authentication one). */
+    int has_timeout;                    /**< Whether the current phase has a timeout. */
+    struct timespec ts_timeout;         /**< Timeout of the current phase. */
+};
+
 /**
  * @brief A server's authorized client.
  */
@@ -175,6 +223,7 @@ struct nc_auth_client {
         };
         char *ts_ref;                       /**< Name of the referenced truststore key. */
     };
+    struct nc_pubkey_index *pubkey_idx;     /**< Index of parsed local pubkeys, rebuilt on every configuration change. */
 
     char *password;                         /**< Client's password */
     int kb_int_enabled;                     /**< Indicates that the client supports keyboard-interactive authentication. */
@@ -212,6 +261,11 @@ struct nc_server_ssh_opts {
     char *mac_algs;                         /**< MAC algorithms supported by the server. */
 
     uint16_t auth_timeout;                  /**< Authentication timeout. */
+
+    pthread_mutex_t sbind_lock;             /**< Lock for the cached SSH bind. */
+    ssh_bind sbind;                         /**< Cached SSH bind with parsed hostkeys and set algorithms used for accepting
+                                                 new sessions, recreated once the configuration changes. */
+    uint32_t sbind_config_gen;              /**< Configuration generation of the cached SSH bind. */
 };
 
 /**
@@ -247,6 +301,29 @@ struct nc_ctn {
     struct nc_ctn *next;                /**< Linked-list reference to the next entry */
 };
 
+/**
+ * @brief Cert-to-name entries compiled for a fast lookup by certificate fingerprints.
+ */
+struct nc_ctn_index {
+    struct nc_ctn_index_entry {
+        uint32_t id;                                    /**< ID of the entry. */
+        uint8_t alg;                                    /**< Fingerprint algorithm (1 MD5 ... 6 SHA-512), 0 for any. */
+        unsigned char digest[NC_TLS_DIGEST_MAX_LEN];    /**< Binary fingerprint digest. */
+        NC_TLS_CTN_MAPTYPE map_type;                    /**< Specifies how to get the username from the certificate. */
+        char *name;                                     /**< Username for this entry. */
+    } *entries;                                         /**< Valid entries ordered by priority. */
+    uint32_t entry_count;                               /**< Count of entries. */
+
+    uint32_t *slots;                                    /**< Hash table of the entries with a fingerprint keyed by (alg, digest),
+                                                             holds entry index + 1, 0 if empty. */
+    uint32_t slot_count;                                /**< Number of slots, always a power of 2. */
+
+    uint32_t *any;                                      /**< Indices of entries without a fingerprint, ordered by priority. */
+    uint32_t any_count;                                 /**< Count of entries without a fingerprint. */
+
+    uint8_t algs;                                       /**< Bitmask of the fingerprint algorithms used by the entries. */
+};
+
 /**
  * @brief Server options for configuring the TLS transport protocol.
  */
@@ -279,6 +356,82 @@ struct nc_server_tls_opts {
     uint16_t cipher_count;                      /**< Number of TLS ciphers */
 
     struct nc_ctn *ctn;                         /**< Cert-to-name entries */
+    struct nc_ctn_index *ctn_idx;               /**< Index of cert-to-name entries, rebuilt on every configuration change. */
+
+    pthread_mutex_t tls_cfg_lock;               /**< Lock for the prepared TLS configuration. */
+    struct nc_server_tls_cfg *tls_cfg;          /**< TLS configuration prepared for accepting new sessions, recreated
+                                                     once the configuration changes. */
+};
+
+/**
+ * @brief TLS configuration of an endpoint shared read-only by all its sessions.
+ */
+struct nc_server_tls_cfg {
+    ATOMIC_T refcount;                          /**< Number of references, held by the endpoint and its sessions. */
+    uint32_t config_gen;                        /**< Configuration generation it was prepared for. */
+    uint32_t crl_gen;                           /**< CRL cache generation it was prepared for. */
+    void *tls_cfg;                              /**< TLS configuration. */
+    struct nc_tls_ctx ctx;                      /**< TLS context with the data used by the configuration. */
+};
+
+/**
+ * @brief State of establishing a new TLS session, progressed whenever new data are received.
+ */
+struct nc_tls_accept {
+    struct nc_tls_verify_cb_data cb_data;   /**< Data of the verify callback, set again before every step. */
+    int has_timeout;                        /**< Whether the handshake has a timeout. */
+    struct timespec ts_timeout;             /**< Timeout of the handshake. */
+};
+
+/**
+ * @brief CRL downloaded from a CRL distribution point.
+ */
+struct nc_crl_cache_entry {
+    char *uri;                  /**< CRL distribution point URI. */
+    unsigned char *data;        /**< Downloaded CRL (null-terminated), NULL if not downloaded yet. */
+    size_t size;                /**< Size of the downloaded CRL. */
+    time_t refresh;             /**< Real time of the next download. */
+};
+
+/**
+ * @brief Cache of CRLs refreshed by a background thread so that no CRLs are downloaded when accepting sessions.
+ */
+struct nc_crl_cache {
+    pthread_mutex_t lock;               /**< Lock for the cache. */
+    pthread_cond_t cond;                /**< Condition for waking the refresh thread. */
+    pthread_cond_t fetch_cond;          /**< Condition signaled after every download attempt. */
+    pthread_t tid;                      /**< Refresh thread ID. */
+    int thread_running;                 /**< Whether the refresh thread was started. */
+    int terminate;                      /**< Flag for the refresh thread to terminate. */
+
+    struct nc_crl_cache_entry *entries; /**< Cached CRLs, only added until the cache is destroyed. */
+    uint32_t entry_count;               /**< Count of cached CRLs. */
+    ATOMIC_T gen;                       /**< Cache generation, incremented whenever a cached CRL changes. */
+};
+
+/**
+ * @brief Parsed public keys of an authorized keys file of a system user.
+ */
+struct nc_authkeys_cache_entry {
+    char *username;                     /**< System username. */
+    char *path;                         /**< Path to the authorized keys file resolved for the user. */
+    dev_t dev;                          /**< Device of the file when it was read. */
+    ino_t ino;                          /**< Inode of the file when it was read. */
+    off_t size;                         /**< Size of the file when it was read. */
+    struct timespec mtime;              /**< Last modification time of the file when it was read. */
+    struct timespec ctime;              /**< Last status change time of the file when it was read. */
+    struct nc_pubkey_index *pubkey_idx; /**< Parsed public keys from the file. */
+    uint64_t last_used;                 /**< Cache tick of the last use, for LRU eviction. */
+};
+
+/**
+ * @brief Cache of authorized keys files, validated by the file metadata on every use.
+ */
+struct nc_authkeys_cache {
+    pthread_mutex_t lock;                       /**< Lock for the cache. */
+    struct nc_authkeys_cache_entry *entries;    /**< Cached authorized keys files. */
+    uint16_t entry_count;                       /**< Count of cached authorized keys files. */
+    uint64_t tick;                              /**< Incremented on every cache use. */
 };
 
 #endif /* NC_ENABLED_SSH_TLS */
@@ -307,10 +460,14 @@ struct nc_server_unix_opts {
  * @brief Stores information about a bind.
  */
 struct nc_bind {
-    char *address;  /**< Bind's address. */
-    uint16_t port;  /**< Bind's port. */
-    int sock;       /**< Bind's socket. */
-    int pollin;     /**< Specifies, which sockets to poll on. */
+    char *address;              /**< Bind's address. */
+    uint16_t port;              /**< Bind's port. */
+    int sock;                   /**< Bind's socket. */
+    int pollin;                 /**< Specifies, which sockets to poll on. */
+
+    int reuseport;              /**< Whether the sockets are SO_REUSEPORT listeners accepted on without the bind lock. */
+    int *reuse_socks;           /**< Listening sockets of the other accept threads, @p sock is used by the first one. */
+    uint16_t reuse_sock_count;  /**< Count of @p reuse_socks. */
 };
 
 #ifdef NC_ENABLED_SSH_TLS
@@ -352,6 +509,15 @@ struct nc_client_tls_opts {
 
     char *ca_file;
     char *ca_dir;
+
+    struct nc_client_tls_sess {
+        char *host;                     /**< Host the session was established with. */
+        uint16_t port;                  /**< Port the session was established with. */
+        void *tls_sess;                 /**< Saved TLS session. */
+    } *sess_cache;                      /**< TLS sessions kept for resumption. */
+    uint32_t sess_cache_count;          /**< Number of kept TLS sessions. */
+    uint32_t sess_cache_size;           /**< Maximum number of kept TLS sessions, 0 if resumption is disabled. */
+    uint32_t sess_cache_next;           /**< Index of the kept TLS session to be replaced next. */
 };
 
 #endif /* NC_ENABLED_SSH_TLS */
@@ -405,6 +571,127 @@ struct nc_ch_client_thread_arg {
     pthread_cond_t cond;        /**< Condition used for signalling the thread to terminate */
 };
 
+/**
+ * @brief Connection accepted by the dispatch acceptor thread and waiting for a handshake worker.
+ */
+struct nc_accept_conn {
+    int sock;                   /**< Accepted socket. */
+    char *host;                 /**< Client host. */
+    uint16_t port;              /**< Client port. */
+    char *endpt_name;           /**< Name of the endpoint the connection was accepted on. */
+};
+
+/**
+ * @brief New session being established by a dispatch handshake worker.
+ */
+struct nc_accept_handshake {
+    struct nc_session *session;         /**< New session. */
+    char *endpt_name;                   /**< Name of the endpoint the session is established on. */
+    struct timespec ts_check;           /**< Time of the next step even if no new data are received. */
+    int hello;                          /**< Whether the transport is established and the client hello is awaited. */
+    int has_timeout;                    /**< Whether the client hello has a timeout. */
+    struct timespec ts_timeout;         /**< Timeout of the client hello. */
+#ifdef NC_ENABLED_SSH_TLS
+    struct nc_ssh_accept ssh_acc;       /**< State of establishing the SSH transport. */
+    struct nc_tls_accept tls_acc;       /**< State of establishing the TLS transport. */
+#endif
+};
+
+/**
+ * @brief Background accepting of new sessions, the acceptor thread only accepts connections and
+ * the worker threads establish the sessions.
+ */
+struct nc_accept_dispatch {
+    pthread_mutex_t lock;               /**< Lock for accessing the members. */
+    pthread_cond_t cond;                /**< Condition signalled when the queue changes or on termination. */
+    int running;                        /**< Whether the threads are running. */
+    ATOMIC_T terminate;                 /**< Flag for the threads to terminate. */
+
+    pthread_t acceptor_tid;             /**< Acceptor thread. */
+    pthread_t *worker_tids;             /**< Handshake worker threads. */
+    uint32_t worker_count;              /**< Number of the worker threads. */
+
+    struct nc_accept_conn *queue;       /**< Ring buffer of accepted connections. */
+    uint32_t queue_first;               /**< Index of the first connection in the queue. */
+    uint32_t queue_count;               /**< Number of connections in the queue. */
+
+    const struct ly_ctx *ctx;           /**< Context of the new sessions. */
+    int (*new_session_cb)(struct nc_session *new_session, void *user_data);    /**< New session callback. */
+    void *new_session_cb_data;          /**< New session callback data. */
+};
+
+/**
+ * @brief NETCONF statistics counters (ietf-netconf-monitoring common-counters), kept both per session
+ * and globally.
+ */
+struct nc_stats_counters {
+    ATOMIC_T in_rpcs;                   /**< Number of correct RPCs received. */
+    ATOMIC_T in_bad_rpcs;               /**< Number of messages received that were not correct RPCs. */
+    ATOMIC_T out_rpc_errors;            /**< Number of replies sent with an rpc-error. */
+    ATOMIC_T out_notifications;         /**< Number of notifications sent. */
+    ATOMIC64_T in_bytes;                /**< Number of bytes read from the transport. */
+    ATOMIC64_T out_bytes;               /**< Number of bytes written to the transport. */
+    ATOMIC64_T in_chunked_msgs;         /**< Number of :base:1.1 messages received. */
+    ATOMIC64_T in_chunked_msg_allocs;   /**< Number of buffer allocations needed for the :base:1.1 messages. */
+};
+
+/**
+ * @brief Latency histogram of an RPC processing phase.
+ */
+struct nc_rpc_lat_hist {
+    ATOMIC64_T count;                           /**< Number of recorded durations. */
+    ATOMIC64_T sum;                             /**< Sum of the recorded durations in usec. */
+    ATOMIC64_T buckets[NC_RPC_LATENCY_BUCKETS]; /**< Number of recorded durations in every bucket. */
+};
+
+/**
+ * @brief Latency histograms of an RPC.
+ */
+struct nc_rpc_lat {
+    char *module;                               /**< Module of the RPC. */
+    char *name;                                 /**< Name of the RPC. */
+    struct nc_rpc_lat_hist phases[NC_RPC_LAT_PHASE_COUNT];  /**< Histograms of all the phases. */
+};
+
+/**
+ * @brief Timestamps of the processing phases of a single RPC.
+ */
+struct nc_rpc_lat_ts {
+    struct timespec start;                      /**< Reading the RPC started. */
+    struct timespec read;                       /**< RPC read. */
+    struct timespec parsed;                     /**< RPC parsed. */
+    struct timespec clb;                        /**< RPC callback returned. */
+    struct timespec written;                    /**< Reply written. */
+};
+
+/**
+ * @brief Get a timestamp of an RPC processing phase, if the latencies are being recorded.
+ */
+#define NC_RPC_LAT_TS(lat_ts, phase) \
+    do { \
+        if (lat_ts) { \
+            nc_timeouttime_get(&(lat_ts)->phase, 0); \
+        } \
+    } while (0)
+
+/**
+ * @brief Increment a statistics counter of a server session and the global one.
+ */
+#define NC_STATS_INC(session, counter) \
+    do { \
+        ATOMIC_INC_RELAXED((session)->opts.server.stats.counter); \
+        ATOMIC_INC_RELAXED(server_opts.stats.counters.counter); \
+    } while (0)
+
+/**
+ * @brief Add to a statistics counter of a server session and the global one.
+ */
+#define NC_STATS_ADD(session, counter, count) \
+    do { \
+        ATOMIC_ADD_RELAXED((session)->opts.server.stats.counter, count); \
+        ATOMIC_ADD_RELAXED(server_opts.stats.counters.counter, count); \
+    } while (0)
+
 struct nc_server_opts {
     /* ACCESS unlocked */
     ATOMIC_T wd_basic_mode;
@@ -427,17 +714,25 @@ struct nc_server_opts {
     void (*interactive_auth_data_free)(void *data);
 
     int (*user_verify_clb)(const struct nc_session *session);
+    uint32_t tls_sess_cache_size;       /**< Maximum number of TLS sessions cached for resumption, 0 if disabled. */
+    uint32_t tls_sess_lifetime;         /**< Lifetime of resumable TLS sessions and of TLS session ticket keys. */
 #endif /* NC_ENABLED_SSH_TLS */
 
     pthread_rwlock_t config_lock;
+    ATOMIC_T config_gen;                /**< Configuration generation, incremented on every configuration change. */
 
 #ifdef NC_ENABLED_SSH_TLS
     struct nc_keystore keystore;        /**< store for server's keys/certificates */
     struct nc_truststore truststore;    /**< store for server client's keys/certificates */
+    struct nc_crl_cache crl_cache;      /**< cache of CRLs downloaded from CRL distribution points */
+    struct nc_authkeys_cache authkeys_cache; /**< cache of parsed authorized keys files of system users */
 #endif /* NC_ENABLED_SSH_TLS */
 
     struct nc_bind *binds;
     pthread_mutex_t bind_lock;          /**< To avoid concurrent calls of poll and accept on the bound sockets **/
+    uint16_t reuseport_count;           /**< Number of SO_REUSEPORT listening sockets of every INET endpoint, 0 if
+                                             not used **/
+    ATOMIC_T reuseport_next_slot;       /**< Listening socket index assigned to the next accepting thread **/
     struct nc_endpt {
         char *name;
 #ifdef NC_ENABLED_SSH_TLS
@@ -511,6 +806,23 @@ struct nc_server_opts {
     } ch_dispatch_data;
 #endif /* NC_ENABLED_SSH_TLS */
 
+    struct nc_accept_dispatch accept_dispatch;  /**< background accepting of new sessions */
+
+    struct {
+        struct nc_stats_counters counters;  /**< counters accumulated from all the sessions */
+        ATOMIC_T in_sessions;               /**< number of sessions whose <hello> was sent */
+        ATOMIC_T in_bad_hellos;             /**< number of sessions dropped because of an invalid <hello> */
+        ATOMIC_T dropped_sessions;          /**< number of abnormally terminated sessions */
+        struct timespec start_time;         /**< real time the server was initialized */
+    } stats;                                /**< NETCONF statistics, reset on server initialization */
+
+    struct {
+        ATOMIC_T enabled;                   /**< whether RPC latencies are being recorded */
+        pthread_rwlock_t lock;              /**< lock for adding RPCs, held for reading while recording */
+        struct nc_rpc_lat *rpcs;            /**< latency histograms of the processed RPCs */
+        uint16_t rpc_count;                 /**< count of rpcs */
+    } rpc_lat;                              /**< RPC processing latencies */
+
     /* Atomic IDs */
     ATOMIC_T new_session_id;
     ATOMIC_T new_client_id;
@@ -558,6 +870,70 @@ struct nc_server_opts {
  */
 #define NC_CH_CONNECT_TIMEOUT 500
 
+/**
+ * Time in sec after which a cached CRL without nextUpdate is downloaded again.
+ */
+#define NC_CRL_REFRESH_INTERVAL 3600
+
+/**
+ * Time in sec after which a failed or outdated CRL download is retried.
+ */
+#define NC_CRL_RETRY_INTERVAL 60
+
+/**
+ * Timeout in msec for the first download of a CRL when it is needed for accepting a session.
+ */
+#define NC_CRL_FETCH_TIMEOUT 5000
+
+/**
+ * Default lifetime in sec of resumable TLS sessions and rotation interval of TLS session ticket keys.
+ */
+#define NC_TLS_SESS_LIFETIME 7200
+
+/**
+ * Timeout in msec for accepting new connections by the dispatch acceptor thread, before checking for termination.
+ */
+#define NC_ACCEPT_DISPATCH_TIMEOUT 200
+
+/**
+ * Maximum number of accepted connections waiting for a dispatch handshake worker.
+ */
+#define NC_ACCEPT_DISPATCH_QUEUE 1024
+
+/**
+ * Default number of dispatch handshake worker threads.
+ */
+#define NC_ACCEPT_DISPATCH_WORKERS 8
+
+/**
+ * Maximum number of sessions established by a single dispatch handshake worker at once.
+ */
+#define NC_ACCEPT_DISPATCH_HANDSHAKES 64
+
+/**
+ * Maximum time in msec between steps of a session being established by a dispatch handshake worker,
+ * its timeouts are checked and any of its pending output flushed even if no new data are received.
+ */
+#define NC_ACCEPT_DISPATCH_POLL 100
+
+/**
+ * Maximum time in msec to wait for new data on the socket of an SSH session being established, before
+ * checking its timeouts and flushing any of its pending output.
+ */
+#define NC_SSH_ACCEPT_POLL 100
+
+/**
+ * Maximum time in msec to wait for the socket of a TLS session being established to become ready, before
+ * checking its timeout.
+ */
+#define NC_TLS_ACCEPT_POLL 100
+
+/**
+ * Time in msec a thread waits for new connections on its own SO_REUSEPORT listening sockets before checking
+ * the sockets of the other threads, whose connections would otherwise never be accepted if there are fewer threads.
+ */
+#define NC_REUSEPORT_FALLBACK_POLL 100
+
 /**
  * Number of sockets kept waiting to be accepted.
  */
@@ -588,9 +964,36 @@ typedef enum {
 struct nc_msg_cont {
     struct ly_in *msg;
     NC_MSG_TYPE type;         /**< can be either NC_MSG_REPLY or NC_MSG_NOTIF */
+    uint64_t msgid;           /**< message-id of a reply kept in the pipelining mode */
     struct nc_msg_cont *next;
 };
 
+/**
+ * @brief Receive buffer of a session, filled in blocks read from the transport.
+ */
+struct nc_rbuf {
+    char *data;         /**< buffered data, allocated on the first read */
+    uint32_t start;     /**< offset of the first unprocessed byte in data */
+    uint32_t len;       /**< count of unprocessed bytes, carried over to the next message */
+};
+
+/**
+ * @brief Bounded queue of notifications to be written to a server session.
+ */
+struct nc_ntf_queue {
+    pthread_mutex_t lock;               /**< lock for all the members */
+    pthread_cond_t cond;                /**< signaled when a notification is dequeued */
+    struct nc_server_notif_msg **msgs;  /**< ring buffer of the queued notifications */
+    uint32_t size;                      /**< size of the ring buffer */
+    uint32_t first;                     /**< index of the oldest queued notification */
+    uint32_t count;                     /**< count of queued notifications */
+    uint32_t written;                   /**< count of bytes of the oldest notification already written */
+    int started;                        /**< whether writing of the oldest notification started, it cannot be dropped */
+    NC_NTF_QUEUE_POLICY policy;         /**< policy applied when the queue is full */
+    NC_SESSION_TERM_REASON term_reason; /**< termination reason used by ::NC_NTF_QUEUE_TERMINATE */
+    uint64_t drop_count;                /**< count of dropped notifications */
+};
+
 /**
  * @brief NETCONF session structure
  */
@@ -630,9 +1033,11 @@ struct nc_session {
             void *session;
             void *config;
             struct nc_tls_ctx ctx;
+            struct nc_server_tls_cfg *srv_cfg;  /**< server side shared TLS configuration, config is owned by it */
         } tls;
 #endif /* NC_ENABLED_SSH_TLS */
     } ti;                          /**< transport implementation data */
+    struct nc_rbuf rbuf;           /**< data read from the transport but not yet processed, protected by io_lock */
     char *username;
     char *host;
     uint16_t port;
@@ -645,6 +1050,8 @@ struct nc_session {
 #define NC_SESSION_SHAREDCTX 0x01
 #define NC_SESSION_CALLHOME 0x02    /**< session is Call Home and ch_lock is initialized */
 #define NC_SESSION_CH_THREAD 0x04   /**< protected by ch_lock */
+#define NC_SESSION_FD_NOTSOCK 0x40  /**< output fd of an FD session is not a socket (detected on the first write) */
+#define NC_SESSION_STATS 0x80       /**< server session is counted in the statistics (its <hello> was sent) */
 
     union {
         struct {
@@ -653,6 +1060,11 @@ struct nc_session {
             char **cpblts;                 /**< list of server's capabilities on client side */
             pthread_mutex_t msgs_lock;     /**< lock for the msgs buffer */
             struct nc_msg_cont *msgs;      /**< queue for messages received of different type than expected */
+            struct nc_msg_cont *replies;   /**< pipelining mode, replies to other RPCs than requested in a linear
+                                                probing table indexed by their message-id modulo replies_size,
+                                                protected by msgs_lock */
+            uint32_t replies_size;         /**< size of the replies table */
+            uint32_t replies_count;        /**< number of replies kept in the replies table */
             ATOMIC_T ntf_thread_count;     /**< number of running notification threads */
             ATOMIC_T ntf_thread_running;   /**< flag whether there are notification threads for this session running or not */
             struct lyd_node *ext_data;     /**< LY ext data used in the context callback */
@@ -660,6 +1072,8 @@ struct nc_session {
             /* client flags */
             /* some server modules failed to load so the data from them will be ignored - not use strict flag for parsing */
 #           define NC_SESSION_CLIENT_NOT_STRICT 0x08
+            /* RPCs may be pipelined, replies to other RPCs than requested are kept in the replies table */
+#           define NC_SESSION_CLIENT_PIPELINING 0x10
         } client;
         struct {
             /* server side only data */
@@ -677,6 +1091,10 @@ struct nc_session {
             pthread_mutex_t ch_lock;       /**< Call Home thread lock */
             pthread_cond_t ch_cond;        /**< Call Home thread condition */
 
+            struct nc_ntf_queue *ntf_queue; /**< optional queue of notifications, written by the poll loop */
+            struct nc_stats_counters stats; /**< NETCONF statistics of the session */
+            ATOMIC_PTR_T epoll_ps;          /**< epoll pollsession the session is in, to be checked again after writing */
+
             /* server flags */
 #ifdef NC_ENABLED_SSH_TLS
             /* SSH session authenticated */
@@ -700,6 +1118,17 @@ enum nc_ps_session_state {
 struct nc_ps_session {
     struct nc_session *session;
     enum nc_ps_session_state state;
+
+    /* epoll mode */
+    int fd;                             /**< polled file descriptor of the session */
+    struct nc_ps_session *fd_next;      /**< ring of sessions sharing fd (SSH channels), points to itself if none */
+    int pending;                        /**< whether the session is in the pending list */
+    struct nc_ps_session *pending_next; /**< next session in the pending list */
+    int claimed;                        /**< whether a thread is working with the session (it is not pending nor armed) */
+    pthread_t claimer;                  /**< thread that claimed the session */
+    int recheck;                        /**< whether the session was signaled while claimed */
+    int removed;                        /**< whether the session was removed by its claimer, freed once released */
+    int del_wait;                       /**< whether a thread removing the session waits for it to be released */
 };
 
 /* ACCESS locked */
@@ -713,6 +1142,15 @@ struct nc_pollsession {
     uint8_t queue[NC_PS_QUEUE_SIZE]; /**< round buffer, queue is empty when queue_len == 0 */
     uint8_t queue_begin;             /**< queue starts on queue[queue_begin] */
     uint8_t queue_len;               /**< queue ends on queue[(queue_begin + queue_len - 1) % NC_PS_QUEUE_SIZE] */
+
+    /* epoll mode, there is no queue and lock is held directly for short periods instead */
+    int epoll_fd;                       /**< epoll instance, -1 if the sessions are polled one-by-one */
+    int wake_fd;                        /**< eventfd for waking up a thread waiting in epoll_wait() */
+    struct nc_ps_session **fd_map;      /**< registered sessions indexed by their fd */
+    int fd_map_size;                    /**< size of fd_map */
+    struct nc_ps_session *pending;      /**< list of sessions that need to be checked for data without waiting */
+    struct nc_ps_session *pending_last; /**< last session in the pending list */
+    time_t last_sweep;                  /**< monotonic time of the last check of all the sessions */
 };
 
 struct nc_ntf_thread_arg {
@@ -810,7 +1248,7 @@ void nc_realtime_get(struct timespec *ts);
  * @param[in] timeout_ms Timeout to use.
  * @return poll(2) return.
  */
-int nc_poll(struct pollfd *pfd, uint16_t pfd_count, int timeout);
+int nc_poll(struct pollfd *pfd, uint32_t pfd_count, int timeout);
 
 /**
  * @brief Enables/disables TCP keepalives.
@@ -875,6 +1313,16 @@ int nc_ps_lock(struct nc_pollsession *ps, uint8_t *id, const char *func);
 
 int nc_ps_unlock(struct nc_pollsession *ps, uint8_t id, const char *func);
 
+/**
+ * @brief Let an epoll pollsession know that a session was written to.
+ *
+ * Writing to an SSH session makes libssh read and buffer any incoming data, which are then never signaled
+ * on its fd, so the session and all the SSH channels sharing its fd need to be checked for them.
+ *
+ * @param[in] session Session written to, must not be IO locked.
+ */
+void nc_ps_epoll_session_written(struct nc_session *session);
+
 int nc_client_session_new_ctx(struct nc_session *session, struct ly_ctx *ctx);
 
 /**
@@ -896,6 +1344,23 @@ int nc_ctx_check_and_fill(struct nc_session *session);
  */
 NC_MSG_TYPE nc_handshake_io(struct nc_session *session);
 
+/**
+ * @brief Start NETCONF handshake on a server @p session by sending its \<hello\>.
+ *
+ * @param[in] session NETCONF session to use.
+ * @return NC_MSG_HELLO on success, NC_MSG_WOULDBLOCK on timeout, NC_MSG_ERROR on other error.
+ */
+NC_MSG_TYPE nc_server_handshake_start_io(struct nc_session *session);
+
+/**
+ * @brief Finish NETCONF handshake on a server @p session by receiving the client \<hello\>.
+ *
+ * @param[in] session NETCONF session to use.
+ * @return NC_MSG_HELLO on success, NC_MSG_BAD_HELLO on client \<hello\> message parsing fail,
+ * NC_MSG_WOULDBLOCK on timeout, NC_MSG_ERROR on other error.
+ */
+NC_MSG_TYPE nc_server_handshake_finish_io(struct nc_session *session);
+
 /**
  * @brief Create a socket connection.
  *
@@ -927,9 +1392,11 @@ int nc_sock_accept(int sock, int timeout, char **peer_host, uint16_t *peer_port)
  *
  * @param[in] address IP address to listen on.
  * @param[in] port Port to listen on.
+ * @param[in] reuseport Whether to create a non-blocking socket with SO_REUSEPORT so that more sockets can listen on
+ * the same @p address and @p port.
  * @return Listening socket, -1 on error.
  */
-int nc_sock_listen_inet(const char *address, uint16_t port);
+int nc_sock_listen_inet(const char *address, uint16_t port, int reuseport);
 
 /**
  * @brief Accept a new connection on a listening socket.
@@ -949,6 +1416,13 @@ int nc_sock_listen_inet(const char *address, uint16_t port);
 int nc_sock_accept_binds(struct nc_bind *binds, uint16_t bind_count, pthread_mutex_t *bind_lock, int timeout,
         char **host, uint16_t *port, uint16_t *idx, int *sock);
 
+/**
+ * @brief Close all the listening sockets of a bind.
+ *
+ * @param[in] bind Bind to close.
+ */
+void nc_server_bind_close(struct nc_bind *bind);
+
 /**
  * @brief Gets an endpoint structure based on its name.
  *
@@ -1009,12 +1483,69 @@ struct nc_session *nc_accept_callhome_ssh_sock(int sock, const char *host, uint1
  * @brief Establish SSH transport on a socket.
  *
  * @param[in] session Session structure of the new connection.
+ * @param[in] opts Endpoint SSH options.
  * @param[in] sock Socket of the new connection.
  * @param[in] timeout Transport operations timeout in msec (not SSH authentication one).
  * @return 1 on success, 0 on timeout, -1 on error.
  */
 int nc_accept_ssh_session(struct nc_session *session, struct nc_server_ssh_opts *opts, int sock, int timeout);
 
+/**
+ * @brief Start establishing SSH transport on a socket, it is then progressed by ::nc_accept_ssh_session_step().
+ *
+ * @param[in] session Session structure of the new connection.
+ * @param[in] opts Endpoint SSH options.
+ * @param[in] sock Socket of the new connection, is always consumed.
+ * @param[in] timeout Transport operations timeout in msec (not SSH authentication one).
+ * @param[out] acc State of establishing the session.
+ * @return 1 on success, -1 on error.
+ */
+int nc_accept_ssh_session_start(struct nc_session *session, struct nc_server_ssh_opts *opts, int sock, int timeout,
+        struct nc_ssh_accept *acc);
+
+/**
+ * @brief Progress establishing SSH transport as far as possible with the data received so far, never blocks.
+ *
+ * @param[in] session Session structure of the new connection.
+ * @param[in] opts Endpoint SSH options.
+ * @param[in] acc State of establishing the session.
+ * @return 1 on success, 2 if waiting for more data on the session socket, 0 on timeout, -1 on error.
+ */
+int nc_accept_ssh_session_step(struct nc_session *session, struct nc_server_ssh_opts *opts, struct nc_ssh_accept *acc);
+
+/**
+ * @brief Free a public key index.
+ *
+ * @param[in] idx Index to free.
+ */
+void nc_server_ssh_pubkey_index_free(struct nc_pubkey_index *idx);
+
+/**
+ * @brief Rebuild the public key indexes of all the configured SSH clients and truststore public key bags.
+ *
+ * CONFIG WRITE LOCK is expected to be held.
+ */
+void nc_server_ssh_pubkey_indexes_update(void);
+
+/**
+ * @brief Remove all the cached authorized keys files of system users.
+ */
+void nc_server_ssh_authkeys_cache_clear(void);
+
+/**
+ * @brief Free a cert-to-name index.
+ *
+ * @param[in] idx Index to free.
+ */
+void nc_server_tls_ctn_index_free(struct nc_ctn_index *idx);
+
+/**
+ * @brief Rebuild the cert-to-name indexes of all the configured TLS endpoints.
+ *
+ * CONFIG WRITE LOCK is expected to be held.
+ */
+void nc_server_tls_ctn_indexes_update(void);
+
 /**
  * @brief Process a SSH message.
  *
@@ -1042,6 +1573,41 @@ struct nc_session *nc_accept_callhome_tls_sock(int sock, const char *host, uint1
  */
 int nc_accept_tls_session(struct nc_session *session, struct nc_server_tls_opts *opts, int sock, int timeout);
 
+/**
+ * @brief Start establishing TLS transport on a socket, it is then progressed by ::nc_accept_tls_session_step().
+ *
+ * Config lock is expected to be held for reading, it is not needed by the following steps.
+ *
+ * @param[in] session Session structure of the new connection.
+ * @param[in] opts Endpoint TLS options.
+ * @param[in] endpt_name Name of the endpoint, its options are looked up by it in every step,
+ * must be valid until the session is established.
+ * @param[in] sock Socket of the new connection, is always consumed.
+ * @param[in] timeout Transport operations timeout in msec.
+ * @param[out] acc State of establishing the session.
+ * @return 1 on success, -1 on error.
+ */
+int nc_accept_tls_session_start(struct nc_session *session, struct nc_server_tls_opts *opts, const char *endpt_name,
+        int sock, int timeout, struct nc_tls_accept *acc);
+
+/**
+ * @brief Progress establishing TLS transport as far as possible with the data received so far, never blocks.
+ *
+ * Config lock must not be held, it is acquired only while the client certificate is being verified.
+ *
+ * @param[in] session Session structure of the new connection.
+ * @param[in] acc State of establishing the session.
+ * @return 1 on success, 2 if waiting for more data on the session socket, 0 on timeout, -1 on error.
+ */
+int nc_accept_tls_session_step(struct nc_session *session, struct nc_tls_accept *acc);
+
+/**
+ * @brief Release a reference to a shared TLS server configuration, freeing it with the last one.
+ *
+ * @param[in] cfg Shared TLS server configuration, may be NULL.
+ */
+void nc_server_tls_cfg_free(struct nc_server_tls_cfg *cfg);
+
 void nc_client_tls_destroy_opts(void);
 void _nc_client_tls_destroy_opts(struct nc_client_tls_opts *opts);
 
@@ -1055,6 +1621,25 @@ void _nc_client_tls_destroy_opts(struct nc_client_tls_opts *opts);
  */
 int nc_session_tls_crl_from_cert_ext_fetch(void *leaf_cert, void *cert_store, void **crl_store);
 
+/**
+ * @brief Add cached CRLs from distribution points to a CRL store, never downloading them.
+ *
+ * CRLs not cached yet are downloaded by a background thread, which keeps refreshing them
+ * according to their nextUpdate. Their first download is waited for up to ::NC_CRL_FETCH_TIMEOUT
+ * and if any CRL is not available, an error is returned.
+ *
+ * @param[in] uris CRL distribution point URIs.
+ * @param[in] uri_count Count of @p uris.
+ * @param[in] crl_store CRL store to add the cached CRLs to.
+ * @return 0 on success, 1 on error.
+ */
+int nc_server_crl_cache_get(char **uris, int uri_count, void *crl_store);
+
+/**
+ * @brief Stop the CRL cache refresh thread and free all the cached CRLs.
+ */
+void nc_server_crl_cache_destroy(void);
+
 #endif /* NC_ENABLED_SSH_TLS */
 
 /**
@@ -1079,6 +1664,46 @@ int nc_session_tls_crl_from_cert_ext_fetch(void *leaf_cert, void *cert_store, vo
  */
 int nc_read_msg_poll_io(struct nc_session *session, int io_timeout, struct ly_in **msg);
 
+/**
+ * @brief Read all the data available on the wire without waiting and learn whether a whole message
+ * in the :base:1.0 framing (such as \<hello\>) was received.
+ *
+ * The data are kept buffered in the session to be then read by ::nc_read_msg_poll_io() without waiting.
+ *
+ * @param[in] session NETCONF session to read from.
+ * @return 1 if the whole message was received or there is too much of it to be buffered.
+ * @return 0 if more data are needed.
+ * @return -1 on error.
+ */
+int nc_read_msg_ready_io(struct nc_session *session);
+
+/**
+ * @brief Callback for the data of a message being read.
+ *
+ * @param[in] data Read data of the message, not terminated.
+ * @param[in] len Length of @p data.
+ * @param[in] user_data Arbitrary user data.
+ */
+typedef void (*nc_read_clb)(const char *data, size_t len, void *user_data);
+
+/**
+ * @brief Poll and read a message from the wire, passing its data to a callback as they are read.
+ *
+ * Unlike nc_read_msg_poll_io(), the whole message is never kept in memory. @p read_clb is called
+ * with the IO lock held.
+ *
+ * @param[in] session NETCONF session from which the message is being read.
+ * @param[in] io_timeout Timeout in milliseconds. Negative value means infinite timeout,
+ *            zero value causes to return immediately.
+ * @param[in] read_clb Callback for the message data, called for every read part of it.
+ * @param[in] user_data Arbitrary user data passed to @p read_clb.
+ * @return 1 on success.
+ * @return 0 on timeout.
+ * @return -1 on error.
+ * @return -2 on malformed message error.
+ */
+int nc_read_msg_poll_clb_io(struct nc_session *session, int io_timeout, nc_read_clb read_clb, void *user_data);
+
 /**
  * @brief Read a message from the wire.
  *
@@ -1121,6 +1746,58 @@ int nc_read_msg_io(struct nc_session *session, int io_timeout, struct ly_in **ms
  */
 NC_MSG_TYPE nc_write_msg_io(struct nc_session *session, int io_timeout, int type, ...);
 
+/**
+ * @brief Write a printed notification into wire.
+ *
+ * @param[in] session NETCONF session to which the notification will be written.
+ * @param[in] io_timeout Timeout in milliseconds. Negative value means infinite timeout,
+ *            zero value causes to return immediately.
+ * @param[in] msg Printed notification to write.
+ * @return #NC_MSG_NOTIF on success, #NC_MSG_WOULDBLOCK if IO lock could not be acquired in @p io_timeout,
+ * #NC_MSG_ERROR on error.
+ */
+NC_MSG_TYPE nc_write_notif_msg_io(struct nc_session *session, int io_timeout, const struct nc_server_notif_msg *msg);
+
+/**
+ * @brief Write the queued notifications of a server session. Session IO lock must be held!
+ *
+ * @param[in] session NETCONF session with a notification queue.
+ * @param[in] finish Whether to only finish writing a partially written notification, waiting until it is written.
+ * Otherwise, as many notifications as possible are written without waiting.
+ * @return 0 on success.
+ * @return -1 on error.
+ */
+int nc_write_ntf_queue(struct nc_session *session, int finish);
+
+/**
+ * @brief Learn whether a server session has any queued notifications.
+ *
+ * @param[in] session NETCONF session.
+ * @return Non-zero if there are notifications to write, 0 otherwise.
+ */
+int nc_session_ntf_queue_pending(struct nc_session *session);
+
+/**
+ * @brief Free a notification queue of a server session.
+ *
+ * @param[in] queue Notification queue to free.
+ */
+void nc_ntf_queue_free(struct nc_ntf_queue *queue);
+
+/**
+ * @brief Escape XML special characters of data printed as XML content.
+ *
+ * Escaping stops when the next output does not fit into @p dst, it can be continued with another buffer.
+ *
+ * @param[in] src Data to escape.
+ * @param[in] src_len Length of @p src.
+ * @param[in,out] src_used Number of bytes of @p src already escaped, is updated.
+ * @param[in] dst Buffer to write the escaped data into.
+ * @param[in] dst_size Size of @p dst.
+ * @return Number of bytes written into @p dst.
+ */
+uint32_t nc_xml_escape(const char *src, uint32_t src_len, uint32_t *src_used, char *dst, uint32_t dst_size);
+
 /**
  * @brief Check whether a session is still connected (on transport layer).
  *
@@ -50,10 +50,24 @@
 #include <libssh/libssh.h>
 #endif
 
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define NC_PS_EPOLL_EVENTS 16 /* maximum number of events returned by a single epoll_wait() call */
+#endif
+
 struct nc_server_opts server_opts = {
     .config_lock = PTHREAD_RWLOCK_INITIALIZER,
     .ch_client_lock = PTHREAD_RWLOCK_INITIALIZER,
     .idle_timeout = 180,    /**< default idle timeout (not in config for UNIX socket) */
+#ifdef NC_ENABLED_SSH_TLS
+    .crl_cache = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER,
+            .fetch_cond = PTHREAD_COND_INITIALIZER},
+    .authkeys_cache = {.lock = PTHREAD_MUTEX_INITIALIZER},
+#endif
+    .accept_dispatch = {.lock = PTHREAD_MUTEX_INITIALIZER, .cond = PTHREAD_COND_INITIALIZER},
+    .rpc_lat = {.lock = PTHREAD_RWLOCK_INITIALIZER},
 };
 
 static nc_rpc_clb global_rpc_clb = NULL;
@@ -272,9 +286,9 @@ nc_server_ch_set_dispatch_data(nc_server_ch_session_acquire_ctx_cb acquire_ctx_c
 #endif
 
 int
-nc_sock_listen_inet(const char *address, uint16_t port)
+nc_sock_listen_inet(const char *address, uint16_t port, int reuseport)
 {
-    int opt;
+    int opt, flags;
     int is_ipv4, sock;
     struct sockaddr_storage saddr;
 
@@ -304,6 +318,20 @@ nc_sock_listen_inet(const char *address, uint16_t port)
         goto fail;
     }
 
+    if (reuseport) {
+        /* the connections are balanced among all the sockets by the kernel */
+        if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof opt) == -1) {
+            ERR(NULL, "Could not set SO_REUSEPORT socket option (%s).", strerror(errno));
+            goto fail;
+        }
+
+        /* more threads may poll on the socket, those that do not manage to accept a connection must not block */
+        if (((flags = fcntl(sock, F_GETFL)) == -1) || (fcntl(sock, F_SETFL, flags | O_NONBLOCK) == -1)) {
+            ERR(NULL, "Fcntl failed (%s).", strerror(errno));
+            goto fail;
+        }
+    }
+
     memset(&saddr, 0, sizeof(struct sockaddr_storage));
     if (is_ipv4) {
         saddr4 = (struct sockaddr_in *)&saddr;
@@ -500,16 +528,79 @@ sock_host_inet6(const struct sockaddr_in6 *addr, char **host, uint16_t *port)
     return 0;
 }
 
+/**
+ * @brief Finish accepting a new connection, learn the information about the client.
+ *
+ * @param[in] client_sock Accepted socket, closed on error.
+ * @param[in] saddr Address of the client.
+ * @param[in] bind Bind the connection was accepted on.
+ * @param[out] host Host of the remote peer. Can be NULL.
+ * @param[out] port Port of the new connection. Can be NULL.
+ * @return 0 on success, -1 on error.
+ */
+static int
+nc_sock_accept_finish(int client_sock, struct sockaddr_storage *saddr, const struct nc_bind *bind, char **host,
+        uint16_t *port)
+{
+    uint16_t client_port;
+    char *client_address;
+    int flags;
+
+    /* make the socket non-blocking */
+    if (((flags = fcntl(client_sock, F_GETFL)) == -1) || (fcntl(client_sock, F_SETFL, flags | O_NONBLOCK) == -1)) {
+        ERR(NULL, "Fcntl failed (%s).", strerror(errno));
+        goto fail;
+    }
+
+    /* learn information about the client end */
+    if (saddr->ss_family == AF_UNIX) {
+        if (sock_host_unix(client_sock, &client_address)) {
+            goto fail;
+        }
+        client_port = 0;
+    } else if (saddr->ss_family == AF_INET) {
+        if (sock_host_inet((struct sockaddr_in *)saddr, &client_address, &client_port)) {
+            goto fail;
+        }
+    } else if (saddr->ss_family == AF_INET6) {
+        if (sock_host_inet6((struct sockaddr_in6 *)saddr, &client_address, &client_port)) {
+            goto fail;
+        }
+    } else {
+        ERR(NULL, "Source host of an unknown protocol family.");
+        goto fail;
+    }
+
+    if (saddr->ss_family == AF_UNIX) {
+        VRB(NULL, "Accepted a connection on %s.", bind->address);
+    } else {
+        VRB(NULL, "Accepted a connection on %s:%u from %s:%u.", bind->address, bind->port, client_address, client_port);
+    }
+
+    if (host) {
+        *host = client_address;
+    } else {
+        free(client_address);
+    }
+    if (port) {
+        *port = client_port;
+    }
+    return 0;
+
+fail:
+    close(client_sock);
+    return -1;
+}
+
 int
 nc_sock_accept_binds(struct nc_bind *binds, uint16_t bind_count, pthread_mutex_t *bind_lock, int timeout, char **host,
         uint16_t *port, uint16_t *idx, int *sock)
 {
-    uint16_t i, j, pfd_count, client_port;
-    char *client_address;
+    uint16_t i, j, pfd_count;
     struct pollfd *pfd;
     struct sockaddr_storage saddr;
     socklen_t saddr_len = sizeof(saddr);
-    int ret, client_sock, server_sock = -1, flags;
+    int ret, client_sock, server_sock = -1;
 
     pfd = malloc(bind_count * sizeof *pfd);
     NC_CHECK_ERRMEM_RET(!pfd, -1);
@@ -584,59 +675,327 @@ nc_sock_accept_binds(struct nc_bind *binds, uint16_t bind_count, pthread_mutex_t
         return -1;
     }
 
-    /* make the socket non-blocking */
-    if (((flags = fcntl(client_sock, F_GETFL)) == -1) || (fcntl(client_sock, F_SETFL, flags | O_NONBLOCK) == -1)) {
-        ERR(NULL, "Fcntl failed (%s).", strerror(errno));
-        goto fail;
+    if (nc_sock_accept_finish(client_sock, &saddr, &binds[i], host, port)) {
+        /* UNLOCK */
+        pthread_mutex_unlock(bind_lock);
+        return -1;
+    }
+    if (idx) {
+        *idx = i;
     }
+    /* UNLOCK */
+    pthread_mutex_unlock(bind_lock);
 
-    /* learn information about the client end */
-    if (saddr.ss_family == AF_UNIX) {
-        if (sock_host_unix(client_sock, &client_address)) {
-            goto fail;
+    *sock = client_sock;
+    return 1;
+}
+
+/**
+ * @brief Accept a new connection on the listening sockets of the calling thread.
+ *
+ * Each thread polls on its own listening socket of SO_REUSEPORT binds first, which are accepted on without
+ * any lock. The sockets of the other threads are checked only if there is no new connection on its own
+ * for a while, in case there are fewer threads than sockets. Other binds are accepted on while holding @p bind_lock.
+ *
+ * @param[in] binds Structure with the listening sockets.
+ * @param[in] bind_count Number of @p binds.
+ * @param[in] bind_lock Lock for avoiding concurrent poll/accept on a single bind.
+ * @param[in] slot Listening socket index of the calling thread, -1 for polling on all the listening sockets.
+ * @param[in] pfd Poll structures for all the sockets to poll on.
+ * @param[in] pfd_bind Bind indices of the sockets in @p pfd.
+ * @param[in] timeout Timeout for accepting.
+ * @param[out] host Host of the remote peer. Can be NULL.
+ * @param[out] port Port of the new connection. Can be NULL.
+ * @param[out] idx Index of the bind that was accepted. Can be NULL.
+ * @param[out] sock Accepted socket, if any.
+ * @return -1 on error.
+ * @return 0 on timeout.
+ * @return 1 if a socket was accepted.
+ */
+static int
+_nc_sock_accept_binds_reuseport(struct nc_bind *binds, uint16_t bind_count, pthread_mutex_t *bind_lock, int slot,
+        struct pollfd *pfd, uint32_t *pfd_bind, int timeout, char **host, uint16_t *port, uint16_t *idx, int *sock)
+{
+    uint32_t i, j, own, own_count, pfd_count = 0;
+    struct sockaddr_storage saddr;
+    socklen_t saddr_len = sizeof saddr;
+    struct timespec ts_timeout;
+    int ret, client_sock, locked = 0, wait_ms;
+
+    /* the sockets of this thread first, then the other listening sockets of SO_REUSEPORT binds */
+    for (i = 0; i < bind_count; i++) {
+        if (binds[i].sock < 0) {
+            /* invalid socket */
+            continue;
         }
-        client_port = 0;
-    } else if (saddr.ss_family == AF_INET) {
-        if (sock_host_inet((struct sockaddr_in *)&saddr, &client_address, &client_port)) {
-            goto fail;
+
+        own = (binds[i].reuseport && (slot > -1)) ? slot % (binds[i].reuse_sock_count + 1) : 0;
+        pfd[pfd_count].fd = own ? binds[i].reuse_socks[own - 1] : binds[i].sock;
+        pfd[pfd_count].events = POLLIN;
+        pfd[pfd_count].revents = 0;
+        pfd_bind[pfd_count] = i;
+        ++pfd_count;
+
+        if (slot == -1) {
+            for (j = 0; binds[i].reuseport && (j < binds[i].reuse_sock_count); j++) {
+                pfd[pfd_count].fd = binds[i].reuse_socks[j];
+                pfd[pfd_count].events = POLLIN;
+                pfd[pfd_count].revents = 0;
+                pfd_bind[pfd_count] = i;
+                ++pfd_count;
+            }
         }
-    } else if (saddr.ss_family == AF_INET6) {
-        if (sock_host_inet6((struct sockaddr_in6 *)&saddr, &client_address, &client_port)) {
-            goto fail;
+    }
+    own_count = pfd_count;
+    for (i = 0; (slot > -1) && (i < bind_count); i++) {
+        if ((binds[i].sock < 0) || !binds[i].reuseport) {
+            continue;
+        }
+
+        own = slot % (binds[i].reuse_sock_count + 1);
+        for (j = 0; j < binds[i].reuse_sock_count + 1U; j++) {
+            if (j == own) {
+                continue;
+            }
+            pfd[pfd_count].fd = j ? binds[i].reuse_socks[j - 1] : binds[i].sock;
+            pfd[pfd_count].events = POLLIN;
+            pfd[pfd_count].revents = 0;
+            pfd_bind[pfd_count] = i;
+            ++pfd_count;
         }
-    } else {
-        ERR(NULL, "Source host of an unknown protocol family.");
-        goto fail;
     }
 
-    if (saddr.ss_family == AF_UNIX) {
-        VRB(NULL, "Accepted a connection on %s.", binds[i].address);
-    } else {
-        VRB(NULL, "Accepted a connection on %s:%u from %s:%u.", binds[i].address, binds[i].port, client_address, client_port);
+    if (timeout > 0) {
+        nc_timeouttime_get(&ts_timeout, timeout);
     }
+    while (1) {
+        /* poll for a new connection on the own sockets, only for a while if there are other sockets */
+        wait_ms = timeout;
+        if (timeout > 0) {
+            wait_ms = nc_timeouttime_cur_diff(&ts_timeout);
+            if (wait_ms < 0) {
+                wait_ms = 0;
+            }
+        }
+        if ((pfd_count > own_count) && ((wait_ms < 0) || (wait_ms > NC_REUSEPORT_FALLBACK_POLL))) {
+            wait_ms = NC_REUSEPORT_FALLBACK_POLL;
+        }
+        ret = nc_poll(pfd, own_count, wait_ms);
+        if (!ret && (pfd_count > own_count)) {
+            /* connections queued on the sockets of the other threads, if there are not enough threads */
+            ret = nc_poll(pfd + own_count, pfd_count - own_count, 0);
+        }
+        if (ret) {
+            break;
+        }
 
-    if (host) {
-        *host = client_address;
-    } else {
-        free(client_address);
+        if (!timeout || ((timeout > 0) && (nc_timeouttime_cur_diff(&ts_timeout) < 1))) {
+            /* timeout */
+            return 0;
+        }
     }
-    if (port) {
-        *port = client_port;
+    if (ret < 0) {
+        return ret;
+    }
+
+    for (j = 0; (j < pfd_count) && !(pfd[j].revents & POLLIN); j++) {}
+    if (j == pfd_count) {
+        ERRINT;
+        return -1;
+    }
+    i = pfd_bind[j];
+
+    if (!binds[i].reuseport) {
+        /* LOCK */
+        pthread_mutex_lock(bind_lock);
+        locked = 1;
+
+        /* the connection may have been accepted by another thread meanwhile */
+        pfd[j].revents = 0;
+        ret = nc_poll(&pfd[j], 1, 0);
+        if (ret < 1) {
+            goto cleanup;
+        }
+    }
+
+    /* accept connection */
+    client_sock = accept(pfd[j].fd, (struct sockaddr *)&saddr, &saddr_len);
+    if (client_sock < 0) {
+        if (binds[i].reuseport && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+            /* accepted by another thread sharing the listening socket */
+            ret = 0;
+        } else {
+            ERR(NULL, "Accept failed (%s).", strerror(errno));
+            ret = -1;
+        }
+        goto cleanup;
+    }
+
+    if (nc_sock_accept_finish(client_sock, &saddr, &binds[i], host, port)) {
+        ret = -1;
+        goto cleanup;
     }
     if (idx) {
         *idx = i;
     }
-    /* UNLOCK */
-    pthread_mutex_unlock(bind_lock);
-
     *sock = client_sock;
-    return 1;
+    ret = 1;
+
+cleanup:
+    if (locked) {
+        /* UNLOCK */
+        pthread_mutex_unlock(bind_lock);
+    }
+    return ret;
+}
+
+/**
+ * @brief Accept a new connection on the listening sockets of the calling thread.
+ *
+ * @param[in] binds Structure with the listening sockets.
+ * @param[in] bind_count Number of @p binds.
+ * @param[in] bind_lock Lock for avoiding concurrent poll/accept on a single bind.
+ * @param[in] slot Listening socket index of the calling thread, -1 for polling on all the listening sockets.
+ * @param[in] timeout Timeout for accepting.
+ * @param[out] host Host of the remote peer. Can be NULL.
+ * @param[out] port Port of the new connection. Can be NULL.
+ * @param[out] idx Index of the bind that was accepted. Can be NULL.
+ * @param[out] sock Accepted socket, if any.
+ * @return -1 on error.
+ * @return 0 on timeout.
+ * @return 1 if a socket was accepted.
+ */
+static int
+nc_sock_accept_binds_reuseport(struct nc_bind *binds, uint16_t bind_count, pthread_mutex_t *bind_lock, int slot,
+        int timeout, char **host, uint16_t *port, uint16_t *idx, int *sock)
+{
+    uint16_t i;
+    uint32_t pfd_size = 0, *pfd_bind;
+    struct pollfd *pfd;
+    int ret;
+
+    /* learn the number of sockets to poll on */
+    for (i = 0; i < bind_count; i++) {
+        if (binds[i].reuseport) {
+            /* all the sockets are polled on, the own one first */
+            pfd_size += binds[i].reuse_sock_count + 1;
+        } else {
+            ++pfd_size;
+        }
+    }
+    if (!pfd_size) {
+        return 0;
+    }
+
+    pfd = malloc(pfd_size * sizeof *pfd);
+    pfd_bind = malloc(pfd_size * sizeof *pfd_bind);
+    if (!pfd || !pfd_bind) {
+        ERRMEM;
+        free(pfd);
+        free(pfd_bind);
+        return -1;
+    }
+
+    ret = _nc_sock_accept_binds_reuseport(binds, bind_count, bind_lock, slot, pfd, pfd_bind, timeout, host, port, idx, sock);
+
+    free(pfd);
+    free(pfd_bind);
+    return ret;
+}
+
+void
+nc_server_bind_close(struct nc_bind *bind)
+{
+    uint16_t i;
+
+    if (bind->sock > -1) {
+        close(bind->sock);
+        bind->sock = -1;
+    }
+
+    for (i = 0; i < bind->reuse_sock_count; i++) {
+        close(bind->reuse_socks[i]);
+    }
+    free(bind->reuse_socks);
+    bind->reuse_socks = NULL;
+    bind->reuse_sock_count = 0;
+    bind->reuseport = 0;
+}
+
+/**
+ * @brief Create all the SO_REUSEPORT listening sockets of a bind.
+ *
+ * @param[in] address IP address to listen on.
+ * @param[in] port Port to listen on.
+ * @param[in] count Number of listening sockets to create.
+ * @param[out] bind Bind with no sockets to fill.
+ * @return 0 on success, 1 on error.
+ */
+static int
+nc_server_bind_listen_reuseport(const char *address, uint16_t port, uint16_t count, struct nc_bind *bind)
+{
+    uint16_t i;
+
+    bind->sock = nc_sock_listen_inet(address, port, 1);
+    if (bind->sock == -1) {
+        return 1;
+    }
+    bind->reuseport = 1;
+
+    if (count > 1) {
+        bind->reuse_socks = malloc((count - 1) * sizeof *bind->reuse_socks);
+        NC_CHECK_ERRMEM_GOTO(!bind->reuse_socks, , fail);
+    }
+    for (i = 0; i < count - 1; i++) {
+        bind->reuse_socks[i] = nc_sock_listen_inet(address, port, 1);
+        if (bind->reuse_socks[i] == -1) {
+            goto fail;
+        }
+        ++bind->reuse_sock_count;
+    }
+
+    return 0;
 
 fail:
-    close(client_sock);
-    /* UNLOCK */
-    pthread_mutex_unlock(bind_lock);
-    return -1;
+    nc_server_bind_close(bind);
+    return 1;
+}
+
+/**
+ * @brief Key of the listening socket index of a thread, created by nc_server_init() and deleted by nc_server_destroy().
+ */
+static pthread_key_t nc_reuseport_slot_key;
+
+/**
+ * @brief Get the listening socket index of the calling thread, a new one is assigned on the first call.
+ *
+ * @return Listening socket index.
+ */
+static int
+nc_server_reuseport_slot(void)
+{
+    uintptr_t slot;
+
+    /* stored incremented so that NULL means not assigned yet */
+    slot = (uintptr_t)pthread_getspecific(nc_reuseport_slot_key);
+    if (!slot) {
+        slot = (ATOMIC_INC_RELAXED(server_opts.reuseport_next_slot) % UINT16_MAX) + 1;
+        pthread_setspecific(nc_reuseport_slot_key, (void *)slot);
+    }
+
+    return slot - 1;
+}
+
+API void
+nc_server_set_reuseport_listeners(uint16_t listener_count)
+{
+    /* CONFIG LOCK */
+    pthread_rwlock_wrlock(&server_opts.config_lock);
+
+    server_opts.reuseport_count = listener_count;
+
+    /* CONFIG UNLOCK */
+    pthread_rwlock_unlock(&server_opts.config_lock);
 }
 
 API struct nc_server_reply *
@@ -781,6 +1140,10 @@ nc_server_init(void)
     ATOMIC_STORE_RELAXED(server_opts.new_session_id, 1);
     ATOMIC_STORE_RELAXED(server_opts.new_client_id, 1);
 
+    /* reset the statistics */
+    memset(&server_opts.stats, 0, sizeof server_opts.stats);
+    nc_realtime_get(&server_opts.stats.start_time);
+
 #ifdef HAVE_PTHREAD_RWLOCKATTR_SETKIND_NP
     pthread_rwlockattr_t attr;
 
@@ -826,6 +1189,11 @@ nc_server_init(void)
         goto error;
     }
 
+    if ((r = pthread_key_create(&nc_reuseport_slot_key, NULL))) {
+        ERR(NULL, "%s: failed to create a thread key (%s).", __func__, strerror(r));
+        goto error;
+    }
+
     return 0;
 
 error:
@@ -840,6 +1208,9 @@ nc_server_destroy(void)
 {
     uint32_t i, endpt_count;
 
+    /* stop accepting new sessions in the background */
+    nc_server_accept_dispatch_stop();
+
     for (i = 0; i < server_opts.capabilities_count; i++) {
         free(server_opts.capabilities[i]);
     }
@@ -861,10 +1232,16 @@ nc_server_destroy(void)
     }
 
     pthread_mutex_destroy(&server_opts.bind_lock);
+    server_opts.reuseport_count = 0;
+    pthread_key_delete(nc_reuseport_slot_key);
+
+    ATOMIC_STORE_RELAXED(server_opts.rpc_lat.enabled, 0);
+    nc_server_reset_rpc_latency();
 
 #ifdef NC_ENABLED_SSH_TLS
     free(server_opts.authkey_path_fmt);
     server_opts.authkey_path_fmt = NULL;
+    nc_server_ssh_authkeys_cache_clear();
     free(server_opts.pam_config_name);
     server_opts.pam_config_name = NULL;
     if (server_opts.interactive_auth_data && server_opts.interactive_auth_data_free) {
@@ -875,6 +1252,7 @@ nc_server_destroy(void)
 
     nc_server_config_ks_keystore(NULL, NC_OP_DELETE);
     nc_server_config_ts_truststore(NULL, NC_OP_DELETE);
+    nc_server_crl_cache_destroy();
     curl_global_cleanup();
     ssh_finalize();
 #endif /* NC_ENABLED_SSH_TLS */
@@ -1066,6 +1444,12 @@ nc_ps_lock(struct nc_pollsession *ps, uint8_t *id, const char *func)
         return -1;
     }
 
+    if (ps->epoll_fd > -1) {
+        /* there is no queue, the lock is only held for a short time and kept until unlocked */
+        *id = 0;
+        return 0;
+    }
+
     /* check that the queue is long enough */
     if (ps->queue_len == NC_PS_QUEUE_SIZE) {
         ERR(NULL, "%s: pollsession queue size (%d) too small.", func, NC_PS_QUEUE_SIZE);
@@ -1112,6 +1496,12 @@ nc_ps_unlock(struct nc_pollsession *ps, uint8_t id, const char *func)
 {
     int ret;
 
+    if (ps->epoll_fd > -1) {
+        /* UNLOCK */
+        pthread_mutex_unlock(&ps->lock);
+        return 0;
+    }
+
     /* LOCK */
     ret = pthread_mutex_lock(&ps->lock);
     if (ret) {
@@ -1154,12 +1544,56 @@ nc_ps_new(void)
     NC_CHECK_ERRMEM_RET(!ps, NULL);
     pthread_cond_init(&ps->cond, NULL);
     pthread_mutex_init(&ps->lock, NULL);
+    ps->epoll_fd = -1;
+    ps->wake_fd = -1;
 
     return ps;
 }
 
-API void
-nc_ps_free(struct nc_pollsession *ps)
+API struct nc_pollsession *
+nc_ps_new_epoll(void)
+{
+#ifdef HAVE_EPOLL
+    struct nc_pollsession *ps;
+    struct epoll_event ev = {0};
+
+    ps = nc_ps_new();
+    if (!ps) {
+        return NULL;
+    }
+
+    ps->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (ps->epoll_fd == -1) {
+        ERR(NULL, "Failed to create an epoll instance (%s).", strerror(errno));
+        goto error;
+    }
+
+    /* eventfd for waking up the waiting threads */
+    ps->wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (ps->wake_fd == -1) {
+        ERR(NULL, "Failed to create an eventfd (%s).", strerror(errno));
+        goto error;
+    }
+    ev.events = EPOLLIN;
+    ev.data.fd = ps->wake_fd;
+    if (epoll_ctl(ps->epoll_fd, EPOLL_CTL_ADD, ps->wake_fd, &ev) == -1) {
+        ERR(NULL, "Failed to add an eventfd into an epoll instance (%s).", strerror(errno));
+        goto error;
+    }
+
+    return ps;
+
+error:
+    nc_ps_free(ps);
+    return NULL;
+#else
+    ERR(NULL, "Polling sessions using epoll is not supported on this system.");
+    return NULL;
+#endif
+}
+
+API void
+nc_ps_free(struct nc_pollsession *ps)
 {
     uint16_t i;
 
@@ -1178,10 +1612,413 @@ nc_ps_free(struct nc_pollsession *ps)
     free(ps->sessions);
     pthread_mutex_destroy(&ps->lock);
     pthread_cond_destroy(&ps->cond);
+    if (ps->epoll_fd > -1) {
+        close(ps->epoll_fd);
+    }
+    if (ps->wake_fd > -1) {
+        close(ps->wake_fd);
+    }
+    free(ps->fd_map);
 
     free(ps);
 }
 
+#ifdef HAVE_EPOLL
+
+/**
+ * @brief Get the file descriptor to wait on for new data of a session.
+ *
+ * @param[in] session Session to use.
+ * @return File descriptor, -1 on error.
+ */
+static int
+nc_ps_epoll_session_fd(const struct nc_session *session)
+{
+    switch (session->ti_type) {
+#ifdef NC_ENABLED_SSH_TLS
+    case NC_TI_SSH:
+        return ssh_get_fd(session->ti.libssh.session);
+    case NC_TI_TLS:
+        return nc_tls_get_fd_wrap(session);
+#endif /* NC_ENABLED_SSH_TLS */
+    case NC_TI_FD:
+        return session->ti.fd.in;
+    case NC_TI_UNIX:
+        return session->ti.unixsock.sock;
+    case NC_TI_NONE:
+        break;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Append a session to the pending list of a pollsession, if not there already.
+ * If the session is claimed by a thread, it is only marked to be checked again once released.
+ * A terminated session that was already returned is never appended.
+ *
+ * @param[in] ps Pollsession structure, locked.
+ * @param[in] ps_session Session to append.
+ */
+static void
+nc_ps_pending_add(struct nc_pollsession *ps, struct nc_ps_session *ps_session)
+{
+    if (ps_session->state == NC_PS_STATE_INVALID) {
+        return;
+    } else if (ps_session->claimed) {
+        ps_session->recheck = 1;
+        return;
+    } else if (ps_session->pending) {
+        return;
+    }
+
+    ps_session->pending = 1;
+    ps_session->pending_next = NULL;
+    if (ps->pending_last) {
+        ps->pending_last->pending_next = ps_session;
+    } else {
+        ps->pending = ps_session;
+    }
+    ps->pending_last = ps_session;
+}
+
+/**
+ * @brief Remove a session from the pending list of a pollsession.
+ *
+ * @param[in] ps Pollsession structure.
+ * @param[in] ps_session Session to remove.
+ * @param[in] prev Previous session in the list, NULL if @p ps_session is the first one.
+ */
+static void
+nc_ps_pending_del(struct nc_pollsession *ps, struct nc_ps_session *ps_session, struct nc_ps_session *prev)
+{
+    if (prev) {
+        prev->pending_next = ps_session->pending_next;
+    } else {
+        ps->pending = ps_session->pending_next;
+    }
+    if (ps->pending_last == ps_session) {
+        ps->pending_last = prev;
+    }
+
+    ps_session->pending = 0;
+    ps_session->pending_next = NULL;
+}
+
+/**
+ * @brief Arm the file descriptor of a session in the epoll instance so that the next data on it are reported (once).
+ *
+ * @param[in] ps Pollsession structure.
+ * @param[in] ps_session Session whose fd to arm.
+ * @return 0 on success, -1 on error.
+ */
+static int
+nc_ps_epoll_arm(struct nc_pollsession *ps, struct nc_ps_session *ps_session)
+{
+    struct epoll_event ev = {0};
+
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    if (nc_session_ntf_queue_pending(ps_session->session)) {
+        /* also write the queued notifications once possible */
+        ev.events |= EPOLLOUT;
+    }
+    ev.data.fd = ps_session->fd;
+    if (epoll_ctl(ps->epoll_fd, EPOLL_CTL_MOD, ps_session->fd, &ev) == -1) {
+        ERR(ps_session->session, "Failed to rearm a session in an epoll instance (%s).", strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Register a new session in the epoll instance of a pollsession.
+ *
+ * @param[in] ps Pollsession structure, locked.
+ * @param[in] ps_session Session to register.
+ * @return 0 on success, -1 on error.
+ */
+static int
+nc_ps_epoll_add(struct nc_pollsession *ps, struct nc_ps_session *ps_session)
+{
+    struct epoll_event ev = {0};
+    struct nc_ps_session **fd_map, *owner;
+    int fd_map_size;
+
+    ps_session->fd_next = ps_session;
+    ps_session->fd = nc_ps_epoll_session_fd(ps_session->session);
+    if (ps_session->fd < 0) {
+        ERR(ps_session->session, "Failed to get the session file descriptor.");
+        return -1;
+    }
+
+    if (ps_session->fd >= ps->fd_map_size) {
+        /* enlarge the fd map */
+        fd_map_size = ps_session->fd + 1 > ps->fd_map_size * 2 ? ps_session->fd + 1 : ps->fd_map_size * 2;
+        fd_map = realloc(ps->fd_map, fd_map_size * sizeof *fd_map);
+        NC_CHECK_ERRMEM_RET(!fd_map, -1);
+        memset(fd_map + ps->fd_map_size, 0, (fd_map_size - ps->fd_map_size) * sizeof *fd_map);
+        ps->fd_map = fd_map;
+        ps->fd_map_size = fd_map_size;
+    }
+
+    /* the fd is stored instead of a pointer to the session so that an event may not outlive it */
+    ev.events = EPOLLIN | EPOLLONESHOT;
+    ev.data.fd = ps_session->fd;
+    if (!epoll_ctl(ps->epoll_fd, EPOLL_CTL_ADD, ps_session->fd, &ev)) {
+        ps->fd_map[ps_session->fd] = ps_session;
+    } else if (errno == EEXIST) {
+        /* fd shared with another session (SSH channels of a single SSH session), link them */
+        owner = ps->fd_map[ps_session->fd];
+        if (!owner) {
+            ERRINT;
+            return -1;
+        }
+        ps_session->fd_next = owner->fd_next;
+        owner->fd_next = ps_session;
+    } else {
+        ERR(ps_session->session, "Failed to add a session into an epoll instance (%s).", strerror(errno));
+        return -1;
+    }
+
+    /* some data may have already been buffered during the handshake */
+    nc_ps_pending_add(ps, ps_session);
+    ATOMIC_PTR_STORE_RELAXED(ps_session->session->opts.server.epoll_ps, ps);
+
+    return 0;
+}
+
+/**
+ * @brief Unregister a session from the epoll instance of a pollsession.
+ *
+ * If the session is claimed by another thread, wait for it to be released so that neither @p ps_session nor
+ * its NETCONF session are used anymore once this function returns.
+ *
+ * @param[in] ps Pollsession structure, locked.
+ * @param[in] ps_session Session to unregister.
+ * @return 0 if @p ps_session can be freed.
+ * @return 1 if @p ps_session is claimed by this thread and will be freed once released.
+ */
+static int
+nc_ps_epoll_del(struct nc_pollsession *ps, struct nc_ps_session *ps_session)
+{
+    struct nc_ps_session *iter, *prev = NULL;
+
+    ATOMIC_PTR_STORE_RELAXED(ps_session->session->opts.server.epoll_ps, NULL);
+
+    if (ps_session->pending) {
+        for (iter = ps->pending; iter != ps_session; iter = iter->pending_next) {
+            prev = iter;
+        }
+        nc_ps_pending_del(ps, ps_session, prev);
+    }
+
+    /* find the previous session in the ring */
+    for (iter = ps_session; iter->fd_next != ps_session; iter = iter->fd_next) {}
+
+    if (iter != ps_session) {
+        /* unlink it, the fd is still used by other sessions, which may need to wait for new data now */
+        iter->fd_next = ps_session->fd_next;
+        if (ps->fd_map[ps_session->fd] == ps_session) {
+            ps->fd_map[ps_session->fd] = iter;
+        }
+        nc_ps_epoll_arm(ps, iter);
+    } else if (ps->fd_map[ps_session->fd] == ps_session) {
+        /* may fail if the fd has already been closed, it is removed automatically then */
+        epoll_ctl(ps->epoll_fd, EPOLL_CTL_DEL, ps_session->fd, NULL);
+        ps->fd_map[ps_session->fd] = NULL;
+    }
+    ps_session->fd_next = ps_session;
+
+    if (ps_session->claimed && pthread_equal(ps_session->claimer, pthread_self())) {
+        /* removed from an RPC callback, cannot wait for ourselves */
+        ps_session->removed = 1;
+        return 1;
+    }
+
+    ps_session->del_wait = 1;
+    while (ps_session->claimed) {
+        pthread_cond_wait(&ps->cond, &ps->lock);
+    }
+    return 0;
+}
+
+/**
+ * @brief Wake up a thread waiting for events of a pollsession.
+ *
+ * @param[in] ps Pollsession structure.
+ */
+static void
+nc_ps_epoll_wake(struct nc_pollsession *ps)
+{
+    uint64_t val = 1;
+
+    if (write(ps->wake_fd, &val, sizeof val) == -1) {
+        ERR(NULL, "Failed to wake up a pollsession thread (%s).", strerror(errno));
+    }
+}
+
+/**
+ * @brief Claim the first session in the pending list of a pollsession.
+ *
+ * @param[in] ps Pollsession structure, locked.
+ * @return Claimed session, NULL if the pending list is empty.
+ */
+static struct nc_ps_session *
+nc_ps_pending_claim(struct nc_pollsession *ps)
+{
+    struct nc_ps_session *ps_session;
+
+    ps_session = ps->pending;
+    if (!ps_session) {
+        return NULL;
+    }
+
+    nc_ps_pending_del(ps, ps_session, NULL);
+    ps_session->claimed = 1;
+    ps_session->claimer = pthread_self();
+
+    if (ps->pending) {
+        /* let another thread claim the next session */
+        nc_ps_epoll_wake(ps);
+    }
+
+    return ps_session;
+}
+
+/**
+ * @brief Learn whether libssh has already buffered some data of an SSH session, which would not be signaled on its fd.
+ *
+ * @param[in] ps_session Session to check, neither claimed nor pending.
+ * @return Non-zero if the session should be checked, 0 otherwise.
+ */
+static int
+nc_ps_epoll_ssh_buffered(struct nc_ps_session *ps_session)
+{
+#ifdef NC_ENABLED_SSH_TLS
+    struct nc_session *session = ps_session->session;
+    int r;
+
+    if ((session->ti_type != NC_TI_SSH) || !session->ti.libssh.channel) {
+        return 0;
+    }
+
+    /* SESSION IO LOCK, if held, the holder lets the session be checked once finished */
+    if (nc_session_io_lock(session, 0, __func__) != 1) {
+        return 0;
+    }
+
+    /* data, EOF, or an error */
+    r = ssh_channel_poll_timeout(session->ti.libssh.channel, 0, 0);
+
+    /* SESSION IO UNLOCK */
+    nc_session_io_unlock(session, __func__);
+
+    return r != 0;
+#else
+    (void)ps_session;
+    return 0;
+#endif /* NC_ENABLED_SSH_TLS */
+}
+
+/**
+ * @brief Release a claimed session of a pollsession.
+ *
+ * @param[in] ps Pollsession structure.
+ * @param[in] ps_session Claimed session.
+ * @param[in] pending Whether the session should be checked again right away (more data may be buffered),
+ * otherwise it is armed to wait for new data on its fd. A terminated session is never checked again,
+ * it is going to be removed and freed by the caller.
+ */
+static void
+nc_ps_epoll_release(struct nc_pollsession *ps, struct nc_ps_session *ps_session, int pending)
+{
+    struct nc_ps_session *iter;
+
+    /* LOCK */
+    pthread_mutex_lock(&ps->lock);
+
+    ps_session->claimed = 0;
+    if (ps_session->removed) {
+        /* removed from ps by this thread meanwhile */
+        free(ps_session);
+        goto unlock;
+    } else if (ps_session->del_wait) {
+        /* removed from ps, let the removing thread finish */
+        pthread_cond_broadcast(&ps->cond);
+        goto unlock;
+    }
+
+    /* SSH channels sharing the fd, libssh may have read and buffered their data, too, so the fd
+     * would not be signaled for them anymore */
+    for (iter = ps_session->fd_next; iter != ps_session; iter = iter->fd_next) {
+        if (pending || (!iter->claimed && !iter->pending && nc_ps_epoll_ssh_buffered(iter))) {
+            nc_ps_pending_add(ps, iter);
+            nc_ps_epoll_wake(ps);
+        }
+    }
+
+    if ((ps_session->state == NC_PS_STATE_INVALID) || (ps_session->session->status != NC_STATUS_RUNNING)) {
+        /* terminated, must not be claimed by another thread anymore */
+        ps_session->recheck = 0;
+    } else if (pending || ps_session->recheck || ((ps_session->fd_next != ps_session) &&
+            nc_ps_epoll_ssh_buffered(ps_session))) {
+        /* checking the other channels may have buffered some data of this one */
+        ps_session->recheck = 0;
+        nc_ps_pending_add(ps, ps_session);
+        nc_ps_epoll_wake(ps);
+    } else {
+        nc_ps_epoll_arm(ps, ps_session);
+    }
+
+unlock:
+    /* UNLOCK */
+    pthread_mutex_unlock(&ps->lock);
+}
+
+#endif /* HAVE_EPOLL */
+
+void
+nc_ps_epoll_session_written(struct nc_session *session)
+{
+#if defined (HAVE_EPOLL) && defined (NC_ENABLED_SSH_TLS)
+    struct nc_pollsession *ps;
+    struct nc_ps_session *first, *iter;
+    int fd;
+
+    if ((session->side != NC_SERVER) || (session->ti_type != NC_TI_SSH)) {
+        return;
+    }
+
+    ps = ATOMIC_PTR_LOAD_RELAXED(session->opts.server.epoll_ps);
+    if (!ps) {
+        return;
+    }
+
+    /* LOCK */
+    pthread_mutex_lock(&ps->lock);
+
+    /* check the session was not removed meanwhile */
+    fd = nc_ps_epoll_session_fd(session);
+    if ((ATOMIC_PTR_LOAD_RELAXED(session->opts.server.epoll_ps) == ps) && (fd > -1) && (fd < ps->fd_map_size) &&
+            ps->fd_map[fd]) {
+        /* all the SSH channels sharing the fd */
+        first = ps->fd_map[fd];
+        iter = first;
+        do {
+            nc_ps_pending_add(ps, iter);
+            iter = iter->fd_next;
+        } while (iter != first);
+        nc_ps_epoll_wake(ps);
+    }
+
+    /* UNLOCK */
+    pthread_mutex_unlock(&ps->lock);
+#else
+    (void)session;
+#endif /* HAVE_EPOLL && NC_ENABLED_SSH_TLS */
+}
+
 API int
 nc_ps_add_session(struct nc_pollsession *ps, struct nc_session *session)
 {
@@ -1213,6 +2050,16 @@ nc_ps_add_session(struct nc_pollsession *ps, struct nc_session *session)
     ps->sessions[ps->session_count - 1]->session = session;
     ps->sessions[ps->session_count - 1]->state = NC_PS_STATE_NONE;
 
+#ifdef HAVE_EPOLL
+    if ((ps->epoll_fd > -1) && nc_ps_epoll_add(ps, ps->sessions[ps->session_count - 1])) {
+        free(ps->sessions[ps->session_count - 1]);
+        --ps->session_count;
+        /* UNLOCK */
+        nc_ps_unlock(ps, q_id, __func__);
+        return -1;
+    }
+#endif
+
     /* UNLOCK */
     return nc_ps_unlock(ps, q_id, __func__);
 }
@@ -1229,6 +2076,12 @@ _nc_ps_del_session(struct nc_pollsession *ps, struct nc_session *session, int in
     for (i = 0; i < ps->session_count; ++i) {
         if (ps->sessions[i]->session == session) {
 remove:
+#ifdef HAVE_EPOLL
+            if ((ps->epoll_fd > -1) && nc_ps_epoll_del(ps, ps->sessions[i])) {
+                /* a thread is working with the session, it frees it once finished */
+                ps->sessions[i] = NULL;
+            }
+#endif
             --ps->session_count;
             if (i <= ps->session_count) {
                 free(ps->sessions[i]);
@@ -1360,14 +2213,16 @@ recv_rpc_check_msgid(struct nc_session *session, const struct lyd_node *envp)
     return NC_MSG_RPC;
 }
 
-/* should be called holding the session RPC lock! IO lock will be acquired as needed
+/* should be called holding the session RPC lock! IO lock will be acquired as needed,
+ * lat_ts is filled with the phase timestamps if set
  * returns: NC_PSPOLL_ERROR,
  *          NC_PSPOLL_TIMEOUT,
  *          NC_PSPOLL_BAD_RPC (| NC_PSPOLL_REPLY_ERROR),
  *          NC_PSPOLL_RPC
  */
 static int
-nc_server_recv_rpc_io(struct nc_session *session, int io_timeout, struct nc_server_rpc **rpc)
+nc_server_recv_rpc_io(struct nc_session *session, int io_timeout, struct nc_rpc_lat_ts *lat_ts,
+        struct nc_server_rpc **rpc)
 {
     struct ly_in *msg;
     struct nc_server_reply *reply = NULL;
@@ -1384,7 +2239,9 @@ nc_server_recv_rpc_io(struct nc_session *session, int io_timeout, struct nc_serv
     *rpc = NULL;
 
     /* get a message */
+    NC_RPC_LAT_TS(lat_ts, start);
     r = nc_read_msg_io(session, io_timeout, &msg, 0);
+    NC_RPC_LAT_TS(lat_ts, read);
     if (r == -2) {
         /* malformed message */
         reply = nc_server_reply_err(nc_err(session->ctx, NC_ERR_MALFORMED_MSG));
@@ -1400,7 +2257,9 @@ nc_server_recv_rpc_io(struct nc_session *session, int io_timeout, struct nc_serv
     NC_CHECK_ERRMEM_GOTO(!*rpc, ret = NC_PSPOLL_ERROR, cleanup);
 
     /* parse the RPC */
-    if (!lyd_parse_op(session->ctx, NULL, msg, LYD_XML, LYD_TYPE_RPC_NETCONF, &(*rpc)->envp, &(*rpc)->rpc)) {
+    r = lyd_parse_op(session->ctx, NULL, msg, LYD_XML, LYD_TYPE_RPC_NETCONF, &(*rpc)->envp, &(*rpc)->rpc);
+    NC_RPC_LAT_TS(lat_ts, parsed);
+    if (!r) {
         /* check message-id */
         if (recv_rpc_check_msgid(session, (*rpc)->envp) == NC_MSG_RPC) {
             /* valid RPC */
@@ -1437,12 +2296,20 @@ cleanup:
                 session->status = NC_STATUS_INVALID;
                 session->term_reason = NC_SESSION_TERM_OTHER;
             }
+        } else {
+            NC_STATS_INC(session, out_rpc_errors);
         }
 
         /* bad RPC and an error reply sent */
         ret = NC_PSPOLL_BAD_RPC | NC_PSPOLL_REPLY_ERROR;
     }
 
+    if (ret == NC_PSPOLL_RPC) {
+        NC_STATS_INC(session, in_rpcs);
+    } else if (ret & NC_PSPOLL_BAD_RPC) {
+        NC_STATS_INC(session, in_bad_rpcs);
+    }
+
     ly_in_free(msg, 1);
     if (ret != NC_PSPOLL_RPC) {
         nc_server_rpc_free(*rpc);
@@ -1457,47 +2324,280 @@ nc_set_global_rpc_clb(nc_rpc_clb clb)
     global_rpc_clb = clb;
 }
 
-API NC_MSG_TYPE
-nc_server_notif_send(struct nc_session *session, struct nc_server_notif *notif, int timeout)
+/**
+ * @brief Queue a printed notification to be written to a session.
+ *
+ * @param[in] session Session with a notification queue.
+ * @param[in] msg Printed notification to queue.
+ * @param[in] timeout Timeout for waiting for space in a full queue with ::NC_NTF_QUEUE_BLOCK policy.
+ * @return NC_MSG_NOTIF on success (also if dropped based on the policy).
+ * @return NC_MSG_WOULDBLOCK if the queue is full.
+ * @return NC_MSG_ERROR on error.
+ */
+static NC_MSG_TYPE
+nc_server_notif_msg_queue(struct nc_session *session, struct nc_server_notif_msg *msg, int timeout)
 {
-    NC_MSG_TYPE ret;
+    struct nc_ntf_queue *queue = session->opts.server.ntf_queue;
+    struct timespec ts_timeout;
+    NC_MSG_TYPE ret = NC_MSG_NOTIF;
+    uint32_t idx;
+    int r = 0;
 
-    /* check parameters */
-    if (!session || (session->side != NC_SERVER) || !nc_session_get_notif_status(session)) {
-        ERRARG(NULL, "session");
-        return NC_MSG_ERROR;
-    } else if (!notif || !notif->ntf || !notif->eventtime) {
-        ERRARG(NULL, "notif");
-        return NC_MSG_ERROR;
+    if (timeout > 0) {
+        nc_timeouttime_get(&ts_timeout, timeout);
     }
 
-    /* we do not need RPC lock for this, IO lock will be acquired properly */
-    ret = nc_write_msg_io(session, timeout, NC_MSG_NOTIF, notif);
-    if (ret != NC_MSG_NOTIF) {
-        ERR(session, "Failed to write notification (%s).", nc_msgtype2str[ret]);
-    }
+    /* QUEUE LOCK */
+    pthread_mutex_lock(&queue->lock);
 
-    return ret;
-}
+    if (queue->count == queue->size) {
+        switch (queue->policy) {
+        case NC_NTF_QUEUE_BLOCK:
+            /* wait for a queued notification to be written */
+            while (!r && (queue->count == queue->size)) {
+                if (!timeout) {
+                    r = ETIMEDOUT;
+                } else if (timeout > 0) {
+                    r = pthread_cond_clockwait(&queue->cond, &queue->lock, COMPAT_CLOCK_ID, &ts_timeout);
+                } else {
+                    r = pthread_cond_wait(&queue->cond, &queue->lock);
+                }
+            }
+            if (r == ETIMEDOUT) {
+                ret = NC_MSG_WOULDBLOCK;
+                goto cleanup;
+            } else if (r) {
+                ERR(session, "Waiting for a notification queue failed (%s).", strerror(r));
+                ret = NC_MSG_ERROR;
+                goto cleanup;
+            }
+            break;
+        case NC_NTF_QUEUE_DROP_OLDEST:
+            if (queue->started && (queue->count == 1)) {
+                /* the only queued notification is being written, drop the new one */
+                WRN(session, "Notification queue full, notification dropped.");
+                ++queue->drop_count;
+                goto cleanup;
+            }
 
-/**
+            if (queue->started) {
+                /* drop the second oldest notification, move the one being written in its place */
+                idx = (queue->first + 1) % queue->size;
+                nc_server_notif_msg_free(queue->msgs[idx]);
+                queue->msgs[idx] = queue->msgs[queue->first];
+            } else {
+                nc_server_notif_msg_free(queue->msgs[queue->first]);
+            }
+            queue->first = (queue->first + 1) % queue->size;
+            --queue->count;
+            ++queue->drop_count;
+            WRN(session, "Notification queue full, the oldest notification dropped.");
+            break;
+        case NC_NTF_QUEUE_TERMINATE:
+            ERR(session, "Notification queue full, terminating the session.");
+            session->status = NC_STATUS_INVALID;
+            session->term_reason = queue->term_reason;
+            ret = NC_MSG_ERROR;
+            goto cleanup;
+        }
+    }
+
+    /* enqueue */
+    queue->msgs[(queue->first + queue->count) % queue->size] = nc_server_notif_msg_ref(msg);
+    ++queue->count;
+
+cleanup:
+    /* QUEUE UNLOCK */
+    pthread_mutex_unlock(&queue->lock);
+    return ret;
+}
+
+/**
+ * @brief Write the queued notifications of a session that can be written without waiting.
+ *
+ * @param[in] session Session with a notification queue.
+ * @return 0 on success (also if the session is busy).
+ * @return -1 on error.
+ */
+static int
+nc_server_notif_queue_write(struct nc_session *session)
+{
+    int r;
+
+    /* SESSION IO LOCK */
+    r = nc_session_io_lock(session, 0, __func__);
+    if (r < 1) {
+        /* someone else is writing to the session */
+        return r;
+    }
+
+    r = nc_write_ntf_queue(session, 0);
+
+    /* SESSION IO UNLOCK */
+    nc_session_io_unlock(session, __func__);
+
+    nc_ps_epoll_session_written(session);
+    return r;
+}
+
+API NC_MSG_TYPE
+nc_server_notif_send(struct nc_session *session, struct nc_server_notif *notif, int timeout)
+{
+    NC_MSG_TYPE ret;
+    struct nc_server_notif_msg *msg;
+
+    /* check parameters */
+    if (!session || (session->side != NC_SERVER) || !nc_session_get_notif_status(session)) {
+        ERRARG(NULL, "session");
+        return NC_MSG_ERROR;
+    } else if (!notif || !notif->ntf || !notif->eventtime) {
+        ERRARG(NULL, "notif");
+        return NC_MSG_ERROR;
+    }
+
+    if (session->opts.server.ntf_queue) {
+        /* the notification is queued printed */
+        msg = nc_server_notif_msg_new(notif);
+        if (!msg) {
+            return NC_MSG_ERROR;
+        }
+        ret = nc_server_notif_msg_send(session, msg, timeout);
+        nc_server_notif_msg_free(msg);
+        return ret;
+    }
+
+    /* we do not need RPC lock for this, IO lock will be acquired properly */
+    ret = nc_write_msg_io(session, timeout, NC_MSG_NOTIF, notif);
+    if (ret != NC_MSG_NOTIF) {
+        ERR(session, "Failed to write notification (%s).", nc_msgtype2str[ret]);
+    } else {
+        NC_STATS_INC(session, out_notifications);
+    }
+
+    return ret;
+}
+
+API NC_MSG_TYPE
+nc_server_notif_msg_send(struct nc_session *session, struct nc_server_notif_msg *msg, int timeout)
+{
+    NC_MSG_TYPE ret;
+
+    /* check parameters */
+    if (!session || (session->side != NC_SERVER) || !nc_session_get_notif_status(session)) {
+        ERRARG(NULL, "session");
+        return NC_MSG_ERROR;
+    } else if (!msg) {
+        ERRARG(NULL, "msg");
+        return NC_MSG_ERROR;
+    }
+
+    if (session->opts.server.ntf_queue) {
+        /* make space in the queue if possible, queue the notification, and write it right away if possible */
+        if (nc_server_notif_queue_write(session)) {
+            ret = NC_MSG_ERROR;
+        } else {
+            ret = nc_server_notif_msg_queue(session, msg, timeout);
+            if ((ret == NC_MSG_NOTIF) && nc_server_notif_queue_write(session)) {
+                ret = NC_MSG_ERROR;
+            }
+        }
+        if ((ret != NC_MSG_NOTIF) && (ret != NC_MSG_WOULDBLOCK)) {
+            ERR(session, "Failed to queue notification (%s).", nc_msgtype2str[ret]);
+        } else if (ret == NC_MSG_NOTIF) {
+            /* counted once queued */
+            NC_STATS_INC(session, out_notifications);
+        }
+        return ret;
+    }
+
+    /* we do not need RPC lock for this, IO lock will be acquired properly */
+    ret = nc_write_notif_msg_io(session, timeout, msg);
+    if (ret != NC_MSG_NOTIF) {
+        ERR(session, "Failed to write notification (%s).", nc_msgtype2str[ret]);
+    } else {
+        NC_STATS_INC(session, out_notifications);
+    }
+
+    return ret;
+}
+
+API int
+nc_server_notif_send_multi(struct nc_session **sessions, uint32_t session_count, const struct nc_server_notif *notif,
+        int timeout, NC_MSG_TYPE *results)
+{
+    struct nc_server_notif_msg *msg;
+    NC_MSG_TYPE r;
+    uint32_t i;
+    int sent = 0;
+
+    NC_CHECK_ARG_RET(NULL, sessions, notif, -1);
+
+    /* print the notification only once */
+    msg = nc_server_notif_msg_new(notif);
+    if (!msg) {
+        return -1;
+    }
+
+    for (i = 0; i < session_count; ++i) {
+        r = nc_server_notif_msg_send(sessions[i], msg, timeout);
+        if (r == NC_MSG_NOTIF) {
+            ++sent;
+        }
+        if (results) {
+            results[i] = r;
+        }
+    }
+
+    nc_server_notif_msg_free(msg);
+    return sent;
+}
+
+/**
+ * @brief Get the schema node of the RPC or action of a received RPC.
+ *
+ * @param[in] rpc Received RPC.
+ * @return RPC or action schema node, NULL if not found.
+ */
+static const struct lysc_node *
+nc_server_rpc_get_op(const struct nc_server_rpc *rpc)
+{
+    struct lyd_node *elem;
+
+    if (rpc->rpc->schema->nodetype == LYS_RPC) {
+        /* RPC */
+        return rpc->rpc->schema;
+    }
+
+    /* action */
+    LYD_TREE_DFS_BEGIN(rpc->rpc, elem) {
+        if (elem->schema->nodetype == LYS_ACTION) {
+            return elem->schema;
+        }
+        LYD_TREE_DFS_END(rpc->rpc, elem);
+    }
+
+    return NULL;
+}
+
+/**
  * @brief Send a reply acquiring IO lock as needed.
  * Session RPC lock must be held!
  *
  * @param[in] session Session to use.
  * @param[in] io_timeout Timeout to use for acquiring IO lock.
  * @param[in] rpc RPC to sent.
+ * @param[in,out] lat_ts Timestamps of the RPC processing phases to fill, NULL if not recorded.
  * @return 0 on success.
  * @return Bitmask of NC_PSPOLL_ERROR (any fatal error) and NC_PSPOLL_REPLY_ERROR (reply failed to be sent).
  * @return NC_PSPOLL_ERROR on other errors.
  */
 static int
-nc_server_send_reply_io(struct nc_session *session, int io_timeout, const struct nc_server_rpc *rpc)
+nc_server_send_reply_io(struct nc_session *session, int io_timeout, const struct nc_server_rpc *rpc,
+        struct nc_rpc_lat_ts *lat_ts)
 {
     nc_rpc_clb clb;
     struct nc_server_reply *reply;
-    const struct lysc_node *rpc_act = NULL;
-    struct lyd_node *elem;
+    const struct lysc_node *rpc_act;
     int ret = 0;
     NC_MSG_TYPE r;
 
@@ -1506,22 +2606,10 @@ nc_server_send_reply_io(struct nc_session *session, int io_timeout, const struct
         return NC_PSPOLL_ERROR;
     }
 
-    if (rpc->rpc->schema->nodetype == LYS_RPC) {
-        /* RPC */
-        rpc_act = rpc->rpc->schema;
-    } else {
-        /* action */
-        LYD_TREE_DFS_BEGIN(rpc->rpc, elem) {
-            if (elem->schema->nodetype == LYS_ACTION) {
-                rpc_act = elem->schema;
-                break;
-            }
-            LYD_TREE_DFS_END(rpc->rpc, elem);
-        }
-        if (!rpc_act) {
-            ERRINT;
-            return NC_PSPOLL_ERROR;
-        }
+    rpc_act = nc_server_rpc_get_op(rpc);
+    if (!rpc_act) {
+        ERRINT;
+        return NC_PSPOLL_ERROR;
     }
 
     if (!rpc_act->priv) {
@@ -1539,9 +2627,14 @@ nc_server_send_reply_io(struct nc_session *session, int io_timeout, const struct
     if (!reply) {
         reply = nc_server_reply_err(nc_err(session->ctx, NC_ERR_OP_FAILED, NC_ERR_TYPE_APP));
     }
+    NC_RPC_LAT_TS(lat_ts, clb);
     r = nc_write_msg_io(session, io_timeout, NC_MSG_REPLY, rpc->envp, reply);
+    NC_RPC_LAT_TS(lat_ts, written);
     if (reply->type == NC_RPL_ERROR) {
         ret |= NC_PSPOLL_REPLY_ERROR;
+        if (r == NC_MSG_REPLY) {
+            NC_STATS_INC(session, out_rpc_errors);
+        }
     }
     nc_server_reply_free(reply);
 
@@ -1601,6 +2694,22 @@ nc_ps_poll_session_io(struct nc_session *session, int io_timeout, time_t now_mon
         return NC_PSPOLL_TIMEOUT;
     }
 
+    if (session->opts.server.ntf_queue && nc_write_ntf_queue(session, 0)) {
+        sprintf(msg, "Failed to write queued notifications");
+        if (session->status == NC_STATUS_RUNNING) {
+            session->status = NC_STATUS_INVALID;
+            session->term_reason = NC_SESSION_TERM_OTHER;
+        }
+        nc_session_io_unlock(session, __func__);
+        return NC_PSPOLL_SESSION_TERM | NC_PSPOLL_SESSION_ERROR;
+    }
+
+    if (session->rbuf.len) {
+        /* some data of a previous read are still buffered */
+        nc_session_io_unlock(session, __func__);
+        return NC_PSPOLL_RPC;
+    }
+
     switch (session->ti_type) {
 #ifdef NC_ENABLED_SSH_TLS
     case NC_TI_SSH:
@@ -1799,22 +2908,211 @@ nc_ps_poll_sess(struct nc_ps_session *ps_session, time_t now_mono)
     return ret;
 }
 
-API int
-nc_ps_poll(struct nc_pollsession *ps, int timeout, struct nc_session **session)
+#ifdef HAVE_EPOLL
+
+/**
+ * @brief Add all the sessions that may need to be terminated without any new data arriving on them
+ * (not running anymore or idle timeout elapsed), have queued notifications, or have some data already
+ * buffered by libssh into the pending list. Performed at most once a second, as a fallback, the buffered
+ * SSH data are checked right after releasing a channel sharing the fd or writing to the session.
+ *
+ * @param[in] ps Pollsession structure.
+ * @param[in] now_mono Current monotonic timestamp.
+ */
+static void
+nc_ps_epoll_sweep(struct nc_pollsession *ps, time_t now_mono)
+{
+    uint16_t i;
+    struct nc_session *session;
+
+    if (ps->last_sweep == now_mono) {
+        return;
+    }
+    ps->last_sweep = now_mono;
+
+    for (i = 0; i < ps->session_count; ++i) {
+        if (ps->sessions[i]->state != NC_PS_STATE_NONE) {
+            continue;
+        }
+
+        session = ps->sessions[i]->session;
+        if ((session->status != NC_STATUS_RUNNING) || (!(session->flags & NC_SESSION_CALLHOME) &&
+                server_opts.idle_timeout && (now_mono >= session->opts.server.last_rpc + (unsigned) server_opts.idle_timeout) &&
+                !nc_session_get_notif_status(session)) || nc_session_ntf_queue_pending(session) ||
+                (!ps->sessions[i]->claimed && !ps->sessions[i]->pending && nc_ps_epoll_ssh_buffered(ps->sessions[i]))) {
+            nc_ps_pending_add(ps, ps->sessions[i]);
+        }
+    }
+}
+
+/**
+ * @brief Poll a claimed session of a pollsession without waiting.
+ *
+ * @param[in] ps Pollsession structure.
+ * @param[in] ps_session Claimed session, released unless NC_PSPOLL_RPC is returned.
+ * @param[in] now_mono Current monotonic timestamp.
+ * @return NC_PSPOLL_RPC if some application data are available, the session is left RPC locked and claimed.
+ * @return Any other return value of nc_ps_poll_sess().
+ */
+static int
+nc_ps_epoll_poll_sess(struct nc_pollsession *ps, struct nc_ps_session *ps_session, time_t now_mono)
+{
+    int r, ret;
+
+    /* SESSION RPC LOCK */
+    r = nc_session_rpc_lock(ps_session->session, 0, __func__);
+    if (r == -1) {
+        nc_ps_epoll_release(ps, ps_session, 1);
+        return NC_PSPOLL_ERROR;
+    } else if (!r) {
+        /* the session is being freed */
+        nc_ps_epoll_release(ps, ps_session, 0);
+        return NC_PSPOLL_TIMEOUT;
+    }
+
+    ret = nc_ps_poll_sess(ps_session, now_mono);
+
+    /* keep RPC lock in this one case */
+    if (ret != NC_PSPOLL_RPC) {
+        /* SESSION RPC UNLOCK */
+        nc_session_rpc_unlock(ps_session->session, NC_SESSION_LOCK_TIMEOUT, __func__);
+
+        /* on an event, more data may be buffered, otherwise wait for new data on the fd */
+        nc_ps_epoll_release(ps, ps_session, ret != NC_PSPOLL_TIMEOUT);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Wait for an event on the sessions of a pollsession using its epoll instance.
+ *
+ * Any number of threads can wait at once, each pending or signaled session is claimed by a single thread.
+ *
+ * @param[in] ps Pollsession structure.
+ * @param[in] timeout Timeout in milliseconds, -1 for infinite.
+ * @param[in] ts_timeout Timeout timestamp, set if @p timeout is not -1.
+ * @param[out] ps_session Session with an event, claimed by this thread if NC_PSPOLL_RPC is returned.
+ * @param[out] session NETCONF session of @p ps_session.
+ * @return NC_PSPOLL_NOSESSIONS if there are no sessions.
+ * @return NC_PSPOLL_TIMEOUT if a timeout elapsed.
+ * @return NC_PSPOLL_ERROR on error.
+ * @return Any other return value of nc_ps_poll_sess() for the session with an event.
+ */
+static int
+nc_ps_epoll_poll(struct nc_pollsession *ps, int timeout, const struct timespec *ts_timeout,
+        struct nc_ps_session **ps_session, struct nc_session **session)
+{
+    struct epoll_event evs[NC_PS_EPOLL_EVENTS];
+    struct nc_ps_session *cur, *first, *iter;
+    struct timespec ts_cur;
+    uint64_t val;
+    int ret, r, i, wait_ms;
+
+    while (1) {
+        nc_timeouttime_get(&ts_cur, 0);
+
+        /* LOCK */
+        pthread_mutex_lock(&ps->lock);
+
+        if (!ps->session_count) {
+            /* UNLOCK */
+            pthread_mutex_unlock(&ps->lock);
+            return NC_PSPOLL_NOSESSIONS;
+        }
+
+        /* claim a session that may have some data buffered or has just been signaled */
+        nc_ps_epoll_sweep(ps, ts_cur.tv_sec);
+        cur = nc_ps_pending_claim(ps);
+
+        /* UNLOCK */
+        pthread_mutex_unlock(&ps->lock);
+
+        if (cur) {
+            *session = cur->session;
+            ret = nc_ps_epoll_poll_sess(ps, cur, ts_cur.tv_sec);
+            if (ret != NC_PSPOLL_TIMEOUT) {
+                *ps_session = cur;
+                return ret;
+            }
+            continue;
+        }
+
+        /* wait for new data, but at most a second so that the sessions are swept regularly */
+        wait_ms = 1000;
+        if (timeout > -1) {
+            r = nc_timeouttime_cur_diff(ts_timeout);
+            if (r < wait_ms) {
+                wait_ms = (r > 0) ? r : 0;
+            }
+        }
+        r = epoll_wait(ps->epoll_fd, evs, NC_PS_EPOLL_EVENTS, wait_ms);
+        if (r == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ERR(NULL, "epoll_wait() failed (%s).", strerror(errno));
+            return NC_PSPOLL_ERROR;
+        }
+
+        if (r) {
+            /* LOCK */
+            pthread_mutex_lock(&ps->lock);
+
+            for (i = 0; i < r; ++i) {
+                if (evs[i].data.fd == ps->wake_fd) {
+                    /* woken up, some sessions are pending */
+                    if (read(ps->wake_fd, &val, sizeof val) == -1) {
+                        ERR(NULL, "Failed to read an eventfd (%s).", strerror(errno));
+                    }
+                    continue;
+                }
+
+                /* new data, check all the sessions using the fd (if not removed meanwhile) */
+                first = ps->fd_map[evs[i].data.fd];
+                if (!first) {
+                    continue;
+                }
+                iter = first;
+                do {
+                    nc_ps_pending_add(ps, iter);
+                    iter = iter->fd_next;
+                } while (iter != first);
+            }
+
+            /* UNLOCK */
+            pthread_mutex_unlock(&ps->lock);
+        } else if ((timeout > -1) && (nc_timeouttime_cur_diff(ts_timeout) < 1)) {
+            /* final timeout */
+            return NC_PSPOLL_TIMEOUT;
+        }
+    }
+}
+
+#endif /* HAVE_EPOLL */
+
+/**
+ * @brief Poll the sessions of a pollsession one-by-one, holding the pollsession lock.
+ *
+ * @param[in] ps Pollsession structure.
+ * @param[in] timeout Timeout in milliseconds, -1 for infinite.
+ * @param[in] ts_timeout Timeout timestamp, set if @p timeout is not -1.
+ * @param[out] ps_session Session with an event, it is left RPC locked if NC_PSPOLL_RPC is returned.
+ * @param[out] session NETCONF session of @p ps_session.
+ * @return NC_PSPOLL_NOSESSIONS if there are no sessions.
+ * @return NC_PSPOLL_TIMEOUT if a timeout elapsed.
+ * @return NC_PSPOLL_ERROR on error.
+ * @return Any other return value of nc_ps_poll_sess() for the session with an event.
+ */
+static int
+nc_ps_poll_all(struct nc_pollsession *ps, int timeout, const struct timespec *ts_timeout,
+        struct nc_ps_session **ps_session, struct nc_session **session)
 {
     int ret = NC_PSPOLL_ERROR, r;
     uint8_t q_id;
     uint16_t i, j;
-    struct timespec ts_timeout, ts_cur;
     struct nc_session *cur_session;
     struct nc_ps_session *cur_ps_session;
-    struct nc_server_rpc *rpc = NULL;
-
-    NC_CHECK_ARG_RET(NULL, ps, NC_PSPOLL_ERROR);
-
-    if (session) {
-        *session = NULL;
-    }
 
     /* PS LOCK */
     if (nc_ps_lock(ps, &q_id, __func__)) {
@@ -1826,12 +3124,6 @@ nc_ps_poll(struct nc_pollsession *ps, int timeout, struct nc_session **session)
         return NC_PSPOLL_NOSESSIONS;
     }
 
-    /* fill timespecs */
-    nc_timeouttime_get(&ts_cur, 0);
-    if (timeout > -1) {
-        nc_timeouttime_get(&ts_timeout, timeout);
-    }
-
     /* poll all the sessions one-by-one */
     do {
         /* loop from i to j once (all sessions) */
@@ -1850,7 +3142,7 @@ nc_ps_poll(struct nc_pollsession *ps, int timeout, struct nc_session **session)
                 ret = NC_PSPOLL_ERROR;
             } else if (r == 1) {
                 /* no one else is currently working with the session, so we can, otherwise skip it */
-                ret = nc_ps_poll_sess(cur_ps_session, ts_timeout.tv_sec);
+                ret = nc_ps_poll_sess(cur_ps_session, ts_timeout->tv_sec);
 
                 /* keep RPC lock in this one case */
                 if (ret != NC_PSPOLL_RPC) {
@@ -1878,37 +3170,229 @@ nc_ps_poll(struct nc_pollsession *ps, int timeout, struct nc_session **session)
         if (ret == NC_PSPOLL_TIMEOUT) {
             usleep(NC_TIMEOUT_STEP);
 
-            if ((timeout > -1) && (nc_timeouttime_cur_diff(&ts_timeout) < 1)) {
+            if ((timeout > -1) && (nc_timeouttime_cur_diff(ts_timeout) < 1)) {
                 /* final timeout */
                 break;
             }
         }
     } while (ret == NC_PSPOLL_TIMEOUT);
 
-    /* do we want to return the session? */
-    switch (ret) {
-    case NC_PSPOLL_RPC:
-    case NC_PSPOLL_SESSION_TERM:
-    case NC_PSPOLL_SESSION_TERM | NC_PSPOLL_SESSION_ERROR:
-#ifdef NC_ENABLED_SSH_TLS
-    case NC_PSPOLL_SSH_CHANNEL:
-    case NC_PSPOLL_SSH_MSG:
-#endif /* NC_ENABLED_SSH_TLS */
-        if (session) {
-            *session = cur_session;
-        }
+    if ((ret != NC_PSPOLL_TIMEOUT) && (ret != NC_PSPOLL_ERROR)) {
+        /* event on a session */
+        *ps_session = cur_ps_session;
+        *session = cur_session;
         ps->last_event_session = i;
-        break;
-    default:
-        break;
     }
 
     /* PS UNLOCK */
     nc_ps_unlock(ps, q_id, __func__);
 
+    return ret;
+}
+
+/**
+ * @brief Get the latency histogram bucket of a duration.
+ *
+ * @param[in] usec Duration in usec.
+ * @return Bucket index.
+ */
+static uint32_t
+nc_rpc_lat_bucket(uint64_t usec)
+{
+    uint32_t msb = 3;
+
+    if (usec < 8) {
+        /* linear buckets */
+        return usec;
+    } else if (usec > UINT32_MAX) {
+        return NC_RPC_LATENCY_BUCKETS - 1;
+    }
+
+    /* 8 linear buckets for every power of 2 */
+    while (usec >> (msb + 1)) {
+        ++msb;
+    }
+    return (msb - 2) * 8 + ((usec >> (msb - 3)) & 7);
+}
+
+/**
+ * @brief Record a duration of an RPC processing phase.
+ *
+ * @param[in] hist Histogram of the phase.
+ * @param[in] from Timestamp of the phase start.
+ * @param[in] to Timestamp of the phase end.
+ */
+static void
+nc_rpc_lat_hist_add(struct nc_rpc_lat_hist *hist, const struct timespec *from, const struct timespec *to)
+{
+    int64_t usec;
+
+    usec = (int64_t)(to->tv_sec - from->tv_sec) * 1000000 + (to->tv_nsec - from->tv_nsec) / 1000;
+    if (usec < 0) {
+        usec = 0;
+    }
+
+    ATOMIC_INC_RELAXED(hist->count);
+    ATOMIC_ADD_RELAXED(hist->sum, usec);
+    ATOMIC_INC_RELAXED(hist->buckets[nc_rpc_lat_bucket(usec)]);
+}
+
+/**
+ * @brief Find the latency histograms of an RPC.
+ *
+ * RPC latency lock is expected to be held.
+ *
+ * @param[in] op RPC or action schema node.
+ * @return Found histograms, NULL if none.
+ */
+static struct nc_rpc_lat *
+nc_server_rpc_lat_find(const struct lysc_node *op)
+{
+    uint16_t i;
+
+    for (i = 0; i < server_opts.rpc_lat.rpc_count; ++i) {
+        if (!strcmp(server_opts.rpc_lat.rpcs[i].name, op->name) &&
+                !strcmp(server_opts.rpc_lat.rpcs[i].module, op->module->name)) {
+            return &server_opts.rpc_lat.rpcs[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Add new latency histograms of an RPC.
+ *
+ * RPC latency lock is expected to be held for writing.
+ *
+ * @param[in] op RPC or action schema node.
+ * @return Added histograms, NULL on error.
+ */
+static struct nc_rpc_lat *
+nc_server_rpc_lat_add(const struct lysc_node *op)
+{
+    struct nc_rpc_lat *rpcs, *lat;
+
+    rpcs = realloc(server_opts.rpc_lat.rpcs, (server_opts.rpc_lat.rpc_count + 1) * sizeof *rpcs);
+    NC_CHECK_ERRMEM_RET(!rpcs, NULL);
+    server_opts.rpc_lat.rpcs = rpcs;
+
+    lat = &rpcs[server_opts.rpc_lat.rpc_count];
+    memset(lat, 0, sizeof *lat);
+    lat->module = strdup(op->module->name);
+    lat->name = strdup(op->name);
+    if (!lat->module || !lat->name) {
+        ERRMEM;
+        free(lat->module);
+        free(lat->name);
+        return NULL;
+    }
+    ++server_opts.rpc_lat.rpc_count;
+
+    return lat;
+}
+
+/**
+ * @brief Record the latencies of a processed RPC.
+ *
+ * @param[in] rpc Processed RPC.
+ * @param[in] lat_ts Timestamps of the RPC processing phases.
+ */
+static void
+nc_server_rpc_lat_record(const struct nc_server_rpc *rpc, const struct nc_rpc_lat_ts *lat_ts)
+{
+    const struct lysc_node *op;
+    struct nc_rpc_lat *lat;
+
+    op = nc_server_rpc_get_op(rpc);
+    if (!op) {
+        return;
+    }
+
+    /* RPC LAT READ LOCK */
+    pthread_rwlock_rdlock(&server_opts.rpc_lat.lock);
+
+    lat = nc_server_rpc_lat_find(op);
+    if (!lat) {
+        /* RPC LAT UNLOCK */
+        pthread_rwlock_unlock(&server_opts.rpc_lat.lock);
+
+        /* RPC LAT WRITE LOCK */
+        pthread_rwlock_wrlock(&server_opts.rpc_lat.lock);
+
+        /* could have been added meanwhile */
+        lat = nc_server_rpc_lat_find(op);
+        if (!lat) {
+            lat = nc_server_rpc_lat_add(op);
+        }
+    }
+
+    if (lat) {
+        nc_rpc_lat_hist_add(&lat->phases[NC_RPC_LAT_READ], &lat_ts->start, &lat_ts->read);
+        nc_rpc_lat_hist_add(&lat->phases[NC_RPC_LAT_PARSE], &lat_ts->read, &lat_ts->parsed);
+        nc_rpc_lat_hist_add(&lat->phases[NC_RPC_LAT_CLB], &lat_ts->parsed, &lat_ts->clb);
+        nc_rpc_lat_hist_add(&lat->phases[NC_RPC_LAT_WRITE], &lat_ts->clb, &lat_ts->written);
+    }
+
+    /* RPC LAT UNLOCK */
+    pthread_rwlock_unlock(&server_opts.rpc_lat.lock);
+}
+
+API int
+nc_ps_poll(struct nc_pollsession *ps, int timeout, struct nc_session **session)
+{
+    int ret;
+    struct timespec ts_timeout, ts_cur;
+    struct nc_session *cur_session = NULL;
+    struct nc_ps_session *cur_ps_session = NULL;
+    struct nc_server_rpc *rpc = NULL;
+    struct nc_rpc_lat_ts lat_ts_buf, *lat_ts;
+
+    NC_CHECK_ARG_RET(NULL, ps, NC_PSPOLL_ERROR);
+
+    if (session) {
+        *session = NULL;
+    }
+
+    /* fill timespecs */
+    nc_timeouttime_get(&ts_cur, 0);
+    if (timeout > -1) {
+        nc_timeouttime_get(&ts_timeout, timeout);
+    }
+
+#ifdef HAVE_EPOLL
+    if (ps->epoll_fd > -1) {
+        /* no queue of threads, each claims its own ready session */
+        ret = nc_ps_epoll_poll(ps, timeout, &ts_timeout, &cur_ps_session, &cur_session);
+    } else
+#endif
+    {
+        ret = nc_ps_poll_all(ps, timeout, &ts_timeout, &cur_ps_session, &cur_session);
+    }
+
+    /* do we want to return the session? */
+    switch (ret) {
+    case NC_PSPOLL_RPC:
+    case NC_PSPOLL_SESSION_TERM:
+    case NC_PSPOLL_SESSION_TERM | NC_PSPOLL_SESSION_ERROR:
+#ifdef NC_ENABLED_SSH_TLS
+    case NC_PSPOLL_SSH_CHANNEL:
+    case NC_PSPOLL_SSH_MSG:
+#endif /* NC_ENABLED_SSH_TLS */
+        if (session) {
+            *session = cur_session;
+        }
+        break;
+    default:
+        break;
+    }
+
     /* we have some data available and the session is RPC locked (but not IO locked) */
     if (ret == NC_PSPOLL_RPC) {
-        ret = nc_server_recv_rpc_io(cur_session, timeout, &rpc);
+        /* the only branch if the latencies are not recorded */
+        lat_ts = ATOMIC_LOAD_RELAXED(server_opts.rpc_lat.enabled) ? &lat_ts_buf : NULL;
+
+        ret = nc_server_recv_rpc_io(cur_session, timeout, lat_ts, &rpc);
         if (ret & (NC_PSPOLL_ERROR | NC_PSPOLL_BAD_RPC)) {
             if (cur_session->status != NC_STATUS_RUNNING) {
                 ret |= NC_PSPOLL_SESSION_TERM | NC_PSPOLL_SESSION_ERROR;
@@ -1920,7 +3404,10 @@ nc_ps_poll(struct nc_pollsession *ps, int timeout, struct nc_session **session)
             cur_session->opts.server.last_rpc = ts_cur.tv_sec;
 
             /* process RPC */
-            ret |= nc_server_send_reply_io(cur_session, timeout, rpc);
+            ret |= nc_server_send_reply_io(cur_session, timeout, rpc, lat_ts);
+            if (lat_ts) {
+                nc_server_rpc_lat_record(rpc, lat_ts);
+            }
             if (cur_session->status != NC_STATUS_RUNNING) {
                 ret |= NC_PSPOLL_SESSION_TERM;
                 if (!(cur_session->term_reason & (NC_SESSION_TERM_CLOSED | NC_SESSION_TERM_KILLED))) {
@@ -1935,6 +3422,13 @@ nc_ps_poll(struct nc_pollsession *ps, int timeout, struct nc_session **session)
 
         /* SESSION RPC UNLOCK */
         nc_session_rpc_unlock(cur_session, NC_SESSION_LOCK_TIMEOUT, __func__);
+
+#ifdef HAVE_EPOLL
+        if (ps->epoll_fd > -1) {
+            /* release the session, more data may be buffered */
+            nc_ps_epoll_release(ps, cur_ps_session, 1);
+        }
+#endif
     }
 
     return ret;
@@ -1959,8 +3453,15 @@ nc_ps_clear(struct nc_pollsession *ps, int all, void (*data_free)(void *))
 
     if (all) {
         for (i = 0; i < ps->session_count; i++) {
-            nc_session_free(ps->sessions[i]->session, data_free);
+            session = ps->sessions[i]->session;
+#ifdef HAVE_EPOLL
+            if ((ps->epoll_fd > -1) && nc_ps_epoll_del(ps, ps->sessions[i])) {
+                /* a thread is working with the session, it frees it once finished */
+                ps->sessions[i] = NULL;
+            }
+#endif
             free(ps->sessions[i]);
+            nc_session_free(session, data_free);
         }
         free(ps->sessions);
         ps->sessions = NULL;
@@ -1987,6 +3488,7 @@ int
 nc_server_set_address_port(struct nc_endpt *endpt, struct nc_bind *bind, const char *address, uint16_t port)
 {
     int sock = -1, set_addr, ret = 0;
+    struct nc_bind reuse_bind = {0};
 
     assert((address && !port) || (!address && port) || (endpt->ti == NC_TI_UNIX));
 
@@ -2004,11 +3506,18 @@ nc_server_set_address_port(struct nc_endpt *endpt, struct nc_bind *bind, const c
 
     /* we have all the information we need to create a listening socket */
     if ((address && port) || (endpt->ti == NC_TI_UNIX)) {
-        /* create new socket, close the old one */
-        if (endpt->ti == NC_TI_UNIX) {
+        if ((endpt->ti != NC_TI_UNIX) && server_opts.reuseport_count) {
+            /* create new SO_REUSEPORT sockets, one for each accepting thread */
+            if (nc_server_bind_listen_reuseport(address, port, server_opts.reuseport_count, &reuse_bind)) {
+                ret = 1;
+                goto cleanup;
+            }
+            sock = reuse_bind.sock;
+        } else if (endpt->ti == NC_TI_UNIX) {
+            /* create new socket */
             sock = nc_sock_listen_unix(endpt->opts.unixsock);
         } else {
-            sock = nc_sock_listen_inet(address, port);
+            sock = nc_sock_listen_inet(address, port, 0);
         }
 
         if (sock == -1) {
@@ -2016,10 +3525,14 @@ nc_server_set_address_port(struct nc_endpt *endpt, struct nc_bind *bind, const c
             goto cleanup;
         }
 
-        if (bind->sock > -1) {
-            close(bind->sock);
-        }
+        /* close the old ones */
+        nc_server_bind_close(bind);
         bind->sock = sock;
+        if (reuse_bind.reuseport) {
+            bind->reuseport = 1;
+            bind->reuse_socks = reuse_bind.reuse_socks;
+            bind->reuse_sock_count = reuse_bind.reuse_sock_count;
+        }
     }
 
     if (sock > -1) {
@@ -2277,76 +3790,83 @@ nc_server_endpt_count(void)
     return server_opts.endpt_count;
 }
 
-API NC_MSG_TYPE
-nc_accept(int timeout, const struct ly_ctx *ctx, struct nc_session **session)
+/**
+ * @brief Create a new server session for an accepted socket.
+ *
+ * Config lock is expected to be held for reading.
+ *
+ * @param[in] ctx Context for the session to use.
+ * @param[in] bind_idx Index of the endpoint the socket was accepted on.
+ * @param[in] sock Accepted socket.
+ * @param[in] host Client host, is always consumed.
+ * @param[in] port Client port.
+ * @return New session, NULL on error.
+ */
+static struct nc_session *
+nc_accept_session_new(const struct ly_ctx *ctx, uint16_t bind_idx, int sock, char *host, uint16_t port)
 {
-    NC_MSG_TYPE msgtype;
-    int sock = -1, ret;
-    char *host = NULL;
-    uint16_t port, bind_idx;
-    struct timespec ts_cur;
-
-    NC_CHECK_ARG_RET(NULL, ctx, session, NC_MSG_ERROR);
-
-    NC_CHECK_SRV_INIT_RET(NC_MSG_ERROR);
-
-    *session = NULL;
-
-    /* init ctx as needed */
-    nc_server_init_cb_ctx(ctx);
-
-    /* CONFIG LOCK */
-    pthread_rwlock_rdlock(&server_opts.config_lock);
+    struct nc_session *session;
 
-    if (!server_opts.endpt_count) {
-        ERR(NULL, "No endpoints to accept sessions on.");
-        msgtype = NC_MSG_ERROR;
-        goto cleanup;
+    /* configure keepalives */
+    if (nc_sock_configure_ka(sock, &server_opts.endpts[bind_idx].ka)) {
+        free(host);
+        return NULL;
     }
 
-    ret = nc_sock_accept_binds(server_opts.binds, server_opts.endpt_count, &server_opts.bind_lock, timeout, &host,
-            &port, &bind_idx, &sock);
-    if (ret < 1) {
-        msgtype = (!ret ? NC_MSG_WOULDBLOCK : NC_MSG_ERROR);
-        goto cleanup;
+    session = nc_new_session(NC_SERVER, 0);
+    if (!session) {
+        ERRMEM;
+        free(host);
+        return NULL;
     }
+    session->status = NC_STATUS_STARTING;
+    session->ctx = (struct ly_ctx *)ctx;
+    session->flags = NC_SESSION_SHAREDCTX;
+    session->host = host;
+    session->port = port;
 
-    /* configure keepalives */
-    if (nc_sock_configure_ka(sock, &server_opts.endpts[bind_idx].ka)) {
-        msgtype = NC_MSG_ERROR;
-        goto cleanup;
-    }
+    return session;
+}
 
-    *session = nc_new_session(NC_SERVER, 0);
-    NC_CHECK_ERRMEM_GOTO(!(*session), msgtype = NC_MSG_ERROR, cleanup);
-    (*session)->status = NC_STATUS_STARTING;
-    (*session)->ctx = (struct ly_ctx *)ctx;
-    (*session)->flags = NC_SESSION_SHAREDCTX;
-    (*session)->host = host;
+/**
+ * @brief Establish the transport of a new server session on an accepted socket.
+ *
+ * Config lock is expected to be held for reading.
+ *
+ * @param[in] ctx Context for the session to use.
+ * @param[in] bind_idx Index of the endpoint the socket was accepted on.
+ * @param[in] sock Accepted socket, is always consumed.
+ * @param[in] host Client host, is always consumed.
+ * @param[in] port Client port.
+ * @param[out] session New session.
+ * @return 1 on success, 0 on timeout, -1 on error.
+ */
+static int
+nc_accept_transport(const struct ly_ctx *ctx, uint16_t bind_idx, int sock, char *host, uint16_t port,
+        struct nc_session **session)
+{
+    int ret;
+
+    *session = nc_accept_session_new(ctx, bind_idx, sock, host, port);
     host = NULL;
-    (*session)->port = port;
+    if (!*session) {
+        ret = -1;
+        goto cleanup;
+    }
 
     /* sock gets assigned to session or closed */
 #ifdef NC_ENABLED_SSH_TLS
     if (server_opts.endpts[bind_idx].ti == NC_TI_SSH) {
         ret = nc_accept_ssh_session(*session, server_opts.endpts[bind_idx].opts.ssh, sock, NC_TRANSPORT_TIMEOUT);
         sock = -1;
-        if (ret < 0) {
-            msgtype = NC_MSG_ERROR;
-            goto cleanup;
-        } else if (!ret) {
-            msgtype = NC_MSG_WOULDBLOCK;
+        if (ret < 1) {
             goto cleanup;
         }
     } else if (server_opts.endpts[bind_idx].ti == NC_TI_TLS) {
         (*session)->data = server_opts.endpts[bind_idx].opts.tls;
         ret = nc_accept_tls_session(*session, server_opts.endpts[bind_idx].opts.tls, sock, NC_TRANSPORT_TIMEOUT);
         sock = -1;
-        if (ret < 0) {
-            msgtype = NC_MSG_ERROR;
-            goto cleanup;
-        } else if (!ret) {
-            msgtype = NC_MSG_WOULDBLOCK;
+        if (ret < 1) {
             goto cleanup;
         }
     } else
@@ -2356,727 +3876,1944 @@ nc_accept(int timeout, const struct ly_ctx *ctx, struct nc_session **session)
         ret = nc_accept_unix_session(*session, sock);
         sock = -1;
         if (ret < 0) {
-            msgtype = NC_MSG_ERROR;
             goto cleanup;
         }
     } else {
         ERRINT;
-        msgtype = NC_MSG_ERROR;
+        ret = -1;
         goto cleanup;
     }
 
     (*session)->data = NULL;
+    return 1;
 
-    /* CONFIG UNLOCK */
-    pthread_rwlock_unlock(&server_opts.config_lock);
+cleanup:
+    free(host);
+    if (sock > -1) {
+        close(sock);
+    }
+    nc_session_free(*session, NULL);
+    *session = NULL;
+    return ret;
+}
 
+/**
+ * @brief Start the NETCONF handshake on a new server session with an established transport.
+ *
+ * @param[in] session New session.
+ * @return NC_MSG_HELLO on success, NC_MSG_WOULDBLOCK on timeout, NC_MSG_ERROR on other errors.
+ */
+static NC_MSG_TYPE
+nc_accept_hello_start(struct nc_session *session)
+{
     /* assign new SID atomically */
-    (*session)->id = ATOMIC_INC_RELAXED(server_opts.new_session_id);
+    session->id = ATOMIC_INC_RELAXED(server_opts.new_session_id);
 
-    /* NETCONF handshake */
-    msgtype = nc_handshake_io(*session);
+    /* send the server <hello> */
+    return nc_server_handshake_start_io(session);
+}
+
+/**
+ * @brief Finish the NETCONF handshake on a new server session, once the client \<hello\> was received.
+ *
+ * @param[in] session New session.
+ * @return NC_MSG_HELLO on success, NC_MSG_BAD_HELLO on client \<hello\> message parsing fail,
+ * NC_MSG_WOULDBLOCK on timeout, NC_MSG_ERROR on other errors.
+ */
+static NC_MSG_TYPE
+nc_accept_hello_finish(struct nc_session *session)
+{
+    NC_MSG_TYPE msgtype;
+    struct timespec ts_cur;
+
+    msgtype = nc_server_handshake_finish_io(session);
     if (msgtype != NC_MSG_HELLO) {
-        nc_session_free(*session, NULL);
-        *session = NULL;
         return msgtype;
     }
 
     nc_timeouttime_get(&ts_cur, 0);
-    (*session)->opts.server.last_rpc = ts_cur.tv_sec;
+    session->opts.server.last_rpc = ts_cur.tv_sec;
     nc_realtime_get(&ts_cur);
-    (*session)->opts.server.session_start = ts_cur;
-    (*session)->status = NC_STATUS_RUNNING;
+    session->opts.server.session_start = ts_cur;
+    session->status = NC_STATUS_RUNNING;
 
     return msgtype;
+}
 
-cleanup:
-    /* CONFIG UNLOCK */
-    pthread_rwlock_unlock(&server_opts.config_lock);
+/**
+ * @brief Perform the NETCONF handshake on a new server session with an established transport.
+ *
+ * @param[in,out] session New session, freed on error.
+ * @return NC_MSG_HELLO on success, NC_MSG_BAD_HELLO on client \<hello\> message parsing fail,
+ * NC_MSG_WOULDBLOCK on timeout, NC_MSG_ERROR on other errors.
+ */
+static NC_MSG_TYPE
+nc_accept_hello(struct nc_session **session)
+{
+    NC_MSG_TYPE msgtype;
 
-    free(host);
-    if (sock > -1) {
-        close(sock);
+    msgtype = nc_accept_hello_start(*session);
+    if (msgtype == NC_MSG_HELLO) {
+        msgtype = nc_accept_hello_finish(*session);
     }
-    nc_session_free(*session, NULL);
-    *session = NULL;
+    if (msgtype != NC_MSG_HELLO) {
+        nc_session_free(*session, NULL);
+        *session = NULL;
+    }
+
     return msgtype;
 }
 
-#ifdef NC_ENABLED_SSH_TLS
-
-API int
-nc_server_ch_is_client(const char *name)
-{
-    uint16_t i;
-    int found = 0;
-
-    if (!name) {
-        return found;
-    }
+API NC_MSG_TYPE
+nc_accept(int timeout, const struct ly_ctx *ctx, struct nc_session **session)
+{
+    NC_MSG_TYPE msgtype;
+    int sock = -1, ret;
+    char *host = NULL;
+    uint16_t port, bind_idx;
 
-    /* READ LOCK */
-    pthread_rwlock_rdlock(&server_opts.ch_client_lock);
+    NC_CHECK_ARG_RET(NULL, ctx, session, NC_MSG_ERROR);
 
-    /* check name uniqueness */
-    for (i = 0; i < server_opts.ch_client_count; ++i) {
-        if (!strcmp(server_opts.ch_clients[i].name, name)) {
-            found = 1;
-            break;
-        }
-    }
+    NC_CHECK_SRV_INIT_RET(NC_MSG_ERROR);
 
-    /* UNLOCK */
-    pthread_rwlock_unlock(&server_opts.ch_client_lock);
+    *session = NULL;
 
-    return found;
-}
+    /* init ctx as needed */
+    nc_server_init_cb_ctx(ctx);
 
-API int
-nc_server_ch_client_is_endpt(const char *client_name, const char *endpt_name)
-{
-    uint16_t i;
-    struct nc_ch_client *client = NULL;
-    int found = 0;
+    /* CONFIG LOCK */
+    pthread_rwlock_rdlock(&server_opts.config_lock);
 
-    if (!client_name || !endpt_name) {
-        return found;
+    if (!server_opts.endpt_count) {
+        ERR(NULL, "No endpoints to accept sessions on.");
+        msgtype = NC_MSG_ERROR;
+        goto cleanup;
     }
 
-    /* READ LOCK */
-    pthread_rwlock_rdlock(&server_opts.ch_client_lock);
-
-    for (i = 0; i < server_opts.ch_client_count; ++i) {
-        if (!strcmp(server_opts.ch_clients[i].name, client_name)) {
-            client = &server_opts.ch_clients[i];
-            break;
-        }
+    if (server_opts.reuseport_count) {
+        /* accept on the own listening socket of this thread */
+        ret = nc_sock_accept_binds_reuseport(server_opts.binds, server_opts.endpt_count, &server_opts.bind_lock,
+                nc_server_reuseport_slot(), timeout, &host, &port, &bind_idx, &sock);
+    } else {
+        ret = nc_sock_accept_binds(server_opts.binds, server_opts.endpt_count, &server_opts.bind_lock, timeout, &host,
+                &port, &bind_idx, &sock);
     }
-
-    if (!client) {
+    if (ret < 1) {
+        msgtype = (!ret ? NC_MSG_WOULDBLOCK : NC_MSG_ERROR);
         goto cleanup;
     }
 
-    for (i = 0; i < client->ch_endpt_count; ++i) {
-        if (!strcmp(client->ch_endpts[i].name, endpt_name)) {
-            found = 1;
-            break;
-        }
+    /* sock and host are consumed */
+    ret = nc_accept_transport(ctx, bind_idx, sock, host, port, session);
+    sock = -1;
+    host = NULL;
+    if (ret < 1) {
+        msgtype = (!ret ? NC_MSG_WOULDBLOCK : NC_MSG_ERROR);
+        goto cleanup;
     }
 
+    /* CONFIG UNLOCK */
+    pthread_rwlock_unlock(&server_opts.config_lock);
+
+    return nc_accept_hello(session);
+
 cleanup:
-    /* UNLOCK */
-    pthread_rwlock_unlock(&server_opts.ch_client_lock);
-    return found;
+    /* CONFIG UNLOCK */
+    pthread_rwlock_unlock(&server_opts.config_lock);
+
+    free(host);
+    if (sock > -1) {
+        close(sock);
+    }
+    return msgtype;
 }
 
 /**
- * @brief Create a connection for an endpoint.
- *
- * Client lock is expected to be held.
+ * @brief Get the next accepted connection from the dispatch queue.
  *
- * @param[in] endpt Endpoint to use.
- * @param[in] acquire_ctx_cb Callback for acquiring the libyang context.
- * @param[in] release_ctx_cb Callback for releasing the libyang context.
- * @param[in] ctx_cb_data Context callbacks data.
- * @param[out] session Created NC session.
- * @return NC_MSG values.
+ * @param[in] wait Whether to wait for a connection if the queue is empty.
+ * @param[out] conn Accepted connection.
+ * @return 0 on success, 1 if the workers are terminating, -1 if the queue is empty and @p wait is not set.
  */
-static NC_MSG_TYPE
-nc_connect_ch_endpt(struct nc_ch_endpt *endpt, nc_server_ch_session_acquire_ctx_cb acquire_ctx_cb,
-        nc_server_ch_session_release_ctx_cb release_ctx_cb, void *ctx_cb_data, struct nc_session **session)
+static int
+nc_accept_dispatch_pop(int wait, struct nc_accept_conn *conn)
 {
-    NC_MSG_TYPE msgtype;
-    const struct ly_ctx *ctx = NULL;
-    int sock, ret;
-    struct timespec ts_cur;
-    char *ip_host;
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    int ret = 0;
 
-    sock = nc_sock_connect(endpt->address, endpt->port, NC_CH_CONNECT_TIMEOUT, &endpt->ka, &endpt->sock_pending, &ip_host);
-    if (sock < 0) {
-        return NC_MSG_ERROR;
+    /* DISPATCH LOCK */
+    pthread_mutex_lock(&disp->lock);
+
+    while (wait && !ATOMIC_LOAD_RELAXED(disp->terminate) && !disp->queue_count) {
+        pthread_cond_wait(&disp->cond, &disp->lock);
     }
 
-    /* acquire context */
-    ctx = acquire_ctx_cb(ctx_cb_data);
-    if (!ctx) {
-        ERR(NULL, "Failed to acquire context for a new Call Home session.");
-        close(sock);
-        free(ip_host);
-        return NC_MSG_ERROR;
+    if (ATOMIC_LOAD_RELAXED(disp->terminate)) {
+        ret = 1;
+    } else if (!disp->queue_count) {
+        ret = -1;
+    } else {
+        *conn = disp->queue[disp->queue_first];
+        disp->queue_first = (disp->queue_first + 1) % NC_ACCEPT_DISPATCH_QUEUE;
+        --disp->queue_count;
+
+        /* there is space in the queue again */
+        pthread_cond_broadcast(&disp->cond);
     }
 
-    /* init ctx as needed */
-    nc_server_init_cb_ctx(ctx);
+    /* DISPATCH UNLOCK */
+    pthread_mutex_unlock(&disp->lock);
 
-    /* create session */
-    *session = nc_new_session(NC_SERVER, 0);
-    NC_CHECK_ERRMEM_GOTO(!(*session), close(sock); free(ip_host); msgtype = NC_MSG_ERROR, fail);
-    (*session)->status = NC_STATUS_STARTING;
-    (*session)->ctx = (struct ly_ctx *)ctx;
-    (*session)->flags = NC_SESSION_SHAREDCTX | NC_SESSION_CALLHOME;
-    (*session)->host = ip_host;
-    (*session)->port = endpt->port;
+    return ret;
+}
 
-    /* sock gets assigned to session or closed */
-    if (endpt->ti == NC_TI_SSH) {
-        ret = nc_accept_ssh_session(*session, endpt->opts.ssh, sock, NC_TRANSPORT_TIMEOUT);
-        (*session)->data = NULL;
+/**
+ * @brief Add an accepted connection into the dispatch queue, waits for space in it.
+ *
+ * @param[in] conn Accepted connection.
+ * @return 0 on success, 1 if the acceptor is terminating.
+ */
+static int
+nc_accept_dispatch_push(const struct nc_accept_conn *conn)
+{
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    int ret = 0;
 
-        if (ret < 0) {
-            msgtype = NC_MSG_ERROR;
-            goto fail;
-        } else if (!ret) {
-            msgtype = NC_MSG_WOULDBLOCK;
-            goto fail;
-        }
-    } else if (endpt->ti == NC_TI_TLS) {
-        (*session)->data = endpt->opts.tls;
-        ret = nc_accept_tls_session(*session, endpt->opts.tls, sock, NC_TRANSPORT_TIMEOUT);
-        (*session)->data = NULL;
+    /* DISPATCH LOCK */
+    pthread_mutex_lock(&disp->lock);
 
-        if (ret < 0) {
-            msgtype = NC_MSG_ERROR;
-            goto fail;
-        } else if (!ret) {
-            msgtype = NC_MSG_WOULDBLOCK;
-            goto fail;
-        }
-    } else {
-        ERRINT;
-        close(sock);
-        msgtype = NC_MSG_ERROR;
-        goto fail;
+    while (!ATOMIC_LOAD_RELAXED(disp->terminate) && (disp->queue_count == NC_ACCEPT_DISPATCH_QUEUE)) {
+        pthread_cond_wait(&disp->cond, &disp->lock);
     }
 
-    /* assign new SID atomically */
-    (*session)->id = ATOMIC_INC_RELAXED(server_opts.new_session_id);
+    if (ATOMIC_LOAD_RELAXED(disp->terminate)) {
+        ret = 1;
+    } else {
+        disp->queue[(disp->queue_first + disp->queue_count) % NC_ACCEPT_DISPATCH_QUEUE] = *conn;
+        ++disp->queue_count;
 
-    /* NETCONF handshake */
-    msgtype = nc_handshake_io(*session);
-    if (msgtype != NC_MSG_HELLO) {
-        goto fail;
+        /* wake up a worker */
+        pthread_cond_broadcast(&disp->cond);
     }
 
-    nc_timeouttime_get(&ts_cur, 0);
-    (*session)->opts.server.last_rpc = ts_cur.tv_sec;
-    nc_realtime_get(&ts_cur);
-    (*session)->opts.server.session_start = ts_cur;
-    (*session)->status = NC_STATUS_RUNNING;
+    /* DISPATCH UNLOCK */
+    pthread_mutex_unlock(&disp->lock);
 
-    return msgtype;
+    return ret;
+}
 
-fail:
-    nc_session_free(*session, NULL);
-    *session = NULL;
-    if (ctx) {
-        release_ctx_cb(ctx_cb_data);
+/**
+ * @brief Free an accepted connection.
+ *
+ * @param[in] conn Accepted connection.
+ */
+static void
+nc_accept_conn_free(struct nc_accept_conn *conn)
+{
+    if (conn->sock > -1) {
+        close(conn->sock);
     }
-    return msgtype;
+    free(conn->host);
+    free(conn->endpt_name);
 }
 
 /**
- * @brief Wait for any event after a NC session was established on a CH client.
+ * @brief Dispatch acceptor thread, accepts new connections and queues them for the handshake workers.
  *
- * @param[in] data CH client thread argument.
- * @param[in] session New NC session. The session is invalid upon being freed (= function exit).
- * @return 0 if session was terminated normally,
- * @return 1 if the CH client was removed,
- * @return -1 on error.
+ * @param[in] arg Unused.
+ * @return NULL.
  */
-static int
-nc_server_ch_client_thread_session_cond_wait(struct nc_ch_client_thread_arg *data, struct nc_session *session)
+static void *
+nc_accept_dispatch_acceptor_thread(void *arg)
 {
-    int rc = 0, r;
-    uint32_t idle_timeout;
-    struct timespec ts;
-    struct nc_ch_client *client;
-
-    /* CH LOCK */
-    pthread_mutex_lock(&session->opts.server.ch_lock);
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    struct nc_accept_conn conn;
+    uint16_t bind_idx;
+    int ret;
 
-    session->flags |= NC_SESSION_CH_THREAD;
+    (void)arg;
 
-    /* give the session to the user */
-    if (data->new_session_cb(data->client_name, session, data->new_session_cb_data)) {
-        /* something is wrong, free the session */
-        session->flags &= ~NC_SESSION_CH_THREAD;
+    while (!ATOMIC_LOAD_RELAXED(disp->terminate)) {
+        memset(&conn, 0, sizeof conn);
 
-        /* CH UNLOCK */
-        pthread_mutex_unlock(&session->opts.server.ch_lock);
+        /* CONFIG LOCK */
+        pthread_rwlock_rdlock(&server_opts.config_lock);
 
-        /* session terminated, free it and release its context */
-        nc_session_free(session, NULL);
-        data->release_ctx_cb(data->ctx_cb_data);
-        return 0;
-    }
+        if (!server_opts.endpt_count) {
+            /* CONFIG UNLOCK */
+            pthread_rwlock_unlock(&server_opts.config_lock);
 
-    do {
-        nc_timeouttime_get(&ts, NC_CH_THREAD_IDLE_TIMEOUT_SLEEP);
+            usleep(NC_ACCEPT_DISPATCH_TIMEOUT * 1000);
+            continue;
+        }
 
-        /* CH COND WAIT */
-        r = pthread_cond_clockwait(&session->opts.server.ch_cond, &session->opts.server.ch_lock, COMPAT_CLOCK_ID, &ts);
-        if (!r) {
-            /* we were woken up, something probably happened */
-            if (session->status != NC_STATUS_RUNNING) {
-                break;
+        if (server_opts.reuseport_count) {
+            /* the only acceptor, poll on all the listening sockets */
+            ret = nc_sock_accept_binds_reuseport(server_opts.binds, server_opts.endpt_count, &server_opts.bind_lock,
+                    -1, NC_ACCEPT_DISPATCH_TIMEOUT, &conn.host, &conn.port, &bind_idx, &conn.sock);
+        } else {
+            ret = nc_sock_accept_binds(server_opts.binds, server_opts.endpt_count, &server_opts.bind_lock,
+                    NC_ACCEPT_DISPATCH_TIMEOUT, &conn.host, &conn.port, &bind_idx, &conn.sock);
+        }
+        if (ret == 1) {
+            /* the endpoint is looked up again by the worker, the configuration may change meanwhile */
+            conn.endpt_name = strdup(server_opts.endpts[bind_idx].name);
+            if (!conn.endpt_name) {
+                ERRMEM;
+                ret = -1;
             }
-        } else if (r != ETIMEDOUT) {
-            ERR(session, "Pthread condition timedwait failed (%s).", strerror(r));
-            rc = -1;
-            break;
         }
 
-        /* check whether the client was not removed */
+        /* CONFIG UNLOCK */
+        pthread_rwlock_unlock(&server_opts.config_lock);
 
-        /* LOCK */
-        client = nc_server_ch_client_lock(data->client_name);
-        if (!client) {
-            /* client was removed, finish thread */
-            VRB(session, "Call Home client \"%s\" removed, but an established session will not be terminated.",
-                    data->client_name);
-            rc = 1;
-            break;
+        if (ret < 1) {
+            nc_accept_conn_free(&conn);
+            if (ret < 0) {
+                /* avoid busy looping on persistent errors */
+                usleep(NC_ACCEPT_DISPATCH_TIMEOUT * 1000);
+            }
+            continue;
         }
 
-        if (client->conn_type == NC_CH_PERIOD) {
-            idle_timeout = client->idle_timeout;
-        } else {
-            idle_timeout = 0;
+        if (nc_accept_dispatch_push(&conn)) {
+            nc_accept_conn_free(&conn);
         }
+    }
 
-        nc_timeouttime_get(&ts, 0);
-        if (!nc_session_get_notif_status(session) && idle_timeout && (ts.tv_sec >= session->opts.server.last_rpc + idle_timeout)) {
-            VRB(session, "Call Home client \"%s\": session idle timeout elapsed.", client->name);
-            session->status = NC_STATUS_INVALID;
-            session->term_reason = NC_SESSION_TERM_TIMEOUT;
-        }
-
-        /* UNLOCK */
-        nc_server_ch_client_unlock(client);
-
-    } while (session->status == NC_STATUS_RUNNING);
+    return NULL;
+}
 
-    /* signal to nc_session_free() that CH thread is terminating */
-    session->flags &= ~NC_SESSION_CH_THREAD;
-    pthread_cond_signal(&session->opts.server.ch_cond);
+/**
+ * @brief Find an endpoint by its name, config lock is expected to be held for reading.
+ *
+ * @param[in] name Name of the endpoint.
+ * @return Index of the endpoint, -1 if not found.
+ */
+static int
+nc_accept_dispatch_endpt_find(const char *name)
+{
+    uint16_t i;
 
-    /* CH UNLOCK */
-    pthread_mutex_unlock(&session->opts.server.ch_lock);
+    for (i = 0; i < server_opts.endpt_count; ++i) {
+        if (!strcmp(server_opts.endpts[i].name, name)) {
+            return i;
+        }
+    }
 
-    return rc;
+    return -1;
 }
 
 /**
- * @brief Waits for some amount of time while reacting to signals about terminating a Call Home thread.
+ * @brief Start establishing a new session on an accepted connection.
  *
- * @param[in] session An established session.
- * @param[in] data Call Home thread's data.
- * @param[in] cond_wait_time Time in seconds to sleep for, after which a reconnect is attempted.
+ * The session is then progressed by ::nc_accept_dispatch_handshake_step() together with the other handshakes
+ * of the worker. Config lock is held only while the endpoint options are being used, never while waiting
+ * for the client.
  *
- * @return 0 if the thread should stop running, 1 if it should continue.
+ * @param[in] conn Accepted connection, is always consumed.
+ * @param[out] hs Started handshake.
+ * @return 1 if a handshake was started, 0 otherwise.
  */
 static int
-nc_server_ch_client_thread_is_running_wait(struct nc_session *session, struct nc_ch_client_thread_arg *data, uint64_t cond_wait_time)
+nc_accept_dispatch_conn(struct nc_accept_conn *conn, struct nc_accept_handshake *hs)
 {
-    struct timespec ts;
-    int ret = 0, thread_running;
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    struct nc_session *session = NULL;
+    NC_TRANSPORT_IMPL ti = NC_TI_NONE;
+    int idx, r = -1;
 
-    /* COND LOCK */
-    pthread_mutex_lock(&data->cond_lock);
-    /* get reconnect timeout in ms */
-    nc_timeouttime_get(&ts, cond_wait_time * 1000);
-    while (!ret && data->thread_running) {
-        ret = pthread_cond_clockwait(&data->cond, &data->cond_lock, COMPAT_CLOCK_ID, &ts);
+    memset(hs, 0, sizeof *hs);
+
+    /* CONFIG LOCK */
+    pthread_rwlock_rdlock(&server_opts.config_lock);
+
+    /* the configuration may have changed since the connection was accepted */
+    idx = nc_accept_dispatch_endpt_find(conn->endpt_name);
+    if (idx == -1) {
+        /* CONFIG UNLOCK */
+        pthread_rwlock_unlock(&server_opts.config_lock);
+
+        VRB(NULL, "Endpoint \"%s\" removed, dropping connection from %s.", conn->endpt_name, conn->host);
+        goto cleanup;
     }
 
-    thread_running = data->thread_running;
-    /* COND UNLOCK */
-    pthread_mutex_unlock(&data->cond_lock);
+    /* host is consumed */
+    ti = server_opts.endpts[idx].ti;
+    session = nc_accept_session_new(disp->ctx, idx, conn->sock, conn->host, conn->port);
+    conn->host = NULL;
+    if (session) {
+        switch (ti) {
+#ifdef NC_ENABLED_SSH_TLS
+        case NC_TI_SSH:
+            /* sock is consumed */
+            r = nc_accept_ssh_session_start(session, server_opts.endpts[idx].opts.ssh, conn->sock, NC_TRANSPORT_TIMEOUT,
+                    &hs->ssh_acc);
+            conn->sock = -1;
+            break;
+        case NC_TI_TLS:
+            /* only the shared TLS configuration is referenced by the session, the endpoint options are looked up
+             * by name when verifying the client, sock is consumed */
+            r = nc_accept_tls_session_start(session, server_opts.endpts[idx].opts.tls, conn->endpt_name, conn->sock,
+                    NC_TRANSPORT_TIMEOUT, &hs->tls_acc);
+            conn->sock = -1;
+            break;
+#endif /* NC_ENABLED_SSH_TLS */
+        case NC_TI_UNIX:
+            /* no options are needed */
+            r = 1;
+            break;
+        default:
+            ERRINT;
+            break;
+        }
+    }
 
-    if (!thread_running) {
-        /* thread is terminating */
-        VRB(session, "Call Home thread signaled to exit, client \"%s\" probably removed.", data->client_name);
-        ret = 0;
-    } else if (ret == ETIMEDOUT) {
-        /* time to reconnect */
-        VRB(session, "Call Home client \"%s\" timeout of %" PRIu64 " seconds expired, reconnecting.", data->client_name, cond_wait_time);
-        ret = 1;
-    } else if (ret) {
-        ERR(session, "Pthread condition timedwait failed (%s).", strerror(ret));
-        ret = 0;
+    /* CONFIG UNLOCK */
+    pthread_rwlock_unlock(&server_opts.config_lock);
+
+    if ((r == 1) && (ti == NC_TI_UNIX)) {
+        /* the transport is established right away, sock is consumed */
+        r = nc_accept_unix_session(session, conn->sock);
+        conn->sock = -1;
+    }
+    if (r != 1) {
+        goto cleanup;
     }
 
-    return ret;
+    /* progress the handshake right away */
+    hs->session = session;
+    hs->endpt_name = conn->endpt_name;
+    conn->endpt_name = NULL;
+    nc_timeouttime_get(&hs->ts_check, 0);
+    session = NULL;
+
+cleanup:
+    nc_accept_conn_free(conn);
+    nc_session_free(session, NULL);
+    return (r == 1) ? 1 : 0;
 }
 
 /**
- * @brief Checks if a Call Home thread should terminate.
- *
- * Checks the shared boolean variable thread_running. This should be done everytime
- * before entering a critical section.
+ * @brief Progress establishing the transport of a new session of a worker, never blocks.
  *
- * @param[in] data Call Home thread's data.
- *
- * @return 0 if the thread should stop running, -1 if it can continue.
+ * @param[in] hs Handshake.
+ * @return 1 on success, 2 if waiting for more data, 0 on timeout, -1 on error.
  */
 static int
-nc_server_ch_client_thread_is_running(struct nc_ch_client_thread_arg *data)
+nc_accept_dispatch_transport_step(struct nc_accept_handshake *hs)
 {
-    int ret = -1;
+#ifdef NC_ENABLED_SSH_TLS
+    int idx, ret;
 
-    /* COND LOCK */
-    pthread_mutex_lock(&data->cond_lock);
-    if (!data->thread_running) {
-        /* thread should stop running */
-        ret = 0;
+    switch (hs->session->ti_type) {
+    case NC_TI_SSH:
+        /* CONFIG LOCK */
+        pthread_rwlock_rdlock(&server_opts.config_lock);
+
+        idx = nc_accept_dispatch_endpt_find(hs->endpt_name);
+        if ((idx == -1) || (server_opts.endpts[idx].ti != NC_TI_SSH)) {
+            VRB(hs->session, "Endpoint \"%s\" removed, dropping the new session.", hs->endpt_name);
+            ret = -1;
+        } else {
+            ret = nc_accept_ssh_session_step(hs->session, server_opts.endpts[idx].opts.ssh, &hs->ssh_acc);
+        }
+
+        /* CONFIG UNLOCK */
+        pthread_rwlock_unlock(&server_opts.config_lock);
+        return ret;
+    case NC_TI_TLS:
+        /* config lock is acquired only for verifying the client */
+        return nc_accept_tls_session_step(hs->session, &hs->tls_acc);
+    default:
+        break;
     }
-    /* COND UNLOCK */
-    pthread_mutex_unlock(&data->cond_lock);
+#else
+    (void)hs;
+#endif /* NC_ENABLED_SSH_TLS */
 
-    return ret;
+    /* UNIX socket transport is established once accepted */
+    return 1;
 }
 
 /**
- * @brief Lock CH client structures for reading and lock the specific client if it has some endpoints, wait otherwise.
+ * @brief Progress a handshake of a worker as far as possible with the data received so far, never blocks.
  *
- * @param[in] name Name of the CH client.
- * @return Pointer to the CH client.
+ * Once the transport is established, the server \<hello\> is sent and the client \<hello\> is read only
+ * after it was fully received.
+ *
+ * @param[in] hs Handshake.
+ * @return 1 if still in progress, 0 if finished and @p hs was freed.
  */
-static struct nc_ch_client *
-nc_server_ch_client_with_endpt_lock(const char *name)
+static int
+nc_accept_dispatch_handshake_step(struct nc_accept_handshake *hs)
 {
-    struct nc_ch_client *client;
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    int r;
 
-    while (1) {
-        /* LOCK */
-        client = nc_server_ch_client_lock(name);
-        if (!client) {
-            return NULL;
+    /* step again after a while even if no new data are received */
+    nc_timeouttime_get(&hs->ts_check, NC_ACCEPT_DISPATCH_POLL);
+
+    if (!hs->hello) {
+        r = nc_accept_dispatch_transport_step(hs);
+        if (r == 2) {
+            return 1;
+        } else if (r != 1) {
+            goto fail;
         }
-        if (client->ch_endpt_count) {
-            return client;
+
+        /* transport established, send the server <hello> */
+        if (nc_accept_hello_start(hs->session) != NC_MSG_HELLO) {
+            goto fail;
         }
-        /* no endpoints defined yet */
+        hs->hello = 1;
+        if (server_opts.idle_timeout) {
+            hs->has_timeout = 1;
+            nc_timeouttime_get(&hs->ts_timeout, server_opts.idle_timeout * 1000);
+        }
+    }
 
-        /* UNLOCK */
-        nc_server_ch_client_unlock(client);
+    /* the client <hello> may have been received together with the last transport data */
+    r = nc_read_msg_ready_io(hs->session);
+    if (r < 0) {
+        goto fail;
+    } else if (!r) {
+        if (hs->has_timeout && (nc_timeouttime_cur_diff(&hs->ts_timeout) < 1)) {
+            ERR(hs->session, "Client <hello> timeout elapsed.");
+            goto fail;
+        }
+        return 1;
+    }
 
-        usleep(NC_CH_NO_ENDPT_WAIT * 1000);
+    /* received, it is read without waiting */
+    if (nc_accept_hello_finish(hs->session) != NC_MSG_HELLO) {
+        goto fail;
     }
 
-    return NULL;
+    if (disp->new_session_cb(hs->session, disp->new_session_cb_data)) {
+        nc_session_free(hs->session, NULL);
+    }
+    free(hs->endpt_name);
+    return 0;
+
+fail:
+    nc_session_free(hs->session, NULL);
+    free(hs->endpt_name);
+    return 0;
 }
 
 /**
- * @brief Call Home client management thread.
+ * @brief Get what to poll for to progress a handshake of a worker.
  *
- * @param[in] arg CH client thread argument.
- * @return NULL.
+ * @param[in] hs Handshake.
+ * @param[out] pfd Poll structure to fill.
  */
-static void *
-nc_ch_client_thread(void *arg)
+static void
+nc_accept_dispatch_handshake_pollfd(const struct nc_accept_handshake *hs, struct pollfd *pfd)
 {
-    struct nc_ch_client_thread_arg *data = arg;
-    NC_MSG_TYPE msgtype;
-    uint8_t cur_attempts = 0;
-    uint16_t next_endpt_index, max_wait;
-    char *cur_endpt_name = NULL;
-    struct nc_ch_endpt *cur_endpt;
-    struct nc_session *session = NULL;
-    struct nc_ch_client *client;
-    uint32_t reconnect_in;
-
-    /* LOCK */
-    client = nc_server_ch_client_with_endpt_lock(data->client_name);
-    if (!client) {
-        VRB(NULL, "Call Home client \"%s\" removed.", data->client_name);
-        goto cleanup;
-    }
+    struct nc_session *session = hs->session;
 
-    cur_endpt = &client->ch_endpts[0];
-    cur_endpt_name = strdup(cur_endpt->name);
+    pfd->fd = -1;
+    pfd->events = POLLIN;
+    pfd->revents = 0;
 
-    while (nc_server_ch_client_thread_is_running(data)) {
-        if (!cur_attempts) {
-            VRB(NULL, "Call Home client \"%s\" endpoint \"%s\" connecting...", data->client_name, cur_endpt_name);
+    switch (session->ti_type) {
+#ifdef NC_ENABLED_SSH_TLS
+    case NC_TI_SSH:
+        pfd->fd = ssh_get_fd(session->ti.libssh.session);
+        if (ssh_get_status(session->ti.libssh.session) & SSH_WRITE_PENDING) {
+            /* libssh has output queued, flush it once possible */
+            pfd->events |= POLLOUT;
         }
+        break;
+    case NC_TI_TLS:
+        /* TLS may need to write when reading */
+        pfd->fd = nc_tls_get_fd_wrap(session);
+        if (nc_tls_want_write_wrap(session)) {
+            pfd->events = POLLOUT;
+        }
+        break;
+#endif /* NC_ENABLED_SSH_TLS */
+    case NC_TI_UNIX:
+        pfd->fd = session->ti.unixsock.sock;
+        break;
+    default:
+        break;
+    }
+}
 
-        msgtype = nc_connect_ch_endpt(cur_endpt, data->acquire_ctx_cb, data->release_ctx_cb, data->ctx_cb_data, &session);
-        if (msgtype == NC_MSG_HELLO) {
-            /* UNLOCK */
-            nc_server_ch_client_unlock(client);
-
-            if (!nc_server_ch_client_thread_is_running(data)) {
-                /* thread should stop running */
-                goto cleanup;
+/**
+ * @brief Dispatch handshake worker thread, establishes new sessions on the accepted connections.
+ *
+ * Handshakes are progressed only when new data are received or after a while to check their timeouts,
+ * so a worker establishes several sessions at once and none of them can block the others.
+ *
+ * @param[in] arg Unused.
+ * @return NULL.
+ */
+static void *
+nc_accept_dispatch_worker_thread(void *arg)
+{
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    struct nc_accept_conn conn;
+    struct nc_accept_handshake hs[NC_ACCEPT_DISPATCH_HANDSHAKES];
+    struct pollfd pfds[NC_ACCEPT_DISPATCH_HANDSHAKES];
+    uint32_t i, hs_count = 0;
+    int r, timeout;
+
+    (void)arg;
+
+    /* checked even if no new connections are taken */
+    while (!ATOMIC_LOAD_RELAXED(disp->terminate)) {
+        /* take new connections, wait for one only if there is no handshake in progress */
+        while (hs_count < NC_ACCEPT_DISPATCH_HANDSHAKES) {
+            r = nc_accept_dispatch_pop(!hs_count, &conn);
+            if (r) {
+                /* terminating or no more connections */
+                break;
             }
 
-            /* run while the session is established */
-            VRB(session, "Call Home client \"%s\" session %u established.", data->client_name, session->id);
-            if (nc_server_ch_client_thread_session_cond_wait(data, session)) {
-                goto cleanup;
+            if (nc_accept_dispatch_conn(&conn, &hs[hs_count])) {
+                ++hs_count;
             }
-            session = NULL;
+        }
 
-            VRB(NULL, "Call Home client \"%s\" session terminated.", data->client_name);
-            if (!nc_server_ch_client_thread_is_running(data)) {
-                /* thread should stop running */
-                goto cleanup;
+        if (!hs_count) {
+            continue;
+        }
+
+        /* wait for new data of any of the handshakes, but only until any of them is to be checked */
+        timeout = NC_ACCEPT_DISPATCH_POLL;
+        for (i = 0; i < hs_count; ++i) {
+            nc_accept_dispatch_handshake_pollfd(&hs[i], &pfds[i]);
+            r = nc_timeouttime_cur_diff(&hs[i].ts_check);
+            if (r < timeout) {
+                timeout = (r > 0) ? r : 0;
             }
+        }
+        r = poll(pfds, hs_count, timeout);
+        if ((r == -1) && (errno != EINTR)) {
+            ERR(NULL, "Poll failed (%s).", strerror(errno));
 
-            /* LOCK */
-            client = nc_server_ch_client_with_endpt_lock(data->client_name);
-            if (!client) {
-                VRB(NULL, "Call Home client \"%s\" removed.", data->client_name);
-                goto cleanup;
+            /* avoid busy looping on persistent errors */
+            usleep(timeout * 1000);
+        }
+
+        /* progress the handshakes with new data and all the others whose timeouts are to be checked */
+        for (i = hs_count; i > 0; --i) {
+            if ((pfds[i - 1].revents || (nc_timeouttime_cur_diff(&hs[i - 1].ts_check) < 1)) &&
+                    !nc_accept_dispatch_handshake_step(&hs[i - 1])) {
+                /* finished, move the last handshake in its place */
+                hs[i - 1] = hs[--hs_count];
+                pfds[i - 1] = pfds[hs_count];
             }
+        }
+    }
 
-            /* session changed status -> it was disconnected for whatever reason,
-             * persistent connection immediately tries to reconnect, periodic connects at specific times */
-            if (client->conn_type == NC_CH_PERIOD) {
-                if (client->anchor_time) {
-                    /* anchored */
-                    reconnect_in = (time(NULL) - client->anchor_time) % (client->period * 60);
-                } else {
-                    /* fixed timeout */
-                    reconnect_in = client->period * 60;
-                }
+    /* drop the handshakes in progress */
+    for (i = 0; i < hs_count; ++i) {
+        nc_session_free(hs[i].session, NULL);
+        free(hs[i].endpt_name);
+    }
+    return NULL;
+}
 
-                /* UNLOCK */
-                nc_server_ch_client_unlock(client);
+API int
+nc_server_accept_dispatch(const struct ly_ctx *ctx, uint32_t worker_count, nc_server_accept_new_session_cb new_session_cb,
+        void *user_data)
+{
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    int r, ret = 0;
 
-                /* wait for the timeout to elapse, so we can try to reconnect */
-                VRB(session, "Call Home client \"%s\" reconnecting in %" PRIu32 " seconds.", data->client_name, reconnect_in);
-                if (!nc_server_ch_client_thread_is_running_wait(session, data, reconnect_in)) {
-                    goto cleanup;
-                }
+    NC_CHECK_ARG_RET(NULL, ctx, new_session_cb, -1);
 
-                /* LOCK */
-                client = nc_server_ch_client_with_endpt_lock(data->client_name);
-                assert(client);
-            }
+    NC_CHECK_SRV_INIT_RET(-1);
+
+    /* init ctx as needed */
+    nc_server_init_cb_ctx(ctx);
+
+    if (!worker_count) {
+        worker_count = NC_ACCEPT_DISPATCH_WORKERS;
+    }
+
+    /* DISPATCH LOCK */
+    pthread_mutex_lock(&disp->lock);
+
+    if (disp->running) {
+        ERR(NULL, "Sessions are already being accepted in the background.");
+        ret = -1;
+        goto cleanup;
+    }
+
+    disp->queue = malloc(NC_ACCEPT_DISPATCH_QUEUE * sizeof *disp->queue);
+    NC_CHECK_ERRMEM_GOTO(!disp->queue, ret = -1, cleanup);
+    disp->worker_tids = malloc(worker_count * sizeof *disp->worker_tids);
+    NC_CHECK_ERRMEM_GOTO(!disp->worker_tids, ret = -1, cleanup);
+    disp->queue_first = 0;
+    disp->queue_count = 0;
+    ATOMIC_STORE_RELAXED(disp->terminate, 0);
+    disp->ctx = ctx;
+    disp->new_session_cb = new_session_cb;
+    disp->new_session_cb_data = user_data;
+
+    /* create the threads */
+    for (disp->worker_count = 0; disp->worker_count < worker_count; ++disp->worker_count) {
+        r = pthread_create(&disp->worker_tids[disp->worker_count], NULL, nc_accept_dispatch_worker_thread, NULL);
+        if (r) {
+            ERR(NULL, "Creating a new thread failed (%s).", strerror(r));
+            ret = -1;
+            goto cleanup;
+        }
+    }
+    r = pthread_create(&disp->acceptor_tid, NULL, nc_accept_dispatch_acceptor_thread, NULL);
+    if (r) {
+        ERR(NULL, "Creating a new thread failed (%s).", strerror(r));
+        ret = -1;
+        goto cleanup;
+    }
+    disp->running = 1;
+
+cleanup:
+    if (ret && disp->worker_count) {
+        /* stop the already created workers */
+        ATOMIC_STORE_RELAXED(disp->terminate, 1);
+        pthread_cond_broadcast(&disp->cond);
+        pthread_mutex_unlock(&disp->lock);
+        while (disp->worker_count) {
+            pthread_join(disp->worker_tids[--disp->worker_count], NULL);
+        }
+        pthread_mutex_lock(&disp->lock);
+    }
+    if (ret) {
+        free(disp->queue);
+        disp->queue = NULL;
+        free(disp->worker_tids);
+        disp->worker_tids = NULL;
+    }
+
+    /* DISPATCH UNLOCK */
+    pthread_mutex_unlock(&disp->lock);
+    return ret;
+}
+
+API void
+nc_server_accept_dispatch_stop(void)
+{
+    struct nc_accept_dispatch *disp = &server_opts.accept_dispatch;
+    uint32_t i;
+
+    /* DISPATCH LOCK */
+    pthread_mutex_lock(&disp->lock);
+
+    if (!disp->running) {
+        /* DISPATCH UNLOCK */
+        pthread_mutex_unlock(&disp->lock);
+        return;
+    }
+
+    /* signal the threads to terminate */
+    ATOMIC_STORE_RELAXED(disp->terminate, 1);
+    pthread_cond_broadcast(&disp->cond);
+
+    /* DISPATCH UNLOCK */
+    pthread_mutex_unlock(&disp->lock);
+
+    /* wait for the threads, workers drop their handshakes in progress */
+    pthread_join(disp->acceptor_tid, NULL);
+    for (i = 0; i < disp->worker_count; ++i) {
+        pthread_join(disp->worker_tids[i], NULL);
+    }
+
+    /* DISPATCH LOCK */
+    pthread_mutex_lock(&disp->lock);
+
+    /* drop the connections never handed to a worker */
+    while (disp->queue_count) {
+        nc_accept_conn_free(&disp->queue[disp->queue_first]);
+        disp->queue_first = (disp->queue_first + 1) % NC_ACCEPT_DISPATCH_QUEUE;
+        --disp->queue_count;
+    }
+    free(disp->queue);
+    disp->queue = NULL;
+    free(disp->worker_tids);
+    disp->worker_tids = NULL;
+    disp->worker_count = 0;
+    disp->running = 0;
+
+    /* DISPATCH UNLOCK */
+    pthread_mutex_unlock(&disp->lock);
+}
+
+#ifdef NC_ENABLED_SSH_TLS
+
+API int
+nc_server_ch_is_client(const char *name)
+{
+    uint16_t i;
+    int found = 0;
+
+    if (!name) {
+        return found;
+    }
+
+    /* READ LOCK */
+    pthread_rwlock_rdlock(&server_opts.ch_client_lock);
+
+    /* check name uniqueness */
+    for (i = 0; i < server_opts.ch_client_count; ++i) {
+        if (!strcmp(server_opts.ch_clients[i].name, name)) {
+            found = 1;
+            break;
+        }
+    }
+
+    /* UNLOCK */
+    pthread_rwlock_unlock(&server_opts.ch_client_lock);
+
+    return found;
+}
+
+API int
+nc_server_ch_client_is_endpt(const char *client_name, const char *endpt_name)
+{
+    uint16_t i;
+    struct nc_ch_client *client = NULL;
+    int found = 0;
+
+    if (!client_name || !endpt_name) {
+        return found;
+    }
+
+    /* READ LOCK */
+    pthread_rwlock_rdlock(&server_opts.ch_client_lock);
+
+    for (i = 0; i < server_opts.ch_client_count; ++i) {
+        if (!strcmp(server_opts.ch_clients[i].name, client_name)) {
+            client = &server_opts.ch_clients[i];
+            break;
+        }
+    }
+
+    if (!client) {
+        goto cleanup;
+    }
+
+    for (i = 0; i < client->ch_endpt_count; ++i) {
+        if (!strcmp(client->ch_endpts[i].name, endpt_name)) {
+            found = 1;
+            break;
+        }
+    }
+
+cleanup:
+    /* UNLOCK */
+    pthread_rwlock_unlock(&server_opts.ch_client_lock);
+    return found;
+}
+
+/**
+ * @brief Create a connection for an endpoint.
+ *
+ * Client lock is expected to be held.
+ *
+ * @param[in] endpt Endpoint to use.
+ * @param[in] acquire_ctx_cb Callback for acquiring the libyang context.
+ * @param[in] release_ctx_cb Callback for releasing the libyang context.
+ * @param[in] ctx_cb_data Context callbacks data.
+ * @param[out] session Created NC session.
+ * @return NC_MSG values.
+ */
+static NC_MSG_TYPE
+nc_connect_ch_endpt(struct nc_ch_endpt *endpt, nc_server_ch_session_acquire_ctx_cb acquire_ctx_cb,
+        nc_server_ch_session_release_ctx_cb release_ctx_cb, void *ctx_cb_data, struct nc_session **session)
+{
+    NC_MSG_TYPE msgtype;
+    const struct ly_ctx *ctx = NULL;
+    int sock, ret;
+    struct timespec ts_cur;
+    char *ip_host;
+
+    sock = nc_sock_connect(endpt->address, endpt->port, NC_CH_CONNECT_TIMEOUT, &endpt->ka, &endpt->sock_pending, &ip_host);
+    if (sock < 0) {
+        return NC_MSG_ERROR;
+    }
+
+    /* acquire context */
+    ctx = acquire_ctx_cb(ctx_cb_data);
+    if (!ctx) {
+        ERR(NULL, "Failed to acquire context for a new Call Home session.");
+        close(sock);
+        free(ip_host);
+        return NC_MSG_ERROR;
+    }
+
+    /* init ctx as needed */
+    nc_server_init_cb_ctx(ctx);
+
+    /* create session */
+    *session = nc_new_session(NC_SERVER, 0);
+    NC_CHECK_ERRMEM_GOTO(!(*session), close(sock); free(ip_host); msgtype = NC_MSG_ERROR, fail);
+    (*session)->status = NC_STATUS_STARTING;
+    (*session)->ctx = (struct ly_ctx *)ctx;
+    (*session)->flags = NC_SESSION_SHAREDCTX | NC_SESSION_CALLHOME;
+    (*session)->host = ip_host;
+    (*session)->port = endpt->port;
+
+    /* sock gets assigned to session or closed */
+    if (endpt->ti == NC_TI_SSH) {
+        ret = nc_accept_ssh_session(*session, endpt->opts.ssh, sock, NC_TRANSPORT_TIMEOUT);
+        (*session)->data = NULL;
+
+        if (ret < 0) {
+            msgtype = NC_MSG_ERROR;
+            goto fail;
+        } else if (!ret) {
+            msgtype = NC_MSG_WOULDBLOCK;
+            goto fail;
+        }
+    } else if (endpt->ti == NC_TI_TLS) {
+        (*session)->data = endpt->opts.tls;
+        ret = nc_accept_tls_session(*session, endpt->opts.tls, sock, NC_TRANSPORT_TIMEOUT);
+        (*session)->data = NULL;
+
+        if (ret < 0) {
+            msgtype = NC_MSG_ERROR;
+            goto fail;
+        } else if (!ret) {
+            msgtype = NC_MSG_WOULDBLOCK;
+            goto fail;
+        }
+    } else {
+        ERRINT;
+        close(sock);
+        msgtype = NC_MSG_ERROR;
+        goto fail;
+    }
+
+    /* assign new SID atomically */
+    (*session)->id = ATOMIC_INC_RELAXED(server_opts.new_session_id);
+
+    /* NETCONF handshake */
+    msgtype = nc_handshake_io(*session);
+    if (msgtype != NC_MSG_HELLO) {
+        goto fail;
+    }
+
+    nc_timeouttime_get(&ts_cur, 0);
+    (*session)->opts.server.last_rpc = ts_cur.tv_sec;
+    nc_realtime_get(&ts_cur);
+    (*session)->opts.server.session_start = ts_cur;
+    (*session)->status = NC_STATUS_RUNNING;
+
+    return msgtype;
+
+fail:
+    nc_session_free(*session, NULL);
+    *session = NULL;
+    if (ctx) {
+        release_ctx_cb(ctx_cb_data);
+    }
+    return msgtype;
+}
+
+/**
+ * @brief Wait for any event after a NC session was established on a CH client.
+ *
+ * @param[in] data CH client thread argument.
+ * @param[in] session New NC session. The session is invalid upon being freed (= function exit).
+ * @return 0 if session was terminated normally,
+ * @return 1 if the CH client was removed,
+ * @return -1 on error.
+ */
+static int
+nc_server_ch_client_thread_session_cond_wait(struct nc_ch_client_thread_arg *data, struct nc_session *session)
+{
+    int rc = 0, r;
+    uint32_t idle_timeout;
+    struct timespec ts;
+    struct nc_ch_client *client;
+
+    /* CH LOCK */
+    pthread_mutex_lock(&session->opts.server.ch_lock);
+
+    session->flags |= NC_SESSION_CH_THREAD;
+
+    /* give the session to the user */
+    if (data->new_session_cb(data->client_name, session, data->new_session_cb_data)) {
+        /* something is wrong, free the session */
+        session->flags &= ~NC_SESSION_CH_THREAD;
+
+        /* CH UNLOCK */
+        pthread_mutex_unlock(&session->opts.server.ch_lock);
+
+        /* session terminated, free it and release its context */
+        nc_session_free(session, NULL);
+        data->release_ctx_cb(data->ctx_cb_data);
+        return 0;
+    }
+
+    do {
+        nc_timeouttime_get(&ts, NC_CH_THREAD_IDLE_TIMEOUT_SLEEP);
+
+        /* CH COND WAIT */
+        r = pthread_cond_clockwait(&session->opts.server.ch_cond, &session->opts.server.ch_lock, COMPAT_CLOCK_ID, &ts);
+        if (!r) {
+            /* we were woken up, something probably happened */
+            if (session->status != NC_STATUS_RUNNING) {
+                break;
+            }
+        } else if (r != ETIMEDOUT) {
+            ERR(session, "Pthread condition timedwait failed (%s).", strerror(r));
+            rc = -1;
+            break;
+        }
+
+        /* check whether the client was not removed */
+
+        /* LOCK */
+        client = nc_server_ch_client_lock(data->client_name);
+        if (!client) {
+            /* client was removed, finish thread */
+            VRB(session, "Call Home client \"%s\" removed, but an established session will not be terminated.",
+                    data->client_name);
+            rc = 1;
+            break;
+        }
+
+        if (client->conn_type == NC_CH_PERIOD) {
+            idle_timeout = client->idle_timeout;
+        } else {
+            idle_timeout = 0;
+        }
+
+        nc_timeouttime_get(&ts, 0);
+        if (!nc_session_get_notif_status(session) && idle_timeout && (ts.tv_sec >= session->opts.server.last_rpc + idle_timeout)) {
+            VRB(session, "Call Home client \"%s\": session idle timeout elapsed.", client->name);
+            session->status = NC_STATUS_INVALID;
+            session->term_reason = NC_SESSION_TERM_TIMEOUT;
+        }
+
+        /* UNLOCK */
+        nc_server_ch_client_unlock(client);
+
+    } while (session->status == NC_STATUS_RUNNING);
+
+    /* signal to nc_session_free() that CH thread is terminating */
+    session->flags &= ~NC_SESSION_CH_THREAD;
+    pthread_cond_signal(&session->opts.server.ch_cond);
+
+    /* CH UNLOCK */
+    pthread_mutex_unlock(&session->opts.server.ch_lock);
+
+    return rc;
+}
+
+/**
+ * @brief Waits for some amount of time while reacting to signals about terminating a Call Home thread.
+ *
+ * @param[in] session An established session.
+ * @param[in] data Call Home thread's data.
+ * @param[in] cond_wait_time Time in seconds to sleep for, after which a reconnect is attempted.
+ *
+ * @return 0 if the thread should stop running, 1 if it should continue.
+ */
+static int
+nc_server_ch_client_thread_is_running_wait(struct nc_session *session, struct nc_ch_client_thread_arg *data, uint64_t cond_wait_time)
+{
+    struct timespec ts;
+    int ret = 0, thread_running;
+
+    /* COND LOCK */
+    pthread_mutex_lock(&data->cond_lock);
+    /* get reconnect timeout in ms */
+    nc_timeouttime_get(&ts, cond_wait_time * 1000);
+    while (!ret && data->thread_running) {
+        ret = pthread_cond_clockwait(&data->cond, &data->cond_lock, COMPAT_CLOCK_ID, &ts);
+    }
+
+    thread_running = data->thread_running;
+    /* COND UNLOCK */
+    pthread_mutex_unlock(&data->cond_lock);
+
+    if (!thread_running) {
+        /* thread is terminating */
+        VRB(session, "Call Home thread signaled to exit, client \"%s\" probably removed.", data->client_name);
+        ret = 0;
+    } else if (ret == ETIMEDOUT) {
+        /* time to reconnect */
+        VRB(session, "Call Home client \"%s\" timeout of %" PRIu64 " seconds expired, reconnecting.", data->client_name, cond_wait_time);
+        ret = 1;
+    } else if (ret) {
+        ERR(session, "Pthread condition timedwait failed (%s).", strerror(ret));
+        ret = 0;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Checks if a Call Home thread should terminate.
+ *
+ * Checks the shared boolean variable thread_running. This should be done everytime
+ * before entering a critical section.
+ *
+ * @param[in] data Call Home thread's data.
+ *
+ * @return 0 if the thread should stop running, -1 if it can continue.
+ */
+static int
+nc_server_ch_client_thread_is_running(struct nc_ch_client_thread_arg *data)
+{
+    int ret = -1;
+
+    /* COND LOCK */
+    pthread_mutex_lock(&data->cond_lock);
+    if (!data->thread_running) {
+        /* thread should stop running */
+        ret = 0;
+    }
+    /* COND UNLOCK */
+    pthread_mutex_unlock(&data->cond_lock);
+
+    return ret;
+}
+
+/**
+ * @brief Lock CH client structures for reading and lock the specific client if it has some endpoints, wait otherwise.
+ *
+ * @param[in] name Name of the CH client.
+ * @return Pointer to the CH client.
+ */
+static struct nc_ch_client *
+nc_server_ch_client_with_endpt_lock(const char *name)
+{
+    struct nc_ch_client *client;
+
+    while (1) {
+        /* LOCK */
+        client = nc_server_ch_client_lock(name);
+        if (!client) {
+            return NULL;
+        }
+        if (client->ch_endpt_count) {
+            return client;
+        }
+        /* no endpoints defined yet */
+
+        /* UNLOCK */
+        nc_server_ch_client_unlock(client);
+
+        usleep(NC_CH_NO_ENDPT_WAIT * 1000);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Call Home client management thread.
+ *
+ * @param[in] arg CH client thread argument.
+ * @return NULL.
+ */
+static void *
+nc_ch_client_thread(void *arg)
+{
+    struct nc_ch_client_thread_arg *data = arg;
+    NC_MSG_TYPE msgtype;
+    uint8_t cur_attempts = 0;
+    uint16_t next_endpt_index, max_wait;
+    char *cur_endpt_name = NULL;
+    struct nc_ch_endpt *cur_endpt;
+    struct nc_session *session = NULL;
+    struct nc_ch_client *client;
+    uint32_t reconnect_in;
+
+    /* LOCK */
+    client = nc_server_ch_client_with_endpt_lock(data->client_name);
+    if (!client) {
+        VRB(NULL, "Call Home client \"%s\" removed.", data->client_name);
+        goto cleanup;
+    }
+
+    cur_endpt = &client->ch_endpts[0];
+    cur_endpt_name = strdup(cur_endpt->name);
+
+    while (nc_server_ch_client_thread_is_running(data)) {
+        if (!cur_attempts) {
+            VRB(NULL, "Call Home client \"%s\" endpoint \"%s\" connecting...", data->client_name, cur_endpt_name);
+        }
+
+        msgtype = nc_connect_ch_endpt(cur_endpt, data->acquire_ctx_cb, data->release_ctx_cb, data->ctx_cb_data, &session);
+        if (msgtype == NC_MSG_HELLO) {
+            /* UNLOCK */
+            nc_server_ch_client_unlock(client);
+
+            if (!nc_server_ch_client_thread_is_running(data)) {
+                /* thread should stop running */
+                goto cleanup;
+            }
+
+            /* run while the session is established */
+            VRB(session, "Call Home client \"%s\" session %u established.", data->client_name, session->id);
+            if (nc_server_ch_client_thread_session_cond_wait(data, session)) {
+                goto cleanup;
+            }
+            session = NULL;
+
+            VRB(NULL, "Call Home client \"%s\" session terminated.", data->client_name);
+            if (!nc_server_ch_client_thread_is_running(data)) {
+                /* thread should stop running */
+                goto cleanup;
+            }
+
+            /* LOCK */
+            client = nc_server_ch_client_with_endpt_lock(data->client_name);
+            if (!client) {
+                VRB(NULL, "Call Home client \"%s\" removed.", data->client_name);
+                goto cleanup;
+            }
+
+            /* session changed status -> it was disconnected for whatever reason,
+             * persistent connection immediately tries to reconnect, periodic connects at specific times */
+            if (client->conn_type == NC_CH_PERIOD) {
+                if (client->anchor_time) {
+                    /* anchored */
+                    reconnect_in = (time(NULL) - client->anchor_time) % (client->period * 60);
+                } else {
+                    /* fixed timeout */
+                    reconnect_in = client->period * 60;
+                }
+
+                /* UNLOCK */
+                nc_server_ch_client_unlock(client);
+
+                /* wait for the timeout to elapse, so we can try to reconnect */
+                VRB(session, "Call Home client \"%s\" reconnecting in %" PRIu32 " seconds.", data->client_name, reconnect_in);
+                if (!nc_server_ch_client_thread_is_running_wait(session, data, reconnect_in)) {
+                    goto cleanup;
+                }
+
+                /* LOCK */
+                client = nc_server_ch_client_with_endpt_lock(data->client_name);
+                assert(client);
+            }
 
             /* set next endpoint to try */
             if (client->start_with == NC_CH_FIRST_LISTED) {
                 next_endpt_index = 0;
-            } else if (client->start_with == NC_CH_LAST_CONNECTED) {
-                /* we keep the current one but due to unlock/lock we have to find it again */
-                for (next_endpt_index = 0; next_endpt_index < client->ch_endpt_count; ++next_endpt_index) {
-                    if (!strcmp(client->ch_endpts[next_endpt_index].name, cur_endpt_name)) {
-                        break;
-                    }
+            } else if (client->start_with == NC_CH_LAST_CONNECTED) {
+                /* we keep the current one but due to unlock/lock we have to find it again */
+                for (next_endpt_index = 0; next_endpt_index < client->ch_endpt_count; ++next_endpt_index) {
+                    if (!strcmp(client->ch_endpts[next_endpt_index].name, cur_endpt_name)) {
+                        break;
+                    }
+                }
+                if (next_endpt_index >= client->ch_endpt_count) {
+                    /* endpoint was removed, start with the first one */
+                    next_endpt_index = 0;
+                }
+            } else {
+                /* just get a random index */
+                next_endpt_index = rand() % client->ch_endpt_count;
+            }
+
+        } else {
+            /* session was not created, wait a little bit and try again */
+            max_wait = client->max_wait;
+
+            /* UNLOCK */
+            nc_server_ch_client_unlock(client);
+
+            /* wait for max_wait seconds */
+            if (!nc_server_ch_client_thread_is_running_wait(session, data, max_wait)) {
+                /* thread should stop running */
+                goto cleanup;
+            }
+
+            /* LOCK */
+            client = nc_server_ch_client_with_endpt_lock(data->client_name);
+            assert(client);
+
+            ++cur_attempts;
+
+            /* try to find our endpoint again */
+            for (next_endpt_index = 0; next_endpt_index < client->ch_endpt_count; ++next_endpt_index) {
+                if (!strcmp(client->ch_endpts[next_endpt_index].name, cur_endpt_name)) {
+                    break;
+                }
+            }
+
+            if (next_endpt_index >= client->ch_endpt_count) {
+                /* endpoint was removed, start with the first one */
+                VRB(session, "Call Home client \"%s\" endpoint \"%s\" removed.", data->client_name, cur_endpt_name);
+                next_endpt_index = 0;
+                cur_attempts = 0;
+            } else if (cur_attempts == client->max_attempts) {
+                /* we have tried to connect to this endpoint enough times */
+                VRB(session, "Call Home client \"%s\" endpoint \"%s\" failed connection attempt limit %" PRIu8 " reached.",
+                        data->client_name, cur_endpt_name, client->max_attempts);
+
+                /* clear a pending socket, if any */
+                cur_endpt = &client->ch_endpts[next_endpt_index];
+                if (cur_endpt->sock_pending > -1) {
+                    close(cur_endpt->sock_pending);
+                    cur_endpt->sock_pending = -1;
                 }
-                if (next_endpt_index >= client->ch_endpt_count) {
-                    /* endpoint was removed, start with the first one */
+
+                if (next_endpt_index < client->ch_endpt_count - 1) {
+                    /* just go to the next endpoint */
+                    ++next_endpt_index;
+                } else {
+                    /* cur_endpoint is the last, start with the first one */
                     next_endpt_index = 0;
                 }
-            } else {
-                /* just get a random index */
-                next_endpt_index = rand() % client->ch_endpt_count;
-            }
+                cur_attempts = 0;
+            } /* else we keep the current one */
+        }
 
-        } else {
-            /* session was not created, wait a little bit and try again */
-            max_wait = client->max_wait;
+        cur_endpt = &client->ch_endpts[next_endpt_index];
+        free(cur_endpt_name);
+        cur_endpt_name = strdup(cur_endpt->name);
+    }
 
-            /* UNLOCK */
-            nc_server_ch_client_unlock(client);
+    /* UNLOCK if we break out of the loop */
+    nc_server_ch_client_unlock(client);
 
-            /* wait for max_wait seconds */
-            if (!nc_server_ch_client_thread_is_running_wait(session, data, max_wait)) {
-                /* thread should stop running */
-                goto cleanup;
-            }
+cleanup:
+    VRB(session, "Call Home client \"%s\" thread exit.", data->client_name);
+    free(cur_endpt_name);
+    free(data->client_name);
+    pthread_mutex_lock(&data->cond_lock);
+    pthread_cond_destroy(&data->cond);
+    pthread_mutex_unlock(&data->cond_lock);
+    pthread_mutex_destroy(&data->cond_lock);
+    free(data);
+    return NULL;
+}
+
+API int
+nc_connect_ch_client_dispatch(const char *client_name, nc_server_ch_session_acquire_ctx_cb acquire_ctx_cb,
+        nc_server_ch_session_release_ctx_cb release_ctx_cb, void *ctx_cb_data, nc_server_ch_new_session_cb new_session_cb,
+        void *new_session_cb_data)
+{
+    int rc = 0, r;
+    pthread_t tid;
+    struct nc_ch_client_thread_arg *arg = NULL;
+    struct nc_ch_client *ch_client;
+
+    NC_CHECK_ARG_RET(NULL, client_name, acquire_ctx_cb, release_ctx_cb, new_session_cb, -1);
+
+    NC_CHECK_SRV_INIT_RET(-1);
+
+    /* LOCK */
+    ch_client = nc_server_ch_client_lock(client_name);
+    if (!ch_client) {
+        ERR(NULL, "Client \"%s\" not found.", client_name);
+        return -1;
+    }
+
+    /* create the thread argument */
+    arg = calloc(1, sizeof *arg);
+    NC_CHECK_ERRMEM_GOTO(!arg, rc = -1, cleanup);
+    arg->client_name = strdup(client_name);
+    NC_CHECK_ERRMEM_GOTO(!arg->client_name, rc = -1, cleanup);
+    arg->acquire_ctx_cb = acquire_ctx_cb;
+    arg->release_ctx_cb = release_ctx_cb;
+    arg->ctx_cb_data = ctx_cb_data;
+    arg->new_session_cb = new_session_cb;
+    arg->new_session_cb_data = new_session_cb_data;
+    pthread_cond_init(&arg->cond, NULL);
+    pthread_mutex_init(&arg->cond_lock, NULL);
+
+    /* creating the thread */
+    arg->thread_running = 1;
+    if ((r = pthread_create(&tid, NULL, nc_ch_client_thread, arg))) {
+        ERR(NULL, "Creating a new thread failed (%s).", strerror(r));
+        rc = -1;
+        goto cleanup;
+    }
+
+    /* the thread now manages arg */
+    ch_client->tid = tid;
+    ch_client->thread_data = arg;
+    arg = NULL;
+
+cleanup:
+    /* UNLOCK */
+    nc_server_ch_client_unlock(ch_client);
+
+    if (arg) {
+        free(arg->client_name);
+        free(arg);
+    }
+    return rc;
+}
+
+#endif /* NC_ENABLED_SSH_TLS */
+
+API struct timespec
+nc_session_get_start_time(const struct nc_session *session)
+{
+    struct timespec fail = {0};
+
+    NC_CHECK_ARG_RET(session, session, fail);
+
+    if (session->side != NC_SERVER) {
+        ERRARG(session, "session");
+        return fail;
+    }
+
+    return session->opts.server.session_start;
+}
+
+API void
+nc_session_inc_notif_status(struct nc_session *session)
+{
+    if (!session || (session->side != NC_SERVER)) {
+        ERRARG(session, "session");
+        return;
+    }
+
+    /* NTF STATUS LOCK */
+    pthread_mutex_lock(&session->opts.server.ntf_status_lock);
+
+    ++session->opts.server.ntf_status;
+
+    /* NTF STATUS UNLOCK */
+    pthread_mutex_unlock(&session->opts.server.ntf_status_lock);
+}
+
+API void
+nc_session_dec_notif_status(struct nc_session *session)
+{
+    if (!session || (session->side != NC_SERVER)) {
+        ERRARG(session, "session");
+        return;
+    }
+
+    /* NTF STATUS LOCK */
+    pthread_mutex_lock(&session->opts.server.ntf_status_lock);
+
+    if (session->opts.server.ntf_status) {
+        --session->opts.server.ntf_status;
+    }
+
+    /* NTF STATUS UNLOCK */
+    pthread_mutex_unlock(&session->opts.server.ntf_status_lock);
+}
+
+API int
+nc_session_set_notif_queue(struct nc_session *session, uint32_t size, NC_NTF_QUEUE_POLICY policy,
+        NC_SESSION_TERM_REASON term_reason)
+{
+    struct nc_ntf_queue *queue;
+    struct nc_server_notif_msg **msgs;
+
+    if (!session || (session->side != NC_SERVER)) {
+        ERRARG(session, "session");
+        return -1;
+    }
+
+    queue = session->opts.server.ntf_queue;
+    if (queue && queue->count) {
+        ERR(session, "Notification queue cannot be changed, there are queued notifications.");
+        return -1;
+    }
+
+    if (!size) {
+        /* remove the queue */
+        nc_ntf_queue_free(queue);
+        session->opts.server.ntf_queue = NULL;
+        return 0;
+    }
+
+    msgs = realloc(queue ? queue->msgs : NULL, size * sizeof *msgs);
+    NC_CHECK_ERRMEM_RET(!msgs, -1);
+
+    if (!queue) {
+        queue = calloc(1, sizeof *queue);
+        NC_CHECK_ERRMEM_GOTO(!queue, free(msgs), error);
+        pthread_mutex_init(&queue->lock, NULL);
+        pthread_cond_init(&queue->cond, NULL);
+        session->opts.server.ntf_queue = queue;
+    }
+
+    queue->msgs = msgs;
+    queue->size = size;
+    queue->first = 0;
+    queue->policy = policy;
+    queue->term_reason = term_reason;
+    return 0;
+
+error:
+    return -1;
+}
+
+API int
+nc_session_get_notif_queue_stats(const struct nc_session *session, uint32_t *depth, uint64_t *drops)
+{
+    struct nc_ntf_queue *queue;
+
+    if (!session || (session->side != NC_SERVER)) {
+        ERRARG(session, "session");
+        return -1;
+    }
+
+    queue = session->opts.server.ntf_queue;
+    if (!queue) {
+        return -1;
+    }
+
+    /* QUEUE LOCK */
+    pthread_mutex_lock(&queue->lock);
+
+    if (depth) {
+        *depth = queue->count;
+    }
+    if (drops) {
+        *drops = queue->drop_count;
+    }
+
+    /* QUEUE UNLOCK */
+    pthread_mutex_unlock(&queue->lock);
+
+    return 0;
+}
+
+int
+nc_session_ntf_queue_pending(struct nc_session *session)
+{
+    struct nc_ntf_queue *queue = session->opts.server.ntf_queue;
+    int pending;
+
+    if (!queue) {
+        return 0;
+    }
+
+    /* QUEUE LOCK */
+    pthread_mutex_lock(&queue->lock);
+
+    pending = queue->count ? 1 : 0;
+
+    /* QUEUE UNLOCK */
+    pthread_mutex_unlock(&queue->lock);
+
+    return pending;
+}
+
+void
+nc_ntf_queue_free(struct nc_ntf_queue *queue)
+{
+    uint32_t i;
+
+    if (!queue) {
+        return;
+    }
+
+    for (i = 0; i < queue->count; ++i) {
+        nc_server_notif_msg_free(queue->msgs[(queue->first + i) % queue->size]);
+    }
+    free(queue->msgs);
+    pthread_cond_destroy(&queue->cond);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue);
+}
+
+API int
+nc_session_get_notif_status(const struct nc_session *session)
+{
+    uint32_t ntf_status;
+
+    if (!session || (session->side != NC_SERVER)) {
+        ERRARG(session, "session");
+        return 0;
+    }
+
+    /* NTF STATUS LOCK */
+    pthread_mutex_lock(&((struct nc_session *)session)->opts.server.ntf_status_lock);
+
+    ntf_status = session->opts.server.ntf_status;
+
+    /* NTF STATUS UNLOCK */
+    pthread_mutex_unlock(&((struct nc_session *)session)->opts.server.ntf_status_lock);
+
+    return ntf_status;
+}
+
+/**
+ * @brief Get the values of statistics counters.
+ *
+ * @param[in] counters Counters to read.
+ * @param[out] stats Statistics to fill.
+ */
+static void
+nc_stats_counters_get(const struct nc_stats_counters *counters, struct nc_stats *stats)
+{
+    stats->in_rpcs = ATOMIC_LOAD_RELAXED(counters->in_rpcs);
+    stats->in_bad_rpcs = ATOMIC_LOAD_RELAXED(counters->in_bad_rpcs);
+    stats->out_rpc_errors = ATOMIC_LOAD_RELAXED(counters->out_rpc_errors);
+    stats->out_notifications = ATOMIC_LOAD_RELAXED(counters->out_notifications);
+    stats->in_bytes = ATOMIC_LOAD_RELAXED(counters->in_bytes);
+    stats->out_bytes = ATOMIC_LOAD_RELAXED(counters->out_bytes);
+    stats->in_chunked_msgs = ATOMIC_LOAD_RELAXED(counters->in_chunked_msgs);
+    stats->in_chunked_msg_allocs = ATOMIC_LOAD_RELAXED(counters->in_chunked_msg_allocs);
+}
 
-            /* LOCK */
-            client = nc_server_ch_client_with_endpt_lock(data->client_name);
-            assert(client);
+API void
+nc_server_get_stats(struct nc_stats *stats)
+{
+    if (!stats) {
+        ERRARG(NULL, "stats");
+        return;
+    }
 
-            ++cur_attempts;
+    nc_stats_counters_get(&server_opts.stats.counters, stats);
+    stats->in_sessions = ATOMIC_LOAD_RELAXED(server_opts.stats.in_sessions);
+    stats->in_bad_hellos = ATOMIC_LOAD_RELAXED(server_opts.stats.in_bad_hellos);
+    stats->dropped_sessions = ATOMIC_LOAD_RELAXED(server_opts.stats.dropped_sessions);
+}
 
-            /* try to find our endpoint again */
-            for (next_endpt_index = 0; next_endpt_index < client->ch_endpt_count; ++next_endpt_index) {
-                if (!strcmp(client->ch_endpts[next_endpt_index].name, cur_endpt_name)) {
-                    break;
-                }
-            }
+API int
+nc_session_get_stats(const struct nc_session *session, struct nc_stats *stats)
+{
+    NC_CHECK_ARG_RET(session, session, stats, -1);
 
-            if (next_endpt_index >= client->ch_endpt_count) {
-                /* endpoint was removed, start with the first one */
-                VRB(session, "Call Home client \"%s\" endpoint \"%s\" removed.", data->client_name, cur_endpt_name);
-                next_endpt_index = 0;
-                cur_attempts = 0;
-            } else if (cur_attempts == client->max_attempts) {
-                /* we have tried to connect to this endpoint enough times */
-                VRB(session, "Call Home client \"%s\" endpoint \"%s\" failed connection attempt limit %" PRIu8 " reached.",
-                        data->client_name, cur_endpt_name, client->max_attempts);
+    if (session->side != NC_SERVER) {
+        ERRARG(session, "session");
+        return -1;
+    }
 
-                /* clear a pending socket, if any */
-                cur_endpt = &client->ch_endpts[next_endpt_index];
-                if (cur_endpt->sock_pending > -1) {
-                    close(cur_endpt->sock_pending);
-                    cur_endpt->sock_pending = -1;
-                }
+    memset(stats, 0, sizeof *stats);
+    nc_stats_counters_get(&session->opts.server.stats, stats);
+    return 0;
+}
 
-                if (next_endpt_index < client->ch_endpt_count - 1) {
-                    /* just go to the next endpoint */
-                    ++next_endpt_index;
-                } else {
-                    /* cur_endpoint is the last, start with the first one */
-                    next_endpt_index = 0;
-                }
-                cur_attempts = 0;
-            } /* else we keep the current one */
-        }
+/**
+ * @brief Create the ietf-netconf-monitoring common-counters leaves.
+ *
+ * @param[in] parent Parent node of the leaves.
+ * @param[in] stats Statistics with the counter values.
+ * @return 0 on success, -1 on error.
+ */
+static int
+nc_stats_counters_new(struct lyd_node *parent, const struct nc_stats *stats)
+{
+    const struct lys_module *mod = parent->schema->module;
+    char buf[11];
 
-        cur_endpt = &client->ch_endpts[next_endpt_index];
-        free(cur_endpt_name);
-        cur_endpt_name = strdup(cur_endpt->name);
+    sprintf(buf, "%" PRIu32, stats->in_rpcs);
+    if (lyd_new_term(parent, mod, "in-rpcs", buf, 0, NULL)) {
+        return -1;
+    }
+    sprintf(buf, "%" PRIu32, stats->in_bad_rpcs);
+    if (lyd_new_term(parent, mod, "in-bad-rpcs", buf, 0, NULL)) {
+        return -1;
+    }
+    sprintf(buf, "%" PRIu32, stats->out_rpc_errors);
+    if (lyd_new_term(parent, mod, "out-rpc-errors", buf, 0, NULL)) {
+        return -1;
+    }
+    sprintf(buf, "%" PRIu32, stats->out_notifications);
+    if (lyd_new_term(parent, mod, "out-notifications", buf, 0, NULL)) {
+        return -1;
     }
 
-    /* UNLOCK if we break out of the loop */
-    nc_server_ch_client_unlock(client);
-
-cleanup:
-    VRB(session, "Call Home client \"%s\" thread exit.", data->client_name);
-    free(cur_endpt_name);
-    free(data->client_name);
-    pthread_mutex_lock(&data->cond_lock);
-    pthread_cond_destroy(&data->cond);
-    pthread_mutex_unlock(&data->cond_lock);
-    pthread_mutex_destroy(&data->cond_lock);
-    free(data);
-    return NULL;
+    return 0;
 }
 
 API int
-nc_connect_ch_client_dispatch(const char *client_name, nc_server_ch_session_acquire_ctx_cb acquire_ctx_cb,
-        nc_server_ch_session_release_ctx_cb release_ctx_cb, void *ctx_cb_data, nc_server_ch_new_session_cb new_session_cb,
-        void *new_session_cb_data)
+nc_server_get_stats_data(const struct ly_ctx *ctx, struct lyd_node **data)
 {
-    int rc = 0, r;
-    pthread_t tid;
-    struct nc_ch_client_thread_arg *arg = NULL;
-    struct nc_ch_client *ch_client;
+    const struct lys_module *mod;
+    struct lyd_node *cont;
+    struct nc_stats stats;
+    char buf[11], *start_time = NULL;
+    int ret = -1;
 
-    NC_CHECK_ARG_RET(NULL, client_name, acquire_ctx_cb, release_ctx_cb, new_session_cb, -1);
+    NC_CHECK_ARG_RET(NULL, ctx, data, -1);
 
-    NC_CHECK_SRV_INIT_RET(-1);
+    *data = NULL;
 
-    /* LOCK */
-    ch_client = nc_server_ch_client_lock(client_name);
-    if (!ch_client) {
-        ERR(NULL, "Client \"%s\" not found.", client_name);
+    mod = ly_ctx_get_module_implemented(ctx, "ietf-netconf-monitoring");
+    if (!mod) {
+        ERR(NULL, "Missing \"ietf-netconf-monitoring\" module in the context.");
         return -1;
     }
 
-    /* create the thread argument */
-    arg = calloc(1, sizeof *arg);
-    NC_CHECK_ERRMEM_GOTO(!arg, rc = -1, cleanup);
-    arg->client_name = strdup(client_name);
-    NC_CHECK_ERRMEM_GOTO(!arg->client_name, rc = -1, cleanup);
-    arg->acquire_ctx_cb = acquire_ctx_cb;
-    arg->release_ctx_cb = release_ctx_cb;
-    arg->ctx_cb_data = ctx_cb_data;
-    arg->new_session_cb = new_session_cb;
-    arg->new_session_cb_data = new_session_cb_data;
-    pthread_cond_init(&arg->cond, NULL);
-    pthread_mutex_init(&arg->cond_lock, NULL);
+    nc_server_get_stats(&stats);
 
-    /* creating the thread */
-    arg->thread_running = 1;
-    if ((r = pthread_create(&tid, NULL, nc_ch_client_thread, arg))) {
-        ERR(NULL, "Creating a new thread failed (%s).", strerror(r));
-        rc = -1;
+    if (lyd_new_inner(NULL, mod, "netconf-state", 0, data)) {
+        goto cleanup;
+    }
+    if (lyd_new_inner(*data, mod, "statistics", 0, &cont)) {
         goto cleanup;
     }
 
-    /* the thread now manages arg */
-    ch_client->tid = tid;
-    ch_client->thread_data = arg;
-    arg = NULL;
+    if (ly_time_ts2str(&server_opts.stats.start_time, &start_time)) {
+        goto cleanup;
+    }
+    if (lyd_new_term(cont, mod, "netconf-start-time", start_time, 0, NULL)) {
+        goto cleanup;
+    }
+    sprintf(buf, "%" PRIu32, stats.in_bad_hellos);
+    if (lyd_new_term(cont, mod, "in-bad-hellos", buf, 0, NULL)) {
+        goto cleanup;
+    }
+    sprintf(buf, "%" PRIu32, stats.in_sessions);
+    if (lyd_new_term(cont, mod, "in-sessions", buf, 0, NULL)) {
+        goto cleanup;
+    }
+    sprintf(buf, "%" PRIu32, stats.dropped_sessions);
+    if (lyd_new_term(cont, mod, "dropped-sessions", buf, 0, NULL)) {
+        goto cleanup;
+    }
+    if (nc_stats_counters_new(cont, &stats)) {
+        goto cleanup;
+    }
 
-cleanup:
-    /* UNLOCK */
-    nc_server_ch_client_unlock(ch_client);
+    ret = 0;
 
-    if (arg) {
-        free(arg->client_name);
-        free(arg);
+cleanup:
+    free(start_time);
+    if (ret) {
+        lyd_free_tree(*data);
+        *data = NULL;
     }
-    return rc;
+    return ret;
 }
 
-#endif /* NC_ENABLED_SSH_TLS */
-
-API struct timespec
-nc_session_get_start_time(const struct nc_session *session)
+API int
+nc_session_get_stats_data(const struct nc_session *session, struct lyd_node *parent)
 {
-    struct timespec fail = {0};
+    struct nc_stats stats;
 
-    NC_CHECK_ARG_RET(session, session, fail);
+    NC_CHECK_ARG_RET(session, session, parent, -1);
 
     if (session->side != NC_SERVER) {
         ERRARG(session, "session");
-        return fail;
+        return -1;
+    } else if (!parent->schema || strcmp(parent->schema->module->name, "ietf-netconf-monitoring") ||
+            strcmp(parent->schema->name, "session")) {
+        ERRARG(session, "parent");
+        return -1;
     }
 
-    return session->opts.server.session_start;
+    nc_session_get_stats(session, &stats);
+    return nc_stats_counters_new(parent, &stats);
 }
 
 API void
-nc_session_inc_notif_status(struct nc_session *session)
+nc_server_set_rpc_latency(int enabled)
 {
-    if (!session || (session->side != NC_SERVER)) {
-        ERRARG(session, "session");
-        return;
+    ATOMIC_STORE_RELAXED(server_opts.rpc_lat.enabled, enabled ? 1 : 0);
+}
+
+API void
+nc_server_reset_rpc_latency(void)
+{
+    uint16_t i;
+
+    /* RPC LAT WRITE LOCK */
+    pthread_rwlock_wrlock(&server_opts.rpc_lat.lock);
+
+    for (i = 0; i < server_opts.rpc_lat.rpc_count; ++i) {
+        free(server_opts.rpc_lat.rpcs[i].module);
+        free(server_opts.rpc_lat.rpcs[i].name);
     }
+    free(server_opts.rpc_lat.rpcs);
+    server_opts.rpc_lat.rpcs = NULL;
+    server_opts.rpc_lat.rpc_count = 0;
 
-    /* NTF STATUS LOCK */
-    pthread_mutex_lock(&session->opts.server.ntf_status_lock);
+    /* RPC LAT UNLOCK */
+    pthread_rwlock_unlock(&server_opts.rpc_lat.lock);
+}
 
-    ++session->opts.server.ntf_status;
+API int
+nc_server_get_rpc_latency(struct nc_rpc_latency **latencies, uint32_t *count)
+{
+    struct nc_rpc_lat *lat;
+    struct nc_rpc_latency *dst;
+    uint32_t i, j, k;
+    int ret = 0;
 
-    /* NTF STATUS UNLOCK */
-    pthread_mutex_unlock(&session->opts.server.ntf_status_lock);
+    NC_CHECK_ARG_RET(NULL, latencies, count, -1);
+
+    *latencies = NULL;
+    *count = 0;
+
+    /* RPC LAT READ LOCK */
+    pthread_rwlock_rdlock(&server_opts.rpc_lat.lock);
+
+    if (!server_opts.rpc_lat.rpc_count) {
+        goto cleanup;
+    }
+
+    *latencies = calloc(server_opts.rpc_lat.rpc_count, sizeof **latencies);
+    NC_CHECK_ERRMEM_GOTO(!*latencies, ret = -1, cleanup);
+
+    for (i = 0; i < server_opts.rpc_lat.rpc_count; ++i) {
+        lat = &server_opts.rpc_lat.rpcs[i];
+        dst = &(*latencies)[i];
+
+        dst->module = strdup(lat->module);
+        dst->name = strdup(lat->name);
+        ++*count;
+        NC_CHECK_ERRMEM_GOTO(!dst->module || !dst->name, ret = -1, cleanup);
+
+        for (j = 0; j < NC_RPC_LAT_PHASE_COUNT; ++j) {
+            dst->phases[j].count = ATOMIC_LOAD_RELAXED(lat->phases[j].count);
+            dst->phases[j].sum = ATOMIC_LOAD_RELAXED(lat->phases[j].sum);
+            for (k = 0; k < NC_RPC_LATENCY_BUCKETS; ++k) {
+                dst->phases[j].buckets[k] = ATOMIC_LOAD_RELAXED(lat->phases[j].buckets[k]);
+            }
+        }
+    }
+
+cleanup:
+    /* RPC LAT UNLOCK */
+    pthread_rwlock_unlock(&server_opts.rpc_lat.lock);
+
+    if (ret) {
+        nc_server_rpc_latency_free(*latencies, *count);
+        *latencies = NULL;
+        *count = 0;
+    }
+    return ret;
 }
 
 API void
-nc_session_dec_notif_status(struct nc_session *session)
+nc_server_rpc_latency_free(struct nc_rpc_latency *latencies, uint32_t count)
 {
-    if (!session || (session->side != NC_SERVER)) {
-        ERRARG(session, "session");
+    uint32_t i;
+
+    if (!latencies) {
         return;
     }
 
-    /* NTF STATUS LOCK */
-    pthread_mutex_lock(&session->opts.server.ntf_status_lock);
+    for (i = 0; i < count; ++i) {
+        free(latencies[i].module);
+        free(latencies[i].name);
+    }
+    free(latencies);
+}
 
-    if (session->opts.server.ntf_status) {
-        --session->opts.server.ntf_status;
+API void
+nc_rpc_latency_bucket_range(uint32_t bucket, uint64_t *lower, uint64_t *upper)
+{
+    uint32_t shift;
+    uint64_t low, up;
+
+    if (bucket >= NC_RPC_LATENCY_BUCKETS) {
+        ERRARG(NULL, "bucket");
+        return;
     }
 
-    /* NTF STATUS UNLOCK */
-    pthread_mutex_unlock(&session->opts.server.ntf_status_lock);
+    if (bucket < 8) {
+        /* linear buckets */
+        low = bucket;
+        up = bucket;
+    } else {
+        /* 8 linear buckets for every power of 2 */
+        shift = bucket / 8 - 1;
+        low = (uint64_t)(8 + bucket % 8) << shift;
+        up = ((uint64_t)(9 + bucket % 8) << shift) - 1;
+    }
+    if (bucket == NC_RPC_LATENCY_BUCKETS - 1) {
+        /* includes all the longer durations */
+        up = UINT64_MAX;
+    }
+
+    if (lower) {
+        *lower = low;
+    }
+    if (upper) {
+        *upper = up;
+    }
 }
 
 API int
-nc_session_get_notif_status(const struct nc_session *session)
+nc_server_get_rpc_latency_data(const struct ly_ctx *ctx, struct lyd_node **data)
 {
-    uint32_t ntf_status;
+    const char *phase_names[] = {"read", "parse", "callback", "write"};
+    const struct lys_module *mod;
+    struct nc_rpc_latency *latencies = NULL;
+    struct lyd_node *rpc, *phase, *bucket;
+    uint32_t i, j, k, count = 0;
+    uint64_t lower, upper;
+    char buf[21];
+    int ret = -1;
 
-    if (!session || (session->side != NC_SERVER)) {
-        ERRARG(session, "session");
+    NC_CHECK_ARG_RET(NULL, ctx, data, -1);
+
+    *data = NULL;
+
+    mod = ly_ctx_get_module_implemented(ctx, "libnetconf2-netconf-server");
+    if (!mod) {
+        ERR(NULL, "Missing \"libnetconf2-netconf-server\" module in the context.");
+        return -1;
+    } else if (!lys_find_path(ctx, NULL, "/libnetconf2-netconf-server:rpc-latency", 0)) {
+        ERR(NULL, "Module \"libnetconf2-netconf-server\" in the context does not include the \"rpc-latency\" container.");
+        return -1;
+    }
+
+    if (nc_server_get_rpc_latency(&latencies, &count)) {
+        return -1;
+    }
+    if (!count) {
         return 0;
     }
 
-    /* NTF STATUS LOCK */
-    pthread_mutex_lock(&((struct nc_session *)session)->opts.server.ntf_status_lock);
+    if (lyd_new_inner(NULL, mod, "rpc-latency", 0, data)) {
+        goto cleanup;
+    }
+    for (i = 0; i < count; ++i) {
+        if (lyd_new_list(*data, mod, "rpc", 0, &rpc, latencies[i].module, latencies[i].name)) {
+            goto cleanup;
+        }
 
-    ntf_status = session->opts.server.ntf_status;
+        for (j = 0; j < NC_RPC_LAT_PHASE_COUNT; ++j) {
+            if (lyd_new_list(rpc, mod, "phase", 0, &phase, phase_names[j])) {
+                goto cleanup;
+            }
+            sprintf(buf, "%" PRIu64, latencies[i].phases[j].count);
+            if (lyd_new_term(phase, mod, "count", buf, 0, NULL)) {
+                goto cleanup;
+            }
+            sprintf(buf, "%" PRIu64, latencies[i].phases[j].sum);
+            if (lyd_new_term(phase, mod, "sum", buf, 0, NULL)) {
+                goto cleanup;
+            }
 
-    /* NTF STATUS UNLOCK */
-    pthread_mutex_unlock(&((struct nc_session *)session)->opts.server.ntf_status_lock);
+            for (k = 0; k < NC_RPC_LATENCY_BUCKETS; ++k) {
+                if (!latencies[i].phases[j].buckets[k]) {
+                    /* empty bucket */
+                    continue;
+                }
 
-    return ntf_status;
+                nc_rpc_latency_bucket_range(k, &lower, &upper);
+                sprintf(buf, "%" PRIu64, lower);
+                if (lyd_new_list(phase, mod, "bucket", 0, &bucket, buf)) {
+                    goto cleanup;
+                }
+                sprintf(buf, "%" PRIu64, upper);
+                if (lyd_new_term(bucket, mod, "upper-bound", buf, 0, NULL)) {
+                    goto cleanup;
+                }
+                sprintf(buf, "%" PRIu64, latencies[i].phases[j].buckets[k]);
+                if (lyd_new_term(bucket, mod, "count", buf, 0, NULL)) {
+                    goto cleanup;
+                }
+            }
+        }
+    }
+
+    ret = 0;
+
+cleanup:
+    nc_server_rpc_latency_free(latencies, count);
+    if (ret) {
+        lyd_free_tree(*data);
+        *data = NULL;
+    }
+    return ret;
 }
@@ -109,6 +109,43 @@ struct nc_server_reply *nc_clb_default_get_schema(struct lyd_node *rpc, struct n
  */
 struct nc_server_reply *nc_clb_default_close_session(struct lyd_node *rpc, struct nc_session *session);
 
+/**
+ * @brief Policy applied when a notification is sent to a session with a full notification queue.
+ */
+typedef enum {
+    NC_NTF_QUEUE_BLOCK = 0,     /**< wait for the send timeout until there is space in the queue */
+    NC_NTF_QUEUE_DROP_OLDEST,   /**< drop the oldest queued notification that is not being written */
+    NC_NTF_QUEUE_TERMINATE      /**< terminate the session with the specified termination reason */
+} NC_NTF_QUEUE_POLICY;
+
+/**
+ * @brief Set a bounded queue of notifications for a session.
+ *
+ * Notifications sent to a session with a queue are only queued and written by the thread calling nc_ps_poll()
+ * on the session without waiting for the peer, unless they can be written right away. Hence, a slow
+ * peer never stalls the thread sending the notifications, the full queue @p policy is applied instead.
+ *
+ * Must not be called while notifications are being sent to the session.
+ *
+ * @param[in] session Server session to modify.
+ * @param[in] size Maximum count of queued notifications, 0 to remove the queue.
+ * @param[in] policy Policy applied when the queue is full.
+ * @param[in] term_reason Termination reason of the session used for ::NC_NTF_QUEUE_TERMINATE.
+ * @return 0 on success, -1 on error (such as there are queued notifications).
+ */
+int nc_session_set_notif_queue(struct nc_session *session, uint32_t size, NC_NTF_QUEUE_POLICY policy,
+        NC_SESSION_TERM_REASON term_reason);
+
+/**
+ * @brief Get the statistics of the notification queue of a session.
+ *
+ * @param[in] session Server session to get the information from.
+ * @param[out] depth Optional current count of queued notifications.
+ * @param[out] drops Optional count of notifications dropped because the queue was full.
+ * @return 0 on success, -1 if the session has no notification queue.
+ */
+int nc_session_get_notif_queue_stats(const struct nc_session *session, uint32_t *depth, uint64_t *drops);
+
 /** @} Server Session */
 
 /**
@@ -251,6 +288,20 @@ NC_MSG_TYPE nc_accept_inout(int fdin, int fdout, const char *username, const str
  */
 struct nc_pollsession *nc_ps_new(void);
 
+/**
+ * @brief Create an empty structure for polling sessions using epoll(7).
+ *
+ * File descriptors of the sessions are registered once when they are added and nc_ps_poll()
+ * then waits only for the sessions that actually have some data available instead of checking
+ * all the sessions one-by-one. Also, threads calling nc_ps_poll() do not wait for each other,
+ * each of them claims a different session with some data so any number of threads can work
+ * with the structure at once. Otherwise, it is used exactly as one created by nc_ps_new().
+ * Available only on systems supporting epoll(7).
+ *
+ * @return Empty pollsession structure, NULL on error.
+ */
+struct nc_pollsession *nc_ps_new_epoll(void);
+
 /**
  * @brief Free a pollsession structure.
  *
@@ -430,6 +481,63 @@ void nc_server_del_endpt_unix_socket(const char *endpt_name);
  */
 NC_MSG_TYPE nc_accept(int timeout, const struct ly_ctx *ctx, struct nc_session **session);
 
+/**
+ * @brief Set the number of SO_REUSEPORT listening sockets created for every TCP endpoint.
+ *
+ * Every thread calling ::nc_accept() then accepts connections on its own listening socket without
+ * any locking and the kernel balances the new connections among the sockets. There should be
+ * @p listener_count threads calling ::nc_accept(), the connections queued on the socket of a missing thread
+ * are accepted by the other threads only after a short delay. The acceptor thread of ::nc_server_accept_dispatch()
+ * accepts on all the sockets. UNIX socket endpoints are not affected.
+ *
+ * Only the listening sockets created afterwards are affected so it should be called before
+ * the server configuration is applied.
+ *
+ * @param[in] listener_count Number of listening sockets of an endpoint, 0 to use a single shared
+ * listening socket (default).
+ */
+void nc_server_set_reuseport_listeners(uint16_t listener_count);
+
+/**
+ * @brief Callback for new sessions accepted in the background.
+ *
+ * @param[in] new_session New established session, the pointer is internally discarded afterwards.
+ * @param[in] user_data Arbitrary new session callback data.
+ * @return 0 on success;
+ * @return non-zero on error and @p new_session is freed.
+ */
+typedef int (*nc_server_accept_new_session_cb)(struct nc_session *new_session, void *user_data);
+
+/**
+ * @brief Accept new sessions on all the endpoints in the background.
+ *
+ * Instead of establishing each session in the thread accepting connections as ::nc_accept() does,
+ * an acceptor thread only accepts new connections and queues them for a pool of handshake workers.
+ * The workers establish the transport (SSH/TLS handshake and authentication) and perform the NETCONF
+ * handshake so a slow or malicious client never delays accepting other connections. Sessions are
+ * progressed, including reading the client \<hello\>, only when new data are received so every worker
+ * establishes many of them at once and none of them blocks the others.
+ * Established sessions are passed to @p new_session_cb, which is called by the workers.
+ *
+ * ::nc_accept() should not be called while sessions are accepted in the background.
+ *
+ * @param[in] ctx Context for the sessions to use, see ::nc_accept().
+ * @param[in] worker_count Number of handshake worker threads, 0 for the default.
+ * @param[in] new_session_cb Callback called for every new session.
+ * @param[in] user_data Arbitrary user data passed to @p new_session_cb.
+ * @return 0 on success, -1 on error.
+ */
+int nc_server_accept_dispatch(const struct ly_ctx *ctx, uint32_t worker_count, nc_server_accept_new_session_cb new_session_cb,
+        void *user_data);
+
+/**
+ * @brief Stop accepting new sessions in the background.
+ *
+ * Waits for the workers, which drop the handshakes in progress, connections not yet handed to a worker are closed.
+ * Called by ::nc_server_destroy() as well.
+ */
+void nc_server_accept_dispatch_stop(void);
+
 #ifdef NC_ENABLED_SSH_TLS
 
 /**
@@ -563,6 +671,19 @@ const void *nc_session_get_client_cert(const struct nc_session *session);
  */
 void nc_server_tls_set_verify_clb(int (*verify_clb)(const struct nc_session *session));
 
+/**
+ * @brief Set TLS session resumption of all the TLS endpoints, disabled by default.
+ *
+ * Sessions are resumed from a bounded session cache of each endpoint or from session tickets,
+ * whose keys are rotated after every @p lifetime. Resumed sessions skip the client certificate
+ * verification, the client is authenticated as the same username as in the original session.
+ * Any configuration change drops all the resumable sessions.
+ *
+ * @param[in] cache_size Maximum number of cached sessions of an endpoint, 0 to disable resumption.
+ * @param[in] lifetime Lifetime of resumable sessions in seconds, 0 for the default.
+ */
+void nc_server_tls_set_resumption(uint32_t cache_size, uint32_t lifetime);
+
 /** @} Server TLS */
 
 #endif /* NC_ENABLED_SSH_TLS */
@@ -607,6 +728,166 @@ void nc_session_dec_notif_status(struct nc_session *session);
  */
 int nc_session_get_notif_status(const struct nc_session *session);
 
+/**
+ * @brief NETCONF statistics, the counters of ietf-netconf-monitoring extended with the transferred bytes.
+ *
+ * Counters not tracked per session are always 0 in session statistics.
+ */
+struct nc_stats {
+    /** @brief \<in-sessions\>, number of sessions started (their \<hello\> was sent), global only. */
+    uint32_t in_sessions;
+    /** @brief \<in-bad-hellos\>, number of sessions dropped because of an invalid \<hello\>, global only. */
+    uint32_t in_bad_hellos;
+    /** @brief \<dropped-sessions\>, number of abnormally terminated sessions, global only. */
+    uint32_t dropped_sessions;
+    /** @brief \<in-rpcs\>, number of correct \<rpc\> messages received. */
+    uint32_t in_rpcs;
+    /** @brief \<in-bad-rpcs\>, number of messages received when an \<rpc\> was expected that were not correct. */
+    uint32_t in_bad_rpcs;
+    /** @brief \<out-rpc-errors\>, number of \<rpc-reply\> messages sent with an \<rpc-error\>. */
+    uint32_t out_rpc_errors;
+    /** @brief \<out-notifications\>, number of \<notification\> messages sent (or queued). */
+    uint32_t out_notifications;
+    /** @brief Number of bytes read from the transport. */
+    uint64_t in_bytes;
+    /** @brief Number of bytes written to the transport. */
+    uint64_t out_bytes;
+    /** @brief Number of messages received with the :base:1.1 chunked framing. */
+    uint64_t in_chunked_msgs;
+    /** @brief Number of message buffer (re)allocations needed to assemble the messages counted in @p in_chunked_msgs,
+     * ideally at most a few per message even for messages split into many chunks. */
+    uint64_t in_chunked_msg_allocs;
+};
+
+/**
+ * @brief Get the global NETCONF statistics accumulated from all the sessions since ::nc_server_init().
+ *
+ * The counters are maintained without any locking so the values may be slightly inconsistent
+ * with each other while sessions are active.
+ *
+ * @param[out] stats Filled statistics.
+ */
+void nc_server_get_stats(struct nc_stats *stats);
+
+/**
+ * @brief Get the NETCONF statistics of a server session.
+ *
+ * @param[in] session Session to get the information from.
+ * @param[out] stats Filled statistics.
+ * @return 0 on success, -1 on error.
+ */
+int nc_session_get_stats(const struct nc_session *session, struct nc_stats *stats);
+
+/**
+ * @brief Get the global NETCONF statistics as data.
+ *
+ * Creates the ietf-netconf-monitoring `/netconf-state/statistics` subtree.
+ *
+ * @param[in] ctx Context with ietf-netconf-monitoring implemented.
+ * @param[out] data Created `netconf-state` container with the `statistics` subtree.
+ * @return 0 on success, -1 on error.
+ */
+int nc_server_get_stats_data(const struct ly_ctx *ctx, struct lyd_node **data);
+
+/**
+ * @brief Add the NETCONF statistics of a server session to its ietf-netconf-monitoring `session` list instance.
+ *
+ * Creates the `in-rpcs`, `in-bad-rpcs`, `out-rpc-errors`, and `out-notifications` leaves.
+ *
+ * @param[in] session Session to get the information from.
+ * @param[in] parent `/netconf-state/sessions/session` list instance of @p session.
+ * @return 0 on success, -1 on error.
+ */
+int nc_session_get_stats_data(const struct nc_session *session, struct lyd_node *parent);
+
+/**
+ * @brief Number of buckets of an RPC latency histogram.
+ *
+ * Durations are recorded in microseconds into log-linear buckets, there are 8 linear buckets for every power of 2
+ * so the relative error is at most 12.5 %. Durations longer than 2^32 usec are recorded in the last bucket.
+ */
+#define NC_RPC_LATENCY_BUCKETS 240
+
+/**
+ * @brief Processing phases of an RPC in ::nc_ps_poll() with recorded latencies.
+ */
+typedef enum {
+    NC_RPC_LAT_READ = 0,    /**< reading the RPC message (::nc_read_msg_io()) */
+    NC_RPC_LAT_PARSE,       /**< parsing the RPC message */
+    NC_RPC_LAT_CLB,         /**< RPC callback (::nc_rpc_clb) creating the reply */
+    NC_RPC_LAT_WRITE        /**< printing and writing the reply */
+} NC_RPC_LAT_PHASE;
+
+/**
+ * @brief Number of RPC processing phases, see ::NC_RPC_LAT_PHASE.
+ */
+#define NC_RPC_LAT_PHASE_COUNT 4
+
+/**
+ * @brief Latency histograms of an RPC.
+ */
+struct nc_rpc_latency {
+    char *module;           /**< Module of the RPC. */
+    char *name;             /**< Name of the RPC. */
+    struct {
+        uint64_t count;     /**< Number of recorded durations. */
+        uint64_t sum;       /**< Sum of the recorded durations in usec. */
+        uint64_t buckets[NC_RPC_LATENCY_BUCKETS];   /**< Number of recorded durations in every bucket. */
+    } phases[NC_RPC_LAT_PHASE_COUNT];   /**< Histograms of all the phases, indexed by ::NC_RPC_LAT_PHASE. */
+};
+
+/**
+ * @brief Enable or disable recording RPC latencies.
+ *
+ * Durations of every ::NC_RPC_LAT_PHASE of the RPCs processed by ::nc_ps_poll() are recorded
+ * into histograms of the particular RPC. Recording is disabled by default.
+ *
+ * @param[in] enabled Non-zero to enable recording, 0 to disable it.
+ */
+void nc_server_set_rpc_latency(int enabled);
+
+/**
+ * @brief Discard all the recorded RPC latencies.
+ */
+void nc_server_reset_rpc_latency(void);
+
+/**
+ * @brief Get the recorded RPC latencies.
+ *
+ * @param[out] latencies Copied histograms of all the RPCs, free with ::nc_server_rpc_latency_free().
+ * @param[out] count Count of @p latencies.
+ * @return 0 on success, -1 on error.
+ */
+int nc_server_get_rpc_latency(struct nc_rpc_latency **latencies, uint32_t *count);
+
+/**
+ * @brief Free RPC latencies.
+ *
+ * @param[in] latencies Histograms to free.
+ * @param[in] count Count of @p latencies.
+ */
+void nc_server_rpc_latency_free(struct nc_rpc_latency *latencies, uint32_t count);
+
+/**
+ * @brief Get the range of durations recorded in an RPC latency histogram bucket.
+ *
+ * @param[in] bucket Bucket index.
+ * @param[out] lower Optional lowest duration in usec of the bucket.
+ * @param[out] upper Optional highest duration in usec of the bucket.
+ */
+void nc_rpc_latency_bucket_range(uint32_t bucket, uint64_t *lower, uint64_t *upper);
+
+/**
+ * @brief Get the recorded RPC latencies as data.
+ *
+ * Creates the libnetconf2-netconf-server `/rpc-latency` subtree with the non-empty buckets only.
+ *
+ * @param[in] ctx Context with libnetconf2-netconf-server implemented in a revision with the `rpc-latency` container.
+ * @param[out] data Created `rpc-latency` container, NULL if there are no recorded latencies.
+ * @return 0 on success, -1 on error.
+ */
+int nc_server_get_rpc_latency_data(const struct ly_ctx *ctx, struct lyd_node **data);
+
 /** @} Server Session */
 
 #ifdef __cplusplus
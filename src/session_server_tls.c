@@ -16,6 +16,8 @@
 
 #define _GNU_SOURCE
 
+#include <ctype.h>
+#include <errno.h>
 #include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -136,127 +138,126 @@ nc_base64der_to_privkey(const char *in, const char *key_str)
     return pkey;
 }
 
-static char *
-nc_server_tls_digest_to_hex(const unsigned char *digest, unsigned int digest_len)
-{
-    unsigned int i;
-    char *hex;
-
-    hex = malloc(digest_len * 3);
-    NC_CHECK_ERRMEM_RET(!hex, NULL);
+/**
+ * @brief Lengths of cert-to-name fingerprint digests indexed by their algorithm.
+ */
+static const uint8_t nc_tls_digest_len[NC_TLS_FP_ALG_COUNT + 1] = {0, 16, 20, 28, 32, 48, 64};
 
-    for (i = 0; i < digest_len - 1; ++i) {
-        sprintf(hex + (i * 3), "%02x:", digest[i]);
-    }
-    sprintf(hex + (i * 3), "%02x", digest[i]);
+/**
+ * @brief Certificate from a client certificate chain with its digests, each computed once when needed.
+ */
+struct nc_tls_cert_digests {
+    void *cert;                                                         /**< Certificate. */
+    uint8_t computed;                                                   /**< Bitmask of the computed digests. */
+    unsigned char digest[NC_TLS_FP_ALG_COUNT][NC_TLS_DIGEST_MAX_LEN];   /**< Digests indexed by the algorithm - 1. */
+};
 
-    return hex;
-}
+/**
+ * @brief Matching cert-to-name entry and a certificate.
+ */
+struct nc_ctn_match {
+    uint32_t entry; /**< Index of the cert-to-name entry. */
+    int cert;       /**< Index of the certificate in the chain. */
+};
 
-static char *
-nc_server_tls_md5(void *cert)
+/**
+ * @brief Get a digest of a certificate, compute it if not yet done.
+ *
+ * @param[in] cd Certificate with its digests.
+ * @param[in] alg Fingerprint algorithm of the digest.
+ * @return Digest, NULL on error.
+ */
+static const unsigned char *
+nc_server_tls_cert_digest(struct nc_tls_cert_digests *cd, uint8_t alg)
 {
     int rc;
-    unsigned int buf_len = 16;
-    unsigned char buf[buf_len];
+    unsigned char *buf = cd->digest[alg - 1];
 
-    /* compute MD-5 hash of cert and store it in buf */
-    rc = nc_server_tls_md5_wrap(cert, buf);
-    if (rc) {
-        return NULL;
+    if (cd->computed & (1 << (alg - 1))) {
+        /* already computed */
+        return buf;
     }
 
-    /* convert the hash to hex */
-    return nc_server_tls_digest_to_hex(buf, buf_len);
-}
-
-static char *
-nc_server_tls_sha1(void *cert)
-{
-    int rc;
-    unsigned int buf_len = 20;
-    unsigned char buf[buf_len];
-
-    /* compute SHA-1 hash of cert and store it in buf */
-    rc = nc_server_tls_sha1_wrap(cert, buf);
-    if (rc) {
+    switch (alg) {
+    case 1:
+        rc = nc_server_tls_md5_wrap(cd->cert, buf);
+        break;
+    case 2:
+        rc = nc_server_tls_sha1_wrap(cd->cert, buf);
+        break;
+    case 3:
+        rc = nc_server_tls_sha224_wrap(cd->cert, buf);
+        break;
+    case 4:
+        rc = nc_server_tls_sha256_wrap(cd->cert, buf);
+        break;
+    case 5:
+        rc = nc_server_tls_sha384_wrap(cd->cert, buf);
+        break;
+    case 6:
+        rc = nc_server_tls_sha512_wrap(cd->cert, buf);
+        break;
+    default:
+        ERRINT;
         return NULL;
     }
-
-    /* convert the hash to hex */
-    return nc_server_tls_digest_to_hex(buf, buf_len);
-}
-
-static char *
-nc_server_tls_sha224(void *cert)
-{
-    int rc;
-    unsigned int buf_len = 28;
-    unsigned char buf[buf_len];
-
-    /* compute SHA-224 hash of cert and store it in buf */
-    rc = nc_server_tls_sha224_wrap(cert, buf);
     if (rc) {
         return NULL;
     }
 
-    /* convert the hash to hex */
-    return nc_server_tls_digest_to_hex(buf, buf_len);
+    cd->computed |= 1 << (alg - 1);
+    return buf;
 }
 
-static char *
-nc_server_tls_sha256(void *cert)
+/**
+ * @brief Parse a cert-to-name fingerprint in the form of colon-separated hex octets, the first being the algorithm.
+ *
+ * @param[in] fingerprint Fingerprint to parse.
+ * @param[out] alg Fingerprint algorithm.
+ * @param[out] digest Binary digest, ::NC_TLS_DIGEST_MAX_LEN bytes long buffer.
+ * @return 0 on success, 1 if the fingerprint is invalid or its algorithm unknown.
+ */
+static int
+nc_server_tls_ctn_fp_parse(const char *fingerprint, uint8_t *alg, unsigned char *digest)
 {
-    int rc;
-    unsigned int buf_len = 32;
-    unsigned char buf[buf_len];
+    const char *ptr = fingerprint;
+    unsigned int octet;
+    uint32_t count = 0;
 
-    /* compute SHA-256 hash of cert and store it in buf */
-    rc = nc_server_tls_sha256_wrap(cert, buf);
-    if (rc) {
-        return NULL;
-    }
+    *alg = 0;
 
-    /* convert the hash to hex */
-    return nc_server_tls_digest_to_hex(buf, buf_len);
-}
+    while (1) {
+        if (!isxdigit(ptr[0]) || !isxdigit(ptr[1]) || (sscanf(ptr, "%2x", &octet) != 1)) {
+            return 1;
+        }
 
-static char *
-nc_server_tls_sha384(void *cert)
-{
-    int rc;
-    unsigned int buf_len = 48;
-    unsigned char buf[buf_len];
+        if (!count) {
+            *alg = octet;
+        } else if (count > NC_TLS_DIGEST_MAX_LEN) {
+            return 1;
+        } else {
+            digest[count - 1] = octet;
+        }
+        ++count;
 
-    /* compute SHA-384 hash of cert and store it in buf */
-    rc = nc_server_tls_sha384_wrap(cert, buf);
-    if (rc) {
-        return NULL;
+        /* next octet */
+        ptr += 2;
+        if (!ptr[0]) {
+            break;
+        } else if (ptr[0] != ':') {
+            return 1;
+        }
+        ++ptr;
     }
 
-    /* convert the hash to hex */
-    return nc_server_tls_digest_to_hex(buf, buf_len);
-}
-
-static char *
-nc_server_tls_sha512(void *cert)
-{
-    int rc;
-    unsigned int buf_len = 64;
-    unsigned char buf[buf_len];
-
-    /* compute SHA-512 hash of cert and store it in buf */
-    rc = nc_server_tls_sha512_wrap(cert, buf);
-    if (rc) {
-        return NULL;
+    if (!*alg || (*alg > NC_TLS_FP_ALG_COUNT) || (count - 1 != nc_tls_digest_len[*alg])) {
+        return 1;
     }
-
-    /* convert the hash to hex */
-    return nc_server_tls_digest_to_hex(buf, buf_len);
+    return 0;
 }
 
 static int
-nc_server_tls_get_username(void *cert, struct nc_ctn *ctn, char **username)
+nc_server_tls_get_username(void *cert, NC_TLS_CTN_MAPTYPE map_type, const char *name, char **username)
 {
     char *subject, *cn, *san_value = NULL, rdn_separator;
     void *sans;
@@ -269,10 +270,10 @@ nc_server_tls_get_username(void *cert, struct nc_ctn *ctn, char **username)
     rdn_separator = '/';
 #endif
 
-    if (ctn->map_type == NC_TLS_CTN_SPECIFIED) {
-        *username = strdup(ctn->name);
+    if (map_type == NC_TLS_CTN_SPECIFIED) {
+        *username = strdup(name);
         NC_CHECK_ERRMEM_RET(!*username, -1);
-    } else if (ctn->map_type == NC_TLS_CTN_COMMON_NAME) {
+    } else if (map_type == NC_TLS_CTN_COMMON_NAME) {
         subject = nc_server_tls_get_subject_wrap(cert);
         if (!subject) {
             return -1;
@@ -313,7 +314,7 @@ nc_server_tls_get_username(void *cert, struct nc_ctn *ctn, char **username)
                 continue;
             }
 
-            if ((ctn->map_type == NC_TLS_CTN_SAN_ANY) || (ctn->map_type == san_type)) {
+            if ((map_type == NC_TLS_CTN_SAN_ANY) || (map_type == san_type)) {
                 /* found a match */
                 *username = san_value;
                 break;
@@ -324,7 +325,7 @@ nc_server_tls_get_username(void *cert, struct nc_ctn *ctn, char **username)
         nc_tls_sans_destroy_wrap(sans);
 
         if (i == nsans) {
-            switch (ctn->map_type) {
+            switch (map_type) {
             case NC_TLS_CTN_SAN_RFC822_NAME:
                 WRN(NULL, "Certificate does not include the SAN rfc822Name field.");
                 break;
@@ -347,171 +348,390 @@ nc_server_tls_get_username(void *cert, struct nc_ctn *ctn, char **username)
     return 0;
 }
 
-static int
-nc_server_tls_cert_to_name(struct nc_ctn *ctn, void *cert_chain, char **username)
+void
+nc_server_tls_ctn_index_free(struct nc_ctn_index *idx)
 {
-    int ret = 1, i, cert_count, fingerprint_match;
-    char *digest_md5 = NULL, *digest_sha1 = NULL, *digest_sha224 = NULL;
-    char *digest_sha256 = NULL, *digest_sha384 = NULL, *digest_sha512 = NULL;
-    void *cert;
+    uint32_t i;
 
-    /* first make sure the entry is valid */
-    if (!ctn->map_type || ((ctn->map_type == NC_TLS_CTN_SPECIFIED) && !ctn->name)) {
-        VRB(NULL, "Cert verify CTN: entry with id %u not valid, skipping.", ctn->id);
-        return 1;
+    if (!idx) {
+        return;
     }
 
-    cert_count = nc_tls_get_num_certs_wrap(cert_chain);
-    for (i = 0; i < cert_count; i++) {
-        /* reset the flag */
-        fingerprint_match = 0;
+    for (i = 0; i < idx->entry_count; i++) {
+        free(idx->entries[i].name);
+    }
+    free(idx->entries);
+    free(idx->slots);
+    free(idx->any);
+    free(idx);
+}
 
-        /*get next cert */
-        nc_tls_get_cert_wrap(cert_chain, i, &cert);
-        if (!cert) {
-            ERR(NULL, "Failed to get certificate from the chain.");
-            ret = -1;
-            goto cleanup;
+/**
+ * @brief Get the first slot of a fingerprint in a cert-to-name index.
+ *
+ * @param[in] idx Cert-to-name index.
+ * @param[in] alg Fingerprint algorithm.
+ * @param[in] digest Fingerprint digest.
+ * @return Slot index.
+ */
+static uint32_t
+nc_server_tls_ctn_index_slot(const struct nc_ctn_index *idx, uint8_t alg, const unsigned char *digest)
+{
+    uint32_t hash;
+
+    /* digests are uniformly distributed, the algorithm separates digests of the same certificate */
+    memcpy(&hash, digest, sizeof hash);
+    return (hash ^ alg) & (idx->slot_count - 1);
+}
+
+/**
+ * @brief Compile cert-to-name entries into an index.
+ *
+ * @param[in] ctn_list Cert-to-name entries ordered by priority.
+ * @return Created index, NULL on error.
+ */
+static struct nc_ctn_index *
+nc_server_tls_ctn_index_new(const struct nc_ctn *ctn_list)
+{
+    struct nc_ctn_index *idx;
+    struct nc_ctn_index_entry *entry;
+    const struct nc_ctn *ctn;
+    uint32_t count = 0, slot;
+
+    for (ctn = ctn_list; ctn; ctn = ctn->next) {
+        ++count;
+    }
+
+    idx = calloc(1, sizeof *idx);
+    NC_CHECK_ERRMEM_RET(!idx, NULL);
+
+    /* keep at least half of the slots empty for short probe sequences */
+    idx->slot_count = 2;
+    while (idx->slot_count < 2 * count) {
+        idx->slot_count <<= 1;
+    }
+
+    idx->entries = calloc(count ? count : 1, sizeof *idx->entries);
+    idx->any = malloc((count ? count : 1) * sizeof *idx->any);
+    idx->slots = calloc(idx->slot_count, sizeof *idx->slots);
+    NC_CHECK_ERRMEM_GOTO(!idx->entries || !idx->any || !idx->slots, , error);
+
+    for (ctn = ctn_list; ctn; ctn = ctn->next) {
+        entry = &idx->entries[idx->entry_count];
+
+        /* first make sure the entry is valid */
+        if (!ctn->map_type || ((ctn->map_type == NC_TLS_CTN_SPECIFIED) && !ctn->name)) {
+            VRB(NULL, "Cert-to-name entry with id %u not valid, skipping.", ctn->id);
+            continue;
+        }
+        if (ctn->fingerprint && nc_server_tls_ctn_fp_parse(ctn->fingerprint, &entry->alg, entry->digest)) {
+            WRN(NULL, "Unknown or invalid cert-to-name fingerprint (%s), skipping.", ctn->fingerprint);
+            memset(entry, 0, sizeof *entry);
+            continue;
         }
 
-        if (!ctn->fingerprint) {
-            /* if ctn has no fingerprint, it will match any certificate */
-            fingerprint_match = 1;
+        entry->id = ctn->id;
+        entry->map_type = ctn->map_type;
+        if (ctn->name) {
+            entry->name = strdup(ctn->name);
+            NC_CHECK_ERRMEM_GOTO(!entry->name, , error);
+        }
 
-            /* MD5 */
-        } else if (!strncmp(ctn->fingerprint, "01", 2)) {
-            digest_md5 = nc_server_tls_md5(cert);
-            if (!digest_md5) {
-                ret = -1;
-                goto cleanup;
+        if (!entry->alg) {
+            /* matches any certificate */
+            idx->any[idx->any_count++] = idx->entry_count;
+        } else {
+            slot = nc_server_tls_ctn_index_slot(idx, entry->alg, entry->digest);
+            while (idx->slots[slot]) {
+                slot = (slot + 1) & (idx->slot_count - 1);
             }
+            idx->slots[slot] = idx->entry_count + 1;
+            idx->algs |= 1 << (entry->alg - 1);
+        }
+        ++idx->entry_count;
+    }
 
-            if (!strcasecmp(ctn->fingerprint + 3, digest_md5)) {
-                /* we got ourselves a potential winner! */
-                VRB(NULL, "Cert verify CTN: entry with a matching fingerprint found.");
-                fingerprint_match = 1;
-            }
-            free(digest_md5);
-            digest_md5 = NULL;
+    return idx;
 
-            /* SHA-1 */
-        } else if (!strncmp(ctn->fingerprint, "02", 2)) {
-            digest_sha1 = nc_server_tls_sha1(cert);
-            if (!digest_sha1) {
-                ret = -1;
-                goto cleanup;
-            }
+error:
+    nc_server_tls_ctn_index_free(idx);
+    return NULL;
+}
 
-            if (!strcasecmp(ctn->fingerprint + 3, digest_sha1)) {
-                /* we got ourselves a potential winner! */
-                VRB(NULL, "Cert verify CTN: entry with a matching fingerprint found.");
-                fingerprint_match = 1;
-            }
-            free(digest_sha1);
-            digest_sha1 = NULL;
+/**
+ * @brief Rebuild the cert-to-name index of a TLS endpoint.
+ *
+ * @param[in] opts Endpoint TLS options.
+ */
+static void
+nc_server_tls_opts_ctn_index_update(struct nc_server_tls_opts *opts)
+{
+    nc_server_tls_ctn_index_free(opts->ctn_idx);
+    opts->ctn_idx = nc_server_tls_ctn_index_new(opts->ctn);
+}
 
-            /* SHA-224 */
-        } else if (!strncmp(ctn->fingerprint, "03", 2)) {
-            digest_sha224 = nc_server_tls_sha224(cert);
-            if (!digest_sha224) {
-                ret = -1;
-                goto cleanup;
-            }
+void
+nc_server_tls_ctn_indexes_update(void)
+{
+    uint16_t i, j;
+    struct nc_ch_client *ch_client;
 
-            if (!strcasecmp(ctn->fingerprint + 3, digest_sha224)) {
-                /* we got ourselves a potential winner! */
-                VRB(NULL, "Cert verify CTN: entry with a matching fingerprint found.");
-                fingerprint_match = 1;
-            }
-            free(digest_sha224);
-            digest_sha224 = NULL;
+    /* listen endpoints */
+    for (i = 0; i < server_opts.endpt_count; i++) {
+        if (server_opts.endpts[i].ti == NC_TI_TLS) {
+            nc_server_tls_opts_ctn_index_update(server_opts.endpts[i].opts.tls);
+        }
+    }
 
-            /* SHA-256 */
-        } else if (!strncmp(ctn->fingerprint, "04", 2)) {
-            digest_sha256 = nc_server_tls_sha256(cert);
-            if (!digest_sha256) {
-                ret = -1;
-                goto cleanup;
+    /* call home endpoints */
+    /* CH CLIENT LOCK */
+    pthread_rwlock_rdlock(&server_opts.ch_client_lock);
+    for (i = 0; i < server_opts.ch_client_count; i++) {
+        ch_client = &server_opts.ch_clients[i];
+
+        /* LOCK */
+        pthread_mutex_lock(&ch_client->lock);
+        for (j = 0; j < ch_client->ch_endpt_count; j++) {
+            if (ch_client->ch_endpts[j].ti == NC_TI_TLS) {
+                nc_server_tls_opts_ctn_index_update(ch_client->ch_endpts[j].opts.tls);
             }
+        }
+
+        /* UNLOCK */
+        pthread_mutex_unlock(&ch_client->lock);
+    }
+
+    /* CH CLIENT UNLOCK */
+    pthread_rwlock_unlock(&server_opts.ch_client_lock);
+}
+
+/**
+ * @brief Add a matching cert-to-name entry and certificate.
+ *
+ * @param[in] entry Index of the entry.
+ * @param[in] cert Index of the certificate.
+ * @param[in,out] matches Array of matches.
+ * @param[in,out] match_count Count of @p matches.
+ * @param[in,out] match_size Allocated size of @p matches.
+ * @return 0 on success, -1 on error.
+ */
+static int
+nc_server_tls_ctn_match_add(uint32_t entry, int cert, struct nc_ctn_match **matches, uint32_t *match_count,
+        uint32_t *match_size)
+{
+    struct nc_ctn_match *m;
+
+    if (*match_count == *match_size) {
+        m = nc_realloc(*matches, (*match_size ? *match_size * 2 : 8) * sizeof *m);
+        NC_CHECK_ERRMEM_RET(!m, -1);
+        *matches = m;
+        *match_size = *match_size ? *match_size * 2 : 8;
+    }
+
+    (*matches)[*match_count].entry = entry;
+    (*matches)[*match_count].cert = cert;
+    ++(*match_count);
+    return 0;
+}
+
+/**
+ * @brief Compare cert-to-name matches by the entry priority and then the certificate position in the chain.
+ */
+static int
+nc_server_tls_ctn_match_cmp(const void *ptr1, const void *ptr2)
+{
+    const struct nc_ctn_match *m1 = ptr1, *m2 = ptr2;
+
+    if (m1->entry != m2->entry) {
+        return (m1->entry < m2->entry) ? -1 : 1;
+    }
+    return m1->cert - m2->cert;
+}
+
+/**
+ * @brief Map a certificate chain to a username using a cert-to-name index.
+ *
+ * All the entries matching any of the certificates are found in the index and then tried in the order of their
+ * priority, the same as if all the entries were tried one by one for every certificate.
+ *
+ * @param[in] idx Cert-to-name index.
+ * @param[in] certs Chain certificates with their digests.
+ * @param[in] cert_count Count of @p certs.
+ * @param[out] username Mapped username.
+ * @return 0 on success, 1 if no entry matched, -1 on error.
+ */
+static int
+nc_server_tls_ctn_index_find(const struct nc_ctn_index *idx, struct nc_tls_cert_digests *certs, int cert_count,
+        char **username)
+{
+    int ret = 1, i;
+    uint8_t alg;
+    uint32_t slot, j, match_count = 0, match_size = 0;
+    const unsigned char *digest;
+    const struct nc_ctn_index_entry *entry;
+    struct nc_ctn_match *matches = NULL;
 
-            if (!strcasecmp(ctn->fingerprint + 3, digest_sha256)) {
-                /* we got ourselves a potential winner! */
-                VRB(NULL, "Cert verify CTN: entry with a matching fingerprint found.");
-                fingerprint_match = 1;
+    for (i = 0; i < cert_count; i++) {
+        /* look up the digests of the certificate for all the algorithms used */
+        for (alg = 1; alg <= NC_TLS_FP_ALG_COUNT; alg++) {
+            if (!(idx->algs & (1 << (alg - 1)))) {
+                continue;
             }
-            free(digest_sha256);
-            digest_sha256 = NULL;
 
-            /* SHA-384 */
-        } else if (!strncmp(ctn->fingerprint, "05", 2)) {
-            digest_sha384 = nc_server_tls_sha384(cert);
-            if (!digest_sha384) {
+            digest = nc_server_tls_cert_digest(&certs[i], alg);
+            if (!digest) {
                 ret = -1;
                 goto cleanup;
             }
 
-            if (!strcasecmp(ctn->fingerprint + 3, digest_sha384)) {
-                /* we got ourselves a potential winner! */
-                VRB(NULL, "Cert verify CTN: entry with a matching fingerprint found.");
-                fingerprint_match = 1;
+            for (slot = nc_server_tls_ctn_index_slot(idx, alg, digest); idx->slots[slot];
+                    slot = (slot + 1) & (idx->slot_count - 1)) {
+                entry = &idx->entries[idx->slots[slot] - 1];
+                if ((entry->alg == alg) && !memcmp(entry->digest, digest, nc_tls_digest_len[alg])) {
+                    if (nc_server_tls_ctn_match_add(idx->slots[slot] - 1, i, &matches, &match_count, &match_size)) {
+                        ret = -1;
+                        goto cleanup;
+                    }
+                }
             }
-            free(digest_sha384);
-            digest_sha384 = NULL;
+        }
 
-            /* SHA-512 */
-        } else if (!strncmp(ctn->fingerprint, "06", 2)) {
-            digest_sha512 = nc_server_tls_sha512(cert);
-            if (!digest_sha512) {
+        /* entries without a fingerprint match any certificate */
+        for (j = 0; j < idx->any_count; j++) {
+            if (nc_server_tls_ctn_match_add(idx->any[j], i, &matches, &match_count, &match_size)) {
                 ret = -1;
                 goto cleanup;
             }
+        }
+    }
 
-            if (!strcasecmp(ctn->fingerprint + 3, digest_sha512)) {
-                /* we got ourselves a potential winner! */
-                VRB(NULL, "Cert verify CTN: entry with a matching fingerprint found.");
-                fingerprint_match = 1;
-            }
-            free(digest_sha512);
-            digest_sha512 = NULL;
+    /* try the matches in the order of priority */
+    if (match_count > 1) {
+        qsort(matches, match_count, sizeof *matches, nc_server_tls_ctn_match_cmp);
+    }
+    for (j = 0; j < match_count; j++) {
+        entry = &idx->entries[matches[j].entry];
+        if (entry->alg) {
+            VRB(NULL, "Cert verify CTN: entry with id %u and a matching fingerprint found.", entry->id);
+        }
 
-            /* unknown */
-        } else {
-            WRN(NULL, "Unknown fingerprint algorithm used (%s), skipping.", ctn->fingerprint);
+        ret = nc_server_tls_get_username(certs[matches[j].cert].cert, entry->map_type, entry->name, username);
+        if (ret != 1) {
+            /* fatal error or username found */
+            goto cleanup;
+        }
+    }
+
+cleanup:
+    free(matches);
+    return ret;
+}
+
+/**
+ * @brief Map a certificate chain to a username by trying all the cert-to-name entries one by one.
+ *
+ * @param[in] ctn_list Cert-to-name entries ordered by priority.
+ * @param[in] certs Chain certificates with their digests.
+ * @param[in] cert_count Count of @p certs.
+ * @param[out] username Mapped username.
+ * @return 0 on success, 1 if no entry matched, -1 on error.
+ */
+static int
+nc_server_tls_ctn_scan(const struct nc_ctn *ctn_list, struct nc_tls_cert_digests *certs, int cert_count, char **username)
+{
+    int ret, i;
+    uint8_t alg;
+    unsigned char fp_digest[NC_TLS_DIGEST_MAX_LEN];
+    const unsigned char *digest;
+    const struct nc_ctn *ctn;
+
+    for (ctn = ctn_list; ctn; ctn = ctn->next) {
+        /* first make sure the entry is valid */
+        if (!ctn->map_type || ((ctn->map_type == NC_TLS_CTN_SPECIFIED) && !ctn->name)) {
+            VRB(NULL, "Cert verify CTN: entry with id %u not valid, skipping.", ctn->id);
             continue;
         }
 
-        if (fingerprint_match) {
-            /* found a fingerprint match, try to obtain the username */
-            ret = nc_server_tls_get_username(cert, ctn, username);
-            if (ret == -1) {
-                /* fatal error */
-                goto cleanup;
-            } else if (!ret) {
-                /* username found */
-                goto cleanup;
+        alg = 0;
+        if (ctn->fingerprint && nc_server_tls_ctn_fp_parse(ctn->fingerprint, &alg, fp_digest)) {
+            WRN(NULL, "Unknown or invalid cert-to-name fingerprint (%s), skipping.", ctn->fingerprint);
+            continue;
+        }
+
+        for (i = 0; i < cert_count; i++) {
+            if (alg) {
+                digest = nc_server_tls_cert_digest(&certs[i], alg);
+                if (!digest) {
+                    return -1;
+                }
+                if (memcmp(fp_digest, digest, nc_tls_digest_len[alg])) {
+                    continue;
+                }
+                VRB(NULL, "Cert verify CTN: entry with id %u and a matching fingerprint found.", ctn->id);
+            }
+
+            ret = nc_server_tls_get_username(certs[i].cert, ctn->map_type, ctn->name, username);
+            if (ret != 1) {
+                /* fatal error or username found */
+                return ret;
             }
         }
     }
 
-cleanup:
-    return ret;
+    return 1;
+}
+
+/**
+ * @brief Map a certificate chain to a username using the cert-to-name entries of an endpoint.
+ *
+ * @param[in] opts Endpoint TLS options.
+ * @param[in] certs Chain certificates with their digests.
+ * @param[in] cert_count Count of @p certs.
+ * @param[out] username Mapped username.
+ * @return 0 on success, 1 if no entry matched, -1 on error.
+ */
+static int
+nc_server_tls_opts_cert_to_name(const struct nc_server_tls_opts *opts, struct nc_tls_cert_digests *certs, int cert_count,
+        char **username)
+{
+    if (opts->ctn_idx) {
+        /* entries compiled when the configuration was applied */
+        return nc_server_tls_ctn_index_find(opts->ctn_idx, certs, cert_count, username);
+    }
+
+    return nc_server_tls_ctn_scan(opts->ctn, certs, cert_count, username);
 }
 
 static int
 _nc_server_tls_cert_to_name(struct nc_server_tls_opts *opts, void *cert_chain, char **username)
 {
-    int ret = 1;
+    int ret = 1, i, cert_count;
     struct nc_endpt *referenced_endpt;
-    struct nc_ctn *ctn;
+    struct nc_tls_cert_digests *certs = NULL;
 
-    for (ctn = opts->ctn; ctn; ctn = ctn->next) {
-        ret = nc_server_tls_cert_to_name(ctn, cert_chain, username);
-        if (ret != 1) {
-            /* fatal error or success */
+    cert_count = nc_tls_get_num_certs_wrap(cert_chain);
+    if (cert_count < 1) {
+        goto cleanup;
+    }
+
+    /* the digests of every certificate are computed at most once */
+    certs = calloc(cert_count, sizeof *certs);
+    NC_CHECK_ERRMEM_GOTO(!certs, ret = -1, cleanup);
+    for (i = 0; i < cert_count; i++) {
+        nc_tls_get_cert_wrap(cert_chain, i, &certs[i].cert);
+        if (!certs[i].cert) {
+            ERR(NULL, "Failed to get certificate from the chain.");
+            ret = -1;
             goto cleanup;
         }
     }
 
+    ret = nc_server_tls_opts_cert_to_name(opts, certs, cert_count, username);
+    if (ret != 1) {
+        /* fatal error or success */
+        goto cleanup;
+    }
+
     /* do the same for referenced endpoint's ctn entries */
     if (opts->referenced_endpt_name) {
         if (nc_server_get_referenced_endpt(opts->referenced_endpt_name, &referenced_endpt)) {
@@ -520,16 +740,11 @@ _nc_server_tls_cert_to_name(struct nc_server_tls_opts *opts, void *cert_chain, c
             goto cleanup;
         }
 
-        for (ctn = referenced_endpt->opts.tls->ctn; ctn; ctn = ctn->next) {
-            ret = nc_server_tls_cert_to_name(ctn, cert_chain, username);
-            if (ret != 1) {
-                /* fatal error or success */
-                goto cleanup;
-            }
-        }
+        ret = nc_server_tls_opts_cert_to_name(referenced_endpt->opts.tls, certs, cert_count, username);
     }
 
 cleanup:
+    free(certs);
     return ret;
 }
 
@@ -596,12 +811,43 @@ nc_server_tls_verify_peer_cert(void *peer_cert, struct nc_server_tls_opts *opts)
     return 1;
 }
 
+/**
+ * @brief Get TLS options used for verifying a new session.
+ *
+ * If the endpoint name is set, config lock is expected to be held for reading.
+ *
+ * @param[in] cb_data Verify callback data.
+ * @return TLS options, NULL if the endpoint no longer exists.
+ */
+static struct nc_server_tls_opts *
+nc_server_tls_verify_opts(const struct nc_tls_verify_cb_data *cb_data)
+{
+    uint16_t i;
+
+    if (!cb_data->endpt_name) {
+        return cb_data->opts;
+    }
+
+    /* the configuration may have changed since the session was started */
+    for (i = 0; i < server_opts.endpt_count; i++) {
+        if (!strcmp(server_opts.endpts[i].name, cb_data->endpt_name)) {
+            if (server_opts.endpts[i].ti != NC_TI_TLS) {
+                break;
+            }
+            return server_opts.endpts[i].opts.tls;
+        }
+    }
+
+    ERR(cb_data->session, "Endpoint \"%s\" removed, dropping the new session.", cb_data->endpt_name);
+    return NULL;
+}
+
 int
 nc_server_tls_verify_cert(void *cert, int depth, int trusted, struct nc_tls_verify_cb_data *cb_data)
 {
-    int ret = 0;
+    int ret = 0, config_locked = 0;
     char *subject = NULL, *issuer = NULL;
-    struct nc_server_tls_opts *opts = cb_data->opts;
+    struct nc_server_tls_opts *opts;
     struct nc_session *session = cb_data->session;
     void *cert_chain = cb_data->chain;
 
@@ -623,6 +869,18 @@ nc_server_tls_verify_cert(void *cert, int depth, int trusted, struct nc_tls_veri
     VRB(session, "Cert verify: issuer: %s.", issuer);
 
     if (depth == 0) {
+        if (cb_data->endpt_name) {
+            /* CONFIG LOCK */
+            pthread_rwlock_rdlock(&server_opts.config_lock);
+            config_locked = 1;
+        }
+
+        opts = nc_server_tls_verify_opts(cb_data);
+        if (!opts) {
+            ret = -1;
+            goto cleanup;
+        }
+
         if (!trusted) {
             /* peer cert is not trusted, so it must match any configured end-entity cert
              * on the given endpoint in order for the client to be authenticated */
@@ -659,6 +917,10 @@ nc_server_tls_verify_cert(void *cert, int depth, int trusted, struct nc_tls_veri
     }
 
 cleanup:
+    if (config_locked) {
+        /* CONFIG UNLOCK */
+        pthread_rwlock_unlock(&server_opts.config_lock);
+    }
     free(subject);
     free(issuer);
     return ret;
@@ -681,6 +943,16 @@ nc_server_tls_set_verify_clb(int (*verify_clb)(const struct nc_session *session)
     server_opts.user_verify_clb = verify_clb;
 }
 
+API void
+nc_server_tls_set_resumption(uint32_t cache_size, uint32_t lifetime)
+{
+    server_opts.tls_sess_cache_size = cache_size;
+    server_opts.tls_sess_lifetime = lifetime ? lifetime : NC_TLS_SESS_LIFETIME;
+
+    /* make the endpoints prepare their TLS configurations again */
+    ATOMIC_INC_RELAXED(server_opts.config_gen);
+}
+
 int
 nc_server_tls_load_server_cert_key(struct nc_server_tls_opts *opts, void **srv_cert, void **srv_pkey)
 {
@@ -784,24 +1056,43 @@ nc_server_tls_accept_check(int accept_ret, void *tls_session)
     return accept_ret;
 }
 
-int
-nc_accept_tls_session(struct nc_session *session, struct nc_server_tls_opts *opts, int sock, int timeout)
+void
+nc_server_tls_cfg_free(struct nc_server_tls_cfg *cfg)
+{
+    /* the last reference must see all the accesses of the other holders before freeing */
+    if (!cfg || (ATOMIC_DEC_ACQ_REL(cfg->refcount) > 1)) {
+        return;
+    }
+
+    nc_tls_config_destroy_wrap(cfg->tls_cfg);
+    nc_tls_ctx_destroy_wrap(&cfg->ctx);
+    free(cfg);
+}
+
+/**
+ * @brief Prepare a TLS configuration of an endpoint to be shared by its new sessions.
+ *
+ * @param[in] opts TLS options of the endpoint.
+ * @return Prepared TLS configuration, NULL on error.
+ */
+static struct nc_server_tls_cfg *
+nc_server_tls_cfg_new(struct nc_server_tls_opts *opts)
 {
-    int rc, timeouted = 0;
-    struct timespec ts_timeout;
-    struct nc_tls_verify_cb_data cb_data = {0};
+    struct nc_server_tls_cfg *cfg;
     struct nc_endpt *referenced_endpt;
-    void *tls_cfg, *srv_cert, *srv_pkey, *cert_store, *crl_store;
+    void *srv_cert, *srv_pkey, *cert_store, *crl_store;
+    char **uris = NULL;
+    int i, uri_count = 0;
 
-    tls_cfg = srv_cert = srv_pkey = cert_store = crl_store = NULL;
+    srv_cert = srv_pkey = cert_store = crl_store = NULL;
 
-    /* set verify cb data */
-    cb_data.session = session;
-    cb_data.opts = opts;
+    cfg = calloc(1, sizeof *cfg);
+    NC_CHECK_ERRMEM_RET(!cfg, NULL);
+    ATOMIC_STORE_RELAXED(cfg->refcount, 1);
 
-    /* prepare TLS context from which a session will be created */
-    tls_cfg = nc_tls_config_new_wrap(NC_SERVER);
-    if (!tls_cfg) {
+    /* prepare TLS context from which sessions will be created */
+    cfg->tls_cfg = nc_tls_config_new_wrap(NC_SERVER);
+    if (!cfg->tls_cfg) {
         goto fail;
     }
 
@@ -813,52 +1104,59 @@ nc_accept_tls_session(struct nc_session *session, struct nc_server_tls_opts *opt
 
     /* load server's key and certificate */
     if (nc_server_tls_load_server_cert_key(opts, &srv_cert, &srv_pkey)) {
-        ERR(session, "Loading server certificate and/or private key failed.");
+        ERR(NULL, "Loading server certificate and/or private key failed.");
         goto fail;
     }
 
     /* load trusted CA certificates */
     if (nc_server_tls_load_trusted_certs(&opts->ca_certs, cert_store)) {
-        ERR(session, "Loading server CA certs failed.");
+        ERR(NULL, "Loading server CA certs failed.");
         goto fail;
     }
 
     /* load referenced endpoint's trusted CA certs if set */
     if (opts->referenced_endpt_name) {
         if (nc_server_get_referenced_endpt(opts->referenced_endpt_name, &referenced_endpt)) {
-            ERR(session, "Referenced endpoint \"%s\" not found.", opts->referenced_endpt_name);
+            ERR(NULL, "Referenced endpoint \"%s\" not found.", opts->referenced_endpt_name);
             goto fail;
         }
 
         if (nc_server_tls_load_trusted_certs(&referenced_endpt->opts.tls->ca_certs, cert_store)) {
-            ERR(session, "Loading server CA certs from referenced endpoint failed.");
+            ERR(NULL, "Loading server CA certs from referenced endpoint failed.");
             goto fail;
         }
     }
 
-    if (nc_session_tls_crl_from_cert_ext_fetch(srv_cert, cert_store, &crl_store)) {
-        ERR(session, "Loading server CRL failed.");
+    /* get the CRLs from the cache, they are never downloaded here but the first download is waited for */
+    if (nc_server_tls_get_crl_distpoint_uris_wrap(srv_cert, cert_store, &uris, &uri_count)) {
         goto fail;
     }
+    if (uri_count) {
+        crl_store = nc_tls_crl_store_new_wrap();
+        if (!crl_store || nc_server_crl_cache_get(uris, uri_count, crl_store)) {
+            ERR(NULL, "Loading server CRL failed.");
+            goto fail;
+        }
+    }
 
     /* set supported TLS versions */
     if (opts->tls_versions) {
-        if (nc_server_tls_set_tls_versions_wrap(tls_cfg, opts->tls_versions)) {
-            ERR(session, "Setting supported server TLS versions failed.");
+        if (nc_server_tls_set_tls_versions_wrap(cfg->tls_cfg, opts->tls_versions)) {
+            ERR(NULL, "Setting supported server TLS versions failed.");
             goto fail;
         }
     }
 
     /* set supported cipher suites */
     if (opts->ciphers) {
-        nc_server_tls_set_cipher_suites_wrap(tls_cfg, opts->ciphers);
+        nc_server_tls_set_cipher_suites_wrap(cfg->tls_cfg, opts->ciphers);
     }
 
-    /* set verify flags, callback and its data */
-    nc_server_tls_set_verify_wrap(tls_cfg, &cb_data);
+    /* set verify flags and callback, its data are set for each session */
+    nc_server_tls_set_verify_wrap(cfg->tls_cfg);
 
     /* init TLS context and store data which may be needed later in it */
-    if (nc_tls_init_ctx_wrap(sock, srv_cert, srv_pkey, cert_store, crl_store, &session->ti.tls.ctx)) {
+    if (nc_tls_init_ctx_wrap(-1, srv_cert, srv_pkey, cert_store, crl_store, &cfg->ctx)) {
         goto fail;
     }
 
@@ -866,57 +1164,211 @@ nc_accept_tls_session(struct nc_session *session, struct nc_server_tls_opts *opt
     srv_cert = srv_pkey = cert_store = crl_store = NULL;
 
     /* setup config from ctx */
-    if (nc_tls_setup_config_from_ctx_wrap(&session->ti.tls.ctx, NC_SERVER, tls_cfg)) {
+    if (nc_tls_setup_config_from_ctx_wrap(&cfg->ctx, NC_SERVER, cfg->tls_cfg)) {
+        goto fail;
+    }
+
+    /* set session resumption, the cache and ticket keys are dropped with the configuration */
+    if (nc_server_tls_set_resumption_wrap(cfg->tls_cfg, &cfg->ctx, server_opts.tls_sess_cache_size,
+            server_opts.tls_sess_lifetime)) {
         goto fail;
     }
-    session->ti.tls.config = tls_cfg;
-    tls_cfg = NULL;
 
-    /* fill session data and create TLS session from config */
+    for (i = 0; i < uri_count; ++i) {
+        free(uris[i]);
+    }
+    free(uris);
+    return cfg;
+
+fail:
+    for (i = 0; i < uri_count; ++i) {
+        free(uris[i]);
+    }
+    free(uris);
+    nc_tls_cert_destroy_wrap(srv_cert);
+    nc_tls_privkey_destroy_wrap(srv_pkey);
+    nc_tls_cert_store_destroy_wrap(cert_store);
+    nc_tls_crl_store_destroy_wrap(crl_store);
+    nc_server_tls_cfg_free(cfg);
+    return NULL;
+}
+
+/**
+ * @brief Authenticate a client of a resumed TLS session, as the username it was originally authenticated as.
+ *
+ * @param[in] session NETCONF session.
+ * @param[in] opts TLS options of the endpoint.
+ * @return 0 on success, non-zero on fail.
+ */
+static int
+nc_server_tls_resumed_auth(struct nc_session *session, struct nc_server_tls_opts *opts)
+{
+    void *cert_chain;
+
+    if (nc_server_tls_get_resumed_auth_wrap(session->ti.tls.session, &session->username,
+            &session->opts.server.client_cert, &cert_chain)) {
+        return 1;
+    }
+
+    if (!session->username) {
+        /* username could not be stored in the session, get it from the peer cert chain, it was already verified */
+        if (_nc_server_tls_cert_to_name(opts, cert_chain, &session->username) || !session->username) {
+            VRB(session, "Resumed TLS session CTN: unsuccessful, dropping the client.");
+            return 1;
+        }
+    }
+    VRB(session, "TLS session resumed, client username \"%s\".", session->username);
+
+    if (server_opts.user_verify_clb && !server_opts.user_verify_clb(session)) {
+        VRB(session, "Resumed TLS session: user verify callback revoked authorization.");
+        return 1;
+    }
+
+    return 0;
+}
+
+int
+nc_accept_tls_session_start(struct nc_session *session, struct nc_server_tls_opts *opts, const char *endpt_name,
+        int sock, int timeout, struct nc_tls_accept *acc)
+{
+    uint32_t config_gen, crl_gen;
+    struct nc_server_tls_cfg *cfg;
+
+    memset(acc, 0, sizeof *acc);
+
+    /* set verify cb data */
+    acc->cb_data.session = session;
+    acc->cb_data.opts = opts;
+    acc->cb_data.endpt_name = endpt_name;
+
+    /* TLS CFG LOCK */
+    pthread_mutex_lock(&opts->tls_cfg_lock);
+
+    /* the certificates and keys are loaded only once for every configuration and cached CRLs */
+    config_gen = ATOMIC_LOAD_RELAXED(server_opts.config_gen);
+    crl_gen = ATOMIC_LOAD_RELAXED(server_opts.crl_cache.gen);
+    if (!opts->tls_cfg || (opts->tls_cfg->config_gen != config_gen) || (opts->tls_cfg->crl_gen != crl_gen)) {
+        nc_server_tls_cfg_free(opts->tls_cfg);
+        opts->tls_cfg = nc_server_tls_cfg_new(opts);
+        if (opts->tls_cfg) {
+            opts->tls_cfg->config_gen = config_gen;
+            opts->tls_cfg->crl_gen = crl_gen;
+        }
+    }
+
+    /* reference the configuration by the session */
+    cfg = opts->tls_cfg;
+    if (cfg) {
+        ATOMIC_INC_RELAXED(cfg->refcount);
+    }
+
+    /* TLS CFG UNLOCK */
+    pthread_mutex_unlock(&opts->tls_cfg_lock);
+
+    if (!cfg) {
+        goto fail;
+    }
+
+    /* fill session data and create TLS session from the shared config */
     session->ti_type = NC_TI_TLS;
+    session->ti.tls.srv_cfg = cfg;
+    session->ti.tls.config = cfg->tls_cfg;
     if (!(session->ti.tls.session = nc_tls_session_new_wrap(session->ti.tls.config))) {
         goto fail;
     }
 
-    /* set session fd */
-    nc_server_tls_set_fd_wrap(session->ti.tls.session, sock, &session->ti.tls.ctx);
+    /* init the context of this session */
+    if (nc_server_tls_init_session_ctx_wrap(sock, &session->ti.tls.ctx)) {
+        goto fail;
+    }
 
+    /* set session fd */
+    if (nc_server_tls_set_fd_wrap(session->ti.tls.session, sock, &session->ti.tls.ctx)) {
+        goto fail;
+    }
     sock = -1;
 
-    /* do the handshake */
     if (timeout > -1) {
-        nc_timeouttime_get(&ts_timeout, timeout);
+        acc->has_timeout = 1;
+        nc_timeouttime_get(&acc->ts_timeout, timeout);
+    }
+    return 1;
+
+fail:
+    if (sock > -1) {
+        close(sock);
     }
-    while ((rc = nc_server_tls_handshake_step_wrap(session->ti.tls.session)) == 0) {
-        usleep(NC_TIMEOUT_STEP);
-        if ((timeout > -1) && (nc_timeouttime_cur_diff(&ts_timeout) < 1)) {
+    return -1;
+}
+
+int
+nc_accept_tls_session_step(struct nc_session *session, struct nc_tls_accept *acc)
+{
+    int rc;
+    struct nc_server_tls_opts *opts;
+
+    /* the state may have been moved since the previous step */
+    nc_server_tls_set_verify_data_wrap(session->ti.tls.session, &acc->cb_data);
+
+    /* do the handshake */
+    rc = nc_server_tls_handshake_step_wrap(session->ti.tls.session, &session->ti.tls.ctx);
+    if (!rc) {
+        if (acc->has_timeout && (nc_timeouttime_cur_diff(&acc->ts_timeout) < 1)) {
             ERR(session, "TLS accept timeout.");
-            timeouted = 1;
-            goto fail;
+            return 0;
         }
+        return 2;
     }
 
     /* check if handshake was ok */
     if (nc_server_tls_accept_check(rc, session->ti.tls.session) != 1) {
-        goto fail;
+        return -1;
     }
 
-    return 1;
+    /* the verify callback always sets the username during a full handshake */
+    if (!session->username) {
+        if (acc->cb_data.endpt_name) {
+            /* CONFIG LOCK */
+            pthread_rwlock_rdlock(&server_opts.config_lock);
+        }
 
-fail:
-    if (sock > -1) {
-        close(sock);
+        opts = nc_server_tls_verify_opts(&acc->cb_data);
+        rc = !opts || nc_server_tls_resumed_auth(session, opts);
+
+        if (acc->cb_data.endpt_name) {
+            /* CONFIG UNLOCK */
+            pthread_rwlock_unlock(&server_opts.config_lock);
+        }
+        if (rc) {
+            return -1;
+        }
     }
 
-    nc_tls_config_destroy_wrap(tls_cfg);
-    nc_tls_cert_destroy_wrap(srv_cert);
-    nc_tls_privkey_destroy_wrap(srv_pkey);
-    nc_tls_cert_store_destroy_wrap(cert_store);
-    nc_tls_crl_store_destroy_wrap(crl_store);
+    return 1;
+}
 
-    if (timeouted) {
-        return 0;
-    } else {
-        return -1;
+int
+nc_accept_tls_session(struct nc_session *session, struct nc_server_tls_opts *opts, int sock, int timeout)
+{
+    int rc;
+    struct nc_tls_accept acc;
+    struct pollfd pfd;
+
+    /* config lock is held by the caller, the options can be used directly */
+    if ((rc = nc_accept_tls_session_start(session, opts, NULL, sock, timeout, &acc)) != 1) {
+        return rc;
     }
+
+    /* progress the handshake whenever the socket is ready in the direction the last step is waiting for */
+    while ((rc = nc_accept_tls_session_step(session, &acc)) == 2) {
+        pfd.fd = nc_tls_get_fd_wrap(session);
+        pfd.events = nc_tls_want_write_wrap(session) ? POLLOUT : POLLIN;
+        pfd.revents = 0;
+        if ((poll(&pfd, 1, NC_TLS_ACCEPT_POLL) == -1) && (errno != EINTR)) {
+            ERR(session, "Poll failed (%s).", strerror(errno));
+            return -1;
+        }
+    }
+
+    return rc;
 }
@@ -16,6 +16,7 @@
 #ifndef _SESSION_WRAPPER_H_
 #define _SESSION_WRAPPER_H_
 
+#include <pthread.h>
 #include <stdlib.h>
 
 #include "config.h"
@@ -29,17 +30,28 @@
 #include <mbedtls/x509_crl.h>
 #include <mbedtls/x509_crt.h>
 
+/**
+ * @brief Random bit generator, may be used by several TLS sessions at once.
+ */
+struct nc_tls_rng {
+    mbedtls_entropy_context entropy;    /**< Entropy. */
+    mbedtls_ctr_drbg_context ctr_drbg;  /**< Random bit generator. */
+    pthread_mutex_t lock;               /**< Lock for the generator, it is not thread-safe without MBEDTLS_THREADING_C. */
+};
+
 /**
  * @brief Context from which a TLS session may be created.
  */
 struct nc_tls_ctx {
     int *sock;                          /**< Socket FD. */
-    mbedtls_entropy_context *entropy;   /**< Entropy. */
-    mbedtls_ctr_drbg_context *ctr_drbg; /**< Random bit generator. */
+    struct nc_tls_rng *rng;             /**< Random bit generator. */
     mbedtls_x509_crt *cert;             /**< Certificate. */
     mbedtls_pk_context *pkey;           /**< Private key. */
     mbedtls_x509_crt *cert_store;       /**< CA certificates store. */
     mbedtls_x509_crl *crl_store;        /**< CRL store. */
+    void *sess_cache;                   /**< Server TLS session cache. */
+    void *ticket;                       /**< Server TLS session ticket keys. */
+    int want_write;                     /**< Whether the last read/write is waiting for the socket to be writable. */
 };
 
 #else
@@ -56,6 +68,7 @@ struct nc_tls_ctx {
     EVP_PKEY *pkey;         /**< Private key. */
     X509_STORE *cert_store; /**< CA certificate store. */
     X509_STORE *crl_store;  /**< CRL store. */
+    void *ticket_keys;      /**< Server TLS session ticket keys. */
 };
 
 #endif
@@ -65,7 +78,8 @@ struct nc_tls_ctx {
  */
 struct nc_tls_verify_cb_data {
     struct nc_session *session;         /**< NETCONF session. */
-    struct nc_server_tls_opts *opts;    /**< TLS server options. */
+    struct nc_server_tls_opts *opts;    /**< TLS server options, used only if endpt_name is not set. */
+    const char *endpt_name;             /**< Name of the endpoint whose TLS options are looked up under the config lock. */
     void *chain;                        /**< Certificate chain used to verify the client cert. */
 };
 
@@ -183,6 +197,16 @@ void * nc_tls_pem_to_privkey_wrap(const char *privkey_data);
  */
 int nc_server_tls_add_crl_to_store_wrap(const unsigned char *crl_data, size_t size, void *crl_store);
 
+/**
+ * @brief Parses a CRL and gets the time of its next update.
+ *
+ * @param[in] crl_data CRL data.
+ * @param[in] size Size of the CRL data.
+ * @param[out] next_update Real time of the next update, 0 if not set.
+ * @return 0 on success, non-zero on fail.
+ */
+int nc_server_tls_crl_next_update_wrap(const unsigned char *crl_data, size_t size, time_t *next_update);
+
 /**
  * @brief Sets the TLS version.
  *
@@ -194,12 +218,66 @@ int nc_server_tls_add_crl_to_store_wrap(const unsigned char *crl_data, size_t si
 int nc_server_tls_set_tls_versions_wrap(void *tls_cfg, unsigned int tls_versions);
 
 /**
- * @brief Set TLS server's verify flags, verify cb and its data.
+ * @brief Set TLS server's verify flags and verify cb.
  *
  * @param[in] tls_cfg TLS configuration.
+ */
+void nc_server_tls_set_verify_wrap(void *tls_cfg);
+
+/**
+ * @brief Set TLS server's verify cb data of a single session.
+ *
+ * @param[in] tls_session TLS session.
  * @param[in] cb_data Verify callback data.
  */
-void nc_server_tls_set_verify_wrap(void *tls_cfg, struct nc_tls_verify_cb_data *cb_data);
+void nc_server_tls_set_verify_data_wrap(void *tls_session, struct nc_tls_verify_cb_data *cb_data);
+
+/**
+ * @brief Set TLS server's session resumption, both from its session cache and from session tickets.
+ *
+ * @param[in] tls_cfg TLS configuration.
+ * @param[in] tls_ctx TLS context of the configuration, stores the session cache and ticket keys.
+ * @param[in] cache_size Maximum number of cached sessions, 0 to disable resumption.
+ * @param[in] lifetime Lifetime of resumable sessions and the rotation interval of ticket keys in seconds.
+ * @return 0 on success, non-zero on fail.
+ */
+int nc_server_tls_set_resumption_wrap(void *tls_cfg, struct nc_tls_ctx *tls_ctx, uint32_t cache_size, uint32_t lifetime);
+
+/**
+ * @brief Get the authentication data of a resumed TLS server session.
+ *
+ * @param[in] tls_session Resumed TLS session.
+ * @param[out] username Username the client was originally authenticated as, NULL if the library
+ * cannot store it in the session.
+ * @param[out] client_cert Copy of the client certificate.
+ * @param[out] cert_chain Client certificate chain for cert-to-name if @p username could not be retrieved.
+ * @return 0 on success, non-zero on fail.
+ */
+int nc_server_tls_get_resumed_auth_wrap(void *tls_session, char **username, void **client_cert, void **cert_chain);
+
+/**
+ * @brief Save an established TLS client session for its later resumption.
+ *
+ * @param[in] tls_session TLS session.
+ * @return Saved session, NULL if the session cannot be resumed.
+ */
+void *nc_client_tls_session_save_wrap(void *tls_session);
+
+/**
+ * @brief Set a saved session to be resumed by a new TLS client session.
+ *
+ * @param[in] tls_session New TLS session, before the handshake.
+ * @param[in] tls_sess Saved session.
+ * @return 0 on success, non-zero on fail.
+ */
+int nc_client_tls_session_resume_wrap(void *tls_session, void *tls_sess);
+
+/**
+ * @brief Free a saved TLS client session.
+ *
+ * @param[in] tls_sess Saved session.
+ */
+void nc_client_tls_session_free_wrap(void *tls_sess);
 
 /**
  * @brief Set TLS client's verify flags.
@@ -368,16 +446,18 @@ int nc_server_tls_sha512_wrap(void *cert, unsigned char *buf);
  * @param[in] tls_session TLS session.
  * @param[in] sock Socket FD.
  * @param[in] tls_ctx TLS context.
+ * @return 0 on success, non-zero on fail.
  */
-void nc_server_tls_set_fd_wrap(void *tls_session, int sock, struct nc_tls_ctx *tls_ctx);
+int nc_server_tls_set_fd_wrap(void *tls_session, int sock, struct nc_tls_ctx *tls_ctx);
 
 /**
  * @brief Perform a server-side step of the TLS handshake.
  *
  * @param[in] tls_session TLS session.
+ * @param[in] tls_ctx TLS context, remembers the socket readiness an unfinished step is waiting for.
  * @return 1 on success, 0 if the handshake is not finished, negative number on error.
  */
-int nc_server_tls_handshake_step_wrap(void *tls_session);
+int nc_server_tls_handshake_step_wrap(void *tls_session, struct nc_tls_ctx *tls_ctx);
 
 /**
  * @brief Perform a client-side step of the TLS handshake.
@@ -438,6 +518,15 @@ int nc_client_tls_set_hostname_wrap(void *tls_session, const char *hostname);
  */
 int nc_tls_init_ctx_wrap(int sock, void *cert, void *pkey, void *cert_store, void *crl_store, struct nc_tls_ctx *tls_ctx);
 
+/**
+ * @brief Initialize a TLS context of a single server session created from a shared TLS configuration.
+ *
+ * @param[in] sock Socket FD.
+ * @param[in,out] tls_ctx TLS context.
+ * @return 0 on success, non-zero on fail.
+ */
+int nc_server_tls_init_session_ctx_wrap(int sock, struct nc_tls_ctx *tls_ctx);
+
 /**
  * @brief Setup a TLS configuration from a TLS context.
  *
@@ -546,6 +635,14 @@ int nc_tls_get_num_pending_bytes_wrap(void *tls_session);
  */
 int nc_tls_get_fd_wrap(const struct nc_session *session);
 
+/**
+ * @brief Learn the socket readiness the last TLS read or write that would block is waiting for.
+ *
+ * @param[in] session NETCONF session.
+ * @return Non-zero if the socket needs to be writable, 0 if readable.
+ */
+int nc_tls_want_write_wrap(const struct nc_session *session);
+
 /**
  * @brief Close a TLS session.
  *
@@ -179,6 +179,71 @@ test_nc_auth_pubkey(void **state)
     }
 }
 
+static void *
+server_thread_fail(void *arg)
+{
+    NC_MSG_TYPE msgtype;
+    struct nc_session *session = NULL;
+    struct test_state *state = arg;
+
+    /* the client is not authorized, accepting the session must fail */
+    pthread_barrier_wait(&state->barrier);
+    msgtype = nc_accept(NC_ACCEPT_TIMEOUT, ctx, &session);
+    assert_int_not_equal(msgtype, NC_MSG_HELLO);
+    assert_null(session);
+
+    return NULL;
+}
+
+static void *
+client_thread_pubkey_unknown(void *arg)
+{
+    int ret;
+    struct nc_session *session = NULL;
+    struct test_state *state = arg;
+
+    /* skip all hostkey and known_hosts checks */
+    nc_client_ssh_set_knownhosts_mode(NC_SSH_KNOWNHOSTS_SKIP);
+
+    ret = nc_client_set_schema_searchpath(MODULES_DIR);
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_ssh_set_username("test_pk");
+    assert_int_equal(ret, 0);
+
+    nc_client_ssh_set_auth_pref(NC_SSH_AUTH_PUBLICKEY, 1);
+    nc_client_ssh_set_auth_pref(NC_SSH_AUTH_PASSWORD, -1);
+    nc_client_ssh_set_auth_pref(NC_SSH_AUTH_INTERACTIVE, -1);
+
+    /* key not configured for the user */
+    ret = nc_client_ssh_add_keypair(TESTS_DIR "/data/id_ed25519.pub", TESTS_DIR "/data/id_ed25519");
+    assert_int_equal(ret, 0);
+
+    pthread_barrier_wait(&state->barrier);
+    session = nc_connect_ssh("127.0.0.1", TEST_PORT, NULL);
+    assert_null(session);
+
+    return NULL;
+}
+
+static void
+test_nc_auth_pubkey_unknown(void **state)
+{
+    int ret, i;
+    pthread_t tids[2];
+
+    assert_non_null(state);
+
+    ret = pthread_create(&tids[0], NULL, client_thread_pubkey_unknown, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread_fail, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
 static void *
 client_thread_none(void *arg)
 {
@@ -257,6 +322,9 @@ setup_f(void **state)
     ret = nc_server_config_add_ssh_user_pubkey(ctx, "endpt", "test_pk", "pubkey", TESTS_DIR "/data/key_rsa.pub", &tree);
     assert_int_equal(ret, 0);
 
+    ret = nc_server_config_add_ssh_user_pubkey(ctx, "endpt", "test_pk", "pubkey2", TESTS_DIR "/data/id_ecdsa256.pub", &tree);
+    assert_int_equal(ret, 0);
+
     ret = nc_server_config_add_ssh_user_password(ctx, "endpt", "test_pw", "testpw", &tree);
     assert_int_equal(ret, 0);
 
@@ -305,6 +373,7 @@ main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_nc_auth_pubkey, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_auth_pubkey_unknown, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_nc_auth_password, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_nc_auth_none, setup_f, teardown_f)
     };
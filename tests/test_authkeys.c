@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <cmocka.h>
 
@@ -217,6 +218,89 @@ test_nc_authkey_bad_path(void **arg)
     }
 }
 
+static void
+copy_authkeys(const char *src_path, const char *dst_path)
+{
+    FILE *src, *dst;
+    char buf[4096];
+    size_t n;
+
+    src = fopen(src_path, "r");
+    assert_non_null(src);
+    dst = fopen(dst_path, "w");
+    assert_non_null(dst);
+
+    while ((n = fread(buf, 1, sizeof buf, src))) {
+        assert_int_equal(fwrite(buf, 1, n, dst), n);
+    }
+
+    fclose(src);
+    fclose(dst);
+}
+
+static void
+connect_authkey(struct test_state *state)
+{
+    int ret, i;
+    pthread_t tids[2];
+
+    /* client */
+    ret = pthread_create(&tids[0], NULL, client_thread, state);
+    assert_int_equal(ret, 0);
+
+    /* server */
+    ret = pthread_create(&tids[1], NULL, server_thread, state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+static void
+test_nc_authkey_changed(void **arg)
+{
+    int ret, fd;
+    struct test_state *state;
+    char path[] = "/tmp/nc_authkeys_XXXXXX";
+
+    assert_non_null(arg);
+
+    state = *(struct test_state **)arg;
+
+    /* create a temporary authorized_keys file */
+    fd = mkstemp(path);
+    assert_int_not_equal(fd, -1);
+    close(fd);
+    copy_authkeys(TESTS_DIR "/data/id_ed25519.pub", path);
+
+    ret = nc_server_ssh_set_authkey_path_format(path);
+    assert_int_equal(ret, 0);
+
+    state->pubkey_path = TESTS_DIR "/data/id_ed25519.pub";
+    state->privkey_path = TESTS_DIR "/data/id_ed25519";
+
+    /* the key is authorized, the file gets cached */
+    state->expect_ok = 1;
+    connect_authkey(state);
+
+    /* the cached file is used */
+    connect_authkey(state);
+
+    /* replace the authorized key, the cached file must not be used anymore */
+    copy_authkeys(TESTS_DIR "/data/id_ecdsa256.pub", path);
+    state->expect_ok = 0;
+    connect_authkey(state);
+
+    /* the new key is authorized */
+    state->pubkey_path = TESTS_DIR "/data/id_ecdsa256.pub";
+    state->privkey_path = TESTS_DIR "/data/id_ecdsa256";
+    state->expect_ok = 1;
+    connect_authkey(state);
+
+    unlink(path);
+}
+
 static int
 setup_f(void **state)
 {
@@ -300,6 +384,7 @@ main(void)
         cmocka_unit_test_setup_teardown(test_nc_authkey_ok, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_nc_authkey_bad_key, setup_f, teardown_f),
         cmocka_unit_test_setup_teardown(test_nc_authkey_bad_path, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_authkey_changed, setup_f, teardown_f),
     };
 
     setenv("CMOCKA_TEST_ABORT", "1", 1);
@@ -0,0 +1,117 @@
+/**
+ * @file test_crl_cache.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 tests - CRL cache
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <cmocka.h>
+
+#include "session_p.h"
+#include "session_server.h"
+#include "session_wrapper.h"
+#include "tests/config.h"
+
+extern struct nc_server_opts server_opts;
+
+static int
+setup_f(void **state)
+{
+    (void)state;
+
+    return nc_server_init();
+}
+
+static int
+teardown_f(void **state)
+{
+    (void)state;
+
+    nc_server_destroy();
+    return 0;
+}
+
+static void
+test_crl_cache_file(void **state)
+{
+    char *uris[] = {"file://" TESTS_DIR "/data/crl.pem"};
+    void *crl_store;
+    uint32_t gen;
+
+    (void)state;
+
+    gen = ATOMIC_LOAD_RELAXED(server_opts.crl_cache.gen);
+
+    /* not cached yet, the first background download is waited for */
+    crl_store = nc_tls_crl_store_new_wrap();
+    assert_non_null(crl_store);
+    assert_int_equal(nc_server_crl_cache_get(uris, 1, crl_store), 0);
+    nc_tls_crl_store_destroy_wrap(crl_store);
+    assert_int_equal(server_opts.crl_cache.entry_count, 1);
+    assert_int_not_equal(ATOMIC_LOAD_RELAXED(server_opts.crl_cache.gen), gen);
+
+    /* cached, refreshed according to its nextUpdate */
+    pthread_mutex_lock(&server_opts.crl_cache.lock);
+    assert_non_null(server_opts.crl_cache.entries[0].data);
+    assert_true(server_opts.crl_cache.entries[0].refresh > time(NULL) + NC_CRL_REFRESH_INTERVAL);
+    pthread_mutex_unlock(&server_opts.crl_cache.lock);
+
+    crl_store = nc_tls_crl_store_new_wrap();
+    assert_non_null(crl_store);
+    assert_int_equal(nc_server_crl_cache_get(uris, 1, crl_store), 0);
+    nc_tls_crl_store_destroy_wrap(crl_store);
+    assert_int_equal(server_opts.crl_cache.entry_count, 1);
+}
+
+static void
+test_crl_cache_fail(void **state)
+{
+    char *uris[] = {"file://" TESTS_DIR "/data/nonexistent.crl"};
+    void *crl_store;
+
+    (void)state;
+
+    /* the first download fails, the CRL is not available so no session can be accepted */
+    crl_store = nc_tls_crl_store_new_wrap();
+    assert_non_null(crl_store);
+    assert_int_equal(nc_server_crl_cache_get(uris, 1, crl_store), 1);
+
+    /* scheduled for a retry, still not available */
+    assert_int_equal(nc_server_crl_cache_get(uris, 1, crl_store), 1);
+    nc_tls_crl_store_destroy_wrap(crl_store);
+
+    pthread_mutex_lock(&server_opts.crl_cache.lock);
+    assert_null(server_opts.crl_cache.entries[0].data);
+    assert_true(server_opts.crl_cache.entries[0].refresh <= time(NULL) + NC_CRL_RETRY_INTERVAL);
+    assert_true(server_opts.crl_cache.entries[0].refresh > time(NULL));
+    pthread_mutex_unlock(&server_opts.crl_cache.lock);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_crl_cache_file, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_crl_cache_fail, setup_f, teardown_f),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
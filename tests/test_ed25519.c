@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <cmocka.h>
 
@@ -120,6 +121,83 @@ test_nc_ed25519(void **state)
     }
 }
 
+#define DISPATCH_CLIENT_COUNT 4
+
+static int
+new_session_cb(struct nc_session *new_session, void *user_data)
+{
+    struct nc_pollsession *ps = user_data;
+
+    return nc_ps_add_session(ps, new_session);
+}
+
+static void *
+client_thread_dispatch(void *arg)
+{
+    int ret;
+    struct nc_session *session = NULL;
+
+    (void) arg;
+
+    nc_client_ssh_set_knownhosts_mode(NC_SSH_KNOWNHOSTS_SKIP);
+
+    ret = nc_client_set_schema_searchpath(MODULES_DIR);
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_ssh_set_username("test_ed25519");
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_ssh_add_keypair(TESTS_DIR "/data/id_ed25519.pub", TESTS_DIR "/data/id_ed25519");
+    assert_int_equal(ret, 0);
+
+    session = nc_connect_ssh("127.0.0.1", TEST_PORT, NULL);
+    assert_non_null(session);
+
+    nc_session_free(session, NULL);
+    return NULL;
+}
+
+static void
+test_nc_ed25519_dispatch(void **state)
+{
+    int ret, i, terminated = 0;
+    pthread_t tids[DISPATCH_CLIENT_COUNT];
+    struct nc_pollsession *ps;
+    struct nc_session *session;
+
+    (void) state;
+
+    ps = nc_ps_new();
+    assert_non_null(ps);
+
+    /* a single worker establishes all the sessions at once */
+    ret = nc_server_accept_dispatch(ctx, 1, new_session_cb, ps);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < DISPATCH_CLIENT_COUNT; i++) {
+        ret = pthread_create(&tids[i], NULL, client_thread_dispatch, NULL);
+        assert_int_equal(ret, 0);
+    }
+
+    while (terminated < DISPATCH_CLIENT_COUNT) {
+        ret = nc_ps_poll(ps, NC_PS_POLL_TIMEOUT, &session);
+        if (ret & NC_PSPOLL_NOSESSIONS) {
+            usleep(10000);
+        } else if (ret & NC_PSPOLL_SESSION_TERM) {
+            nc_ps_del_session(ps, session);
+            nc_session_free(session, NULL);
+            terminated++;
+        }
+    }
+
+    for (i = 0; i < DISPATCH_CLIENT_COUNT; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    nc_server_accept_dispatch_stop();
+    nc_ps_free(ps);
+}
+
 static int
 setup_f(void **state)
 {
@@ -201,6 +279,7 @@ main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_nc_ed25519, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_ed25519_dispatch, setup_f, teardown_f),
     };
 
     setenv("CMOCKA_TEST_ABORT", "1", 1);
@@ -31,6 +31,7 @@
 #include <cmocka.h>
 #include <libyang/libyang.h>
 
+#include <config.h>
 #include <messages_p.h>
 #include <session_client.h>
 #include <session_p.h>
@@ -357,6 +358,259 @@ test_send_recv_data_11(void **state)
     test_send_recv_data();
 }
 
+#define STREAM_ITEM_COUNT 1000
+
+int stream_fail;
+
+static int
+my_stream_clb(struct nc_session *session, struct lyd_node **subtree, const char **fragment, void *user_data)
+{
+    static char buf[64];
+    uint32_t *part = user_data;
+
+    if (*part == 0) {
+        *fragment = "<data xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\">";
+    } else if (*part == 1) {
+        lyd_new_path(NULL, session->ctx, "/ietf-netconf-acm:nacm/enable-nacm", "false", 0, subtree);
+        assert_non_null(*subtree);
+    } else if (*part < STREAM_ITEM_COUNT + 2) {
+        sprintf(buf, "<item xmlns=\"urn:test\">%u</item>", (unsigned)(*part - 2));
+        *fragment = buf;
+    } else if (*part == STREAM_ITEM_COUNT + 2) {
+        *fragment = "</data>";
+    } else {
+        /* finished */
+        return 1;
+    }
+
+    ++(*part);
+    return 0;
+}
+
+static int
+my_stream_err_clb(struct nc_session *session, struct lyd_node **subtree, const char **fragment, void *user_data)
+{
+    static char buf[64];
+    uint32_t *part = user_data;
+
+    (void)session;
+    (void)subtree;
+
+    if (*part == 0) {
+        *fragment = "<data xmlns=\"urn:ietf:params:xml:ns:netconf:base:1.0\">";
+        ++(*part);
+        return 0;
+    } else if ((stream_fail == 2) && (*part < STREAM_ITEM_COUNT + 1)) {
+        /* enough parts for some to be written */
+        sprintf(buf, "<item xmlns=\"urn:test\">%u</item>", (unsigned)(*part - 1));
+        *fragment = buf;
+        ++(*part);
+        return 0;
+    }
+
+    /* failed to produce the data */
+    return -1;
+}
+
+struct nc_server_reply *
+my_getconfig_stream_rpc_clb(struct lyd_node *rpc, struct nc_session *session)
+{
+    uint32_t *part;
+
+    assert_string_equal(rpc->schema->name, "get-config");
+    assert_ptr_equal(session, server_session);
+
+    part = calloc(1, sizeof *part);
+    assert_non_null(part);
+
+    return nc_server_reply_stream(stream_fail ? my_stream_err_clb : my_stream_clb, part, free, NC_WD_EXPLICIT);
+}
+
+static void
+test_send_recv_stream(void **state)
+{
+    int ret, i;
+    uint64_t msgid;
+    NC_MSG_TYPE msgtype;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op, *tag;
+    struct lysc_node *node;
+    struct nc_pollsession *ps;
+    char *str;
+
+    (void)state;
+
+    node = (struct lysc_node *)lys_find_path(ctx, NULL, "/ietf-netconf:get-config", 0);
+    assert_non_null(node);
+    node->priv = my_getconfig_stream_rpc_clb;
+
+    rpc = nc_rpc_getconfig(NC_DATASTORE_RUNNING, NULL, 0, 0);
+    assert_non_null(rpc);
+    ps = nc_ps_new();
+    assert_non_null(ps);
+    nc_ps_add_session(ps, server_session);
+
+    /* the same streamed reply with both framings */
+    for (i = 0; i < 2; ++i) {
+        server_session->version = i ? NC_VERSION_11 : NC_VERSION_10;
+        client_session->version = i ? NC_VERSION_11 : NC_VERSION_10;
+
+        msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+        assert_int_equal(msgtype, NC_MSG_RPC);
+
+        ret = nc_ps_poll(ps, 0, NULL);
+        assert_int_equal(ret, NC_PSPOLL_RPC);
+
+        msgtype = nc_recv_reply(client_session, rpc, msgid, 1000, &envp, &op);
+        assert_int_equal(msgtype, NC_MSG_REPLY);
+        assert_non_null(envp);
+        lyd_free_tree(envp);
+        assert_non_null(op);
+
+        /* all the parts received */
+        lyd_print_mem(&str, op, LYD_XML, LYD_PRINT_SHRINK);
+        assert_non_null(strstr(str, "<enable-nacm>false</enable-nacm>"));
+        assert_non_null(strstr(str, "<item xmlns=\"urn:test\">0</item>"));
+        assert_non_null(strstr(str, "<item xmlns=\"urn:test\">999</item>"));
+        free(str);
+        lyd_free_tree(op);
+    }
+
+    /* producing the reply fails before any of it was written, an error reply is sent instead */
+    stream_fail = 1;
+    msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+
+    ret = nc_ps_poll(ps, 0, NULL);
+    assert_int_equal(ret, NC_PSPOLL_RPC);
+    assert_int_equal(server_session->status, NC_STATUS_RUNNING);
+
+    msgtype = nc_recv_reply(client_session, rpc, msgid, 1000, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_REPLY);
+    assert_string_equal(LYD_NAME(lyd_child(envp)), "rpc-error");
+    assert_null(lyd_child(envp)->next);
+    lyd_find_sibling_opaq_next(lyd_child(lyd_child(envp)), "error-tag", &tag);
+    assert_non_null(tag);
+    assert_string_equal(((struct lyd_node_opaq *)tag)->value, "operation-failed");
+    lyd_free_tree(envp);
+    assert_null(op);
+
+    /* producing the reply fails after it was partially written */
+    stream_fail = 2;
+    msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+
+    ret = nc_ps_poll(ps, 0, NULL);
+    assert_true(ret & NC_PSPOLL_ERROR);
+    assert_int_equal(server_session->status, NC_STATUS_INVALID);
+    assert_int_equal(server_session->term_reason, NC_SESSION_TERM_OTHER);
+    stream_fail = 0;
+
+    nc_ps_free(ps);
+    nc_rpc_free(rpc);
+    node->priv = my_getconfig_rpc_clb;
+}
+
+struct reply_stream_arg {
+    char *data;
+    size_t len;
+    uint32_t calls;
+    uint32_t stop;
+};
+
+static int
+my_reply_stream_clb(const char *data, size_t len, void *user_data)
+{
+    struct reply_stream_arg *arg = user_data;
+
+    arg->data = realloc(arg->data, arg->len + len + 1);
+    assert_non_null(arg->data);
+    memcpy(arg->data + arg->len, data, len);
+    arg->len += len;
+    arg->data[arg->len] = '\0';
+
+    ++arg->calls;
+    return arg->stop && (arg->calls == arg->stop);
+}
+
+static void
+test_recv_reply_stream(void **state)
+{
+    int ret, i;
+    uint64_t msgid;
+    NC_MSG_TYPE msgtype;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op;
+    struct lysc_node *node;
+    struct nc_pollsession *ps;
+    struct reply_stream_arg arg = {0};
+
+    (void)state;
+
+    node = (struct lysc_node *)lys_find_path(ctx, NULL, "/ietf-netconf:get-config", 0);
+    assert_non_null(node);
+    node->priv = my_getconfig_stream_rpc_clb;
+
+    rpc = nc_rpc_getconfig(NC_DATASTORE_RUNNING, NULL, 0, 0);
+    assert_non_null(rpc);
+    ps = nc_ps_new();
+    assert_non_null(ps);
+    nc_ps_add_session(ps, server_session);
+
+    /* the reply received incrementally with both framings */
+    for (i = 0; i < 2; ++i) {
+        server_session->version = i ? NC_VERSION_11 : NC_VERSION_10;
+        client_session->version = i ? NC_VERSION_11 : NC_VERSION_10;
+
+        msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+        assert_int_equal(msgtype, NC_MSG_RPC);
+
+        ret = nc_ps_poll(ps, 0, NULL);
+        assert_int_equal(ret, NC_PSPOLL_RPC);
+
+        msgtype = nc_recv_reply_stream(client_session, msgid, 1000, my_reply_stream_clb, &arg);
+        assert_int_equal(msgtype, NC_MSG_REPLY);
+
+        /* the whole reply received in several parts */
+        assert_true(arg.calls > 1);
+        assert_non_null(strstr(arg.data, "<rpc-reply"));
+        assert_non_null(strstr(arg.data, "<item xmlns=\"urn:test\">0</item>"));
+        assert_non_null(strstr(arg.data, "<item xmlns=\"urn:test\">999</item>"));
+        assert_non_null(strstr(arg.data, "</rpc-reply>"));
+        free(arg.data);
+        memset(&arg, 0, sizeof arg);
+    }
+
+    /* receiving stopped by the callback, the rest of the reply is discarded */
+    arg.stop = 1;
+    msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+
+    ret = nc_ps_poll(ps, 0, NULL);
+    assert_int_equal(ret, NC_PSPOLL_RPC);
+
+    msgtype = nc_recv_reply_stream(client_session, msgid, 1000, my_reply_stream_clb, &arg);
+    assert_int_equal(msgtype, NC_MSG_ERROR);
+    assert_int_equal(arg.calls, 1);
+    free(arg.data);
+
+    /* the session can still be used */
+    node->priv = my_getconfig_rpc_clb;
+    msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+
+    ret = nc_ps_poll(ps, 0, NULL);
+    assert_int_equal(ret, NC_PSPOLL_RPC);
+
+    msgtype = nc_recv_reply(client_session, rpc, msgid, 1000, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_REPLY);
+    lyd_free_tree(envp);
+    lyd_free_tree(op);
+
+    nc_ps_free(ps);
+    nc_rpc_free(rpc);
+}
+
 static void *
 server_send_notif_thread(void *arg)
 {
@@ -502,6 +756,249 @@ test_send_recv_notif_11(void **state)
     test_send_recv_notif();
 }
 
+static void
+test_send_recv_pipelining(void **state)
+{
+    (void)state;
+    int ret;
+    uint64_t msgid1, msgid2;
+    NC_MSG_TYPE msgtype;
+    struct nc_rpc *rpc1, *rpc2;
+    struct lyd_node *envp, *op;
+    struct nc_pollsession *ps;
+
+    server_session->version = NC_VERSION_11;
+    client_session->version = NC_VERSION_11;
+    assert_int_equal(nc_client_session_set_pipelining(client_session, 1), 0);
+
+    /* client RPCs sent one after another */
+    rpc1 = nc_rpc_get(NULL, 0, 0);
+    assert_non_null(rpc1);
+    rpc2 = nc_rpc_getconfig(NC_DATASTORE_RUNNING, NULL, 0, 0);
+    assert_non_null(rpc2);
+
+    msgtype = nc_send_rpc(client_session, rpc1, 0, &msgid1);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+    msgtype = nc_send_rpc(client_session, rpc2, 0, &msgid2);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+
+    /* server replies to both */
+    ps = nc_ps_new();
+    assert_non_null(ps);
+    nc_ps_add_session(ps, server_session);
+
+    ret = nc_ps_poll(ps, 0, NULL);
+    assert_int_equal(ret, NC_PSPOLL_RPC);
+    ret = nc_ps_poll(ps, 0, NULL);
+    assert_int_equal(ret, NC_PSPOLL_RPC);
+
+    nc_ps_free(ps);
+
+    /* client receives the second reply first, the first one is kept */
+    msgtype = nc_recv_reply(client_session, rpc2, msgid2, 0, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_REPLY);
+    assert_non_null(op);
+    assert_string_equal(LYD_NAME(lyd_child(op)), "data");
+    lyd_free_tree(envp);
+    lyd_free_tree(op);
+    assert_non_null(client_session->opts.client.replies);
+
+    msgtype = nc_recv_reply(client_session, rpc1, msgid1, 0, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_REPLY);
+    assert_null(op);
+    assert_string_equal(LYD_NAME(lyd_child(envp)), "ok");
+    lyd_free_tree(envp);
+
+    /* nothing else to receive */
+    msgtype = nc_recv_reply(client_session, rpc1, msgid1, 0, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_WOULDBLOCK);
+
+    nc_rpc_free(rpc1);
+    nc_rpc_free(rpc2);
+    assert_int_equal(nc_client_session_set_pipelining(client_session, 0), 0);
+    assert_null(client_session->opts.client.replies);
+}
+
+static void
+test_send_recv_pipelining_many(void **state)
+{
+    (void)state;
+    int i, len;
+    uint64_t msgids[40];
+    char reply[256], buf[256 + 16];
+    NC_MSG_TYPE msgtype;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op;
+
+    server_session->version = NC_VERSION_11;
+    client_session->version = NC_VERSION_11;
+    assert_int_equal(nc_client_session_set_pipelining(client_session, 1), 0);
+
+    rpc = nc_rpc_lock(NC_DATASTORE_RUNNING);
+    assert_non_null(rpc);
+    for (i = 0; i < 40; ++i) {
+        msgtype = nc_send_rpc(client_session, rpc, 0, &msgids[i]);
+        assert_int_equal(msgtype, NC_MSG_RPC);
+    }
+
+    /* replies with a prefixed element name written in the reverse order */
+    for (i = 39; i >= 0; --i) {
+        len = sprintf(reply, "<nc:rpc-reply xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" "
+                "message-id=\"%" PRIu64 "\"><nc:ok/></nc:rpc-reply>", msgids[i]);
+        len = sprintf(buf, "\n#%d\n%s\n##\n", len, reply);
+        assert_int_equal(write(server_session->ti.fd.out, buf, len), len);
+    }
+
+    /* all the other replies are kept while receiving the first one, then taken out of the table */
+    for (i = 0; i < 40; ++i) {
+        msgtype = nc_recv_reply(client_session, rpc, msgids[i], 1000, &envp, &op);
+        assert_int_equal(msgtype, NC_MSG_REPLY);
+        assert_null(op);
+        assert_string_equal(LYD_NAME(lyd_child(envp)), "ok");
+        lyd_free_tree(envp);
+    }
+    assert_int_equal(client_session->opts.client.replies_count, 0);
+
+    nc_rpc_free(rpc);
+    assert_int_equal(nc_client_session_set_pipelining(client_session, 0), 0);
+}
+
+static void
+test_send_recv_notif_msg(void **state)
+{
+    struct nc_session *sessions[1];
+    struct lyd_node *notif_tree, *envp, *op;
+    struct nc_server_notif *notif;
+    NC_MSG_TYPE results[1], msgtype;
+    struct timespec ts;
+    char *buf;
+    int i;
+
+    (void)state;
+
+    lyd_new_path(NULL, ctx, "/nc-notifications:notificationComplete", NULL, 0, &notif_tree);
+    assert_non_null(notif_tree);
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ly_time_ts2str(&ts, &buf);
+    notif = nc_server_notif_new(notif_tree, buf, NC_PARAMTYPE_FREE);
+    assert_non_null(notif);
+
+    sessions[0] = server_session;
+    nc_session_inc_notif_status(server_session);
+
+    /* the same printed notification with both framings */
+    for (i = 0; i < 2; ++i) {
+        server_session->version = i ? NC_VERSION_11 : NC_VERSION_10;
+        client_session->version = i ? NC_VERSION_11 : NC_VERSION_10;
+
+        assert_int_equal(nc_server_notif_send_multi(sessions, 1, notif, 100, results), 1);
+        assert_int_equal(results[0], NC_MSG_NOTIF);
+
+        msgtype = nc_recv_notif(client_session, 1000, &envp, &op);
+        assert_int_equal(msgtype, NC_MSG_NOTIF);
+        assert_string_equal(op->schema->name, "notificationComplete");
+        lyd_free_tree(envp);
+        lyd_free_tree(op);
+    }
+
+    nc_session_dec_notif_status(server_session);
+    nc_server_notif_free(notif);
+}
+
+static struct nc_server_notif *
+test_new_notif(void)
+{
+    struct lyd_node *notif_tree;
+    struct nc_server_notif *notif;
+    struct timespec ts;
+    char *buf;
+
+    lyd_new_path(NULL, ctx, "/nc-notifications:notificationComplete", NULL, 0, &notif_tree);
+    assert_non_null(notif_tree);
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ly_time_ts2str(&ts, &buf);
+    notif = nc_server_notif_new(notif_tree, buf, NC_PARAMTYPE_FREE);
+    assert_non_null(notif);
+
+    return notif;
+}
+
+static void
+test_notif_queue(void **state)
+{
+    struct nc_server_notif *notif;
+    struct nc_pollsession *ps;
+    struct lyd_node *envp, *op;
+    uint32_t depth;
+    uint64_t drops;
+    int i;
+
+    (void)state;
+
+    notif = test_new_notif();
+    nc_session_inc_notif_status(server_session);
+    assert_int_equal(nc_session_get_notif_queue_stats(server_session, &depth, &drops), -1);
+
+    /* full queue with a blocked session waits for the timeout */
+    assert_int_equal(nc_session_set_notif_queue(server_session, 2, NC_NTF_QUEUE_BLOCK, NC_SESSION_TERM_OTHER), 0);
+    pthread_mutex_lock(server_session->io_lock);
+    assert_int_equal(nc_server_notif_send(server_session, notif, 0), NC_MSG_NOTIF);
+    assert_int_equal(nc_server_notif_send(server_session, notif, 0), NC_MSG_NOTIF);
+    assert_int_equal(nc_server_notif_send(server_session, notif, 10), NC_MSG_WOULDBLOCK);
+    assert_int_equal(nc_session_get_notif_queue_stats(server_session, &depth, &drops), 0);
+    assert_int_equal(depth, 2);
+    assert_int_equal(drops, 0);
+    pthread_mutex_unlock(server_session->io_lock);
+
+    /* written by the poll loop */
+    ps = nc_ps_new();
+    assert_non_null(ps);
+    assert_int_equal(nc_ps_add_session(ps, server_session), 0);
+    assert_int_equal(nc_ps_poll(ps, 0, NULL), NC_PSPOLL_TIMEOUT);
+    assert_int_equal(nc_session_get_notif_queue_stats(server_session, &depth, NULL), 0);
+    assert_int_equal(depth, 0);
+    nc_ps_free(ps);
+
+    for (i = 0; i < 2; ++i) {
+        assert_int_equal(nc_recv_notif(client_session, 1000, &envp, &op), NC_MSG_NOTIF);
+        lyd_free_tree(envp);
+        lyd_free_tree(op);
+    }
+
+    /* the oldest notification is dropped */
+    assert_int_equal(nc_session_set_notif_queue(server_session, 2, NC_NTF_QUEUE_DROP_OLDEST, NC_SESSION_TERM_OTHER), 0);
+    pthread_mutex_lock(server_session->io_lock);
+    for (i = 0; i < 3; ++i) {
+        assert_int_equal(nc_server_notif_send(server_session, notif, 0), NC_MSG_NOTIF);
+    }
+    assert_int_equal(nc_session_get_notif_queue_stats(server_session, &depth, &drops), 0);
+    assert_int_equal(depth, 2);
+    assert_int_equal(drops, 1);
+    pthread_mutex_unlock(server_session->io_lock);
+
+    /* queued notifications written with the next one */
+    assert_int_equal(nc_server_notif_send(server_session, notif, 0), NC_MSG_NOTIF);
+    assert_int_equal(nc_session_get_notif_queue_stats(server_session, &depth, NULL), 0);
+    assert_int_equal(depth, 0);
+    for (i = 0; i < 3; ++i) {
+        assert_int_equal(nc_recv_notif(client_session, 1000, &envp, &op), NC_MSG_NOTIF);
+        lyd_free_tree(envp);
+        lyd_free_tree(op);
+    }
+
+    /* the session is terminated */
+    assert_int_equal(nc_session_set_notif_queue(server_session, 1, NC_NTF_QUEUE_TERMINATE, NC_SESSION_TERM_TIMEOUT), 0);
+    pthread_mutex_lock(server_session->io_lock);
+    assert_int_equal(nc_server_notif_send(server_session, notif, 0), NC_MSG_NOTIF);
+    assert_int_equal(nc_server_notif_send(server_session, notif, 0), NC_MSG_ERROR);
+    pthread_mutex_unlock(server_session->io_lock);
+    assert_int_equal(server_session->status, NC_STATUS_INVALID);
+    assert_int_equal(server_session->term_reason, NC_SESSION_TERM_TIMEOUT);
+
+    nc_session_dec_notif_status(server_session);
+    nc_server_notif_free(notif);
+}
+
 static void
 test_send_recv_malformed_10(void **state)
 {
@@ -551,6 +1048,263 @@ test_send_recv_malformed_10(void **state)
     assert_null(op);
 }
 
+#ifdef HAVE_EPOLL
+
+static void
+test_send_recv_epoll(void **state)
+{
+    int ret;
+    uint64_t msgid;
+    NC_MSG_TYPE msgtype;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op;
+    struct nc_pollsession *ps;
+
+    (void)state;
+
+    server_session->version = NC_VERSION_11;
+    client_session->version = NC_VERSION_11;
+
+    ps = nc_ps_new_epoll();
+    assert_non_null(ps);
+    nc_ps_add_session(ps, server_session);
+
+    /* no data yet */
+    ret = nc_ps_poll(ps, 0, NULL);
+    assert_int_equal(ret, NC_PSPOLL_TIMEOUT);
+
+    /* client RPCs */
+    rpc = nc_rpc_get(NULL, 0, 0);
+    assert_non_null(rpc);
+
+    msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+    msgtype = nc_send_rpc(client_session, rpc, 0, &msgid);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+
+    /* server RPCs, the second one may already be buffered */
+    ret = nc_ps_poll(ps, 1000, NULL);
+    assert_int_equal(ret, NC_PSPOLL_RPC);
+    ret = nc_ps_poll(ps, 1000, NULL);
+    assert_int_equal(ret, NC_PSPOLL_RPC);
+
+    /* no more data */
+    ret = nc_ps_poll(ps, 10, NULL);
+    assert_int_equal(ret, NC_PSPOLL_TIMEOUT);
+
+    /* server finished */
+    nc_ps_del_session(ps, server_session);
+    nc_ps_free(ps);
+
+    /* client replies */
+    msgtype = nc_recv_reply(client_session, rpc, msgid - 1, 0, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_REPLY);
+    assert_string_equal(LYD_NAME(lyd_child(envp)), "ok");
+    lyd_free_tree(envp);
+    msgtype = nc_recv_reply(client_session, rpc, msgid, 0, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_REPLY);
+    assert_string_equal(LYD_NAME(lyd_child(envp)), "ok");
+    lyd_free_tree(envp);
+
+    nc_rpc_free(rpc);
+}
+
+#define EPOLL_SESSION_COUNT 4
+#define EPOLL_THREAD_COUNT (NC_PS_QUEUE_SIZE + 2)
+
+struct nc_pollsession *epoll_ps;
+int epoll_rpc_count;
+
+static void *
+thread_epoll_poll(void *arg)
+{
+    int ret;
+
+    (void)arg;
+
+    pthread_mutex_lock(&state_lock);
+    while (epoll_rpc_count < 2 * EPOLL_SESSION_COUNT) {
+        pthread_mutex_unlock(&state_lock);
+        ret = nc_ps_poll(epoll_ps, 100, NULL);
+        pthread_mutex_lock(&state_lock);
+
+        if (ret & NC_PSPOLL_RPC) {
+            ++epoll_rpc_count;
+        } else {
+            assert_int_equal(ret, NC_PSPOLL_TIMEOUT);
+        }
+    }
+    pthread_mutex_unlock(&state_lock);
+
+    return NULL;
+}
+
+static void
+test_send_recv_epoll_threads(void **state)
+{
+    int i, ret, sock[2];
+    pthread_t tids[EPOLL_THREAD_COUNT];
+    struct nc_session *servers[EPOLL_SESSION_COUNT], *clients[EPOLL_SESSION_COUNT];
+    uint64_t msgid;
+    NC_MSG_TYPE msgtype;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op;
+
+    (void)state;
+
+    epoll_ps = nc_ps_new_epoll();
+    assert_non_null(epoll_ps);
+    epoll_rpc_count = 0;
+
+    rpc = nc_rpc_discard();
+    assert_non_null(rpc);
+
+    for (i = 0; i < EPOLL_SESSION_COUNT; ++i) {
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sock);
+
+        servers[i] = test_new_session(NC_SERVER);
+        servers[i]->status = NC_STATUS_RUNNING;
+        servers[i]->id = i + 1;
+        servers[i]->version = NC_VERSION_11;
+        servers[i]->ti_type = NC_TI_FD;
+        servers[i]->ti.fd.in = sock[0];
+        servers[i]->ti.fd.out = sock[0];
+        servers[i]->ctx = ctx;
+        servers[i]->flags = NC_SESSION_SHAREDCTX;
+        assert_int_equal(nc_ps_add_session(epoll_ps, servers[i]), 0);
+
+        clients[i] = test_new_session(NC_CLIENT);
+        clients[i]->status = NC_STATUS_RUNNING;
+        clients[i]->id = i + 1;
+        clients[i]->version = NC_VERSION_11;
+        clients[i]->ti_type = NC_TI_FD;
+        clients[i]->ti.fd.in = sock[1];
+        clients[i]->ti.fd.out = sock[1];
+        clients[i]->ctx = ctx;
+        clients[i]->flags = NC_SESSION_SHAREDCTX;
+        clients[i]->opts.client.msgid = 50;
+    }
+
+    /* more threads than a queue-based pollsession allows */
+    for (i = 0; i < EPOLL_THREAD_COUNT; ++i) {
+        ret = pthread_create(&tids[i], NULL, thread_epoll_poll, NULL);
+        assert_int_equal(ret, 0);
+    }
+
+    /* client RPCs */
+    for (i = 0; i < 2 * EPOLL_SESSION_COUNT; ++i) {
+        msgtype = nc_send_rpc(clients[i % EPOLL_SESSION_COUNT], rpc, 0, &msgid);
+        assert_int_equal(msgtype, NC_MSG_RPC);
+    }
+
+    for (i = 0; i < EPOLL_THREAD_COUNT; ++i) {
+        pthread_join(tids[i], NULL);
+    }
+    assert_int_equal(epoll_rpc_count, 2 * EPOLL_SESSION_COUNT);
+
+    /* client replies */
+    for (i = 0; i < 2 * EPOLL_SESSION_COUNT; ++i) {
+        msgtype = nc_recv_reply(clients[i % EPOLL_SESSION_COUNT], rpc, 51 + i / EPOLL_SESSION_COUNT, 0, &envp, &op);
+        assert_int_equal(msgtype, NC_MSG_REPLY);
+        assert_string_equal(LYD_NAME(lyd_child(envp)), "rpc-error");
+        lyd_free_tree(envp);
+        assert_null(op);
+    }
+    nc_rpc_free(rpc);
+
+    for (i = 0; i < EPOLL_SESSION_COUNT; ++i) {
+        nc_ps_del_session(epoll_ps, servers[i]);
+        close(servers[i]->ti.fd.in);
+        servers[i]->ti.fd.in = -1;
+        nc_session_free(servers[i], NULL);
+        close(clients[i]->ti.fd.in);
+        clients[i]->ti.fd.in = -1;
+        nc_session_free(clients[i], NULL);
+    }
+    nc_ps_free(epoll_ps);
+}
+
+int epoll_term_count;
+
+static void *
+thread_epoll_term(void *arg)
+{
+    int ret;
+    struct nc_session *session;
+
+    (void)arg;
+
+    pthread_mutex_lock(&state_lock);
+    while (epoll_term_count < EPOLL_SESSION_COUNT) {
+        pthread_mutex_unlock(&state_lock);
+        ret = nc_ps_poll(epoll_ps, 100, &session);
+        pthread_mutex_lock(&state_lock);
+
+        if (ret & NC_PSPOLL_SESSION_TERM) {
+            /* reported only once, no other thread may work with the session once removed */
+            assert_int_equal(nc_ps_del_session(epoll_ps, session), 0);
+            close(session->ti.fd.in);
+            session->ti.fd.in = -1;
+            nc_session_free(session, NULL);
+            ++epoll_term_count;
+        } else {
+            assert_int_equal(ret, NC_PSPOLL_TIMEOUT);
+        }
+    }
+    pthread_mutex_unlock(&state_lock);
+
+    return NULL;
+}
+
+static void
+test_epoll_threads_term(void **state)
+{
+    int i, ret, sock[2], clients[EPOLL_SESSION_COUNT];
+    pthread_t tids[EPOLL_THREAD_COUNT];
+    struct nc_session *server;
+
+    (void)state;
+
+    epoll_ps = nc_ps_new_epoll();
+    assert_non_null(epoll_ps);
+    epoll_term_count = 0;
+
+    for (i = 0; i < EPOLL_SESSION_COUNT; ++i) {
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sock);
+
+        server = test_new_session(NC_SERVER);
+        server->status = NC_STATUS_RUNNING;
+        server->id = i + 1;
+        server->version = NC_VERSION_11;
+        server->ti_type = NC_TI_FD;
+        server->ti.fd.in = sock[0];
+        server->ti.fd.out = sock[0];
+        server->ctx = ctx;
+        server->flags = NC_SESSION_SHAREDCTX;
+        assert_int_equal(nc_ps_add_session(epoll_ps, server), 0);
+        clients[i] = sock[1];
+    }
+
+    for (i = 0; i < EPOLL_THREAD_COUNT; ++i) {
+        ret = pthread_create(&tids[i], NULL, thread_epoll_term, NULL);
+        assert_int_equal(ret, 0);
+    }
+
+    /* the clients disconnect, the sessions are terminated and freed while all the threads are polling */
+    for (i = 0; i < EPOLL_SESSION_COUNT; ++i) {
+        close(clients[i]);
+    }
+
+    for (i = 0; i < EPOLL_THREAD_COUNT; ++i) {
+        pthread_join(tids[i], NULL);
+    }
+    assert_int_equal(epoll_term_count, EPOLL_SESSION_COUNT);
+
+    nc_ps_free(epoll_ps);
+}
+
+#endif
+
 int
 main(void)
 {
@@ -599,7 +1353,18 @@ main(void)
         cmocka_unit_test_setup_teardown(test_send_recv_ok_11, setup_sessions, teardown_sessions),
         cmocka_unit_test_setup_teardown(test_send_recv_error_11, setup_sessions, teardown_sessions),
         cmocka_unit_test_setup_teardown(test_send_recv_data_11, setup_sessions, teardown_sessions),
+        cmocka_unit_test_setup_teardown(test_send_recv_stream, setup_sessions, teardown_sessions),
+        cmocka_unit_test_setup_teardown(test_recv_reply_stream, setup_sessions, teardown_sessions),
         cmocka_unit_test_setup_teardown(test_send_recv_notif_11, setup_sessions, teardown_sessions),
+        cmocka_unit_test_setup_teardown(test_send_recv_pipelining, setup_sessions, teardown_sessions),
+        cmocka_unit_test_setup_teardown(test_send_recv_pipelining_many, setup_sessions, teardown_sessions),
+        cmocka_unit_test_setup_teardown(test_send_recv_notif_msg, setup_sessions, teardown_sessions),
+        cmocka_unit_test_setup_teardown(test_notif_queue, setup_sessions, teardown_sessions),
+#ifdef HAVE_EPOLL
+        cmocka_unit_test_setup_teardown(test_send_recv_epoll, setup_sessions, teardown_sessions),
+        cmocka_unit_test(test_send_recv_epoll_threads),
+        cmocka_unit_test(test_epoll_threads_term),
+#endif
     };
 
     ret = cmocka_run_group_tests(comm, NULL, NULL);
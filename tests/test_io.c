@@ -34,6 +34,8 @@
 #include <session_p.h>
 #include "tests/config.h"
 
+#define TINY_CHUNK_COUNT 4096
+
 struct wr {
     struct nc_session *session;
     struct nc_rpc *rpc;
@@ -174,6 +176,154 @@ test_write_rpc_11_bad(void **state)
     return test_write_rpc_bad(state);
 }
 
+static void
+test_write_rpc_11_framing(void **state)
+{
+    struct wr *w = (struct wr *)*state;
+    uint64_t msgid;
+    NC_MSG_TYPE type;
+    char buf[1024], *body;
+    ssize_t len;
+    unsigned long chunk_len;
+
+    w->session->side = NC_CLIENT;
+    w->session->version = NC_VERSION_11;
+
+    type = nc_send_rpc(w->session, w->rpc, 1000, &msgid);
+    assert_int_equal(type, NC_MSG_RPC);
+
+    /* a single chunk followed by the end of chunks */
+    len = read(w->session->ti.fd.in, buf, sizeof buf - 1);
+    assert_true(len > 0);
+    buf[len] = '\0';
+    assert_memory_equal(buf, "\n#", 2);
+    chunk_len = strtoul(buf + 2, &body, 10);
+    assert_int_equal(body[0], '\n');
+    ++body;
+    assert_ptr_equal(body + chunk_len + 4, buf + len);
+    assert_string_equal(body + chunk_len, "\n##\n");
+    assert_memory_equal(body, "<rpc ", 5);
+}
+
+static void
+test_read_msg_11(void **state)
+{
+    struct wr *w = (struct wr *)*state;
+    struct ly_in *msg;
+    const char *first = "\n#4\n<rpc\n#1\n/\n#1\n>\n##\n\n#6\n<rp";
+    const char *second = "c/>\n##\n";
+
+    w->session->side = NC_CLIENT;
+    w->session->version = NC_VERSION_11;
+
+    /* whole first message and a part of the second one written at once */
+    assert_int_equal(write(w->session->ti.fd.out, first, strlen(first)), strlen(first));
+    assert_int_equal(nc_read_msg_io(w->session, 1000, &msg, 0), 1);
+    assert_string_equal(ly_in_memory(msg, NULL), "<rpc/>");
+    ly_in_free(msg, 1);
+
+    /* the rest of the second message, the beginning must have been kept */
+    assert_int_equal(write(w->session->ti.fd.out, second, strlen(second)), strlen(second));
+    assert_int_equal(nc_read_msg_io(w->session, 1000, &msg, 0), 1);
+    assert_string_equal(ly_in_memory(msg, NULL), "<rpc/>");
+    ly_in_free(msg, 1);
+}
+
+static void
+test_read_msg_11_bad(void **state)
+{
+    struct wr *w = (struct wr *)*state;
+    struct ly_in *msg;
+    const char *data = "\n#04\n<rpc\n##\n";
+
+    w->session->side = NC_CLIENT;
+    w->session->version = NC_VERSION_11;
+
+    /* chunk-size with a leading zero */
+    assert_int_equal(write(w->session->ti.fd.out, data, strlen(data)), strlen(data));
+    assert_int_equal(nc_read_msg_io(w->session, 1000, &msg, 0), -2);
+    assert_null(msg);
+}
+
+static void
+test_read_msg_11_tiny_chunks(void **state)
+{
+    struct wr *w = (struct wr *)*state;
+    struct ly_in *msg;
+    char data[TINY_CHUNK_COUNT * 5 + 5];
+    uint32_t i;
+    size_t len = 0;
+
+    w->session->side = NC_SERVER;
+    w->session->version = NC_VERSION_11;
+
+    /* a single message made of single-byte chunks */
+    for (i = 0; i < TINY_CHUNK_COUNT; ++i) {
+        memcpy(data + len, "\n#1\nx", 5);
+        len += 5;
+    }
+    memcpy(data + len, "\n##\n", 4);
+    len += 4;
+
+    assert_int_equal(write(w->session->ti.fd.out, data, len), len);
+    assert_int_equal(nc_read_msg_io(w->session, 1000, &msg, 0), 1);
+    assert_int_equal(strlen(ly_in_memory(msg, NULL)), TINY_CHUNK_COUNT);
+    ly_in_free(msg, 1);
+
+    /* the message buffer grows geometrically, 2^13 bytes are enough for 2^12 chunks and the terminating null byte */
+    assert_int_equal(ATOMIC_LOAD_RELAXED(w->session->opts.server.stats.in_chunked_msgs), 1);
+    assert_true(ATOMIC_LOAD_RELAXED(w->session->opts.server.stats.in_chunked_msg_allocs) <= 13);
+}
+
+static void
+test_read_msg_10(void **state)
+{
+    struct wr *w = (struct wr *)*state;
+    struct ly_in *msg;
+    const char *data = "<rpc/>]]>]]><hello/>]]>]]>";
+
+    w->session->side = NC_CLIENT;
+    w->session->version = NC_VERSION_10;
+
+    /* two messages written at once */
+    assert_int_equal(write(w->session->ti.fd.out, data, strlen(data)), strlen(data));
+    assert_int_equal(nc_read_msg_io(w->session, 1000, &msg, 0), 1);
+    assert_string_equal(ly_in_memory(msg, NULL), "<rpc/>");
+    ly_in_free(msg, 1);
+
+    assert_int_equal(nc_read_msg_io(w->session, 1000, &msg, 0), 1);
+    assert_string_equal(ly_in_memory(msg, NULL), "<hello/>");
+    ly_in_free(msg, 1);
+}
+
+static void
+test_xml_escape(void **state)
+{
+    (void) state; /* unused */
+    const char *src = "<data>long enough text to be scanned in blocks & some more</data>&&>";
+    const char *exp = "&lt;data&gt;long enough text to be scanned in blocks &amp; some more&lt;/data&gt;&amp;&amp;&gt;";
+    char out[256];
+    uint32_t src_used, out_len, dst_size;
+
+    /* whole output at once */
+    src_used = 0;
+    out_len = nc_xml_escape(src, strlen(src), &src_used, out, sizeof out);
+    assert_int_equal(src_used, strlen(src));
+    assert_int_equal(out_len, strlen(exp));
+    assert_memory_equal(out, exp, out_len);
+
+    /* continued in small buffers, an escape sequence is never split */
+    for (dst_size = 5; dst_size < 40; ++dst_size) {
+        src_used = 0;
+        out_len = 0;
+        while (src_used < strlen(src)) {
+            out_len += nc_xml_escape(src, strlen(src), &src_used, out + out_len, dst_size);
+        }
+        assert_int_equal(out_len, strlen(exp));
+        assert_memory_equal(out, exp, out_len);
+    }
+}
+
 int
 main(void)
 {
@@ -181,7 +331,13 @@ main(void)
         cmocka_unit_test_setup_teardown(test_write_rpc_10, setup_write, teardown_write),
         cmocka_unit_test_setup_teardown(test_write_rpc_10_bad, setup_write, teardown_write),
         cmocka_unit_test_setup_teardown(test_write_rpc_11, setup_write, teardown_write),
-        cmocka_unit_test_setup_teardown(test_write_rpc_11_bad, setup_write, teardown_write)
+        cmocka_unit_test_setup_teardown(test_write_rpc_11_bad, setup_write, teardown_write),
+        cmocka_unit_test_setup_teardown(test_write_rpc_11_framing, setup_write, teardown_write),
+        cmocka_unit_test_setup_teardown(test_read_msg_10, setup_write, teardown_write),
+        cmocka_unit_test_setup_teardown(test_read_msg_11, setup_write, teardown_write),
+        cmocka_unit_test_setup_teardown(test_read_msg_11_bad, setup_write, teardown_write),
+        cmocka_unit_test_setup_teardown(test_read_msg_11_tiny_chunks, setup_write, teardown_write),
+        cmocka_unit_test(test_xml_escape)
     };
 
     return cmocka_run_group_tests(io, NULL, NULL);
@@ -0,0 +1,223 @@
+/**
+ * @file test_reuseport.c
+ * @author agent <agent@local>
+ * @brief libnetconf2 tests - accepting on per-thread SO_REUSEPORT listening sockets
+ *
+ * @copyright
+ * Copyright (c) 2026 agent
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <cmocka.h>
+
+#include "tests/config.h"
+
+#define NC_PS_POLL_TIMEOUT 2000
+
+#define CLIENT_COUNT 4
+#define REUSEPORT_THREAD_COUNT 2
+
+struct ly_ctx *ctx;
+
+struct test_state {
+    struct nc_pollsession *ps;
+    pthread_mutex_t lock;
+    int accepted;
+};
+
+static void *
+client_thread(void *arg)
+{
+    int ret;
+    struct nc_session *session = NULL;
+
+    (void) arg;
+
+    nc_client_ssh_set_knownhosts_mode(NC_SSH_KNOWNHOSTS_SKIP);
+
+    ret = nc_client_set_schema_searchpath(MODULES_DIR);
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_ssh_set_username("test_reuseport");
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_ssh_add_keypair(TESTS_DIR "/data/id_ed25519.pub", TESTS_DIR "/data/id_ed25519");
+    assert_int_equal(ret, 0);
+
+    session = nc_connect_ssh("127.0.0.1", TEST_PORT, NULL);
+    assert_non_null(session);
+
+    nc_session_free(session, NULL);
+    return NULL;
+}
+
+static void *
+server_thread(void *arg)
+{
+    int ret, done = 0;
+    NC_MSG_TYPE msgtype;
+    struct nc_session *session;
+    struct test_state *test_state = arg;
+
+    /* accept on the own listening socket until all the clients are accepted */
+    while (!done) {
+        msgtype = nc_accept(100, ctx, &session);
+        assert_int_not_equal(msgtype, NC_MSG_ERROR);
+
+        pthread_mutex_lock(&test_state->lock);
+        if (msgtype == NC_MSG_HELLO) {
+            ret = nc_ps_add_session(test_state->ps, session);
+            assert_int_equal(ret, 0);
+            test_state->accepted++;
+        }
+        done = (test_state->accepted == CLIENT_COUNT);
+        pthread_mutex_unlock(&test_state->lock);
+    }
+
+    return NULL;
+}
+
+static void
+reuseport_accept(struct test_state *test_state, int thread_count)
+{
+    int ret, i, terminated = 0;
+    pthread_t tids[CLIENT_COUNT + REUSEPORT_THREAD_COUNT];
+    struct nc_session *session;
+
+    for (i = 0; i < thread_count; i++) {
+        ret = pthread_create(&tids[i], NULL, server_thread, test_state);
+        assert_int_equal(ret, 0);
+    }
+    for (i = thread_count; i < thread_count + CLIENT_COUNT; i++) {
+        ret = pthread_create(&tids[i], NULL, client_thread, NULL);
+        assert_int_equal(ret, 0);
+    }
+
+    while (terminated < CLIENT_COUNT) {
+        ret = nc_ps_poll(test_state->ps, NC_PS_POLL_TIMEOUT, &session);
+        if (ret & NC_PSPOLL_NOSESSIONS) {
+            usleep(10000);
+        } else if (ret & NC_PSPOLL_SESSION_TERM) {
+            nc_ps_del_session(test_state->ps, session);
+            nc_session_free(session, NULL);
+            terminated++;
+        }
+    }
+
+    for (i = 0; i < thread_count + CLIENT_COUNT; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+static void
+test_nc_reuseport(void **state)
+{
+    reuseport_accept(*state, REUSEPORT_THREAD_COUNT);
+}
+
+static void
+test_nc_reuseport_fewer_threads(void **state)
+{
+    /* the connections queued on the listening socket without a thread are accepted as well */
+    reuseport_accept(*state, 1);
+}
+
+static int
+setup_f(void **state)
+{
+    int ret;
+    struct lyd_node *tree = NULL;
+    struct test_state *test_state;
+
+    nc_verbosity(NC_VERB_VERBOSE);
+
+    test_state = calloc(1, sizeof *test_state);
+    assert_non_null(test_state);
+    test_state->ps = nc_ps_new();
+    assert_non_null(test_state->ps);
+    pthread_mutex_init(&test_state->lock, NULL);
+    *state = test_state;
+
+    /* initialize server */
+    ret = nc_server_init();
+    assert_int_equal(ret, 0);
+
+    /* initialize client */
+    ret = nc_client_init();
+    assert_int_equal(ret, 0);
+
+    /* a listening socket for each accepting thread, must be set before the configuration is applied */
+    nc_server_set_reuseport_listeners(REUSEPORT_THREAD_COUNT);
+
+    ret = ly_ctx_new(MODULES_DIR, 0, &ctx);
+    assert_int_equal(ret, 0);
+
+    ret = nc_server_init_ctx(&ctx);
+    assert_int_equal(ret, 0);
+
+    ret = nc_server_config_load_modules(&ctx);
+    assert_int_equal(ret, 0);
+
+    ret = nc_server_config_add_ssh_hostkey(ctx, "endpt", "hostkey", TESTS_DIR "/data/server.key", NULL, &tree);
+    assert_int_equal(ret, 0);
+
+    ret = nc_server_config_add_address_port(ctx, "endpt", NC_TI_SSH, "127.0.0.1", TEST_PORT, &tree);
+    assert_int_equal(ret, 0);
+
+    ret = nc_server_config_add_ssh_user_pubkey(ctx, "endpt", "test_reuseport", "pubkey", TESTS_DIR "/data/id_ed25519.pub", &tree);
+    assert_int_equal(ret, 0);
+
+    ret = nc_server_config_setup_data(tree);
+    assert_int_equal(ret, 0);
+
+    lyd_free_all(tree);
+
+    return 0;
+}
+
+static int
+teardown_f(void **state)
+{
+    struct test_state *test_state = *state;
+
+    nc_ps_free(test_state->ps);
+    pthread_mutex_destroy(&test_state->lock);
+    free(test_state);
+
+    /* the setting is global, do not let it affect any other tests */
+    nc_server_set_reuseport_listeners(0);
+
+    nc_client_destroy();
+    nc_server_destroy();
+    ly_ctx_destroy(ctx);
+
+    return 0;
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_nc_reuseport, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_reuseport_fewer_threads, setup_f, teardown_f),
+    };
+
+    setenv("CMOCKA_TEST_ABORT", "1", 1);
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
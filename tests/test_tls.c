@@ -15,11 +15,16 @@
 
 #define _GNU_SOURCE
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
 #include <pthread.h>
 #include <setjmp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
 
 #include <cmocka.h>
 
@@ -110,6 +115,332 @@ test_nc_tls(void **state)
     }
 }
 
+static int resumed;
+
+static void
+test_msg_callback(const struct nc_session *session, NC_VERB_LEVEL level, const char *msg)
+{
+    (void) session;
+    (void) level;
+
+    if (strstr(msg, "TLS session resumed")) {
+        resumed = 1;
+    }
+}
+
+static void *
+server_thread_resumption(void *arg)
+{
+    int ret, i;
+    NC_MSG_TYPE msgtype;
+    struct nc_session *session;
+    struct nc_pollsession *ps;
+    struct test_state *state = arg;
+
+    nc_set_print_clb_session(test_msg_callback);
+
+    ps = nc_ps_new();
+    assert_non_null(ps);
+
+    for (i = 0; i < 2; i++) {
+        /* accept a session, the second one is resumed with the same username */
+        resumed = 0;
+        pthread_barrier_wait(&state->barrier);
+        msgtype = nc_accept(NC_ACCEPT_TIMEOUT, ctx, &session);
+        assert_int_equal(msgtype, NC_MSG_HELLO);
+        assert_int_equal(resumed, i);
+        assert_string_equal(nc_session_get_username(session), "client");
+        assert_non_null(nc_session_get_client_cert(session));
+
+        ret = nc_ps_add_session(ps, session);
+        assert_int_equal(ret, 0);
+
+        do {
+            ret = nc_ps_poll(ps, NC_PS_POLL_TIMEOUT, NULL);
+            assert_int_equal(ret & NC_PSPOLL_RPC, NC_PSPOLL_RPC);
+        } while (!(ret & NC_PSPOLL_SESSION_TERM));
+
+        nc_ps_clear(ps, 1, NULL);
+    }
+
+    nc_ps_free(ps);
+    nc_set_print_clb_session(NULL);
+    return NULL;
+}
+
+static void *
+client_thread_resumption(void *arg)
+{
+    int ret, i;
+    struct nc_session *session = NULL;
+    struct test_state *state = arg;
+
+    ret = nc_client_set_schema_searchpath(MODULES_DIR);
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_tls_set_cert_key_paths(TESTS_DIR "/data/client.crt", TESTS_DIR "/data/client.key");
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_tls_set_trusted_ca_paths(NULL, TESTS_DIR "/data");
+    assert_int_equal(ret, 0);
+
+    /* keep the session of the first connection */
+    nc_client_tls_set_resumption(4);
+
+    for (i = 0; i < 2; i++) {
+        pthread_barrier_wait(&state->barrier);
+        session = nc_connect_tls("127.0.0.1", TEST_PORT, NULL);
+        assert_non_null(session);
+
+        nc_session_free(session, NULL);
+    }
+
+    nc_client_tls_set_resumption(0);
+    return NULL;
+}
+
+static void
+test_nc_tls_resumption(void **state)
+{
+    int ret, i;
+    pthread_t tids[2];
+
+    assert_non_null(state);
+
+    nc_server_tls_set_resumption(16, 0);
+
+    ret = pthread_create(&tids[0], NULL, client_thread_resumption, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread_resumption, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    nc_server_tls_set_resumption(0, 0);
+}
+
+static void
+create_endpt_config(struct lyd_node **tree)
+{
+    int ret;
+
+    /* create new address and port data */
+    ret = nc_server_config_add_address_port(ctx, "endpt", NC_TI_TLS, "127.0.0.1", TEST_PORT, tree);
+    assert_int_equal(ret, 0);
+
+    /* create new server certificate data */
+    ret = nc_server_config_add_tls_server_cert(ctx, "endpt", TESTS_DIR "/data/server.key", NULL, TESTS_DIR "/data/server.crt", tree);
+    assert_int_equal(ret, 0);
+
+    /* create new end entity client cert data */
+    ret = nc_server_config_add_tls_client_cert(ctx, "endpt", "client_cert", TESTS_DIR "/data/client.crt", tree);
+    assert_int_equal(ret, 0);
+
+    /* create new client ca data */
+    ret = nc_server_config_add_tls_ca_cert(ctx, "endpt", "client_ca", TESTS_DIR "/data/serverca.pem", tree);
+    assert_int_equal(ret, 0);
+}
+
+static int
+new_session_cb(struct nc_session *new_session, void *user_data)
+{
+    struct nc_pollsession *ps = user_data;
+
+    return nc_ps_add_session(ps, new_session);
+}
+
+static pthread_mutex_t accept_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t accept_cond = PTHREAD_COND_INITIALIZER;
+static int accepted;
+
+static void
+accept_msg_callback(const struct nc_session *session, NC_VERB_LEVEL level, const char *msg)
+{
+    (void) session;
+    (void) level;
+
+    if (strstr(msg, "Accepted a connection")) {
+        pthread_mutex_lock(&accept_lock);
+        accepted = 1;
+        pthread_cond_broadcast(&accept_cond);
+        pthread_mutex_unlock(&accept_lock);
+    }
+}
+
+static void *
+server_thread_dispatch(void *arg)
+{
+    int ret, sock;
+    struct nc_pollsession *ps;
+    struct lyd_node *tree = NULL;
+    struct sockaddr_in addr = {0};
+    struct timespec ts_start, ts_end;
+    struct test_state *state = arg;
+
+    ps = nc_ps_new();
+    assert_non_null(ps);
+
+    accepted = 0;
+    nc_set_print_clb_session(accept_msg_callback);
+
+    /* sessions are accepted in the background and added to the poll session structure */
+    ret = nc_server_accept_dispatch(ctx, 2, new_session_cb, ps);
+    assert_int_equal(ret, 0);
+
+    /* a client that never starts its TLS handshake */
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    assert_int_not_equal(sock, -1);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ret = connect(sock, (struct sockaddr *)&addr, sizeof addr);
+    assert_int_equal(ret, 0);
+
+    /* wait until it is accepted and handed to a worker */
+    pthread_mutex_lock(&accept_lock);
+    while (!accepted) {
+        pthread_cond_wait(&accept_cond, &accept_lock);
+    }
+    pthread_mutex_unlock(&accept_lock);
+    nc_set_print_clb_session(NULL);
+
+    /* the configuration can be changed while its handshake is waiting for data */
+    create_endpt_config(&tree);
+    ret = nc_server_config_add_tls_ctn(ctx, "endpt", 1,
+            "04:85:6B:75:D1:1A:86:E0:D8:FE:5B:BD:72:F5:73:1D:07:EA:32:BF:09:11:21:6A:6E:23:78:8E:B6:D5:73:C3:2D",
+            NC_TLS_CTN_SPECIFIED, "client", &tree);
+    assert_int_equal(ret, 0);
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+    ret = nc_server_config_setup_data(tree);
+    assert_int_equal(ret, 0);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    lyd_free_all(tree);
+    assert_true(ts_end.tv_sec - ts_start.tv_sec < 5);
+
+    pthread_barrier_wait(&state->barrier);
+
+    /* wait for the session to be established by a worker */
+    while (!nc_ps_session_count(ps)) {
+        usleep(10000);
+    }
+    assert_string_equal(nc_session_get_username(nc_ps_get_session(ps, 0)), "client");
+
+    do {
+        ret = nc_ps_poll(ps, NC_PS_POLL_TIMEOUT, NULL);
+        assert_int_equal(ret & NC_PSPOLL_RPC, NC_PSPOLL_RPC);
+    } while (!(ret & NC_PSPOLL_SESSION_TERM));
+
+    nc_server_accept_dispatch_stop();
+    close(sock);
+
+    nc_ps_clear(ps, 1, NULL);
+    nc_ps_free(ps);
+    return NULL;
+}
+
+static void
+test_nc_tls_dispatch(void **state)
+{
+    int ret, i;
+    pthread_t tids[2];
+
+    assert_non_null(state);
+
+    ret = pthread_create(&tids[0], NULL, client_thread, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread_dispatch, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+static void *
+server_thread_ctn(void *arg)
+{
+    int ret;
+    NC_MSG_TYPE msgtype;
+    struct nc_session *session;
+    struct nc_pollsession *ps;
+    struct test_state *state = arg;
+
+    ps = nc_ps_new();
+    assert_non_null(ps);
+
+    /* the matching entry with the highest priority must be used */
+    pthread_barrier_wait(&state->barrier);
+    msgtype = nc_accept(NC_ACCEPT_TIMEOUT, ctx, &session);
+    assert_int_equal(msgtype, NC_MSG_HELLO);
+    assert_string_equal(nc_session_get_username(session), "client2");
+
+    ret = nc_ps_add_session(ps, session);
+    assert_int_equal(ret, 0);
+
+    do {
+        ret = nc_ps_poll(ps, NC_PS_POLL_TIMEOUT, NULL);
+        assert_int_equal(ret & NC_PSPOLL_RPC, NC_PSPOLL_RPC);
+    } while (!(ret & NC_PSPOLL_SESSION_TERM));
+
+    nc_ps_clear(ps, 1, NULL);
+    nc_ps_free(ps);
+    return NULL;
+}
+
+static void
+test_nc_tls_ctn(void **state)
+{
+    int ret, i, j, len;
+    pthread_t tids[2];
+    struct lyd_node *tree = NULL;
+    char fp[3 + 32 * 3];
+
+    assert_non_null(state);
+
+    create_endpt_config(&tree);
+
+    /* lots of entries that do not match */
+    for (i = 0; i < 500; i++) {
+        len = sprintf(fp, "%s", (i % 2) ? "04" : "02");
+        for (j = 0; j < ((i % 2) ? 32 : 20); j++) {
+            len += sprintf(fp + len, ":%02X", (i * 31 + j) % 256);
+        }
+        ret = nc_server_config_add_tls_ctn(ctx, "endpt", 10 + i, fp, NC_TLS_CTN_SPECIFIED, "junk", &tree);
+        assert_int_equal(ret, 0);
+    }
+
+    /* two matching entries, the one with the lower ID has priority */
+    ret = nc_server_config_add_tls_ctn(ctx, "endpt", 3,
+            "04:85:6B:75:D1:1A:86:E0:D8:FE:5B:BD:72:F5:73:1D:07:EA:32:BF:09:11:21:6A:6E:23:78:8E:B6:D5:73:C3:2D",
+            NC_TLS_CTN_SPECIFIED, "client3", &tree);
+    assert_int_equal(ret, 0);
+    ret = nc_server_config_add_tls_ctn(ctx, "endpt", 2,
+            "04:85:6b:75:d1:1a:86:e0:d8:fe:5b:bd:72:f5:73:1d:07:ea:32:bf:09:11:21:6a:6e:23:78:8e:b6:d5:73:c3:2d",
+            NC_TLS_CTN_SPECIFIED, "client2", &tree);
+    assert_int_equal(ret, 0);
+
+    /* an entry with a higher priority that does not match */
+    ret = nc_server_config_add_tls_ctn(ctx, "endpt", 1,
+            "02:00:11:22:33:44:55:66:77:88:99:AA:BB:CC:DD:EE:FF:00:11:22:33",
+            NC_TLS_CTN_SPECIFIED, "client1", &tree);
+    assert_int_equal(ret, 0);
+
+    ret = nc_server_config_setup_data(tree);
+    assert_int_equal(ret, 0);
+    lyd_free_all(tree);
+
+    ret = pthread_create(&tids[0], NULL, client_thread, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread_ctn, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
 static int
 setup_f(void **state)
 {
@@ -137,21 +468,7 @@ setup_f(void **state)
     ret = nc_server_config_load_modules(&ctx);
     assert_int_equal(ret, 0);
 
-    /* create new address and port data */
-    ret = nc_server_config_add_address_port(ctx, "endpt", NC_TI_TLS, "127.0.0.1", TEST_PORT, &tree);
-    assert_int_equal(ret, 0);
-
-    /* create new server certificate data */
-    ret = nc_server_config_add_tls_server_cert(ctx, "endpt", TESTS_DIR "/data/server.key", NULL, TESTS_DIR "/data/server.crt", &tree);
-    assert_int_equal(ret, 0);
-
-    /* create new end entity client cert data */
-    ret = nc_server_config_add_tls_client_cert(ctx, "endpt", "client_cert", TESTS_DIR "/data/client.crt", &tree);
-    assert_int_equal(ret, 0);
-
-    /* create new client ca data */
-    ret = nc_server_config_add_tls_ca_cert(ctx, "endpt", "client_ca", TESTS_DIR "/data/serverca.pem", &tree);
-    assert_int_equal(ret, 0);
+    create_endpt_config(&tree);
 
     /* create new cert-to-name */
     ret = nc_server_config_add_tls_ctn(ctx, "endpt", 1,
@@ -200,6 +517,9 @@ main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_nc_tls, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_tls_resumption, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_tls_ctn, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_tls_dispatch, setup_f, teardown_f),
     };
 
     setenv("CMOCKA_TEST_ABORT", "1", 1);
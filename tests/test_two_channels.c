@@ -30,6 +30,7 @@
 #define NC_ACCEPT_TIMEOUT 2000
 #define NC_PS_POLL_TIMEOUT 2000
 #define BACKOFF_TIMEOUT_USECS 100
+#define RPC_ROUNDS 50
 
 struct ly_ctx *ctx;
 
@@ -41,9 +42,8 @@ server_thread(void *arg)
     struct nc_session *session, *new_session;
     struct nc_pollsession *ps;
 
-    (void) arg;
-
-    ps = nc_ps_new();
+    /* use epoll if requested */
+    ps = arg ? nc_ps_new_epoll() : nc_ps_new();
     assert_non_null(ps);
 
     while (del_session_count < 2) {
@@ -117,6 +117,80 @@ client_thread(void *arg)
     return NULL;
 }
 
+static void *
+client_thread_rpcs(void *arg)
+{
+    int ret, i;
+    uint64_t msgid1, msgid2;
+    NC_MSG_TYPE msgtype;
+    struct nc_session *session_cl1, *session_cl2;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op;
+
+    (void) arg;
+
+    nc_client_ssh_set_knownhosts_mode(NC_SSH_KNOWNHOSTS_SKIP);
+
+    ret = nc_client_set_schema_searchpath(MODULES_DIR);
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_ssh_add_keypair(TESTS_DIR "/data/id_ed25519.pub", TESTS_DIR "/data/id_ed25519");
+    assert_int_equal(ret, 0);
+
+    ret = nc_client_ssh_set_username("client_1");
+    assert_int_equal(ret, 0);
+
+    /* both channels of a single SSH session authenticated as the same user */
+    session_cl1 = nc_connect_ssh("127.0.0.1", TEST_PORT, NULL);
+    assert_non_null(session_cl1);
+    session_cl2 = nc_connect_ssh_channel(session_cl1, NULL);
+    assert_non_null(session_cl2);
+
+    rpc = nc_rpc_getschema("ietf-netconf", NULL, NULL, NC_PARAMTYPE_CONST);
+    assert_non_null(rpc);
+
+    /* RPCs on both channels sent at once, data of both may be read by the server at once */
+    for (i = 0; i < RPC_ROUNDS; ++i) {
+        msgtype = nc_send_rpc(session_cl1, rpc, 1000, &msgid1);
+        assert_int_equal(msgtype, NC_MSG_RPC);
+        msgtype = nc_send_rpc(session_cl2, rpc, 1000, &msgid2);
+        assert_int_equal(msgtype, NC_MSG_RPC);
+
+        msgtype = nc_recv_reply(session_cl1, rpc, msgid1, 5000, &envp, &op);
+        assert_int_equal(msgtype, NC_MSG_REPLY);
+        lyd_free_tree(envp);
+        lyd_free_tree(op);
+        msgtype = nc_recv_reply(session_cl2, rpc, msgid2, 5000, &envp, &op);
+        assert_int_equal(msgtype, NC_MSG_REPLY);
+        lyd_free_tree(envp);
+        lyd_free_tree(op);
+    }
+
+    nc_rpc_free(rpc);
+    nc_client_destroy();
+    nc_session_free(session_cl2, NULL);
+    nc_session_free(session_cl1, NULL);
+    return NULL;
+}
+
+static void
+test_nc_two_channels_epoll(void **state)
+{
+    int ret, i;
+    pthread_t tids[2];
+
+    (void) state;
+
+    ret = pthread_create(&tids[0], NULL, client_thread_rpcs, NULL);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread, (void *)1);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
 static void
 test_nc_two_channels(void **state)
 {
@@ -197,6 +271,7 @@ main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_nc_two_channels, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_two_channels_epoll, setup_f, teardown_f),
     };
 
     setenv("CMOCKA_TEST_ABORT", "1", 1);
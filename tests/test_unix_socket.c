@@ -22,6 +22,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 #include <cmocka.h>
 
@@ -102,6 +105,307 @@ test_nc_connect_unix_socket(void **state)
     }
 }
 
+static int
+new_session_cb(struct nc_session *new_session, void *user_data)
+{
+    struct nc_pollsession *ps = user_data;
+
+    return nc_ps_add_session(ps, new_session);
+}
+
+static void *
+server_thread_dispatch(void *arg)
+{
+    int ret;
+    struct nc_pollsession *ps;
+    struct test_state *state = arg;
+
+    ps = nc_ps_new();
+    assert_non_null(ps);
+
+    /* sessions are accepted in the background and added to the poll session structure */
+    ret = nc_server_accept_dispatch(ctx, 2, new_session_cb, ps);
+    assert_int_equal(ret, 0);
+
+    pthread_barrier_wait(&state->barrier);
+
+    /* wait for the session to be established by a worker */
+    while (!nc_ps_session_count(ps)) {
+        usleep(10000);
+    }
+
+    do {
+        ret = nc_ps_poll(ps, NC_PS_POLL_TIMEOUT, NULL);
+        assert_int_equal(ret & NC_PSPOLL_RPC, NC_PSPOLL_RPC);
+    } while (!(ret & NC_PSPOLL_SESSION_TERM));
+
+    nc_server_accept_dispatch_stop();
+
+    nc_ps_clear(ps, 1, NULL);
+    nc_ps_free(ps);
+    return NULL;
+}
+
+static void
+test_nc_accept_dispatch(void **state)
+{
+    int ret, i;
+    pthread_t tids[2];
+
+    assert_non_null(state);
+
+    ret = pthread_create(&tids[0], NULL, client_thread, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread_dispatch, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+static void *
+server_thread_dispatch_no_hello(void *arg)
+{
+    int ret, sock;
+    char buf[1024];
+    ssize_t len = 0, r;
+    struct nc_pollsession *ps;
+    struct sockaddr_un addr = {0};
+    struct test_state *state = arg;
+
+    ps = nc_ps_new();
+    assert_non_null(ps);
+
+    /* a single worker establishes all the sessions */
+    ret = nc_server_accept_dispatch(ctx, 1, new_session_cb, ps);
+    assert_int_equal(ret, 0);
+
+    /* a client that never sends its <hello> */
+    sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert_int_not_equal(sock, -1);
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, "/tmp/nc2_test_unix_sock");
+    ret = connect(sock, (struct sockaddr *)&addr, sizeof addr);
+    assert_int_equal(ret, 0);
+
+    /* the worker is handling its handshake once the server <hello> is received */
+    do {
+        if (len > 6) {
+            /* keep the end in case the delimiter is split */
+            memmove(buf, buf + len - 6, 6);
+            len = 6;
+        }
+        r = read(sock, buf + len, sizeof buf - 1 - len);
+        assert_true(r > 0);
+        len += r;
+        buf[len] = '\0';
+    } while (!strstr(buf, "]]>]]>"));
+
+    pthread_barrier_wait(&state->barrier);
+
+    /* the session of the other client is still established */
+    while (!nc_ps_session_count(ps)) {
+        usleep(10000);
+    }
+
+    do {
+        ret = nc_ps_poll(ps, NC_PS_POLL_TIMEOUT, NULL);
+        assert_int_equal(ret & NC_PSPOLL_RPC, NC_PSPOLL_RPC);
+    } while (!(ret & NC_PSPOLL_SESSION_TERM));
+
+    /* the handshake in progress is dropped */
+    nc_server_accept_dispatch_stop();
+    close(sock);
+
+    nc_ps_clear(ps, 1, NULL);
+    nc_ps_free(ps);
+    return NULL;
+}
+
+static void
+test_nc_accept_dispatch_no_hello(void **state)
+{
+    int ret, i;
+    pthread_t tids[2];
+
+    assert_non_null(state);
+
+    ret = pthread_create(&tids[0], NULL, client_thread, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread_dispatch_no_hello, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+}
+
+static void *
+client_thread_stats(void *arg)
+{
+    int ret = 0;
+    struct nc_session *session = NULL;
+    struct nc_rpc *rpc;
+    struct lyd_node *envp, *op;
+    uint64_t msgid;
+    NC_MSG_TYPE msgtype;
+    struct test_state *state = arg;
+
+    ret = nc_client_set_schema_searchpath(MODULES_DIR);
+    assert_int_equal(ret, 0);
+
+    pthread_barrier_wait(&state->barrier);
+    session = nc_connect_unix("/tmp/nc2_test_unix_sock", NULL);
+    assert_non_null(session);
+
+    /* get-schema of an unknown module, an error reply is sent */
+    rpc = nc_rpc_getschema("unknown-module", NULL, NULL, NC_PARAMTYPE_CONST);
+    assert_non_null(rpc);
+    msgtype = nc_send_rpc(session, rpc, 1000, &msgid);
+    assert_int_equal(msgtype, NC_MSG_RPC);
+    msgtype = nc_recv_reply(session, rpc, msgid, 1000, &envp, &op);
+    assert_int_equal(msgtype, NC_MSG_REPLY);
+    lyd_free_tree(envp);
+    lyd_free_tree(op);
+    nc_rpc_free(rpc);
+
+    /* close-session is sent */
+    nc_session_free(session, NULL);
+    return NULL;
+}
+
+static void
+test_nc_stats(void **state)
+{
+    int ret, i;
+    pthread_t tids[2];
+    struct nc_stats stats;
+    struct lyd_node *data, *node;
+
+    assert_non_null(state);
+
+    ret = pthread_create(&tids[0], NULL, client_thread_stats, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    /* get-schema and close-session received, get-schema failed */
+    nc_server_get_stats(&stats);
+    assert_int_equal(stats.in_sessions, 1);
+    assert_int_equal(stats.in_bad_hellos, 0);
+    assert_int_equal(stats.dropped_sessions, 0);
+    assert_int_equal(stats.in_rpcs, 2);
+    assert_int_equal(stats.in_bad_rpcs, 0);
+    assert_int_equal(stats.out_rpc_errors, 1);
+    assert_int_equal(stats.out_notifications, 0);
+    assert_true(stats.in_bytes > 0);
+    assert_true(stats.out_bytes > 0);
+    assert_int_equal(stats.in_chunked_msgs, 2);
+    assert_true(stats.in_chunked_msg_allocs >= 2);
+
+    ret = nc_server_get_stats_data(ctx, &data);
+    assert_int_equal(ret, 0);
+    ret = lyd_find_path(data, "statistics/in-rpcs", 0, &node);
+    assert_int_equal(ret, 0);
+    assert_string_equal(lyd_get_value(node), "2");
+    ret = lyd_find_path(data, "statistics/out-rpc-errors", 0, &node);
+    assert_int_equal(ret, 0);
+    assert_string_equal(lyd_get_value(node), "1");
+    lyd_free_tree(data);
+}
+
+static void
+test_nc_rpc_latency(void **state)
+{
+    int ret, i;
+    uint32_t j, k, count, buckets;
+    uint64_t sum, lower, upper;
+    pthread_t tids[2];
+    struct nc_rpc_latency *lats;
+    struct lyd_node *data, *node, *child;
+
+    assert_non_null(state);
+
+    nc_server_set_rpc_latency(1);
+
+    ret = pthread_create(&tids[0], NULL, client_thread_stats, *state);
+    assert_int_equal(ret, 0);
+    ret = pthread_create(&tids[1], NULL, server_thread, *state);
+    assert_int_equal(ret, 0);
+
+    for (i = 0; i < 2; i++) {
+        pthread_join(tids[i], NULL);
+    }
+
+    /* a single get-schema and close-session, each phase recorded once in exactly one bucket */
+    ret = nc_server_get_rpc_latency(&lats, &count);
+    assert_int_equal(ret, 0);
+    assert_int_equal(count, 2);
+    for (i = 0; i < 2; i++) {
+        assert_true(!strcmp(lats[i].name, "get-schema") || !strcmp(lats[i].name, "close-session"));
+        for (j = 0; j < NC_RPC_LAT_PHASE_COUNT; j++) {
+            assert_int_equal(lats[i].phases[j].count, 1);
+
+            sum = 0;
+            buckets = 0;
+            for (k = 0; k < NC_RPC_LATENCY_BUCKETS; k++) {
+                if (lats[i].phases[j].buckets[k]) {
+                    assert_int_equal(lats[i].phases[j].buckets[k], 1);
+                    ++buckets;
+                }
+                sum += lats[i].phases[j].buckets[k];
+            }
+            assert_int_equal(buckets, 1);
+            assert_int_equal(sum, 1);
+        }
+    }
+    nc_server_rpc_latency_free(lats, count);
+
+    /* buckets */
+    nc_rpc_latency_bucket_range(7, &lower, &upper);
+    assert_int_equal(lower, 7);
+    assert_int_equal(upper, 7);
+    nc_rpc_latency_bucket_range(17, &lower, &upper);
+    assert_int_equal(lower, 18);
+    assert_int_equal(upper, 19);
+
+    ret = nc_server_config_load_modules(&ctx);
+    assert_int_equal(ret, 0);
+    ret = nc_server_get_rpc_latency_data(ctx, &data);
+    assert_int_equal(ret, 0);
+    ret = lyd_find_path(data, "rpc[module='ietf-netconf'][name='close-session']/phase[name='callback']/count", 0, &node);
+    assert_int_equal(ret, 0);
+    assert_string_equal(lyd_get_value(node), "1");
+
+    /* only the single non-empty bucket */
+    buckets = 0;
+    LY_LIST_FOR(lyd_child(lyd_parent(node)), child) {
+        if (!strcmp(LYD_NAME(child), "bucket")) {
+            ret = lyd_find_path(child, "count", 0, &node);
+            assert_int_equal(ret, 0);
+            assert_string_equal(lyd_get_value(node), "1");
+            ++buckets;
+        }
+    }
+    assert_int_equal(buckets, 1);
+    lyd_free_tree(data);
+
+    /* nothing recorded after a reset */
+    nc_server_reset_rpc_latency();
+    ret = nc_server_get_rpc_latency(&lats, &count);
+    assert_int_equal(ret, 0);
+    assert_int_equal(count, 0);
+    assert_null(lats);
+
+    /* the setting is global, do not let it affect any other tests */
+    nc_server_set_rpc_latency(0);
+}
+
 static int
 setup_f(void **state)
 {
@@ -168,6 +472,10 @@ main(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test_setup_teardown(test_nc_connect_unix_socket, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_accept_dispatch, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_accept_dispatch_no_hello, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_stats, setup_f, teardown_f),
+        cmocka_unit_test_setup_teardown(test_nc_rpc_latency, setup_f, teardown_f),
     };
 
     setenv("CMOCKA_TEST_ABORT", "1", 1);